@@ -576,14 +576,338 @@ u64 GetHashHiresTexture(const u8* src, u32 len, u32 samples)
 }
 #endif
 
+// xxHash3 (XXH3_64bits with the default secret and no seed). Inputs longer than 240 bytes are
+// consumed as 64 byte stripes, which is where the SSE2 and AVX2 versions come in.
+// Unsampled results match the reference implementation. When sampling, only evenly spaced
+// stripes are fed to the accumulators, so the result is no longer a standard XXH3 hash.
+namespace
+{
+const u32 XXH_PRIME32_1 = 0x9E3779B1U;
+const u32 XXH_PRIME32_2 = 0x85EBCA77U;
+const u32 XXH_PRIME32_3 = 0xC2B2AE3DU;
+const u64 XXH_PRIME64_1 = 0x9E3779B185EBCA87ULL;
+const u64 XXH_PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+const u64 XXH_PRIME64_3 = 0x165667B19E3779F9ULL;
+const u64 XXH_PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+const u64 XXH_PRIME64_5 = 0x27D4EB2F165667C5ULL;
+const u64 XXH_PRIME_MX1 = 0x165667919E3779F9ULL;
+const u64 XXH_PRIME_MX2 = 0x9FB21C651E98DF25ULL;
+
+alignas(64) const u8 s_xxh3_secret[192] = {
+	0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+	0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+	0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+	0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+	0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+	0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+	0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+	0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+	0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+	0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+	0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+	0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+const u32 XXH3_STRIPE_LEN = 64;
+const u32 XXH3_STRIPES_PER_BLOCK = (sizeof(s_xxh3_secret) - XXH3_STRIPE_LEN) / 8;
+
+inline u64 XXH3Read64(const u8* p)
+{
+	u64 value;
+	std::memcpy(&value, p, sizeof(u64));
+	return value;
+}
+
+inline u32 XXH3Read32(const u8* p)
+{
+	u32 value;
+	std::memcpy(&value, p, sizeof(u32));
+	return value;
+}
+
+// Folds the 128 bit product of lhs and rhs into 64 bits
+inline u64 XXH3Mul128Fold64(u64 lhs, u64 rhs)
+{
+#if defined(_MSC_VER) && defined(_M_X86_64)
+	u64 high;
+	u64 low = _umul128(lhs, rhs, &high);
+	return low ^ high;
+#elif defined(__SIZEOF_INT128__)
+	unsigned __int128 product = static_cast<unsigned __int128>(lhs) * rhs;
+	return static_cast<u64>(product) ^ static_cast<u64>(product >> 64);
+#else
+	u64 lo_lo = (lhs & 0xFFFFFFFF) * (rhs & 0xFFFFFFFF);
+	u64 hi_lo = (lhs >> 32) * (rhs & 0xFFFFFFFF);
+	u64 lo_hi = (lhs & 0xFFFFFFFF) * (rhs >> 32);
+	u64 hi_hi = (lhs >> 32) * (rhs >> 32);
+	u64 cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFF) + lo_hi;
+	u64 upper = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+	u64 lower = (cross << 32) | (lo_lo & 0xFFFFFFFF);
+	return lower ^ upper;
+#endif
+}
+
+inline u64 XXH64Avalanche(u64 h)
+{
+	h ^= h >> 33;
+	h *= XXH_PRIME64_2;
+	h ^= h >> 29;
+	h *= XXH_PRIME64_3;
+	h ^= h >> 32;
+	return h;
+}
+
+inline u64 XXH3Avalanche(u64 h)
+{
+	h ^= h >> 37;
+	h *= XXH_PRIME_MX1;
+	h ^= h >> 32;
+	return h;
+}
+
+inline u64 XXH3rrmxmx(u64 h, u64 len)
+{
+	h ^= _rotl64(h, 49) ^ _rotl64(h, 24);
+	h *= XXH_PRIME_MX2;
+	h ^= (h >> 35) + len;
+	h *= XXH_PRIME_MX2;
+	return h ^ (h >> 28);
+}
+
+inline u64 XXH3Mix16B(const u8* input, const u8* secret)
+{
+	return XXH3Mul128Fold64(XXH3Read64(input) ^ XXH3Read64(secret), XXH3Read64(input + 8) ^ XXH3Read64(secret + 8));
+}
+
+u64 XXH3HashShort(const u8* input, u32 len)
+{
+	const u8* secret = s_xxh3_secret;
+	if (len > 8)
+	{
+		u64 input_lo = XXH3Read64(input) ^ (XXH3Read64(secret + 24) ^ XXH3Read64(secret + 32));
+		u64 input_hi = XXH3Read64(input + len - 8) ^ (XXH3Read64(secret + 40) ^ XXH3Read64(secret + 48));
+		u64 acc = len + Common::swap64(input_lo) + input_hi + XXH3Mul128Fold64(input_lo, input_hi);
+		return XXH3Avalanche(acc);
+	}
+	if (len >= 4)
+	{
+		u64 input64 = XXH3Read32(input + len - 4) + (static_cast<u64>(XXH3Read32(input)) << 32);
+		return XXH3rrmxmx(input64 ^ (XXH3Read64(secret + 8) ^ XXH3Read64(secret + 16)), len);
+	}
+	if (len > 0)
+	{
+		u32 combined = (static_cast<u32>(input[0]) << 16) | (static_cast<u32>(input[len >> 1]) << 24) |
+			input[len - 1] | (len << 8);
+		return XXH64Avalanche(combined ^ (XXH3Read32(secret) ^ XXH3Read32(secret + 4)));
+	}
+	return XXH64Avalanche(XXH3Read64(secret + 56) ^ XXH3Read64(secret + 64));
+}
+
+u64 XXH3HashMedium(const u8* input, u32 len)
+{
+	const u8* secret = s_xxh3_secret;
+	u64 acc = len * XXH_PRIME64_1;
+	if (len <= 128)
+	{
+		for (u32 i = 0; i < (len - 1) / 32 + 1; i++)
+		{
+			acc += XXH3Mix16B(input + 16 * i, secret + 32 * i);
+			acc += XXH3Mix16B(input + len - 16 * (i + 1), secret + 32 * i + 16);
+		}
+		return XXH3Avalanche(acc);
+	}
+
+	for (u32 i = 0; i < 8; i++)
+		acc += XXH3Mix16B(input + 16 * i, secret + 16 * i);
+	acc = XXH3Avalanche(acc);
+	u64 acc_end = XXH3Mix16B(input + len - 16, secret + 136 - 17);
+	for (u32 i = 8; i < len / 16; i++)
+		acc_end += XXH3Mix16B(input + 16 * i, secret + 16 * (i - 8) + 3);
+	return XXH3Avalanche(acc + acc_end);
+}
+
+// Accumulates count stripes, spaced stride bytes apart, using consecutive 8 byte steps of secret
+typedef void(*XXH3AccumulateFunction)(u64* acc, const u8* input, size_t stride, const u8* secret, u32 count);
+typedef void(*XXH3ScrambleFunction)(u64* acc, const u8* secret);
+
+#ifdef _M_X86
+
+void XXH3AccumulateSSE2(u64* acc, const u8* input, size_t stride, const u8* secret, u32 count)
+{
+	__m128i* xacc = reinterpret_cast<__m128i*>(acc);
+	__m128i acc0 = xacc[0], acc1 = xacc[1], acc2 = xacc[2], acc3 = xacc[3];
+	for (u32 n = 0; n < count; n++, input += stride, secret += 8)
+	{
+		const __m128i* xinput = reinterpret_cast<const __m128i*>(input);
+		const __m128i* xsecret = reinterpret_cast<const __m128i*>(secret);
+#define XXH3_SSE2_ROUND(acc_vec, i) \
+		{ \
+			const __m128i data = _mm_loadu_si128(xinput + i); \
+			const __m128i key = _mm_xor_si128(data, _mm_loadu_si128(xsecret + i)); \
+			const __m128i product = _mm_mul_epu32(key, _mm_srli_epi64(key, 32)); \
+			acc_vec = _mm_add_epi64(_mm_add_epi64(acc_vec, _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2))), product); \
+		}
+		XXH3_SSE2_ROUND(acc0, 0);
+		XXH3_SSE2_ROUND(acc1, 1);
+		XXH3_SSE2_ROUND(acc2, 2);
+		XXH3_SSE2_ROUND(acc3, 3);
+#undef XXH3_SSE2_ROUND
+	}
+	xacc[0] = acc0;
+	xacc[1] = acc1;
+	xacc[2] = acc2;
+	xacc[3] = acc3;
+}
+
+void XXH3ScrambleSSE2(u64* acc, const u8* secret)
+{
+	__m128i* xacc = reinterpret_cast<__m128i*>(acc);
+	const __m128i* xsecret = reinterpret_cast<const __m128i*>(secret);
+	const __m128i prime = _mm_set1_epi32(XXH_PRIME32_1);
+	for (int i = 0; i < 4; i++)
+	{
+		__m128i value = _mm_xor_si128(xacc[i], _mm_srli_epi64(xacc[i], 47));
+		value = _mm_xor_si128(value, _mm_loadu_si128(xsecret + i));
+		const __m128i product_lo = _mm_mul_epu32(value, prime);
+		const __m128i product_hi = _mm_mul_epu32(_mm_srli_epi64(value, 32), prime);
+		xacc[i] = _mm_add_epi64(product_lo, _mm_slli_epi64(product_hi, 32));
+	}
+}
+
+FUNCTION_TARGET_AVX2 void XXH3AccumulateAVX2(u64* acc, const u8* input, size_t stride, const u8* secret, u32 count)
+{
+	__m256i* xacc = reinterpret_cast<__m256i*>(acc);
+	__m256i acc0 = _mm256_load_si256(xacc), acc1 = _mm256_load_si256(xacc + 1);
+	for (u32 n = 0; n < count; n++, input += stride, secret += 8)
+	{
+		const __m256i* xinput = reinterpret_cast<const __m256i*>(input);
+		const __m256i* xsecret = reinterpret_cast<const __m256i*>(secret);
+#define XXH3_AVX2_ROUND(acc_vec, i) \
+		{ \
+			const __m256i data = _mm256_loadu_si256(xinput + i); \
+			const __m256i key = _mm256_xor_si256(data, _mm256_loadu_si256(xsecret + i)); \
+			const __m256i product = _mm256_mul_epu32(key, _mm256_srli_epi64(key, 32)); \
+			acc_vec = _mm256_add_epi64(_mm256_add_epi64(acc_vec, _mm256_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2))), product); \
+		}
+		XXH3_AVX2_ROUND(acc0, 0);
+		XXH3_AVX2_ROUND(acc1, 1);
+#undef XXH3_AVX2_ROUND
+	}
+	_mm256_store_si256(xacc, acc0);
+	_mm256_store_si256(xacc + 1, acc1);
+}
+
+FUNCTION_TARGET_AVX2 void XXH3ScrambleAVX2(u64* acc, const u8* secret)
+{
+	__m256i* xacc = reinterpret_cast<__m256i*>(acc);
+	const __m256i* xsecret = reinterpret_cast<const __m256i*>(secret);
+	const __m256i prime = _mm256_set1_epi32(XXH_PRIME32_1);
+	for (int i = 0; i < 2; i++)
+	{
+		__m256i value = _mm256_load_si256(xacc + i);
+		value = _mm256_xor_si256(value, _mm256_srli_epi64(value, 47));
+		value = _mm256_xor_si256(value, _mm256_loadu_si256(xsecret + i));
+		const __m256i product_lo = _mm256_mul_epu32(value, prime);
+		const __m256i product_hi = _mm256_mul_epu32(_mm256_srli_epi64(value, 32), prime);
+		_mm256_store_si256(xacc + i, _mm256_add_epi64(product_lo, _mm256_slli_epi64(product_hi, 32)));
+	}
+}
+
+XXH3AccumulateFunction s_xxh3_accumulate = &XXH3AccumulateSSE2;
+XXH3ScrambleFunction s_xxh3_scramble = &XXH3ScrambleSSE2;
+
+#else
+
+void XXH3AccumulateScalar(u64* acc, const u8* input, size_t stride, const u8* secret, u32 count)
+{
+	for (u32 n = 0; n < count; n++, input += stride, secret += 8)
+	{
+		for (int i = 0; i < 8; i++)
+		{
+			u64 data = XXH3Read64(input + 8 * i);
+			u64 key = data ^ XXH3Read64(secret + 8 * i);
+			acc[i ^ 1] += data;
+			acc[i] += (key & 0xFFFFFFFF) * (key >> 32);
+		}
+	}
+}
+
+void XXH3ScrambleScalar(u64* acc, const u8* secret)
+{
+	for (int i = 0; i < 8; i++)
+	{
+		u64 value = acc[i] ^ (acc[i] >> 47);
+		value ^= XXH3Read64(secret + 8 * i);
+		acc[i] = value * XXH_PRIME32_1;
+	}
+}
+
+XXH3AccumulateFunction s_xxh3_accumulate = &XXH3AccumulateScalar;
+XXH3ScrambleFunction s_xxh3_scramble = &XXH3ScrambleScalar;
+
+#endif
+
+// Hashes every step-th stripe of an input longer than 240 bytes, plus the last one
+u64 XXH3HashLong(const u8* input, u32 len, u32 step)
+{
+	alignas(32) u64 acc[8] = {
+		XXH_PRIME32_3, XXH_PRIME64_1, XXH_PRIME64_2, XXH_PRIME64_3,
+		XXH_PRIME64_4, XXH_PRIME32_2, XXH_PRIME64_5, XXH_PRIME32_1 };
+	const u8* secret = s_xxh3_secret;
+	const size_t stride = static_cast<size_t>(step) * XXH3_STRIPE_LEN;
+	const u32 stripes = ((len - 1) / XXH3_STRIPE_LEN + step - 1) / step;
+
+	u32 done = 0;
+	for (; done + XXH3_STRIPES_PER_BLOCK <= stripes; done += XXH3_STRIPES_PER_BLOCK)
+	{
+		s_xxh3_accumulate(acc, input + done * stride, stride, secret, XXH3_STRIPES_PER_BLOCK);
+		s_xxh3_scramble(acc, secret + sizeof(s_xxh3_secret) - XXH3_STRIPE_LEN);
+	}
+	s_xxh3_accumulate(acc, input + done * stride, stride, secret, stripes - done);
+	s_xxh3_accumulate(acc, input + len - XXH3_STRIPE_LEN, 0, secret + sizeof(s_xxh3_secret) - XXH3_STRIPE_LEN - 7, 1);
+
+	u64 result = len * XXH_PRIME64_1;
+	for (int i = 0; i < 4; i++)
+		result += XXH3Mul128Fold64(acc[2 * i] ^ XXH3Read64(secret + 11 + 16 * i), acc[2 * i + 1] ^ XXH3Read64(secret + 11 + 16 * i + 8));
+	return XXH3Avalanche(result);
+}
+}
+
+u64 GetXXHash3(const u8* src, u32 len, u32 samples)
+{
+	if (len <= 16)
+		return XXH3HashShort(src, len);
+	if (len <= 240)
+		return XXH3HashMedium(src, len);
+
+	// Like the other hashes, samples counts 8 byte words, so a stripe covers 8 of them
+	u32 step = 1;
+	if (samples != 0)
+		step = std::max(((len - 1) / XXH3_STRIPE_LEN) / std::max(samples / 8, 1u), 1u);
+	return XXH3HashLong(src, len, step);
+}
+
 u64 GetHash64(const u8* src, u32 len, u32 samples)
 {
 	return ptrHashFunction(src, len, samples);
 }
 
 // sets the hash function used for the texture cache
-void SetHash64Function()
+void SetHash64Function(bool use_xxhash3)
 {
+#ifdef _M_X86
+	if (cpu_info.bAVX2)
+	{
+		s_xxh3_accumulate = &XXH3AccumulateAVX2;
+		s_xxh3_scramble = &XXH3ScrambleAVX2;
+	}
+#endif
+
+	if (use_xxhash3)
+	{
+		ptrHashFunction = &GetXXHash3;
+	}
+	else
 #if _M_SSE >= 0x402
 	if (cpu_info.bSSE4_2) // sse crc32 version
 	{
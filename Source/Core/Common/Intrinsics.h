@@ -28,4 +28,18 @@
 # endif
 #endif
 
+// Lets a single function use AVX2 instructions; callers have to check cpu_info.bAVX2 first.
+#ifdef _MSC_VER
+#define FUNCTION_TARGET_AVX2
+#else
+#define FUNCTION_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+// Same for the AES-NI instructions, guarded by cpu_info.bAES.
+#ifdef _MSC_VER
+#define FUNCTION_TARGET_AES
+#else
+#define FUNCTION_TARGET_AES __attribute__((target("aes")))
+#endif
+
 #endif // _M_X86
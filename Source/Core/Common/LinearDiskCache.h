@@ -4,29 +4,52 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
 #include <cstring>
 #include <fstream>
+#include <memory>
 #include <string>
 #include <type_traits>
+#include <vector>
 
 #include "Common/Common.h"
 #include "Common/CommonTypes.h"
 #include "Common/FileUtil.h"
+#include "Common/MappedFile.h"
+#include "Common/NonCopyable.h"
 
 // On disk format:
 //header{
-// u32 'DCAC';
-// u32 version;  // svn_rev
+// u32 'DCAI';
 // u16 sizeof(key_type);
 // u16 sizeof(value_type);
+// char ver[40];  // scm_rev_cache_str
+// u64 index_offset;  // 0 while the index is missing or stale
 //}
 
+// The log, every entry starts 8 byte aligned:
 //key_value_pair{
 // u32 value_size;
+// u32 entry_number;  // 1-based, the log ends before the first entry breaking the sequence
 // key_type   key;
+// padding to alignof(value_type)
 // value_type[value_size]   value;
+// padding to 8 bytes
 //}
 
+// The index, written after the last entry when the cache is closed:
+//index{
+// u32 entry_count;  // entries in the log
+// u32 dead_count;   // entries replaced by a newer one with the same key
+// u32 slot_count;   // power of two
+// u32 padding;
+// slot{u64 entry_offset; u32 key_hash; u32 value_size;}[slot_count]  // linear probing, offset 0 if empty
+//}
+
+// Caches in the previous format ('DCAC' header, entries of u32 value_size, key, value and
+// u32 entry_number without padding, no index) are migrated when opened.
+
 template <typename K, typename V>
 class LinearDiskCacheReader
 {
@@ -35,11 +58,12 @@ public:
 };
 
 // Dead simple unsorted key-value store with append functionality.
-// No random read functionality, all reading is done in OpenAndRead.
+// Entries are appended to a log. A hashed index of the newest entry of every key is written
+// after the log when the cache is closed, so opening a cache only maps the file and finds the
+// index, and a value is only read when it is looked up.
 // Keys and values can contain any characters, including \0.
 //
 // Suitable for caching generated shader bytecode between executions.
-// Not tuned for extreme performance but should be reasonably fast.
 // Does not support keys or values larger than 2GB, which should be reasonable.
 // Keys must have non-zero length; values can have zero length.
 
@@ -50,11 +74,31 @@ template <typename K, typename V>
 class LinearDiskCache
 {
 public:
-	// return number of read entries
-	u32 OpenAndRead(const std::string& filename, LinearDiskCacheReader<K, V> &reader)
+	struct Entry
+	{
+		K key;
+		const V* value;
+		u32 value_size;
+	};
+
+	// Every entry of a cache file, read in one go by OpenAndReadMapped.
+	// The values point into a mapping of the file and stay valid as long as this object.
+	class MappedEntries : public NonCopyable
+	{
+	public:
+		const std::vector<Entry>& GetEntries() const { return m_entries; }
+
+	private:
+		friend class LinearDiskCache;
+		std::shared_ptr<File::MappedFile> m_file;
+		std::vector<Entry> m_entries;
+	};
+
+	// Opens the cache for lookups and appending without reading the entries.
+	// Old format caches are migrated, files that can't be used are recreated.
+	// Returns the number of keys in the cache.
+	u32 Open(const std::string& filename)
 	{
-		using std::ios_base;
-
 		// Since we're reading/writing directly to the storage of K instances,
 		// K must be trivially copyable. TODO: Remove #if once GCC 5.0 is a
 		// minimum requirement.
@@ -63,70 +107,99 @@ public:
 #else
 		static_assert(std::is_trivially_copyable<K>::value, "K must be a trivially copyable type");
 #endif
+		static_assert(alignof(V) <= 8, "Entries are only 8 byte aligned");
 
 		// close any currently opened file
 		Close();
-		m_num_entries = 0;
-
-		// try opening for reading/writing
-		OpenFStream(m_file, filename, ios_base::in | ios_base::out | ios_base::binary);
-
-		m_file.seekg(0, std::ios::end);
-		std::fstream::pos_type end_pos = m_file.tellg();
-		m_file.seekg(0, std::ios::beg);
-		std::fstream::pos_type start_pos = m_file.tellg();
-		std::streamoff file_size = end_pos - start_pos;
-
 		m_header.Init();
-		if (m_file.is_open() && ValidateHeader())
-		{
-			// good header, read some key/value pairs
-			K key;
+		m_filename = filename;
+		if (LoadFile())
+			return m_live_count;
 
-			V* value = nullptr;
-			u32 value_size = 0;
-			u32 entry_number = 0;
+		CloseFile();
+		m_filename = filename;
+		if (MigrateLegacyFile(filename) && LoadFile())
+			return m_live_count;
 
-			std::fstream::pos_type last_pos = m_file.tellg();
+		// failed to open file for reading or bad header
+		// close and recreate file
+		CloseFile();
+		m_filename = filename;
+		m_header.Init();
+		OpenFStream(m_file, filename, std::ios_base::out | std::ios_base::trunc | std::ios_base::binary);
+		Write(&m_header);
+		m_log_end = sizeof(Header);
+		m_index_dirty = true;
+		return 0;
+	}
 
-			while (Read(&value_size))
-			{
-				std::streamoff next_extent = (last_pos - start_pos) + sizeof(value_size) + value_size;
-				if (next_extent > file_size)
-					break;
+	// Looks key up through the index. The value stays valid until the cache is closed.
+	// Only finds entries that were in the file when it was opened.
+	const V* Find(const K& key, u32* value_size) const
+	{
+		if (m_slots.empty())
+			return nullptr;
+
+		const u8* data = m_mapping->GetData();
+		const u32 hash = HashKey(&key);
+		const u32 slot_count = static_cast<u32>(m_slots.size());
+		const u32 mask = slot_count - 1;
+		for (u32 i = hash & mask, probes = 0; probes < slot_count; i = (i + 1) & mask, probes++)
+		{
+			const IndexSlot& slot = m_slots[i];
+			if (!slot.entry_offset)
+				break;
+			if (slot.key_hash != hash || !IsValidEntry(slot.entry_offset, slot.value_size) ||
+				memcmp(data + slot.entry_offset + KEY_OFFSET, &key, sizeof(K)))
+				continue;
+
+			*value_size = slot.value_size;
+			return reinterpret_cast<const V*>(data + slot.entry_offset + ValueOffset());
+		}
+		return nullptr;
+	}
 
-				delete[] value;
-				value = new V[value_size];
-
-				// read key/value and pass to reader
-				if (Read(&key) &&
-					Read(value, value_size) &&
-					Read(&entry_number) &&
-					entry_number == m_num_entries + 1)
-				{
-					reader.Read(key, value, value_size);
-				}
-				else
-				{
-					break;
-				}
+	// Opens the cache and passes the newest entry of every key to the reader.
+	// return number of read entries
+	u32 OpenAndRead(const std::string& filename, LinearDiskCacheReader<K, V> &reader)
+	{
+		MappedEntries entries;
+		OpenAndReadMapped(filename, &entries);
+		for (const Entry& entry : entries.GetEntries())
+			reader.Read(entry.key, entry.value, entry.value_size);
+		return static_cast<u32>(entries.GetEntries().size());
+	}
 
-				m_num_entries++;
-				last_pos = m_file.tellg();
-			}
-			m_file.seekp(last_pos);
-			m_file.clear();
+	// Same as OpenAndRead, but returns the entries all at once instead of passing them to a reader,
+	// so that the caller can process them in parallel. Entries are in the order they were appended.
+	u32 OpenAndReadMapped(const std::string& filename, MappedEntries* entries)
+	{
+		entries->m_entries.clear();
+		Open(filename);
+		entries->m_file = m_mapping;
 
-			delete[] value;
-			return m_num_entries;
+		std::vector<const IndexSlot*> slots;
+		slots.reserve(m_live_count);
+		for (const IndexSlot& slot : m_slots)
+		{
+			if (slot.entry_offset && IsValidEntry(slot.entry_offset, slot.value_size))
+				slots.push_back(&slot);
 		}
+		std::sort(slots.begin(), slots.end(), [](const IndexSlot* a, const IndexSlot* b)
+		{
+			return a->entry_offset < b->entry_offset;
+		});
 
-		// failed to open file for reading or bad header
-		// close and recreate file
-		Close();
-		m_file.open(filename, ios_base::out | ios_base::trunc | ios_base::binary);
-		WriteHeader();
-		return 0;
+		const u8* data = slots.empty() ? nullptr : m_mapping->GetData();
+		entries->m_entries.resize(slots.size());
+		for (size_t i = 0; i < slots.size(); i++)
+		{
+			Entry& entry = entries->m_entries[i];
+			std::memcpy(&entry.key, data + slots[i]->entry_offset + KEY_OFFSET, sizeof(K));
+			entry.value = reinterpret_cast<const V*>(data + slots[i]->entry_offset + ValueOffset());
+			entry.value_size = slots[i]->value_size;
+		}
+		return static_cast<u32>(slots.size());
 	}
 
 	void Sync()
@@ -134,52 +207,97 @@ public:
 		m_file.flush();
 	}
 
+	// Writes the index and closes the file. Caches with many replaced entries get compacted.
 	void Close()
 	{
-		if (m_file.is_open())
-			m_file.close();
-		// clear any error flags
-		m_file.clear();
+		if (m_file.is_open() && m_index_dirty)
+			WriteIndex();
+
+		const std::string filename = m_filename;
+		const bool compact = m_dead_count >= COMPACT_MIN_DEAD && m_dead_count > m_live_count / 2;
+		CloseFile();
+		if (compact)
+			Compact(filename);
 	}
 
-	// Appends a key-value pair to the store.
+	// Appends a key-value pair to the store. A later entry with the same key replaces this one.
 	void Append(const K& key, const V* value, u32 value_size)
 	{
-		// TODO: Should do a check that we don't already have "key"? (I think each caller does that already.)
+		if (!m_file.is_open())
+			return;
+
+		// A crash from here on leaves a log without an index, which is rebuilt on the next open
+		if (m_header.index_offset)
+		{
+			m_header.index_offset = 0;
+			m_file.seekp(offsetof(Header, index_offset));
+			Write(&m_header.index_offset);
+			m_file.seekp(m_log_end);
+		}
+
+		static const u8 padding[8] = {};
+		const u32 entry_number = m_num_entries + 1;
 		Write(&value_size);
+		Write(&entry_number);
 		Write(&key);
+		Write(padding, static_cast<u32>(ValueOffset() - KEY_OFFSET - sizeof(K)));
 		Write(value, value_size);
+		Write(padding, static_cast<u32>(EntrySize(value_size) - ValueOffset() - value_size * sizeof(V)));
+
+		m_appended.push_back({key, m_log_end, value_size});
 		m_num_entries++;
-		Write(&m_num_entries);
+		m_log_end += EntrySize(value_size);
+		m_index_dirty = true;
 	}
 
-private:
-	void WriteHeader()
+	// Rewrites a cache that is not open with only the newest entry of every key.
+	static bool Compact(const std::string& filename)
 	{
-		Write(&m_header);
+		const std::string temp_filename = filename + ".compact";
+		File::Delete(temp_filename);
+		{
+			LinearDiskCache<K, V> source;
+			MappedEntries entries;
+			source.OpenAndReadMapped(filename, &entries);
+			LinearDiskCache<K, V> target;
+			target.Open(temp_filename);
+			for (const Entry& entry : entries.GetEntries())
+				target.Append(entry.key, entry.value, entry.value_size);
+			target.Close();
+			source.CloseFile();
+		}
+		if (File::Rename(temp_filename, filename))
+			return true;
+		File::Delete(temp_filename);
+		return false;
 	}
 
-	bool ValidateHeader()
+private:
+	struct Header
 	{
-		char file_header[sizeof(Header)];
-
-		return (Read(file_header, sizeof(Header)) &&
-			!memcmp((const char*)&m_header, file_header, sizeof(Header)));
-	}
+		void Init()
+		{
+			std::memset(this, 0, sizeof(*this));
+			// Null-terminator is intentionally not copied.
+			std::memcpy(&id, "DCAI", sizeof(u32));
+			key_t_size = sizeof(K);
+			value_t_size = sizeof(V);
+			std::memcpy(ver, scm_rev_cache_str.c_str(), std::min(scm_rev_cache_str.size(), sizeof(ver)));
+		}
 
-	template <typename D>
-	bool Write(const D* data, u32 count = 1)
-	{
-		return m_file.write((const char*)data, count * sizeof(D)).good();
-	}
+		bool IsCompatible(const Header& other) const
+		{
+			return !memcmp(this, &other, offsetof(Header, index_offset));
+		}
 
-	template <typename D>
-	bool Read(const D* data, u32 count = 1)
-	{
-		return m_file.read((char*)data, count * sizeof(D)).good();
-	}
+		u32 id;
+		u16 key_t_size;
+		u16 value_t_size;
+		char ver[40];
+		u64 index_offset;
+	};
 
-	struct Header
+	struct LegacyHeader
 	{
 		void Init()
 		{
@@ -192,9 +310,297 @@ private:
 		const u16 key_t_size = sizeof(K);
 		const u16 value_t_size = sizeof(V);
 		char ver[40] = {};
+	};
+
+	struct IndexHeader
+	{
+		u32 entry_count;
+		u32 dead_count;
+		u32 slot_count;
+		u32 padding;
+	};
 
-	} m_header;
+	struct IndexSlot
+	{
+		u64 entry_offset;
+		u32 key_hash;
+		u32 value_size;
+	};
+
+	struct AppendedEntry
+	{
+		K key;
+		u64 entry_offset;
+		u32 value_size;
+	};
+
+	static const u64 KEY_OFFSET = 2 * sizeof(u32);
+	// Fewer replaced entries are not worth rewriting the file for
+	static const u32 COMPACT_MIN_DEAD = 64;
+
+	static constexpr u64 AlignUp(u64 value, u64 alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+	static constexpr u64 ValueOffset()
+	{
+		return AlignUp(KEY_OFFSET + sizeof(K), alignof(V));
+	}
+	static constexpr u64 EntrySize(u32 value_size)
+	{
+		return AlignUp(ValueOffset() + static_cast<u64>(value_size) * sizeof(V), 8);
+	}
+
+	// FNV-1a, which unlike GetHash64 gives the same result on every host
+	static u32 HashKey(const void* key)
+	{
+		const u8* bytes = static_cast<const u8*>(key);
+		u32 hash = 2166136261u;
+		for (size_t i = 0; i < sizeof(K); i++)
+			hash = (hash ^ bytes[i]) * 16777619u;
+		return hash;
+	}
+
+	bool IsValidEntry(u64 entry_offset, u32 value_size) const
+	{
+		return entry_offset >= sizeof(Header) && entry_offset % 8 == 0 && entry_offset < m_mapped_log_end &&
+			value_size <= (m_mapped_log_end - entry_offset) / sizeof(V) &&
+			EntrySize(value_size) <= m_mapped_log_end - entry_offset;
+	}
+
+	// Maps the file and finds its index, which is rebuilt from the log if it is stale
+	bool LoadFile()
+	{
+		m_mapping = std::make_shared<File::MappedFile>();
+		if (!m_mapping->Open(m_filename) || m_mapping->GetSize() < sizeof(Header))
+			return false;
+
+		Header header;
+		std::memcpy(&header, m_mapping->GetData(), sizeof(Header));
+		if (!m_header.IsCompatible(header))
+			return false;
+		m_header.index_offset = header.index_offset;
+
+		if (!LoadIndex(header.index_offset))
+		{
+			ScanLog();
+			m_index_dirty = true;
+		}
+
+		// try opening for reading/writing, new entries overwrite the index
+		OpenFStream(m_file, m_filename, std::ios_base::in | std::ios_base::out | std::ios_base::binary);
+		if (!m_file.is_open())
+			return false;
+		m_file.seekp(m_log_end);
+		return true;
+	}
+
+	bool LoadIndex(u64 index_offset)
+	{
+		const u64 file_size = m_mapping->GetSize();
+		if (index_offset < sizeof(Header) || index_offset % 8 != 0 || index_offset > file_size ||
+			file_size - index_offset < sizeof(IndexHeader))
+			return false;
+
+		IndexHeader index;
+		std::memcpy(&index, m_mapping->GetData() + index_offset, sizeof(IndexHeader));
+		if (!index.slot_count || (index.slot_count & (index.slot_count - 1)) ||
+			index.entry_count < index.dead_count || index.entry_count - index.dead_count >= index.slot_count ||
+			(file_size - index_offset - sizeof(IndexHeader)) / sizeof(IndexSlot) < index.slot_count)
+			return false;
+
+		// Copied, since the first append overwrites the index in the file
+		const IndexSlot* slots = reinterpret_cast<const IndexSlot*>(m_mapping->GetData() + index_offset + sizeof(IndexHeader));
+		m_slots.assign(slots, slots + index.slot_count);
+		m_num_entries = index.entry_count;
+		m_dead_count = index.dead_count;
+		m_live_count = index.entry_count - index.dead_count;
+		m_log_end = index_offset;
+		m_mapped_log_end = index_offset;
+		return true;
+	}
+
+	// Rebuilds the index from the log, up to the first incomplete or bad entry
+	void ScanLog()
+	{
+		const u8* data = m_mapping->GetData();
+		const u64 file_size = m_mapping->GetSize();
+		u64 pos = sizeof(Header);
+		std::vector<IndexSlot> slots;
+		m_num_entries = 0;
+		m_dead_count = 0;
+		while (file_size - pos >= ValueOffset())
+		{
+			u32 value_size, entry_number;
+			std::memcpy(&value_size, data + pos, sizeof(u32));
+			std::memcpy(&entry_number, data + pos + sizeof(u32), sizeof(u32));
+			if (entry_number != m_num_entries + 1 || value_size > (file_size - pos) / sizeof(V) ||
+				EntrySize(value_size) > file_size - pos)
+				break;
+
+			slots.push_back({pos, HashKey(data + pos + KEY_OFFSET), value_size});
+			m_num_entries++;
+			pos += EntrySize(value_size);
+		}
+		m_log_end = pos;
+		m_mapped_log_end = pos;
+
+		BuildTable(slots.size());
+		for (const IndexSlot& slot : slots)
+			Insert(slot, data + slot.entry_offset + KEY_OFFSET);
+		m_live_count = m_num_entries - m_dead_count;
+	}
+
+	// Starts an empty table in m_slots for up to count keys
+	void BuildTable(size_t count)
+	{
+		u32 slot_count = 16;
+		while (slot_count < count * 2)
+			slot_count *= 2;
+		m_slots.assign(slot_count, IndexSlot{0, 0, 0});
+		m_slot_keys.assign(slot_count, nullptr);
+	}
+
+	// Adds an entry to m_slots, replacing an older entry with the same key
+	void Insert(const IndexSlot& slot, const u8* key)
+	{
+		const u32 mask = static_cast<u32>(m_slots.size()) - 1;
+		u32 i = slot.key_hash & mask;
+		while (m_slots[i].entry_offset)
+		{
+			if (m_slots[i].key_hash == slot.key_hash && !memcmp(m_slot_keys[i], key, sizeof(K)))
+			{
+				m_dead_count++;
+				break;
+			}
+			i = (i + 1) & mask;
+		}
+		m_slots[i] = slot;
+		m_slot_keys[i] = key;
+	}
+
+	// Writes the index for the log and the appended entries after the last entry
+	void WriteIndex()
+	{
+		std::vector<IndexSlot> old_slots;
+		old_slots.swap(m_slots);
+		const u8* data = old_slots.empty() ? nullptr : m_mapping->GetData();
+		BuildTable(m_live_count + m_appended.size());
+		for (const IndexSlot& slot : old_slots)
+		{
+			if (slot.entry_offset && IsValidEntry(slot.entry_offset, slot.value_size))
+				Insert(slot, data + slot.entry_offset + KEY_OFFSET);
+		}
+		for (const AppendedEntry& entry : m_appended)
+		{
+			Insert({entry.entry_offset, HashKey(&entry.key), entry.value_size},
+				reinterpret_cast<const u8*>(&entry.key));
+		}
+		m_live_count = m_num_entries - m_dead_count;
+
+		const IndexHeader index = {m_num_entries, m_dead_count, static_cast<u32>(m_slots.size()), 0};
+		m_file.seekp(m_log_end);
+		Write(&index);
+		Write(m_slots.data(), static_cast<u32>(m_slots.size()));
+		m_header.index_offset = m_log_end;
+		m_file.seekp(offsetof(Header, index_offset));
+		Write(&m_header.index_offset);
+		m_index_dirty = false;
+	}
+
+	// Converts a cache in the previous format to the current one
+	static bool MigrateLegacyFile(const std::string& filename)
+	{
+		File::MappedFile legacy;
+		LegacyHeader header;
+		header.Init();
+		if (!legacy.Open(filename) || legacy.GetSize() < sizeof(LegacyHeader) ||
+			memcmp(&header, legacy.GetData(), sizeof(LegacyHeader)))
+			return false;
+
+		const std::string temp_filename = filename + ".migrate";
+		File::Delete(temp_filename);
+		{
+			LinearDiskCache<K, V> target;
+			target.Open(temp_filename);
+			const u8* data = legacy.GetData();
+			const u64 file_size = legacy.GetSize();
+			u64 pos = sizeof(LegacyHeader);
+			u32 entry_count = 0;
+			K key;
+			std::vector<V> value;
+			while (file_size - pos >= sizeof(u32) + sizeof(K) + sizeof(u32))
+			{
+				u32 value_size;
+				std::memcpy(&value_size, data + pos, sizeof(u32));
+				const u64 value_pos = pos + sizeof(u32) + sizeof(K);
+				if ((file_size - value_pos - sizeof(u32)) / sizeof(V) < value_size)
+					break;
+				const u64 next_pos = value_pos + static_cast<u64>(value_size) * sizeof(V) + sizeof(u32);
+				u32 entry_number;
+				std::memcpy(&entry_number, data + next_pos - sizeof(u32), sizeof(u32));
+				if (entry_number != ++entry_count)
+					break;
+
+				// Values in the old format need not be aligned
+				std::memcpy(&key, data + pos + sizeof(u32), sizeof(K));
+				value.resize(value_size);
+				std::memcpy(value.data(), data + value_pos, value_size * sizeof(V));
+				target.Append(key, value.data(), value_size);
+				pos = next_pos;
+			}
+			target.Close();
+		}
+		legacy.Close();
+		if (File::Rename(temp_filename, filename))
+			return true;
+		File::Delete(temp_filename);
+		return false;
+	}
+
+	// Closes the file without writing the index
+	void CloseFile()
+	{
+		if (m_file.is_open())
+			m_file.close();
+		// clear any error flags
+		m_file.clear();
+
+		m_mapping.reset();
+		std::vector<IndexSlot>().swap(m_slots);
+		std::vector<const u8*>().swap(m_slot_keys);
+		std::vector<AppendedEntry>().swap(m_appended);
+		m_filename.clear();
+		m_num_entries = 0;
+		m_live_count = 0;
+		m_dead_count = 0;
+		m_log_end = 0;
+		m_mapped_log_end = 0;
+		m_index_dirty = false;
+	}
+
+	template <typename D>
+	bool Write(const D* data, u32 count = 1)
+	{
+		return m_file.write((const char*)data, count * sizeof(D)).good();
+	}
 
+	Header m_header;
 	std::fstream m_file;
-	u32 m_num_entries;
+	std::string m_filename;
+
+	// The file as it was when opened. Only its size is fixed, appending overwrites whatever
+	// followed the log, so the index is kept in m_slots rather than read from the mapping.
+	std::shared_ptr<File::MappedFile> m_mapping;
+	std::vector<IndexSlot> m_slots;
+	std::vector<const u8*> m_slot_keys;
+	// Entries appended since the file was opened, which the index gets on close
+	std::vector<AppendedEntry> m_appended;
+
+	u32 m_num_entries = 0;
+	u32 m_live_count = 0;
+	u32 m_dead_count = 0;
+	u64 m_log_end = 0;
+	u64 m_mapped_log_end = 0;
+	bool m_index_dirty = false;
 };
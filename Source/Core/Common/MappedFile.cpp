@@ -0,0 +1,120 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <string>
+
+#include "Common/CommonTypes.h"
+#include "Common/FileUtil.h"
+#include "Common/Logging/Log.h"
+#include "Common/MappedFile.h"
+#include "Common/StringUtil.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace File
+{
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool MappedFile::Open(const std::string& filename)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFile(UTF8ToTStr(filename).c_str(), GENERIC_READ,
+		FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER size;
+	if (GetFileSizeEx(file, &size) && size.QuadPart > 0 &&
+		static_cast<u64>(size.QuadPart) <= static_cast<size_t>(-1))
+	{
+		HANDLE mapping = CreateFileMapping(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping)
+		{
+			// The view keeps the mapping object alive
+			m_data = static_cast<const u8*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+			CloseHandle(mapping);
+		}
+		m_size = size.QuadPart;
+	}
+	CloseHandle(file);
+#else
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat st;
+	if (fstat(fd, &st) == 0 && st.st_size > 0 &&
+		static_cast<u64>(st.st_size) <= static_cast<size_t>(-1))
+	{
+		void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+		if (view != MAP_FAILED)
+			m_data = static_cast<const u8*>(view);
+		m_size = st.st_size;
+	}
+	close(fd);
+#endif
+
+	if (m_data)
+	{
+		m_mapped = true;
+		return true;
+	}
+	if (m_size == 0)
+		return false;
+
+	// Mapping failed (e.g. no address space left on a 32-bit host), read the file instead
+	WARN_LOG(COMMON, "Could not map %s, reading it into memory", filename.c_str());
+	IOFile file_handle(filename, "rb");
+	m_buffer.resize(static_cast<size_t>(m_size));
+	if (!file_handle.ReadBytes(m_buffer.data(), m_buffer.size()))
+	{
+		Close();
+		return false;
+	}
+	m_data = m_buffer.data();
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (m_mapped)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(m_data);
+#else
+		munmap(const_cast<u8*>(m_data), static_cast<size_t>(m_size));
+#endif
+	}
+	m_data = nullptr;
+	m_size = 0;
+	m_mapped = false;
+	std::vector<u8>().swap(m_buffer);
+}
+
+void MappedFile::WillRead(u64 offset, u64 size) const
+{
+#ifndef _WIN32
+	if (!m_mapped || offset >= m_size)
+		return;
+
+	// madvise wants a page aligned start
+	static const u64 page_size = sysconf(_SC_PAGESIZE);
+	const u64 start = offset - offset % page_size;
+	const u64 end = std::min(offset + size, m_size);
+	madvise(const_cast<u8*>(m_data) + start, static_cast<size_t>(end - start), MADV_WILLNEED);
+#endif
+}
+
+}  // namespace
@@ -0,0 +1,41 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/NonCopyable.h"
+
+namespace File
+{
+// Read-only view of a whole file. The file is memory mapped when possible and read into memory
+// otherwise, so callers always get a pointer to its contents.
+// Only the size is fixed at Open. When the file is mapped, later writes inside the mapped range
+// show up in the view, so data that gets overwritten must be copied out first.
+class MappedFile : public NonCopyable
+{
+public:
+	MappedFile() {}
+	~MappedFile();
+
+	bool Open(const std::string& filename);
+	void Close();
+
+	bool IsOpen() const { return m_data != nullptr; }
+	const u8* GetData() const { return m_data; }
+	u64 GetSize() const { return m_size; }
+	// Hints that [offset, offset + size) is going to be read soon.
+	void WillRead(u64 offset, u64 size) const;
+
+private:
+	const u8* m_data = nullptr;
+	u64 m_size = 0;
+	bool m_mapped = false;
+	std::vector<u8> m_buffer;
+};
+
+}  // namespace
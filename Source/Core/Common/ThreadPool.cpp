@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <deque>
+
 #include "Common/Common.h"
 #include "Common/CPUDetect.h"
 #include "Common/ThreadPool.h"
@@ -6,11 +9,24 @@
 #endif
 using namespace Common;
 
-ThreadPool::ThreadPool(): m_workflag(0), m_workercount(0), m_workers(16)
+// Worker threads are the only ones pushing to and popping from the back of their own deque,
+// other threads take tasks from the front.
+struct ThreadPool::TaskQueue
+{
+	std::mutex lock;
+	std::deque<std::function<void()>> tasks;
+};
+
+// Index of the deque owned by the current thread, -1 for threads outside the pool.
+static thread_local int s_queue_index = -1;
+
+ThreadPool::ThreadPool(): m_next_queue(0), m_queued(0), m_parked(0), m_waiting(0)
 {
 	m_working.store(true);
 	int workers = cpu_info.logical_cpu_count - 1;
 	workers = workers < 1 ? 1 : workers;
+	for (int i = 0; i < workers; i++)
+		m_queues.push_back(std::make_unique<TaskQueue>());
 	for (size_t i = 0; i < workers; i++)
 	{
 		std::thread* current = new std::thread(&ThreadPool::Workloop, std::ref(*this), i);
@@ -23,7 +39,12 @@ ThreadPool::ThreadPool(): m_workflag(0), m_workercount(0), m_workers(16)
 
 ThreadPool::~ThreadPool()
 {
-	m_working.store(false);
+	{
+		std::lock_guard<std::mutex> lk(m_park_mutex);
+		m_working.store(false);
+	}
+	m_park_cv.notify_all();
+	m_done_cv.notify_all();
 	for (u32 i = 0; i < m_workerThreads.size(); i++)
 	{
 		std::thread* current = m_workerThreads[i].get();
@@ -40,117 +61,213 @@ ThreadPool& ThreadPool::Getinstance()
 	return instance;
 }
 
-void ThreadPool::NotifyWorkPending()
+void ThreadPool::Push(std::function<void()>&& func)
 {
-	ThreadPool::Getinstance().m_workflag.fetch_add(2);
+	// Tasks queued by a worker stay on its own deque, where they are likely to run next while
+	// their data is still in the cache. Other threads spread their tasks over all deques.
+	size_t index = s_queue_index >= 0 ? s_queue_index : m_next_queue.fetch_add(1) % m_queues.size();
+	TaskQueue& queue = *m_queues[index];
+	{
+		std::lock_guard<std::mutex> lk(queue.lock);
+		queue.tasks.push_back(std::move(func));
+	}
+	m_queued.fetch_add(1);
+	if (m_parked.load() > 0)
+	{
+		// Taking the lock makes sure a thread that just decided to sleep is waiting already
+		std::lock_guard<std::mutex> lk(m_park_mutex);
+		m_park_cv.notify_one();
+	}
 }
 
-static SpinLock<true> workerLock;
-void ThreadPool::RegisterWorker(IWorker* worker)
-{
-	workerLock.lock();
-	ThreadPool& instance = ThreadPool::Getinstance();
-	size_t count = instance.m_workercount.fetch_add(1);
-	instance.m_workers[count] = worker;
-	workerLock.unlock();
-}
-void ThreadPool::UnregisterWorker(IWorker* worker)
+bool ThreadPool::TryPop(std::function<void()>* func)
 {
-	workerLock.lock();
-	ThreadPool& instance = ThreadPool::Getinstance();
-	u32 count = instance.m_workercount.load();
-	u32 index = 0;
-	for (u32 i = 0; i < count; i++)
+	if (m_queued.load() <= 0)
+		return false;
+
+	const size_t count = m_queues.size();
+	if (s_queue_index >= 0)
+	{
+		TaskQueue& queue = *m_queues[s_queue_index];
+		std::lock_guard<std::mutex> lk(queue.lock);
+		if (!queue.tasks.empty())
+		{
+			*func = std::move(queue.tasks.back());
+			queue.tasks.pop_back();
+			m_queued.fetch_sub(1);
+			return true;
+		}
+	}
+
+	// Steal the oldest task of the other deques, starting after our own
+	const size_t first = s_queue_index >= 0 ? s_queue_index + 1 : 0;
+	for (size_t i = 0; i < count; i++)
 	{
-		if (instance.m_workers[i] == worker)
+		TaskQueue& queue = *m_queues[(first + i) % count];
+		std::lock_guard<std::mutex> lk(queue.lock);
+		if (!queue.tasks.empty())
 		{
-			index = i;
-			break;
+			*func = std::move(queue.tasks.front());
+			queue.tasks.pop_front();
+			m_queued.fetch_sub(1);
+			return true;
 		}
 	}
-	instance.m_workers[index] = instance.m_workers[count - 1];
-	instance.m_workercount.fetch_sub(1);
-	workerLock.unlock();
+	return false;
 }
 
-void ThreadPool::Workloop(ThreadPool &state, size_t ID)
+bool ThreadPool::RunQueuedTask()
 {
-	u32 rest_time = 1;
-	while (state.m_working.load())
+	std::function<void()> func;
+	if (!TryPop(&func))
+		return false;
+	func();
+	return true;
+}
+
+void ThreadPool::WaitFor(const std::atomic<s32>& pending, bool help)
+{
+	while (pending.load() > 0 && m_working.load())
 	{
-		if (state.m_workflag.load() > ID)
+		if (help)
 		{
-			bool worked = false;
-			u32 count = state.m_workercount.load();
-			for (u32 i = 0; i < count; i++)
-			{
-				IWorker* worker = state.m_workers[i];
-				if (worker)
-				{
-					if (worker->NextTask())
-					{
-						worked = true;
-						state.m_workflag.fetch_sub(1);
-					}
-				}
-			}
-			if (worked)
-			{
-				Common::YieldCPU();
+			if (RunQueuedTask())
 				continue;
-			}
-			else if (state.m_workflag.load() > ID)
-			{
-				state.m_workflag.fetch_sub(1);
-			}
-			rest_time = 1;
+			// Sleeps with the workers, so new tasks wake it up as well
+			std::unique_lock<std::mutex> lk(m_park_mutex);
+			m_parked.fetch_add(1);
+			m_park_cv.wait(lk, [&] {
+				return pending.load() <= 0 || m_queued.load() > 0 || !m_working.load();
+			});
+			m_parked.fetch_sub(1);
 		}
 		else
 		{
-			rest_time++;
-			rest_time = rest_time > 5 ? 5 : rest_time;
+			std::unique_lock<std::mutex> lk(m_park_mutex);
+			m_waiting.fetch_add(1);
+			m_done_cv.wait(lk, [&] { return pending.load() <= 0 || !m_working.load(); });
+			m_waiting.fetch_sub(1);
 		}
-		SleepCurrentThread(rest_time);
 	}
 }
 
-AsyncWorker& AsyncWorker::Getinstance()
+void ThreadPool::WakeWaiters()
 {
-	static AsyncWorker intance;
-	return intance;
+	if (m_parked.load() > 0 || m_waiting.load() > 0)
+	{
+		std::lock_guard<std::mutex> lk(m_park_mutex);
+		m_park_cv.notify_all();
+		m_done_cv.notify_all();
+	}
 }
 
-AsyncWorker::AsyncWorker(): m_inputsize(0), m_TaskQueue()
+void ThreadPool::Workloop(ThreadPool &state, size_t ID)
 {
-	ThreadPool::RegisterWorker(this);
+	s_queue_index = static_cast<int>(ID);
+	while (state.m_working.load())
+	{
+		if (state.RunQueuedTask())
+			continue;
+
+		std::unique_lock<std::mutex> lk(state.m_park_mutex);
+		state.m_parked.fetch_add(1);
+		state.m_park_cv.wait(lk, [&state] {
+			return state.m_queued.load() > 0 || !state.m_working.load();
+		});
+		state.m_parked.fetch_sub(1);
+	}
 }
 
-AsyncWorker::~AsyncWorker()
+void ThreadPool::ExecuteAsync(std::function<void()> &&func)
 {
-	ThreadPool::UnregisterWorker(this);
+	Getinstance().Push(std::move(func));
 }
 
-bool AsyncWorker::NextTask()
+u32 ThreadPool::GetThreadCount()
 {
-	if (m_inputsize.load() > 0)
-	{
-		std::function<void()> func;
-		if (m_TaskQueue.try_pop(func))
-		{
-			func();
-			m_inputsize.fetch_sub(1);
-			return true;
-		}
-	}
-	return false;
+	return static_cast<u32>(ThreadPool::Getinstance().m_workerThreads.size()) + 1;
 }
 
-void AsyncWorker::ExecuteAsync(std::function<void()> &&func)
+TaskGroup::TaskGroup(): m_pending(0)
 {
-	AsyncWorker& instance = Getinstance();
-	instance.m_inputsize.fetch_add(1);
-	instance.m_TaskQueue.push(std::move(func));
-	ThreadPool::NotifyWorkPending();
 }
 
+TaskGroup::~TaskGroup()
+{
+	Wait();
+}
 
+void TaskGroup::Run(std::function<void()>&& func)
+{
+	m_pending.fetch_add(1);
+	ThreadPool::Getinstance().Push([this, func = std::move(func)] {
+		func();
+		if (m_pending.fetch_sub(1) == 1)
+			ThreadPool::Getinstance().WakeWaiters();
+	});
+}
+
+void TaskGroup::Wait()
+{
+	ThreadPool::Getinstance().WaitFor(m_pending, true);
+}
+
+namespace
+{
+// More bands than threads, so the calling thread keeps busy while the workers wake up.
+const s32 BANDS_PER_THREAD = 4;
+
+struct ParallelForState
+{
+	std::function<void(s32, s32)> func;
+	s32 begin;
+	s32 end;
+	s32 band_size;
+	s32 band_count;
+	std::atomic<s32> next_band;
+	std::atomic<s32> remaining_bands;
+};
+}
+
+void ThreadPool::ParallelFor(s32 begin, s32 end, s32 min_band_size, const std::function<void(s32, s32)>& func, u32 max_threads)
+{
+	const s32 count = end - begin;
+	if (count <= 0)
+		return;
+	u32 threads = GetThreadCount();
+	if (max_threads > 0)
+		threads = std::min(threads, max_threads);
+	s32 band_count = std::min(static_cast<s32>(threads) * BANDS_PER_THREAD, count / std::max(min_band_size, 1));
+	if (threads < 2 || band_count < 2)
+	{
+		func(begin, end);
+		return;
+	}
+	// The state is shared with the helper tasks, which may only start after this call returned.
+	std::shared_ptr<ParallelForState> state = std::make_shared<ParallelForState>();
+	state->func = func;
+	state->begin = begin;
+	state->end = end;
+	state->band_size = (count + band_count - 1) / band_count;
+	state->band_count = (count + state->band_size - 1) / state->band_size;
+	state->next_band.store(0);
+	state->remaining_bands.store(state->band_count);
+	auto run_bands = [state] {
+		s32 band;
+		while ((band = state->next_band.fetch_add(1)) < state->band_count)
+		{
+			s32 band_begin = state->begin + band * state->band_size;
+			s32 band_end = std::min(band_begin + state->band_size, state->end);
+			state->func(band_begin, band_end);
+			if (state->remaining_bands.fetch_sub(1) == 1)
+				Getinstance().WakeWaiters();
+		}
+	};
+	ThreadPool& instance = Getinstance();
+	u32 helpers = std::min(threads, static_cast<u32>(state->band_count)) - 1;
+	for (u32 i = 0; i < helpers; i++)
+		instance.Push(run_bands);
+	run_bands();
+	// Helpers that didn't start yet find no bands left, there is no need to wait for them.
+	instance.WaitFor(state->remaining_bands, false);
+}
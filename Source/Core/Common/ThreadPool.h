@@ -31,8 +31,12 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 #include <atomic>
+#include <condition_variable>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <vector>
+#include "Common/Common.h"
 #include "Common/Thread.h"
 
 namespace Common
@@ -429,44 +433,69 @@ public:
 	}
 };
 
-class IWorker
+class ThreadPool;
+
+// A set of tasks that can be waited for together.
+class TaskGroup
 {
 public:
-	virtual ~IWorker()
-	{}
-	virtual bool NextTask() = 0;
+	TaskGroup();
+	// Waits for the tasks that are still running.
+	~TaskGroup();
+	// Queues func on the pool, the group counts it until it returned.
+	void Run(std::function<void()>&& func);
+	// Returns once every task of the group finished. The calling thread runs queued pool tasks
+	// while it waits, and sleeps when there are none.
+	void Wait();
+
+private:
+	TaskGroup(TaskGroup const&);
+	void operator=(TaskGroup const&);
+	std::atomic<s32> m_pending;
 };
 
+// Work stealing scheduler. Every worker thread has its own task deque: it runs the newest task
+// it queued itself first, and takes the oldest task of another worker when its own deque is
+// empty. Idle workers sleep until a task is queued.
 class ThreadPool
 {
 private:
+	struct TaskQueue;
 	std::vector<std::unique_ptr<std::thread>> m_workerThreads;
-	std::vector<IWorker*> m_workers;
-	std::atomic<s32> m_workflag;
-	std::atomic<s32> m_workercount;
+	std::vector<std::unique_ptr<TaskQueue>> m_queues;
+	std::atomic<u32> m_next_queue;
+	// Number of queued tasks that no thread took yet
+	std::atomic<s32> m_queued;
+	// Number of threads sleeping until a task is queued, or until what they wait for is done
+	std::atomic<s32> m_parked;
+	std::condition_variable m_park_cv;
+	// Number of threads sleeping only until what they wait for is done
+	std::atomic<s32> m_waiting;
+	std::condition_variable m_done_cv;
+	std::mutex m_park_mutex;
 	std::atomic<bool> m_working;
 	static void Workloop(ThreadPool &state, size_t ID);
 	static ThreadPool &Getinstance();
 	ThreadPool(ThreadPool const&);
 	void operator=(ThreadPool const&);
 	ThreadPool();
+	void Push(std::function<void()>&& func);
+	bool TryPop(std::function<void()>* func);
+	bool RunQueuedTask();
+	// Sleeps until pending reaches zero, running queued tasks meanwhile when help is set.
+	void WaitFor(const std::atomic<s32>& pending, bool help);
+	void WakeWaiters();
+	friend class TaskGroup;
 public:
 	virtual ~ThreadPool();
-	static void NotifyWorkPending();
-	static void RegisterWorker(IWorker* worker);
-	static void UnregisterWorker(IWorker* worker);
-};
-
-class AsyncWorker final: IWorker
-{
-private:
-	std::atomic<s32> m_inputsize;
-	ManyToManyQueue<std::function<void()>, CircularQueue<std::function<void()>>> m_TaskQueue;
-	static AsyncWorker &Getinstance();
-	AsyncWorker();
-public:
-	virtual ~AsyncWorker();
-	bool NextTask() override;
+	// Queues func to run on a worker thread.
 	static void ExecuteAsync(std::function<void()> &&func);
+	// Number of threads that can run pool work, counting the thread waiting for it.
+	static u32 GetThreadCount();
+	// Splits [begin, end) into bands of at least min_band_size elements and runs func(band_begin, band_end)
+	// for each of them on the pool workers and the calling thread, returning once every band is done.
+	// Bands never overlap, so the result doesn't depend on the number of threads.
+	// max_threads limits the number of threads taking part, 0 means no limit.
+	static void ParallelFor(s32 begin, s32 end, s32 min_band_size, const std::function<void(s32, s32)>& func, u32 max_threads = 0);
 };
 }
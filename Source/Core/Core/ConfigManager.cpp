@@ -256,6 +256,8 @@ void SConfig::SaveCoreSettings(IniFile& ini)
 	core->Set("TimingVariance", iTimingVariance);
 	core->Set("CPUCore", iCPUCore);
 	core->Set("Fastmem", bFastmem);
+	core->Set("JITBlockDiskCache", bJITBlockDiskCache);
+	core->Set("DVDReadAheadCacheSize", iDVDReadAheadCacheSize);
 	core->Set("CPUThread", bCPUThread);
 	core->Set("DSPHLE", bDSPHLE);
 	core->Set("SyncOnSkipIdle", bSyncGPUOnSkipIdleHack);
@@ -275,6 +277,10 @@ void SConfig::SaveCoreSettings(IniFile& ini)
 	core->Set("TimeStretching", bTimeStretching);
 	core->Set("RSHACK", bRSHACK);
 	core->Set("Latency", iLatency);
+	core->Set("StateCompression", iStateCompression);
+	core->Set("Rewind", bRewind);
+	core->Set("RewindStates", iRewindStates);
+	core->Set("RewindInterval", iRewindInterval);
 	core->Set("MemcardAPath", m_strMemoryCardA);
 	core->Set("MemcardBPath", m_strMemoryCardB);
 	core->Set("AgpCartAPath", m_strGbaCartA);
@@ -571,6 +577,7 @@ void SConfig::LoadCoreSettings(IniFile& ini)
 	core->Get("CPUCore", &iCPUCore, PowerPC::CORE_INTERPRETER);
 #endif
 	core->Get("Fastmem", &bFastmem, true);
+	core->Get("JITBlockDiskCache", &bJITBlockDiskCache, false);
 	core->Get("DSPHLE", &bDSPHLE, true);
 	core->Get("TimingVariance", &iTimingVariance, 40);
 	core->Get("CPUThread", &bCPUThread, true);
@@ -585,6 +592,10 @@ void SConfig::LoadCoreSettings(IniFile& ini)
 	core->Get("TimeStretching", &bTimeStretching, false);
 	core->Get("RSHACK", &bRSHACK, false);
 	core->Get("Latency", &iLatency, 2);
+	core->Get("StateCompression", &iStateCompression, 0);
+	core->Get("Rewind", &bRewind, false);
+	core->Get("RewindStates", &iRewindStates, 60);
+	core->Get("RewindInterval", &iRewindInterval, 30);
 	core->Get("MemcardAPath", &m_strMemoryCardA);
 	core->Get("MemcardBPath", &m_strMemoryCardB);
 	core->Get("AgpCartAPath", &m_strGbaCartA);
@@ -615,6 +626,7 @@ void SConfig::LoadCoreSettings(IniFile& ini)
 	core->Get("SyncGpuMinDistance", &iSyncGpuMinDistance, -200000);
 	core->Get("SyncGpuOverclock", &fSyncGpuOverclock, 1.0);
 	core->Get("FastDiscSpeed", &bFastDiscSpeed, false);
+	core->Get("DVDReadAheadCacheSize", &iDVDReadAheadCacheSize, 16);
 	core->Get("DCBZ", &bDCBZOFF, false);
 	core->Get("FPRF", &bFPRF, false);
 	core->Get("AccurateNaNs", &bAccurateNaNs, false);
@@ -759,6 +771,7 @@ void SConfig::LoadDefaults()
 	bRunCompareServer = false;
 	bDSPHLE = true;
 	bFastmem = true;
+	bJITBlockDiskCache = false;
 	bFPRF = false;
 	bAccurateNaNs = false;
 	bMMU = false;
@@ -768,6 +781,7 @@ void SConfig::LoadDefaults()
 	bHalfAudioRate = false;
 	bSyncGPU = false;
 	bFastDiscSpeed = false;
+	iDVDReadAheadCacheSize = 16;
 	m_strWiiSDCardPath = File::GetUserPath(F_WIISDCARD_IDX);
 	bEnableMemcardSdWriting = true;
 	SelectedLanguage = 0;
@@ -777,6 +791,10 @@ void SConfig::LoadDefaults()
 	bTimeStretching = false;
 	bRSHACK = false;
 	iLatency = 14;
+	iStateCompression = 0;
+	bRewind = false;
+	iRewindStates = 60;
+	iRewindInterval = 30;
 
 	iPosX = INT_MIN;
 	iPosY = INT_MIN;
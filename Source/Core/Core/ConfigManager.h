@@ -83,6 +83,8 @@ struct SConfig : NonCopyable
 	bool bJITBranchOff = false;
 	bool bJITILTimeProfiling = false;
 	bool bJITILOutputIR = false;
+	// Remember compiled blocks per game and compile them again at boot
+	bool bJITBlockDiskCache = false;
 
 	bool bFastmem;
 	bool bFPRF = false;
@@ -98,6 +100,12 @@ struct SConfig : NonCopyable
 	bool bHLE_BS2 = true;
 	bool bEnableCheats = false;
 	bool bEnableMemcardSdWriting = true;
+	// State::StateCompressionCodec used for new savestates
+	int iStateCompression = 0;
+	// Keep iRewindStates in-memory states, one every iRewindInterval frames
+	bool bRewind = false;
+	int iRewindStates = 60;
+	int iRewindInterval = 30;
 
 	bool bDPL2Decoder = false;
 	bool bTimeStretching = false;
@@ -111,6 +119,8 @@ struct SConfig : NonCopyable
 	bool bDCBZOFF = false;
 	int iBBDumpPort = 0;
 	bool bFastDiscSpeed = false;
+	// Memory for disc data read ahead of sequential streams, in MiB. 0 disables it.
+	int iDVDReadAheadCacheSize = 16;
 	int iVideoRate = 8;
 	bool bHalfAudioRate = false;
 
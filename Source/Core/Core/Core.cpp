@@ -158,6 +158,8 @@ void FrameUpdateOnCPUThread()
 {
 	if (NetPlay::IsNetPlayRunning())
 		NetPlayClient::SendTimeBase();
+
+	State::CaptureRewindState();
 }
 
 // Display messages and return values
@@ -84,6 +84,9 @@ public:
 	// If enabled then all memory updates happen at once before the first frame
 	// Default is disabled
 	void SetEarlyMemoryUpdates(bool enabled) { m_EarlyMemoryUpdates = enabled; }
+	// Number of times the frame range is played before the emulation stops.
+	// 0 (the default) follows the "Loop FIFO replay" setting instead.
+	void SetLoopCount(u32 count) { m_LoopCount = count; }
 	// Callbacks
 	void SetFileLoadedCallback(CallbackFunc callback) { m_FileLoadedCb = callback; }
 	void SetFrameWrittenCallback(CallbackFunc callback) { m_FrameWrittenCb = callback; }
@@ -129,6 +132,8 @@ private:
 	static bool IsHighWatermarkSet();
 
 	bool m_Loop;
+	u32 m_LoopCount;
+	u32 m_LoopsPlayed;
 
 	u32 m_CurrentFrame;
 	u32 m_FrameRangeStart;
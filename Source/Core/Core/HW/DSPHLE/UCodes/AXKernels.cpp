@@ -0,0 +1,182 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "Core/HW/DSPHLE/UCodes/AXKernels.h"
+#include "Common/Intrinsics.h"
+#include "Common/MathUtil.h"
+
+namespace DSP
+{
+namespace HLE
+{
+namespace AXKernels
+{
+u32 ResampleLinearScalar(const s16* input, s16* output, u32 count, u32 curr_pos, u32 ratio)
+{
+	u32 consumed = 0;
+	for (u32 i = 0; i < count; ++i)
+	{
+		curr_pos += ratio;
+		consumed += curr_pos >> 16;
+		curr_pos &= 0xFFFF;
+
+		// Interpolate! If curr_frac is 0, we can simply take the last
+		// sample without any multiplying.
+		u16 curr_frac = curr_pos;
+		u16 inv_curr_frac = -curr_frac;
+		s32 s0 = input[consumed];
+		s32 s1 = input[consumed + 1];
+		if (curr_frac)
+			output[i] = ((s0 * inv_curr_frac) + (s1 * curr_frac)) >> 16;
+		else
+			output[i] = s0;
+	}
+	return curr_pos;
+}
+
+static inline s16 ScaleSample(s16 sample, u16 volume)
+{
+	s32 scaled = ((s32)sample * volume) >> 15;
+	return MathUtil::Clamp(scaled, -32767, 32767);  // -32768 ?
+}
+
+void ApplyVolumeRampScalar(s16* samples, u32 count, u16* volume, u16 delta)
+{
+	for (u32 i = 0; i < count; ++i)
+	{
+		samples[i] = ScaleSample(samples[i], *volume);
+		*volume += delta;
+	}
+}
+
+void MixAddScalar(int* out, const s16* input, u32 count, u16* pvol, s16* dpop, bool ramp)
+{
+	u16& volume = pvol[0];
+	u16 volume_delta = pvol[1];
+
+	// If volume ramping is disabled, set volume_delta to 0. That way, the
+	// mixing loop can avoid testing if volume ramping is enabled at each step,
+	// and just add volume_delta.
+	if (!ramp)
+		volume_delta = 0;
+
+	for (u32 i = 0; i < count; ++i)
+	{
+		s16 sample = ScaleSample(input[i], volume);
+		out[i] += sample;
+		volume += volume_delta;
+
+		*dpop = sample;
+	}
+}
+
+#ifdef _M_X86
+
+// Signed 16 bit times unsigned 16 bit, giving the 32 bit products of the low and high four lanes
+static inline void MultiplySignedUnsigned(__m128i a, __m128i b, __m128i* low, __m128i* high)
+{
+	const __m128i lo = _mm_mullo_epi16(a, b);
+	// The unsigned high half is off by b where a is negative
+	const __m128i hi = _mm_sub_epi16(_mm_mulhi_epu16(a, b), _mm_and_si128(_mm_srai_epi16(a, 15), b));
+	*low = _mm_unpacklo_epi16(lo, hi);
+	*high = _mm_unpackhi_epi16(lo, hi);
+}
+
+// ScaleSample for 8 samples
+static inline __m128i ScaleSamples(__m128i samples, __m128i volumes)
+{
+	__m128i low, high;
+	MultiplySignedUnsigned(samples, volumes, &low, &high);
+	// The products shifted by 15 are within +-65535, so saturating to 16 bits only leaves
+	// the lower bound to fix
+	const __m128i scaled = _mm_packs_epi32(_mm_srai_epi32(low, 15), _mm_srai_epi32(high, 15));
+	return _mm_max_epi16(scaled, _mm_set1_epi16(-32767));
+}
+
+// Volumes for the next 8 samples, wrapping around like the u16 counter does
+static inline __m128i RampVolumes(u16 volume, u16 delta)
+{
+	const __m128i steps = _mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7);
+	return _mm_add_epi16(_mm_set1_epi16(volume), _mm_mullo_epi16(steps, _mm_set1_epi16(delta)));
+}
+
+u32 ResampleLinearSSE2(const s16* input, s16* output, u32 count, u32 curr_pos, u32 ratio)
+{
+	u32 consumed = 0;
+	u32 i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		// Positions depend on each other, gather the inputs of 8 samples first
+		alignas(16) s16 s0[8], s1[8];
+		alignas(16) u16 frac[8];
+		for (u32 j = 0; j < 8; ++j)
+		{
+			curr_pos += ratio;
+			consumed += curr_pos >> 16;
+			curr_pos &= 0xFFFF;
+			frac[j] = curr_pos;
+			s0[j] = input[consumed];
+			s1[j] = input[consumed + 1];
+		}
+
+		const __m128i first = _mm_load_si128((const __m128i*)s0);
+		const __m128i second = _mm_load_si128((const __m128i*)s1);
+		const __m128i curr_frac = _mm_load_si128((const __m128i*)frac);
+		const __m128i inv_curr_frac = _mm_sub_epi16(_mm_setzero_si128(), curr_frac);
+
+		__m128i first_low, first_high, second_low, second_high;
+		MultiplySignedUnsigned(first, inv_curr_frac, &first_low, &first_high);
+		MultiplySignedUnsigned(second, curr_frac, &second_low, &second_high);
+		// Interpolated values are between the two inputs, so they fit in 16 bits
+		const __m128i interpolated =
+			_mm_packs_epi32(_mm_srai_epi32(_mm_add_epi32(first_low, second_low), 16),
+				_mm_srai_epi32(_mm_add_epi32(first_high, second_high), 16));
+
+		const __m128i no_frac = _mm_cmpeq_epi16(curr_frac, _mm_setzero_si128());
+		const __m128i result =
+			_mm_or_si128(_mm_and_si128(no_frac, first), _mm_andnot_si128(no_frac, interpolated));
+		_mm_storeu_si128((__m128i*)(output + i), result);
+	}
+	return ResampleLinearScalar(input + consumed, output + i, count - i, curr_pos, ratio);
+}
+
+void ApplyVolumeRampSSE2(s16* samples, u32 count, u16* volume, u16 delta)
+{
+	u32 i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m128i input = _mm_loadu_si128((const __m128i*)(samples + i));
+		_mm_storeu_si128((__m128i*)(samples + i), ScaleSamples(input, RampVolumes(*volume, delta)));
+		*volume += delta * 8;
+	}
+	ApplyVolumeRampScalar(samples + i, count - i, volume, delta);
+}
+
+void MixAddSSE2(int* out, const s16* input, u32 count, u16* pvol, s16* dpop, bool ramp)
+{
+	u16& volume = pvol[0];
+	const u16 volume_delta = ramp ? pvol[1] : 0;
+
+	u32 i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m128i samples = ScaleSamples(_mm_loadu_si128((const __m128i*)(input + i)),
+			RampVolumes(volume, volume_delta));
+		volume += volume_delta * 8;
+
+		// Sign extend to 32 bits and accumulate
+		const __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16);
+		const __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16);
+		_mm_storeu_si128((__m128i*)(out + i), _mm_add_epi32(_mm_loadu_si128((const __m128i*)(out + i)), low));
+		_mm_storeu_si128((__m128i*)(out + i + 4), _mm_add_epi32(_mm_loadu_si128((const __m128i*)(out + i + 4)), high));
+
+		*dpop = static_cast<s16>(_mm_extract_epi16(samples, 7));
+	}
+	MixAddScalar(out + i, input + i, count - i, pvol, dpop, ramp);
+}
+
+#endif
+}  // namespace AXKernels
+}  // namespace HLE
+}  // namespace DSP
@@ -0,0 +1,64 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "Common/CommonTypes.h"
+
+// Per sample math of the AX voice processing, working on a whole frame of samples at once.
+// The scalar versions are the reference, the SIMD ones must match them bit for bit.
+namespace DSP
+{
+namespace HLE
+{
+namespace AXKernels
+{
+// Linear interpolation of <count> samples. <input> starts with the four last samples of the
+// previous frame, followed by the (curr_pos + ratio * count) >> 16 samples consumed by this
+// frame. curr_pos and ratio are 16.16 fixed point; returns the new position.
+u32 ResampleLinearScalar(const s16* input, s16* output, u32 count, u32 curr_pos, u32 ratio);
+
+// Scales the samples by a volume that changes by <delta> after every sample, clamping the result.
+// <volume> is updated to the volume after the last sample.
+void ApplyVolumeRampScalar(s16* samples, u32 count, u16* volume, u16 delta);
+
+// Add samples to an output buffer, with optional volume ramping. pvol[0] is the volume,
+// pvol[1] the ramp delta; <dpop> receives the last mixed sample.
+void MixAddScalar(int* out, const s16* input, u32 count, u16* pvol, s16* dpop, bool ramp);
+
+#ifdef _M_X86
+u32 ResampleLinearSSE2(const s16* input, s16* output, u32 count, u32 curr_pos, u32 ratio);
+void ApplyVolumeRampSSE2(s16* samples, u32 count, u16* volume, u16 delta);
+void MixAddSSE2(int* out, const s16* input, u32 count, u16* pvol, s16* dpop, bool ramp);
+#endif
+
+inline u32 ResampleLinear(const s16* input, s16* output, u32 count, u32 curr_pos, u32 ratio)
+{
+#ifdef _M_X86
+	return ResampleLinearSSE2(input, output, count, curr_pos, ratio);
+#else
+	return ResampleLinearScalar(input, output, count, curr_pos, ratio);
+#endif
+}
+
+inline void ApplyVolumeRamp(s16* samples, u32 count, u16* volume, u16 delta)
+{
+#ifdef _M_X86
+	ApplyVolumeRampSSE2(samples, count, volume, delta);
+#else
+	ApplyVolumeRampScalar(samples, count, volume, delta);
+#endif
+}
+
+inline void MixAdd(int* out, const s16* input, u32 count, u16* pvol, s16* dpop, bool ramp)
+{
+#ifdef _M_X86
+	MixAddSSE2(out, input, count, pvol, dpop, ramp);
+#else
+	MixAddScalar(out, input, count, pvol, dpop, ramp);
+#endif
+}
+}  // namespace AXKernels
+}  // namespace HLE
+}  // namespace DSP
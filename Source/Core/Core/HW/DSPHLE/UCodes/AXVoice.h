@@ -12,13 +12,14 @@
 #error AXVoice.h included without specifying version
 #endif
 
-#include <functional>
+#include <cstring>
 
 #include "Common/CommonTypes.h"
 #include "Common/MathUtil.h"
 #include "Core/ConfigManager.h"
 #include "Core/HW/DSP.h"
 #include "Core/HW/DSPHLE/UCodes/AX.h"
+#include "Core/HW/DSPHLE/UCodes/AXKernels.h"
 #include "Core/HW/DSPHLE/UCodes/AXStructs.h"
 #include "Core/HW/Memmap.h"
 
@@ -34,6 +35,10 @@ namespace HLE
 #define MAX_SAMPLES_PER_FRAME 96
 #endif
 
+// Frames resampled with a ratio up to this have their input decoded up front
+#define MAX_BATCH_RATIO 0x40000
+#define MAX_BATCH_INPUT_SAMPLES (4 * MAX_SAMPLES_PER_FRAME + 1)
+
 // Put all of that in an anonymous namespace to avoid stupid compilers merging
 // functions from AX GC and AX Wii.
 namespace
@@ -292,7 +297,8 @@ u16 AcceleratorGetSample()
 // We start getting samples not from sample 0, but 0.<curr_pos_frac>. This
 // avoids discontinuities in the audio stream, especially with very low ratios
 // which interpolate a lot of values between two "real" samples.
-u32 ResampleAudio(std::function<s16(u32)> input_callback, s16* output, u32 count, s16* last_samples,
+template <typename InputCallback>
+u32 ResampleAudio(InputCallback input_callback, s16* output, u32 count, s16* last_samples,
 	u32 curr_pos, u32 ratio, int srctype, const s16* coeffs)
 {
 	int read_samples_count = 0;
@@ -416,9 +422,27 @@ void GetInputSamples(PB_TYPE& pb, s16* samples, u16 count, const s16* coeffs)
 
 	if (coeffs)
 		coeffs += pb.coef_select * 0x200;
-	u32 curr_pos =
-		ResampleAudio([](u32) { return AcceleratorGetSample(); }, samples, count, pb.src.last_samples,
-			pb.src.cur_addr_frac, HILO_TO_32(pb.src.ratio), pb.src_type, coeffs);
+
+	const u32 ratio = HILO_TO_32(pb.src.ratio);
+	u32 curr_pos;
+	if ((pb.src_type == SRCTYPE_LINEAR || pb.src_type == SRCTYPE_POLYPHASE) && ratio <= MAX_BATCH_RATIO)
+	{
+		// Decode all the samples the frame consumes first, in the order ResampleAudio would
+		// read them, then interpolate from memory.
+		s16 input[4 + MAX_BATCH_INPUT_SAMPLES];
+		const u32 input_count = static_cast<u32>((pb.src.cur_addr_frac + static_cast<u64>(ratio) * count) >> 16);
+		memcpy(input, pb.src.last_samples, sizeof(pb.src.last_samples));
+		for (u32 i = 0; i < input_count; ++i)
+			input[4 + i] = AcceleratorGetSample();
+
+		curr_pos = AXKernels::ResampleLinear(input, samples, count, pb.src.cur_addr_frac, ratio);
+		memcpy(pb.src.last_samples, input + input_count, sizeof(pb.src.last_samples));
+	}
+	else
+	{
+		curr_pos = ResampleAudio([](u32) { return AcceleratorGetSample(); }, samples, count,
+			pb.src.last_samples, pb.src.cur_addr_frac, ratio, pb.src_type, coeffs);
+	}
 	pb.src.cur_addr_frac = (curr_pos & 0xFFFF);
 
 	// Update current position in the PB.
@@ -429,27 +453,7 @@ void GetInputSamples(PB_TYPE& pb, s16* samples, u16 count, const s16* coeffs)
 // Add samples to an output buffer, with optional volume ramping.
 void MixAdd(int* out, const s16* input, u32 count, u16* pvol, s16* dpop, bool ramp)
 {
-	u16& volume = pvol[0];
-	u16 volume_delta = pvol[1];
-
-	// If volume ramping is disabled, set volume_delta to 0. That way, the
-	// mixing loop can avoid testing if volume ramping is enabled at each step,
-	// and just add volume_delta.
-	if (!ramp)
-		volume_delta = 0;
-
-	for (u32 i = 0; i < count; ++i)
-	{
-		s64 sample = input[i];
-		sample *= volume;
-		sample >>= 15;
-		sample = MathUtil::Clamp((s32)sample, -32767, 32767);  // -32768 ?
-
-		out[i] += (s16)sample;
-		volume += volume_delta;
-
-		*dpop = (s16)sample;
-	}
+	AXKernels::MixAdd(out, input, count, pvol, dpop, ramp);
 }
 
 // Execute a low pass filter on the samples using one history value. Returns
@@ -475,12 +479,7 @@ void ProcessVoice(PB_TYPE& pb, const AXBuffers& buffers, u16 count, AXMixControl
 	GetInputSamples(pb, samples, count, coeffs);
 
 	// Apply a global volume ramp using the volume envelope parameters.
-	for (u32 i = 0; i < count; ++i)
-	{
-		samples[i] = MathUtil::Clamp(((s32)samples[i] * pb.vol_env.cur_volume) >> 15, -32767,
-			32767);  // -32768 ?
-		pb.vol_env.cur_volume += pb.vol_env.cur_volume_delta;
-	}
+	AXKernels::ApplyVolumeRamp(samples, count, &pb.vol_env.cur_volume, pb.vol_env.cur_volume_delta);
 
 	// Optionally, execute a low pass filter
 	// TODO: LPF code is currently broken, causing Super Monkey Ball sound
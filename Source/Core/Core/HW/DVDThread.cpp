@@ -2,8 +2,12 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <atomic>
 #include <cinttypes>
+#include <cstring>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <thread>
 #include <utility>
@@ -19,6 +23,7 @@
 #include "Common/Thread.h"
 #include "Common/Timer.h"
 
+#include "Core/ConfigManager.h"
 #include "Core/Core.h"
 #include "Core/CoreTiming.h"
 #include "Core/HW/DVDInterface.h"
@@ -54,7 +59,14 @@ struct ReadRequest
 	u64 realtime_done_us;
 };
 
-using ReadResult = std::pair<ReadRequest, std::vector<u8>>;
+struct ReadResult
+{
+	ReadRequest request;
+	std::vector<u8> buffer;
+	// Used instead of the buffer when the data can be copied to emulated RAM straight
+	// out of a memory mapped disc image. Keeps the mapping alive.
+	std::shared_ptr<const u8> mapped_data;
+};
 
 static void StartDVDThread();
 static void StopDVDThread();
@@ -79,6 +91,45 @@ static Common::FifoQueue<ReadRequest, false> s_request_queue;
 static Common::FifoQueue<ReadResult, false> s_result_queue;
 static std::map<u64, ReadResult> s_result_map;
 
+// Read-ahead cache for sequential streams (FMVs, streamed audio...). The DVD thread reads the
+// blocks that follow a stream while it has no requests to serve. Only the data source changes,
+// the emulated timing is still decided by DVDInterface.
+// Everything below is only used by the DVD thread, and reset when it starts. That includes
+// every disc and partition change, since those go through WaitUntilIdle.
+static const u64 READ_AHEAD_BLOCK_SIZE = 0x20000;
+static const u64 READ_AHEAD_DISTANCE = 8 * READ_AHEAD_BLOCK_SIZE;
+// A read that starts at most this far after the end of the previous read of a stream continues it
+static const u64 STREAM_MAX_GAP = 0x10000;
+// Number of reads continuing a stream before it gets prefetched
+static const u32 STREAM_MIN_READS = 2;
+static const size_t MAX_STREAMS = 4;
+
+struct CachedBlock
+{
+	std::vector<u8> data;
+	u64 last_use;
+};
+
+struct Stream
+{
+	u64 last_offset;
+	u64 end;
+	bool decrypt;
+	u32 reads;
+	u64 last_use;
+	u64 prefetch_next;
+	u64 prefetch_end;
+};
+
+static std::map<std::pair<u64, bool>, CachedBlock> s_read_ahead_cache;
+static size_t s_read_ahead_max_blocks;
+static std::vector<Stream> s_streams;
+static u64 s_read_ahead_use_counter;
+
+static std::atomic<u64> s_read_ahead_hits;
+static std::atomic<u64> s_read_ahead_misses;
+static std::atomic<u64> s_read_ahead_prefetched_bytes;
+
 void Start()
 {
 	s_finish_read = CoreTiming::RegisterEvent("FinishReadDVDThread", FinishRead);
@@ -92,6 +143,10 @@ void Start()
 	// much, because this will never get exposed to the emulated game.
 	s_next_id = 0;
 
+	s_read_ahead_hits = 0;
+	s_read_ahead_misses = 0;
+	s_read_ahead_prefetched_bytes = 0;
+
 	StartDVDThread();
 }
 
@@ -99,12 +154,35 @@ static void StartDVDThread()
 {
 	_assert_(!s_dvd_thread.joinable());
 	s_dvd_thread_exiting.Clear();
+
+	s_read_ahead_cache.clear();
+	s_streams.clear();
+	s_read_ahead_use_counter = 0;
+	const int cache_size_mb = std::max(SConfig::GetInstance().iDVDReadAheadCacheSize, 0);
+	s_read_ahead_max_blocks = static_cast<size_t>(cache_size_mb) * 1024 * 1024 / READ_AHEAD_BLOCK_SIZE;
+
 	s_dvd_thread = std::thread(DVDThread);
 }
 
 void Stop()
 {
 	StopDVDThread();
+
+	const ReadAheadStats stats = GetReadAheadStats();
+	if (stats.hits + stats.misses != 0)
+	{
+		INFO_LOG(DVDINTERFACE, "Read-ahead cache: %" PRIu64 " hits, %" PRIu64 " misses, %" PRIu64
+			" bytes prefetched", stats.hits, stats.misses, stats.prefetched_bytes);
+	}
+}
+
+ReadAheadStats GetReadAheadStats()
+{
+	ReadAheadStats stats;
+	stats.hits = s_read_ahead_hits.load();
+	stats.misses = s_read_ahead_misses.load();
+	stats.prefetched_bytes = s_read_ahead_prefetched_bytes.load();
+	return stats;
 }
 
 static void StopDVDThread()
@@ -133,13 +211,27 @@ void DoState(PointerWrap& p)
 	// This won't affect the behavior of FinishRead.
 	ReadResult result;
 	while (s_result_queue.Pop(result))
-		s_result_map.emplace(result.first.id, std::move(result));
+		s_result_map.emplace(result.request.id, std::move(result));
 
 	// Everything is now in s_result_map, so we simply savestate that.
+	// Results are saved as (request, data) pairs, which means copying out
+	// the data of reads that point into a memory mapped image.
 	// We also savestate s_next_id to avoid ID collisions.
-	p.Do(s_result_map);
+	std::map<u64, std::pair<ReadRequest, std::vector<u8>>> results;
+	for (auto& entry : s_result_map)
+	{
+		ReadResult& r = entry.second;
+		if (r.mapped_data)
+			r.buffer.assign(r.mapped_data.get(), r.mapped_data.get() + r.request.length);
+		results.emplace(entry.first, std::make_pair(r.request, std::move(r.buffer)));
+	}
+	p.Do(results);
 	p.Do(s_next_id);
 
+	s_result_map.clear();
+	for (auto& entry : results)
+		s_result_map.emplace(entry.first, ReadResult{entry.second.first, std::move(entry.second.second), nullptr});
+
 	// TODO: Savestates can be smaller if the buffers of results aren't saved,
 	// but instead get re-read from the disc when loading the savestate.
 
@@ -228,16 +320,16 @@ static void FinishRead(u64 id, s64 cycles_late)
 			while (!s_result_queue.Pop(result))
 				s_result_queue_expanded.Wait();
 
-			if (result.first.id == id)
+			if (result.request.id == id)
 				break;
 			else
-				s_result_map.emplace(result.first.id, std::move(result));
+				s_result_map.emplace(result.request.id, std::move(result));
 		}
 	}
 	// We have now obtained the right ReadResult.
 
-	const ReadRequest& request = result.first;
-	const std::vector<u8>& buffer = result.second;
+	const ReadRequest& request = result.request;
+	const std::vector<u8>& buffer = result.buffer;
 
 	DEBUG_LOG(DVDINTERFACE, "Disc has been read. Real time: %" PRIu64 " us. "
 		"Real time including delay: %" PRIu64 " us. "
@@ -247,7 +339,7 @@ static void FinishRead(u64 id, s64 cycles_late)
 		(CoreTiming::GetTicks() - request.time_started_ticks) /
 		(SystemTimers::GetTicksPerSecond() / 1000000));
 
-	if (buffer.empty())
+	if (buffer.empty() && !result.mapped_data)
 	{
 		PanicAlertT("The disc could not be read (at 0x%" PRIx64 " - 0x%" PRIx64 ").",
 			request.dvd_offset, request.dvd_offset + request.length);
@@ -255,7 +347,10 @@ static void FinishRead(u64 id, s64 cycles_late)
 	else
 	{
 		if (request.copy_to_ram)
-			Memory::CopyToEmu(request.output_address, buffer.data(), request.length);
+		{
+			Memory::CopyToEmu(request.output_address,
+				result.mapped_data ? result.mapped_data.get() : buffer.data(), request.length);
+		}
 	}
 
 	// Notify the emulated software that the command has been executed
@@ -263,13 +358,139 @@ static void FinishRead(u64 id, s64 cycles_late)
 		buffer);
 }
 
+// Copies the request from the cache if all of it is there
+static bool ReadFromCache(const ReadRequest& request, u8* buffer)
+{
+	const u64 end = request.dvd_offset + request.length;
+	const u64 first_block = request.dvd_offset - request.dvd_offset % READ_AHEAD_BLOCK_SIZE;
+	for (u64 block = first_block; block < end; block += READ_AHEAD_BLOCK_SIZE)
+	{
+		if (!s_read_ahead_cache.count(std::make_pair(block, request.decrypt)))
+			return false;
+	}
+
+	for (u64 block = first_block; block < end; block += READ_AHEAD_BLOCK_SIZE)
+	{
+		CachedBlock& cached = s_read_ahead_cache[std::make_pair(block, request.decrypt)];
+		cached.last_use = ++s_read_ahead_use_counter;
+
+		const u64 copy_start = std::max(block, request.dvd_offset);
+		const u64 copy_end = std::min(block + READ_AHEAD_BLOCK_SIZE, end);
+		memcpy(buffer + (copy_start - request.dvd_offset), cached.data.data() + (copy_start - block),
+			static_cast<size_t>(copy_end - copy_start));
+	}
+	return true;
+}
+
+// Finds the stream the request belongs to, and extends its prefetch window
+static void UpdateStreams(const ReadRequest& request)
+{
+	const u64 end = request.dvd_offset + request.length;
+	auto stream = std::find_if(s_streams.begin(), s_streams.end(), [&](const Stream& s) {
+		return s.decrypt == request.decrypt && request.dvd_offset >= s.last_offset &&
+			request.dvd_offset <= s.end + STREAM_MAX_GAP;
+	});
+
+	if (stream == s_streams.end())
+	{
+		// Start a new stream, replacing the least recently used one
+		if (s_streams.size() < MAX_STREAMS)
+		{
+			s_streams.emplace_back();
+			stream = s_streams.end() - 1;
+		}
+		else
+		{
+			stream = std::min_element(s_streams.begin(), s_streams.end(),
+				[](const Stream& a, const Stream& b) { return a.last_use < b.last_use; });
+		}
+		stream->decrypt = request.decrypt;
+		stream->reads = 0;
+		stream->prefetch_next = 0;
+		stream->prefetch_end = 0;
+	}
+	else
+	{
+		stream->reads++;
+	}
+
+	stream->last_offset = request.dvd_offset;
+	stream->end = end;
+	stream->last_use = ++s_read_ahead_use_counter;
+
+	if (stream->reads >= STREAM_MIN_READS)
+	{
+		// Keep half the cache for the blocks that are being read
+		const u64 distance = std::min<u64>(READ_AHEAD_DISTANCE, s_read_ahead_max_blocks / 2 * READ_AHEAD_BLOCK_SIZE);
+		stream->prefetch_next = std::max(stream->prefetch_next, end - end % READ_AHEAD_BLOCK_SIZE);
+		stream->prefetch_end = end + distance;
+		DVDInterface::GetVolume().WillRead(end, distance, request.decrypt);
+	}
+}
+
+static bool HasPrefetchWork()
+{
+	return std::any_of(s_streams.begin(), s_streams.end(),
+		[](const Stream& stream) { return stream.prefetch_next < stream.prefetch_end; });
+}
+
+// Reads one block ahead of a stream into the cache
+static void PrefetchBlock()
+{
+	for (Stream& stream : s_streams)
+	{
+		while (stream.prefetch_next < stream.prefetch_end)
+		{
+			const u64 block = stream.prefetch_next;
+			stream.prefetch_next += READ_AHEAD_BLOCK_SIZE;
+
+			const auto key = std::make_pair(block, stream.decrypt);
+			auto it = s_read_ahead_cache.find(key);
+			if (it != s_read_ahead_cache.end())
+			{
+				it->second.last_use = ++s_read_ahead_use_counter;
+				continue;
+			}
+
+			// Mapped images don't need the cache, getting the mapped data pages it in
+			const DiscIO::IVolume& volume = DVDInterface::GetVolume();
+			if (volume.GetMappedData(block, READ_AHEAD_BLOCK_SIZE, stream.decrypt))
+				return;
+
+			std::vector<u8> data(READ_AHEAD_BLOCK_SIZE);
+			if (!volume.Read(block, READ_AHEAD_BLOCK_SIZE, data.data(), stream.decrypt))
+			{
+				// Most likely the end of the disc or partition
+				stream.prefetch_end = stream.prefetch_next;
+				break;
+			}
+
+			while (s_read_ahead_cache.size() >= s_read_ahead_max_blocks)
+			{
+				s_read_ahead_cache.erase(std::min_element(s_read_ahead_cache.begin(), s_read_ahead_cache.end(),
+					[](const std::pair<const std::pair<u64, bool>, CachedBlock>& a,
+						const std::pair<const std::pair<u64, bool>, CachedBlock>& b) {
+					return a.second.last_use < b.second.last_use;
+				}));
+			}
+			CachedBlock& cached = s_read_ahead_cache[key];
+			cached.data = std::move(data);
+			cached.last_use = ++s_read_ahead_use_counter;
+			s_read_ahead_prefetched_bytes += READ_AHEAD_BLOCK_SIZE;
+			return;
+		}
+	}
+}
+
 static void DVDThread()
 {
 	Common::SetCurrentThreadName("DVD thread");
 
 	while (true)
 	{
-		s_request_queue_expanded.Wait();
+		// Blocks are only prefetched when there are no requests to serve
+		if (!HasPrefetchWork())
+			s_request_queue_expanded.Wait();
 
 		if (s_dvd_thread_exiting.IsSet())
 			return;
@@ -277,19 +498,49 @@ static void DVDThread()
 		ReadRequest request;
 		while (s_request_queue.Pop(request))
 		{
-			std::vector<u8> buffer(request.length);
-			const DiscIO::IVolume& volume = DVDInterface::GetVolume();
-			if (!volume.Read(request.dvd_offset, request.length, buffer.data(), request.decrypt))
-				buffer.resize(0);
+			std::vector<u8> buffer;
+			std::shared_ptr<const u8> mapped_data;
+			if (request.copy_to_ram)
+				mapped_data = DVDInterface::GetVolume().GetMappedData(request.dvd_offset, request.length, request.decrypt);
+
+			if (mapped_data)
+			{
+				// FinishRead copies the data to emulated RAM
+				if (s_read_ahead_max_blocks != 0)
+					UpdateStreams(request);
+			}
+			else if (s_read_ahead_max_blocks == 0)
+			{
+				buffer.resize(request.length);
+				if (!DVDInterface::GetVolume().Read(request.dvd_offset, request.length, buffer.data(), request.decrypt))
+					buffer.resize(0);
+			}
+			else
+			{
+				buffer.resize(request.length);
+				if (ReadFromCache(request, buffer.data()))
+				{
+					s_read_ahead_hits++;
+				}
+				else
+				{
+					s_read_ahead_misses++;
+					if (!DVDInterface::GetVolume().Read(request.dvd_offset, request.length, buffer.data(), request.decrypt))
+						buffer.resize(0);
+				}
+				UpdateStreams(request);
+			}
 
 			request.realtime_done_us = Common::Timer::GetTimeUs();
 
-			s_result_queue.Push(ReadResult(std::move(request), std::move(buffer)));
+			s_result_queue.Push(ReadResult{std::move(request), std::move(buffer), std::move(mapped_data)});
 			s_result_queue_expanded.Set();
 
 			if (s_dvd_thread_exiting.IsSet())
 				return;
 		}
+
+		PrefetchBlock();
 	}
 }
 }
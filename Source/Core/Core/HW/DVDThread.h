@@ -23,4 +23,13 @@ void StartRead(u64 dvd_offset, u32 length, bool decrypt, DVDInterface::ReplyType
 	s64 ticks_until_completion);
 void StartReadToEmulatedRAM(u32 output_address, u64 dvd_offset, u32 length, bool decrypt,
 	DVDInterface::ReplyType reply_type, s64 ticks_until_completion);
+
+struct ReadAheadStats
+{
+	u64 hits;
+	u64 misses;
+	u64 prefetched_bytes;
+};
+// Counters of the read-ahead cache since the emulation started
+ReadAheadStats GetReadAheadStats();
 }
@@ -139,6 +139,7 @@ const std::string hotkey_labels[] = {
 		_trans("Undo Save State"),
 		_trans("Save State"),
 		_trans("Load State"),
+		_trans("Rewind State"),
 		_trans("Reload Post-Processing Shaders"),		
 };
 static_assert(NUM_HOTKEYS == sizeof(hotkey_labels) / sizeof(hotkey_labels[0]),
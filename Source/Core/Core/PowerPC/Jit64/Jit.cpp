@@ -594,6 +594,30 @@ void Jit64::Jit(u32 em_address)
 	blocks.FinalizeBlock(block_num, jo.enableBlocklink, DoJit(em_address, &code_buffer, b, nextPC));
 }
 
+JitBase::PrecompileResult Jit64::Precompile(u32 em_address, u32 physical_address)
+{
+	// Stop well before Jit() would clear the cache, so that precompiling never throws away
+	// blocks the game compiled itself. This should leave room for many of the biggest blocks.
+	const size_t reserve = 0x100000;
+	if (m_cleanup_after_stackfault || GetSpaceLeft() < reserve || m_far_code.GetSpaceLeft() < reserve ||
+		trampolines.GetSpaceLeft() < reserve || blocks.IsFull() ||
+		SConfig::GetInstance().bJITNoBlockCache || SConfig::GetInstance().bEnableDebugging)
+	{
+		return PrecompileResult::Stopped;
+	}
+
+	analyzer.SetOption(PPCAnalyst::PPCAnalyzer::OPTION_HOST_READ);
+	u32 nextPC = analyzer.Analyze(em_address, &code_block, &code_buffer, code_buffer.GetSize());
+	analyzer.ClearOption(PPCAnalyst::PPCAnalyzer::OPTION_HOST_READ);
+	if (code_block.m_memory_exception)
+		return PrecompileResult::Skipped;
+
+	int block_num = blocks.AllocateBlock(em_address, physical_address);
+	JitBlock* b = blocks.GetBlock(block_num);
+	blocks.FinalizeBlock(block_num, jo.enableBlocklink, DoJit(em_address, &code_buffer, b, nextPC));
+	return PrecompileResult::Compiled;
+}
+
 const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer* code_buf, JitBlock* b, u32 nextPC)
 {
 	js.firstFPInstructionFound = false;
@@ -65,6 +65,7 @@ public:
 	// Jit!
 
 	void Jit(u32 em_address) override;
+	PrecompileResult Precompile(u32 em_address, u32 physical_address) override;
 	const u8* DoJit(u32 em_address, PPCAnalyst::CodeBuffer* code_buf, JitBlock* b, u32 nextPC);
 
 	BitSet32 CallerSavedRegistersInUse() const;
@@ -119,6 +119,22 @@ public:
 
 	virtual void Jit(u32 em_address) = 0;
 
+	enum class PrecompileResult
+	{
+		Compiled,
+		// The code can't be read without faulting
+		Skipped,
+		// No room for more blocks without clearing the cache, or not supported by this JIT
+		Stopped,
+	};
+	// Compiles the block at em_address for the current MSR before the CPU executes it. Unlike
+	// Jit(), this never raises exceptions, touches the TLB or the instruction cache, or clears
+	// the cache.
+	virtual PrecompileResult Precompile(u32 em_address, u32 physical_address)
+	{
+		return PrecompileResult::Stopped;
+	}
+
 	virtual const CommonAsmRoutinesBase* GetAsmRoutines() = 0;
 
 	virtual bool HandleFault(uintptr_t access_address, SContext* ctx) = 0;
@@ -0,0 +1,172 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <utility>
+
+#include "Common/FileUtil.h"
+#include "Common/Hash.h"
+#include "Common/Logging/Log.h"
+#include "Common/StringUtil.h"
+#include "Common/Thread.h"
+#include "Core/HW/Memmap.h"
+#include "Core/PowerPC/JitCommon/JitBlockDiskCache.h"
+#include "Core/PowerPC/JitCommon/JitCache.h"
+
+static const u32 CACHE_FILE_MAGIC = 0x424A5444;  // "DTJB"
+static const u32 CACHE_FILE_VERSION = 1;
+
+struct CacheFileHeader
+{
+	u32 magic;
+	u32 version;
+	u32 entry_count;
+	u32 entry_size;
+};
+
+// Only returns code that is entirely in RAM, so it can be hashed without faulting.
+static const u8* GetCodePointer(u32 physical_address, u32 size)
+{
+	const u32 address = physical_address & 0x3FFFFFFF;
+	if (address < Memory::REALRAM_SIZE && size <= Memory::REALRAM_SIZE - address)
+		return Memory::m_pRAM + address;
+	const u32 exram_address = address & 0x0FFFFFFF;
+	if (Memory::m_pEXRAM && (address >> 28) == 0x1 && exram_address < Memory::EXRAM_SIZE &&
+		size <= Memory::EXRAM_SIZE - exram_address)
+	{
+		return Memory::m_pEXRAM + exram_address;
+	}
+	return nullptr;
+}
+
+static bool HashCode(u32 physical_address, u32 num_instructions, u64* hash)
+{
+	const u8* code = GetCodePointer(physical_address, num_instructions * 4);
+	if (!code || num_instructions == 0)
+		return false;
+	*hash = GetMurmurHash3(code, num_instructions * 4, 0);
+	return true;
+}
+
+JitBlockDiskCache::~JitBlockDiskCache()
+{
+	if (m_load_thread.joinable())
+		m_load_thread.join();
+}
+
+void JitBlockDiskCache::Load(const std::string& game_id)
+{
+	Reset();
+	if (game_id.empty())
+		return;
+
+	m_enabled = true;
+	m_filename = StringFromFormat("%sJitBlocks/%s.jbc", File::GetUserPath(D_CACHE_IDX).c_str(),
+		game_id.c_str());
+	m_load_thread = std::thread(&JitBlockDiskCache::LoadThread, this, m_filename);
+}
+
+void JitBlockDiskCache::LoadThread(std::string filename)
+{
+	Common::SetCurrentThreadName("JIT Cache Loader");
+
+	File::IOFile file(filename, "rb");
+	CacheFileHeader header;
+	if (file && file.ReadArray(&header, 1) && header.magic == CACHE_FILE_MAGIC &&
+		header.version == CACHE_FILE_VERSION && header.entry_size == sizeof(Entry))
+	{
+		m_loaded_entries.resize(header.entry_count);
+		if (!file.ReadArray(m_loaded_entries.data(), m_loaded_entries.size()))
+			m_loaded_entries.clear();
+	}
+	INFO_LOG(DYNA_REC, "Loaded %zu cached JIT blocks from %s", m_loaded_entries.size(),
+		filename.c_str());
+	m_loaded.store(true);
+}
+
+void JitBlockDiskCache::Save()
+{
+	if (!m_enabled)
+		return;
+
+	// Blocks that were never reached this time are kept for the next run
+	std::vector<Entry> entries;
+	if (m_load_thread.joinable())
+		m_load_thread.join();
+	entries = std::move(m_loaded_entries);
+	for (const auto& pending : m_pending)
+		entries.push_back(pending.second);
+	std::unordered_map<u64, Entry> all = std::move(m_recorded);
+	for (const Entry& entry : entries)
+		all.emplace(static_cast<u64>(entry.msr_bits) << 32 | entry.effective_address, entry);
+
+	entries.clear();
+	entries.reserve(all.size());
+	for (const auto& entry : all)
+		entries.push_back(entry.second);
+
+	File::CreateFullPath(m_filename);
+	File::IOFile file(m_filename, "wb");
+	CacheFileHeader header = { CACHE_FILE_MAGIC, CACHE_FILE_VERSION,
+		static_cast<u32>(entries.size()), sizeof(Entry) };
+	if (!file || !file.WriteArray(&header, 1) || !file.WriteArray(entries.data(), entries.size()))
+		ERROR_LOG(DYNA_REC, "Failed to write the JIT block cache %s", m_filename.c_str());
+
+	Reset();
+}
+
+void JitBlockDiskCache::Reset()
+{
+	if (m_load_thread.joinable())
+		m_load_thread.join();
+	m_enabled = false;
+	m_loaded.store(false);
+	m_loaded_entries.clear();
+	m_pending.clear();
+	m_recorded.clear();
+}
+
+void JitBlockDiskCache::Record(const JitBlock& block)
+{
+	if (!m_enabled)
+		return;
+
+	Entry entry;
+	entry.effective_address = block.effectiveAddress;
+	entry.physical_address = block.physicalAddress;
+	entry.msr_bits = block.msrBits;
+	entry.num_instructions = block.originalSize;
+	if (HashCode(entry.physical_address, entry.num_instructions, &entry.hash))
+		m_recorded[static_cast<u64>(entry.msr_bits) << 32 | entry.effective_address] = entry;
+}
+
+bool JitBlockDiskCache::TakeLoadedEntries(std::vector<Entry>* entries)
+{
+	if (!m_enabled || !m_loaded.load())
+		return false;
+
+	m_load_thread.join();
+	m_loaded.store(false);
+	*entries = std::move(m_loaded_entries);
+	m_loaded_entries.clear();
+	return true;
+}
+
+void JitBlockDiskCache::AddPending(const Entry& entry)
+{
+	m_pending.emplace(entry.physical_address >> PAGE_SHIFT, entry);
+}
+
+void JitBlockDiskCache::TakePendingEntries(u32 physical_address, std::vector<Entry>* entries)
+{
+	auto range = m_pending.equal_range(physical_address >> PAGE_SHIFT);
+	for (auto it = range.first; it != range.second; ++it)
+		entries->push_back(it->second);
+	m_pending.erase(range.first, range.second);
+}
+
+bool JitBlockDiskCache::Matches(const Entry& entry)
+{
+	u64 hash;
+	return HashCode(entry.physical_address, entry.num_instructions, &hash) && hash == entry.hash;
+}
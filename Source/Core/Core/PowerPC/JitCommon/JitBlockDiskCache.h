@@ -0,0 +1,69 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+
+struct JitBlock;
+
+// Remembers the blocks compiled while a game runs, so they can be compiled again right when the
+// game is booted the next time instead of when they are first executed.
+// A block is only precompiled while the guest code it was built from is unchanged in memory.
+class JitBlockDiskCache
+{
+public:
+	struct Entry
+	{
+		u32 effective_address;
+		u32 physical_address;
+		u32 msr_bits;
+		// Length of the block found by PPCAnalyst, the hash covers as many instructions
+		u32 num_instructions;
+		u64 hash;
+	};
+
+	~JitBlockDiskCache();
+
+	// Reads the entries of the given game on a background thread.
+	void Load(const std::string& game_id);
+	// Writes the recorded entries and the ones that were never precompiled, and forgets them.
+	void Save();
+	bool IsEnabled() const { return m_enabled; }
+
+	void Record(const JitBlock& block);
+
+	// Returns all entries once the background thread has read them, false before and after that.
+	bool TakeLoadedEntries(std::vector<Entry>* entries);
+	// Entries that couldn't be compiled yet wait until code in the same page is executed.
+	void AddPending(const Entry& entry);
+	void TakePendingEntries(u32 physical_address, std::vector<Entry>* entries);
+
+	// Whether the guest code of the entry is in memory.
+	static bool Matches(const Entry& entry);
+
+private:
+	static constexpr u32 PAGE_SHIFT = 12;
+
+	void LoadThread(std::string filename);
+	void Reset();
+
+	bool m_enabled = false;
+	std::string m_filename;
+	std::thread m_load_thread;
+	std::atomic<bool> m_loaded{ false };
+	std::vector<Entry> m_loaded_entries;
+
+	// physical page -> entry
+	std::multimap<u32, Entry> m_pending;
+	// (msr_bits << 32 | effective_address) -> entry
+	std::unordered_map<u64, Entry> m_recorded;
+};
@@ -9,9 +9,10 @@
 // performance hit, it's not enabled by default, but it's useful for
 // locating performance issues.
 
+#include <algorithm>
 #include <cstring>
-#include <map>
 #include <utility>
+#include <vector>
 
 #include "Common/CommonTypes.h"
 #include "Common/JitRegister.h"
@@ -48,12 +49,16 @@ void JitBaseBlockCache::Init()
 
 	iCache.fill(0);
 	Clear();
+
+	if (SConfig::GetInstance().bJITBlockDiskCache)
+		m_disk_cache.Load(SConfig::GetInstance().GetGameID());
 }
 
 void JitBaseBlockCache::Shutdown()
 {
 	num_blocks = 1;
 
+	m_disk_cache.Save();
 	JitRegister::Shutdown();
 }
 
@@ -120,11 +125,16 @@ int* JitBaseBlockCache::GetICache()
 }
 
 int JitBaseBlockCache::AllocateBlock(u32 em_address)
+{
+	return AllocateBlock(em_address, PowerPC::JitCache_TranslateAddress(em_address).address);
+}
+
+int JitBaseBlockCache::AllocateBlock(u32 em_address, u32 physical_address)
 {
 	JitBlock& b = blocks[num_blocks];
 	b.invalid = false;
 	b.effectiveAddress = em_address;
-	b.physicalAddress = PowerPC::JitCache_TranslateAddress(em_address).address;
+	b.physicalAddress = physical_address;
 	b.msrBits = MSR & JitBlock::JIT_CACHE_MSR_MASK;
 	b.linkData.clear();
 	num_blocks++;  // commit the current block
@@ -141,9 +151,7 @@ void JitBaseBlockCache::FinalizeBlock(int block_num, bool block_link, const u8*
 		// is called both with DR/IR enabled or disabled.
 		WARN_LOG(DYNA_REC, "Invalidating compiled block at same address %08x", b.physicalAddress);
 		int old_block_num = start_block_map[b.physicalAddress];
-		const JitBlock& old_b = blocks[old_block_num];
-		block_map.erase(
-			std::make_pair(old_b.physicalAddress + 4 * old_b.originalSize - 1, old_b.physicalAddress));
+		RemoveBlockFromPages(old_block_num);
 		DestroyBlock(old_block_num, true);
 	}
 	start_block_map[b.physicalAddress] = block_num;
@@ -154,19 +162,22 @@ void JitBaseBlockCache::FinalizeBlock(int block_num, bool block_link, const u8*
 	for (u32 block = pAddr / 32; block <= (pAddr + (b.originalSize - 1) * 4) / 32; ++block)
 		valid_block.Set(block);
 
-	block_map[std::make_pair(pAddr + 4 * b.originalSize - 1, pAddr)] = block_num;
+	const u32 last_page = (pAddr + 4 * b.originalSize - 1) >> BLOCK_MAP_PAGE_SHIFT;
+	for (u32 page = pAddr >> BLOCK_MAP_PAGE_SHIFT; page <= last_page; ++page)
+		block_map[page].push_back(block_num);
 
 	if (block_link)
 	{
 		for (const auto& e : b.linkData)
 		{
-			links_to.emplace(e.exitAddress, block_num);
+			links_to[e.exitAddress].push_back(block_num);
 		}
 
 		LinkBlock(block_num);
 	}
 
 	JitRegister::Register(b.checkedEntry, b.codeSize, "JIT_PPC_%08x", b.physicalAddress);
+	m_disk_cache.Record(b);
 }
 
 int JitBaseBlockCache::GetBlockNumberFromStartAddress(u32 addr, u32 msr)
@@ -181,8 +192,12 @@ int JitBaseBlockCache::GetBlockNumberFromStartAddress(u32 addr, u32 msr)
 		}
 		translated_addr = translated.address;
 	}
+	return GetBlockNumberFromPhysicalAddress(addr, translated_addr, msr);
+}
 
-	auto map_result = start_block_map.find(translated_addr);
+int JitBaseBlockCache::GetBlockNumberFromPhysicalAddress(u32 addr, u32 physical_addr, u32 msr)
+{
+	auto map_result = start_block_map.find(physical_addr);
 	if (map_result == start_block_map.end())
 		return -1;
 	int block_num = map_result->second;
@@ -228,16 +243,45 @@ void JitBaseBlockCache::InvalidateICache(u32 address, const u32 length, bool for
 	}
 
 	// destroy JIT blocks
-	// !! this works correctly under assumption that any two overlapping blocks end at the same
-	// address
-	if (destroy_block)
+	if (destroy_block && length != 0)
 	{
-		auto it = block_map.lower_bound(std::make_pair(pAddr, 0));
-		while (it != block_map.end() && it->first.second < pAddr + length)
+		// Collect the blocks first, destroying them modifies the page lists
+		const u64 end = static_cast<u64>(pAddr) + length;
+		const u32 first_page = pAddr >> BLOCK_MAP_PAGE_SHIFT;
+		const u32 last_page = static_cast<u32>((end - 1) >> BLOCK_MAP_PAGE_SHIFT);
+		auto collect = [&](const std::vector<int>& list) {
+			for (int block_num : list)
+			{
+				const JitBlock& b = blocks[block_num];
+				if (b.physicalAddress + 4 * b.originalSize > pAddr && b.physicalAddress < end)
+					invalidated_blocks.push_back(block_num);
+			}
+		};
+		if (last_page - first_page >= block_map.size())
+		{
+			// Huge ranges, e.g. the whole address space, are cheaper to check block by block
+			for (const auto& page_blocks : block_map)
+				collect(page_blocks.second);
+		}
+		else
+		{
+			for (u32 page = first_page; page <= last_page; ++page)
+			{
+				auto page_blocks = block_map.find(page);
+				if (page_blocks != block_map.end())
+					collect(page_blocks->second);
+			}
+		}
+
+		// Blocks spanning several pages are found more than once
+		for (int block_num : invalidated_blocks)
 		{
-			DestroyBlock(it->second, true);
-			it = block_map.erase(it);
+			if (blocks[block_num].invalid)
+				continue;
+			RemoveBlockFromPages(block_num);
+			DestroyBlock(block_num, true);
 		}
+		invalidated_blocks.clear();
 
 		// If the code was actually modified, we need to clear the relevant entries from the
 		// FIFO write address cache, so we don't end up with FIFO checks in places they shouldn't
@@ -298,24 +342,28 @@ void JitBaseBlockCache::LinkBlock(int i)
 {
 	LinkBlockExits(i);
 	const JitBlock& b = blocks[i];
-	auto ppp = links_to.equal_range(b.effectiveAddress);
+	auto sources = links_to.find(b.effectiveAddress);
+	if (sources == links_to.end())
+		return;
 
-	for (auto iter = ppp.first; iter != ppp.second; ++iter)
+	for (int source : sources->second)
 	{
-		const JitBlock& b2 = blocks[iter->second];
+		const JitBlock& b2 = blocks[source];
 		if (b.msrBits == b2.msrBits)
-			LinkBlockExits(iter->second);
+			LinkBlockExits(source);
 	}
 }
 
 void JitBaseBlockCache::UnlinkBlock(int i)
 {
 	JitBlock& b = blocks[i];
-	auto ppp = links_to.equal_range(b.effectiveAddress);
+	auto sources = links_to.find(b.effectiveAddress);
+	if (sources == links_to.end())
+		return;
 
-	for (auto iter = ppp.first; iter != ppp.second; ++iter)
+	for (int source : sources->second)
 	{
-		JitBlock& sourceBlock = blocks[iter->second];
+		JitBlock& sourceBlock = blocks[source];
 		if (sourceBlock.msrBits != b.msrBits)
 			continue;
 
@@ -351,25 +399,49 @@ void JitBaseBlockCache::DestroyBlock(int block_num, bool invalidate)
 	UnlinkBlock(block_num);
 
 	// Delete linking addresses
-	auto it = links_to.equal_range(b.effectiveAddress);
-	while (it.first != it.second)
+	for (const auto& e : b.linkData)
 	{
-		if (it.first->second == block_num)
-			it.first = links_to.erase(it.first);
-		else
-			it.first++;
+		auto sources = links_to.find(e.exitAddress);
+		if (sources == links_to.end())
+			continue;
+		std::vector<int>& list = sources->second;
+		list.erase(std::remove(list.begin(), list.end(), block_num), list.end());
+		if (list.empty())
+			links_to.erase(sources);
 	}
 
 	// Raise an signal if we are going to call this block again
 	WriteDestroyBlock(b);
 }
 
+void JitBaseBlockCache::RemoveBlockFromPages(int block_num)
+{
+	const JitBlock& b = blocks[block_num];
+	const u32 last_page = (b.physicalAddress + 4 * b.originalSize - 1) >> BLOCK_MAP_PAGE_SHIFT;
+	for (u32 page = b.physicalAddress >> BLOCK_MAP_PAGE_SHIFT; page <= last_page; ++page)
+	{
+		auto page_blocks = block_map.find(page);
+		if (page_blocks == block_map.end())
+			continue;
+		std::vector<int>& list = page_blocks->second;
+		auto it = std::find(list.begin(), list.end(), block_num);
+		if (it != list.end())
+		{
+			*it = list.back();
+			list.pop_back();
+		}
+		if (list.empty())
+			block_map.erase(page_blocks);
+	}
+}
+
 void JitBaseBlockCache::MoveBlockIntoFastCache(u32 addr, u32 msr)
 {
 	int block_num = GetBlockNumberFromStartAddress(addr, msr);
 	if (block_num < 0)
 	{
 		Jit(addr);
+		PrecompileCachedBlocks(addr);
 	}
 	else
 	{
@@ -378,6 +450,65 @@ void JitBaseBlockCache::MoveBlockIntoFastCache(u32 addr, u32 msr)
 	}
 }
 
+// This runs on the CPU thread, right after the first block cache miss once the entries are
+// loaded. Compiling on another thread would need the CPU thread stopped anyway: the emitters, the
+// code space the CPU is executing from, the block links and iCache are only ever touched by it,
+// and the dispatcher reads them without locks.
+void JitBaseBlockCache::PrecompileCachedBlocks(u32 em_address)
+{
+	const SConfig& config = SConfig::GetInstance();
+	if (!m_disk_cache.IsEnabled() || config.bEnableDebugging || config.bJITNoBlockCache)
+		return;
+
+	std::vector<JitBlockDiskCache::Entry> entries;
+	if (!m_disk_cache.TakeLoadedEntries(&entries))
+	{
+		auto translated = PowerPC::JitCache_HostTranslateAddress(em_address);
+		if (!translated.valid)
+			return;
+		m_disk_cache.TakePendingEntries(translated.address, &entries);
+	}
+	if (entries.empty())
+		return;
+
+	// The blocks are translated and compiled for their own address translation mode. MSR is the
+	// only PowerPC state this changes, the code is read without raising exceptions or going
+	// through the TLB or the instruction cache.
+	const u32 msr = MSR;
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		const JitBlockDiskCache::Entry& entry = entries[i];
+		MSR = (msr & ~JitBlock::JIT_CACHE_MSR_MASK) | entry.msr_bits;
+		auto translated = PowerPC::JitCache_HostTranslateAddress(entry.effective_address);
+		if (translated.valid && GetBlockNumberFromPhysicalAddress(entry.effective_address,
+			translated.address, MSR) >= 0)
+		{
+			continue;
+		}
+
+		// Code that isn't loaded yet, or was replaced, is tried again once it is executed
+		if (!translated.valid || translated.address != entry.physical_address ||
+			!JitBlockDiskCache::Matches(entry))
+		{
+			m_disk_cache.AddPending(entry);
+			continue;
+		}
+
+		// Leave room for the blocks the game compiles itself; the rest is kept for the next run
+		JitBase::PrecompileResult result = JitBase::PrecompileResult::Stopped;
+		if (GetNumBlocks() < MAX_NUM_BLOCKS - PRECOMPILE_BLOCK_RESERVE)
+			result = m_jit.Precompile(entry.effective_address, entry.physical_address);
+		if (result == JitBase::PrecompileResult::Stopped)
+		{
+			for (; i < entries.size(); i++)
+				m_disk_cache.AddPending(entries[i]);
+			break;
+		}
+		// Skipped blocks are compiled the usual way once the CPU gets to them
+	}
+	MSR = msr;
+}
+
 int& JitBaseBlockCache::FastLookupEntryForAddress(u32 address)
 {
 	return iCache[(address >> 2) & iCache_Mask];
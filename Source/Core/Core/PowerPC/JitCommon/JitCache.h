@@ -6,11 +6,12 @@
 
 #include <array>
 #include <bitset>
-#include <map>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 #include "Common/CommonTypes.h"
+#include "Core/PowerPC/JitCommon/JitBlockDiskCache.h"
 
 class JitBase;
 
@@ -113,6 +114,9 @@ public:
 	static constexpr int MAX_NUM_BLOCKS = 65536 * 2;
 	static constexpr u32 iCache_Num_Elements = 0x10000;
 	static constexpr u32 iCache_Mask = iCache_Num_Elements - 1;
+	static constexpr u32 BLOCK_MAP_PAGE_SHIFT = 12;
+	// Blocks that precompiling leaves free, see PrecompileCachedBlocks
+	static constexpr int PRECOMPILE_BLOCK_RESERVE = MAX_NUM_BLOCKS / 8;
 
 	explicit JitBaseBlockCache(JitBase& jit);
 	virtual ~JitBaseBlockCache();
@@ -132,6 +136,7 @@ public:
 	int* GetICache();
 
 	int AllocateBlock(u32 em_address);
+	int AllocateBlock(u32 em_address, u32 physical_address);
 	void FinalizeBlock(int block_num, bool block_link, const u8* code_ptr);
 
 	// Look for the block in the slow but accurate way.
@@ -159,9 +164,15 @@ private:
 	void LinkBlock(int i);
 	void UnlinkBlock(int i);
 	void DestroyBlock(int block_num, bool invalidate);
+	void RemoveBlockFromPages(int block_num);
+	int GetBlockNumberFromPhysicalAddress(u32 em_address, u32 physical_address, u32 msr);
 
 	void MoveBlockIntoFastCache(u32 em_address, u32 msr);
 
+	// Compiles the blocks from the disk cache that belong to the code at em_address,
+	// or all of them the first time after they were loaded.
+	void PrecompileCachedBlocks(u32 em_address);
+
 	// Fast but risky block lookup based on iCache.
 	int& FastLookupEntryForAddress(u32 address);
 
@@ -172,16 +183,17 @@ private:
 
 	// links_to hold all exit points of all valid blocks in a reverse way.
 	// It is used to query all blocks which links to an address.
-	std::multimap<u32, int> links_to;  // destination_PC -> number
+	std::unordered_map<u32, std::vector<int>> links_to;  // destination_PC -> numbers
 
-	// Map indexed by the physical memory location.
-	// It is used to invalidate blocks based on memory location.
-	std::map<std::pair<u32, u32>, u32> block_map;  // (end_addr, start_addr) -> number
+	// Blocks bucketed by the pages of physical memory they cover, a block is listed in every page
+	// it overlaps. It is used to invalidate blocks based on memory location.
+	std::unordered_map<u32, std::vector<int>> block_map;  // physical_page -> numbers
+	// Scratch list for InvalidateICache, kept to avoid allocating on every call.
+	std::vector<int> invalidated_blocks;
 
 	// Map indexed by the physical address of the entry point.
 	// This is used to query the block based on the current PC in a slow way.
-	// TODO: This is redundant with block_map, and both should be a multimap.
-	std::map<u32, u32> start_block_map;  // start_addr -> number
+	std::unordered_map<u32, u32> start_block_map;  // start_addr -> number
 
 	// This bitsets shows which cachelines overlap with any blocks.
 	// It is used to provide a fast way to query if no icache invalidation is needed.
@@ -190,4 +202,7 @@ private:
 	// This array is indexed with the masked PC and likely holds the correct block id.
 	// This is used as a fast cache of start_block_map used in the assembly dispatcher.
 	std::array<int, iCache_Num_Elements> iCache;  // start_addr & mask -> number
+
+	// Blocks compiled in earlier runs of the same game, see SConfig::bJITBlockDiskCache.
+	JitBlockDiskCache m_disk_cache;
 };
@@ -406,6 +406,33 @@ TryReadInstResult TryReadInstruction(u32 address)
 	return TryReadInstResult{ true, from_bat, hex };
 }
 
+TryReadInstResult HostTryReadInstruction(const u32 address)
+{
+	auto translated = JitCache_HostTranslateAddress(address);
+	if (!translated.valid)
+		return TryReadInstResult{ false, false, 0 };
+
+	const u32 physical_address = translated.address;
+	u32 hex;
+	if (Memory::m_pFakeVMEM && ((physical_address & 0xFE000000) == 0x7E000000))
+	{
+		hex = bswap(*(const u32*)&Memory::m_pFakeVMEM[physical_address & Memory::FAKEVMEM_MASK]);
+	}
+	else
+	{
+		// Memory::Read_U32 complains about anything else
+		const u32 segment = physical_address >> 28;
+		const u32 offset = physical_address & 0x0FFFFFFF;
+		if (!(segment == 0x0 && offset < Memory::REALRAM_SIZE) &&
+			!(Memory::m_pEXRAM && segment == 0x1 && offset < Memory::EXRAM_SIZE))
+		{
+			return TryReadInstResult{ false, false, 0 };
+		}
+		hex = PowerPC::ppcState.iCache.PeekInstruction(physical_address);
+	}
+	return TryReadInstResult{ true, translated.from_bat, hex };
+}
+
 u32 HostRead_Instruction(const u32 address)
 {
 	UGeckoInstruction inst = HostRead_U32(address);
@@ -802,6 +829,19 @@ TranslateResult JitCache_TranslateAddress(u32 address)
 	return TranslateResult{ true, from_bat, tlb_addr.address };
 }
 
+TranslateResult JitCache_HostTranslateAddress(u32 address)
+{
+	if (!UReg_MSR(MSR).IR)
+		return TranslateResult{ true, true, address };
+
+	auto tlb_addr = TranslateAddress<FLAG_OPCODE_NO_EXCEPTION>(address);
+	if (!tlb_addr.Success())
+		return TranslateResult{ false, false, 0 };
+
+	bool from_bat = tlb_addr.result == TranslateAddressResult::BAT_TRANSLATED;
+	return TranslateResult{ true, from_bat, tlb_addr.address };
+}
+
 // *********************************************************************************
 // Warning: Test Area
 //
@@ -1240,7 +1280,7 @@ void IBATUpdated()
 template <const XCheckTLBFlag flag>
 static TranslateAddressResult TranslateAddress(const u32 address)
 {
-	u32 bat_result = (flag == FLAG_OPCODE ? ibat_table : dbat_table)[address >> BAT_INDEX_SHIFT];
+	u32 bat_result = (IsOpcodeFlag(flag) ? ibat_table : dbat_table)[address >> BAT_INDEX_SHIFT];
 	if (bat_result & 1)
 	{
 		u32 result_addr = (bat_result & ~3) | (address & 0x0001FFFF);
@@ -657,7 +657,8 @@ u32 PPCAnalyzer::Analyze(u32 address, CodeBlock* block, CodeBuffer* buffer, u32
 
 	for (u32 i = 0; i < blockSize; ++i)
 	{
-		auto result = PowerPC::TryReadInstruction(address);
+		auto result = HasOption(OPTION_HOST_READ) ? PowerPC::HostTryReadInstruction(address) :
+			PowerPC::TryReadInstruction(address);
 		if (!result.valid)
 		{
 			if (i == 0)
@@ -213,6 +213,10 @@ public:
 
 		// Reorder cror instructions next to their associated fcmp.
 		OPTION_CROR_MERGE = (1 << 6),
+
+		// Read the instructions with PowerPC::HostTryReadInstruction, for blocks compiled before
+		// the CPU gets to them. Code that can't be read that way is a memory exception.
+		OPTION_HOST_READ = (1 << 7),
 	};
 
 	PPCAnalyzer() : m_options(0) {}
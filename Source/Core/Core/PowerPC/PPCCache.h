@@ -32,6 +32,8 @@ struct InstructionCache
 
 	InstructionCache();
 	u32 ReadInstruction(u32 addr);
+	// Returns what ReadInstruction would, without loading the line into the cache.
+	u32 PeekInstruction(u32 addr) const;
 	void Invalidate(u32 addr);
 	void Init();
 	void Reset();
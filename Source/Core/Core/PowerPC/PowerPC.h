@@ -234,6 +234,9 @@ struct TryReadInstResult
 	u32 hex;
 };
 TryReadInstResult TryReadInstruction(const u32 address);
+// Same as TryReadInstruction, but leaves the instruction cache, the TLB and the page table
+// untouched, so that code can be read before the CPU executes it. Only reads RAM.
+TryReadInstResult HostTryReadInstruction(const u32 address);
 
 u8 Read_U8(const u32 address);
 u16 Read_U16(const u32 address);
@@ -284,6 +287,8 @@ struct TranslateResult
 	u32 address;
 };
 TranslateResult JitCache_TranslateAddress(u32 address);
+// Same as JitCache_TranslateAddress, without updating the TLB or the page table.
+TranslateResult JitCache_HostTranslateAddress(u32 address);
 
 static const int BAT_INDEX_SHIFT = 17;
 using BatTable = std::array<u32, 1 << (32 - BAT_INDEX_SHIFT)>;  // 128 KB
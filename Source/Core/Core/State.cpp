@@ -2,6 +2,11 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <cstring>
+#include <deque>
 #include <lzo/lzo1x.h>
 #include <map>
 #include <mutex>
@@ -9,15 +14,19 @@
 #include <thread>
 #include <utility>
 #include <vector>
+#include <zlib.h>
 
 #include "Common/ChunkFile.h"
 #include "Common/CommonTypes.h"
 #include "Common/Event.h"
 #include "Common/FileUtil.h"
+#include "Common/Flag.h"
+#include "Common/Logging/Log.h"
 #include "Common/MsgHandler.h"
 #include "Common/ScopeGuard.h"
 #include "Common/StringUtil.h"
 #include "Common/Thread.h"
+#include "Common/ThreadPool.h"
 #include "Common/Timer.h"
 
 #include "Core/ConfigManager.h"
@@ -34,6 +43,7 @@
 
 #include "VideoCommon/AVIDump.h"
 #include "VideoCommon/OnScreenDisplay.h"
+#include "VideoCommon/Statistics.h"
 #include "VideoCommon/VideoBackendBase.h"
 
 namespace State
@@ -48,12 +58,23 @@ static const u32 IN_LEN = 128 * 1024u;
 
 static const u32 OUT_LEN = IN_LEN + (IN_LEN / 16) + 64 + 3;
 
+// Only used to read states written before the chunked format
 static unsigned char __LZO_MMODEL out[OUT_LEN];
 
-#define HEAP_ALLOC(var, size)                                                                      \
-  lzo_align_t __LZO_MMODEL var[((size) + (sizeof(lzo_align_t) - 1)) / sizeof(lzo_align_t)]
+// Compressed states start with a ChunkedStateHeader after the StateHeader. Its magic is larger than
+// any block of the old single threaded LZO format can be, which is how the two are told apart.
+// Every chunk is stored as its compressed size followed by the data, chunks that don't get any
+// smaller are stored uncompressed. Chunks are independent, so they are (de)compressed in parallel.
+static const u32 CHUNKED_STATE_MAGIC = 0x4B484353;  // "SCHK"
+static const u32 STATE_CHUNK_SIZE = 1024 * 1024;
 
-static HEAP_ALLOC(wrkmem, LZO1X_1_MEM_COMPRESS);
+struct ChunkedStateHeader
+{
+	u32 magic;
+	u32 codec;
+	u32 chunk_size;
+	u32 chunk_count;
+};
 
 static std::string g_last_filename;
 
@@ -70,8 +91,26 @@ static Common::Event g_compressAndDumpStateSyncEvent;
 
 static std::thread g_save_thread;
 
+// The newest rewind state is kept as is. Older ones are stored as their XOR with the next newer
+// state, compressed in chunks. Only a small part of RAM changes between two captures, so the XOR
+// is mostly zeros and compresses well, and the next newer state is all that is needed to restore it.
+struct RewindDelta
+{
+	// Size of the older state. Bytes past the end of the newer state are XORed with zero.
+	u32 size;
+	std::vector<std::vector<u8>> chunks;
+};
+
+static std::mutex s_rewind_mutex;
+static std::vector<u8> s_rewind_newest;
+static std::deque<RewindDelta> s_rewind_deltas;
+static size_t s_rewind_memory = 0;
+static int s_rewind_frame_count = 0;
+static Common::Flag s_rewind_capture_pending;
+static std::thread s_rewind_thread;
+
 // Don't forget to increase this after doing changes on the savestate system
-static const u32 STATE_VERSION = 68;  // Last changed in PR 4638
+static const u32 STATE_VERSION = 69;  // Last changed for the chunked state format
 
 																			// Maps savestate versions to Dolphin versions.
 																			// Versions after 42 don't need to be added to this list,
@@ -278,11 +317,130 @@ static std::map<double, int> GetSavedStates()
 	return m;
 }
 
+static void CompressChunk(u32 codec, const u8* src, u32 src_size, std::vector<u8>* dst)
+{
+	bool compressed = false;
+	if (codec == STATE_CODEC_ZLIB)
+	{
+		uLongf dst_size = compressBound(src_size);
+		dst->resize(dst_size);
+		compressed = compress2(dst->data(), &dst_size, src, src_size, Z_DEFAULT_COMPRESSION) == Z_OK;
+		dst->resize(dst_size);
+	}
+	else
+	{
+		std::vector<lzo_align_t> wrkmem((LZO1X_1_MEM_COMPRESS + sizeof(lzo_align_t) - 1) / sizeof(lzo_align_t));
+		lzo_uint dst_size = 0;
+		dst->resize(src_size + (src_size / 16) + 64 + 3);
+		compressed = lzo1x_1_compress(src, src_size, dst->data(), &dst_size, wrkmem.data()) == LZO_E_OK;
+		dst->resize(dst_size);
+	}
+
+	if (!compressed || dst->size() >= src_size)
+		dst->assign(src, src + src_size);
+}
+
+static bool DecompressChunk(u32 codec, const u8* src, u32 src_size, u8* dst, u32 dst_size)
+{
+	if (src_size == dst_size)
+	{
+		memcpy(dst, src, dst_size);
+		return true;
+	}
+
+	if (codec == STATE_CODEC_ZLIB)
+	{
+		uLongf out_size = dst_size;
+		return uncompress(dst, &out_size, src, src_size) == Z_OK && out_size == dst_size;
+	}
+	else if (codec == STATE_CODEC_LZO)
+	{
+		lzo_uint out_size = dst_size;
+		return lzo1x_decompress_safe(src, src_size, dst, &out_size, nullptr) == LZO_E_OK &&
+			out_size == dst_size;
+	}
+	return false;
+}
+
+static void WriteChunkedState(File::IOFile& f, const u8* buffer_data, size_t buffer_size, u32 codec)
+{
+	const u32 chunk_count = static_cast<u32>((buffer_size + STATE_CHUNK_SIZE - 1) / STATE_CHUNK_SIZE);
+	ChunkedStateHeader chunked_header = { CHUNKED_STATE_MAGIC, codec, STATE_CHUNK_SIZE, chunk_count };
+	f.WriteArray(&chunked_header, 1);
+
+	// Compress a few chunks per thread at a time and write them out before starting on the next
+	// batch, so the compressed copy never has to be held in memory as a whole
+	const u32 batch_size = Common::ThreadPool::GetThreadCount() * 2;
+	std::vector<std::vector<u8>> compressed(batch_size);
+	for (u32 first = 0; first < chunk_count; first += batch_size)
+	{
+		const u32 count = std::min(batch_size, chunk_count - first);
+		Common::ThreadPool::ParallelFor(0, count, 1, [&](s32 begin, s32 end) {
+			for (s32 i = begin; i < end; ++i)
+			{
+				const size_t offset = static_cast<size_t>(first + i) * STATE_CHUNK_SIZE;
+				const u32 size = static_cast<u32>(std::min<size_t>(STATE_CHUNK_SIZE, buffer_size - offset));
+				CompressChunk(codec, buffer_data + offset, size, &compressed[i]);
+			}
+		});
+		for (u32 i = 0; i < count; ++i)
+		{
+			const u32 size = static_cast<u32>(compressed[i].size());
+			f.WriteArray(&size, 1);
+			f.WriteBytes(compressed[i].data(), size);
+		}
+	}
+}
+
+static bool ReadChunkedState(File::IOFile& f, std::vector<u8>& buffer)
+{
+	ChunkedStateHeader chunked_header;
+	if (!f.ReadArray(&chunked_header, 1) || chunked_header.magic != CHUNKED_STATE_MAGIC ||
+		chunked_header.chunk_size == 0 ||
+		chunked_header.chunk_count != (buffer.size() + chunked_header.chunk_size - 1) / chunked_header.chunk_size)
+	{
+		return false;
+	}
+
+	std::vector<u8> data(f.GetSize() - f.Tell());
+	if (!f.ReadBytes(data.data(), data.size()))
+		return false;
+
+	// Find where each chunk starts, so they can be decompressed independently
+	std::vector<std::pair<size_t, u32>> chunks(chunked_header.chunk_count);
+	size_t position = 0;
+	for (auto& chunk : chunks)
+	{
+		u32 size;
+		if (data.size() - position < sizeof(size))
+			return false;
+		memcpy(&size, &data[position], sizeof(size));
+		position += sizeof(size);
+		if (data.size() - position < size)
+			return false;
+		chunk = std::make_pair(position, size);
+		position += size;
+	}
+
+	std::atomic<bool> success(true);
+	Common::ThreadPool::ParallelFor(0, chunked_header.chunk_count, 1, [&](s32 begin, s32 end) {
+		for (s32 i = begin; i < end; ++i)
+		{
+			const size_t offset = static_cast<size_t>(i) * chunked_header.chunk_size;
+			const u32 size = static_cast<u32>(std::min<size_t>(chunked_header.chunk_size, buffer.size() - offset));
+			if (!DecompressChunk(chunked_header.codec, &data[chunks[i].first], chunks[i].second, &buffer[offset], size))
+				success.store(false);
+		}
+	});
+	return success.load();
+}
+
 struct CompressAndDumpState_args
 {
 	std::vector<u8>* buffer_vector;
 	std::mutex* buffer_mutex;
 	std::string filename;
+	u32 codec;
 	bool wait;
 };
 
@@ -336,6 +494,8 @@ static void CompressAndDumpState(CompressAndDumpState_args save_args)
 		return;
 	}
 
+	const u32 start_time = Common::Timer::GetTimeMs();
+
 	// Setting up the header
 	StateHeader header;
 	strncpy(header.gameID, SConfig::GetInstance().GetGameID().c_str(), 6);
@@ -346,40 +506,17 @@ static void CompressAndDumpState(CompressAndDumpState_args save_args)
 
 	if (header.size != 0)  // non-zero header size means the state is compressed
 	{
-		lzo_uint i = 0;
-		while (true)
-		{
-			lzo_uint32 cur_len = 0;
-			lzo_uint out_len = 0;
-
-			if ((i + IN_LEN) >= buffer_size)
-			{
-				cur_len = (lzo_uint32)(buffer_size - i);
-			}
-			else
-			{
-				cur_len = IN_LEN;
-			}
-
-			if (lzo1x_1_compress(buffer_data + i, cur_len, out, &out_len, wrkmem) != LZO_E_OK)
-				PanicAlertT("Internal LZO Error - compression failed");
-
-			// The size of the data to write is 'out_len'
-			f.WriteArray((lzo_uint32*)&out_len, 1);
-			f.WriteBytes(out, out_len);
-
-			if (cur_len != IN_LEN)
-				break;
-
-			i += cur_len;
-		}
+		WriteChunkedState(f, buffer_data, buffer_size, save_args.codec);
 	}
 	else  // uncompressed
 	{
 		f.WriteBytes(buffer_data, buffer_size);
 	}
 
-	Core::DisplayMessage(StringFromFormat("Saved State to %s", filename.c_str()), 2000);
+	const u32 elapsed = Common::Timer::GetTimeMs() - start_time;
+	NOTICE_LOG(COMMON, "Saved state %s: %zu bytes, %" PRIu64 " bytes on disk, %u ms", filename.c_str(),
+		buffer_size, f.Tell(), elapsed);
+	Core::DisplayMessage(StringFromFormat("Saved State to %s (%u ms)", filename.c_str(), elapsed), 2000);
 	Host_UpdateMainFrame();
 }
 
@@ -411,6 +548,7 @@ void SaveAs(const std::string& filename, bool wait)
 		save_args.buffer_vector = &g_current_buffer;
 		save_args.buffer_mutex = &g_cs_current_buffer;
 		save_args.filename = filename;
+		save_args.codec = SConfig::GetInstance().iStateCompression == STATE_CODEC_ZLIB ? STATE_CODEC_ZLIB : STATE_CODEC_LZO;
 		save_args.wait = wait;
 
 		Flush();
@@ -484,6 +622,21 @@ static void LoadFileStateData(const std::string& filename, std::vector<u8>& ret_
 
 		buffer.resize(header.size);
 
+		u32 magic = 0;
+		if (f.ReadArray(&magic, 1))
+			f.Seek(-static_cast<s64>(sizeof(magic)), SEEK_CUR);
+		if (magic == CHUNKED_STATE_MAGIC)
+		{
+			if (!ReadChunkedState(f, buffer))
+			{
+				PanicAlertT("Failed to decompress the state, the file may be corrupted.");
+				return;
+			}
+			ret_data.swap(buffer);
+			return;
+		}
+
+		// States written before the chunked format are a series of LZO blocks
 		lzo_uint i = 0;
 		while (true)
 		{
@@ -555,6 +708,8 @@ void LoadAs(const std::string& filename)
 	bool loadedSuccessfully = false;
 	std::string version_created_by;
 
+	const u32 start_time = Common::Timer::GetTimeMs();
+
 	// brackets here are so buffer gets freed ASAP
 	{
 		std::vector<u8> buffer;
@@ -574,7 +729,9 @@ void LoadAs(const std::string& filename)
 	{
 		if (loadedSuccessfully)
 		{
-			Core::DisplayMessage(StringFromFormat("Loaded state from %s", filename.c_str()), 2000);
+			const u32 elapsed = Common::Timer::GetTimeMs() - start_time;
+			NOTICE_LOG(COMMON, "Loaded state %s in %u ms", filename.c_str(), elapsed);
+			Core::DisplayMessage(StringFromFormat("Loaded state from %s (%u ms)", filename.c_str(), elapsed), 2000);
 			if (File::Exists(filename + ".dtm"))
 				Movie::LoadInput(filename + ".dtm");
 			else if (!Movie::IsJustStartingRecordingInputFromSaveState() &&
@@ -630,6 +787,201 @@ void VerifyAt(const std::string& filename)
 	Core::PauseAndLock(false, wasUnpaused);
 }
 
+// dst = src ^ state[offset, offset + size), where state is padded with zeros. dst may be src.
+static void XorWithState(const u8* src, const std::vector<u8>& state, size_t offset, size_t size, u8* dst)
+{
+	const size_t overlap = state.size() > offset ? std::min(size, state.size() - offset) : 0;
+	const u8* other = state.data() + offset;
+	for (size_t i = 0; i < overlap; i++)
+		dst[i] = src[i] ^ other[i];
+	if (dst != src)
+		memcpy(dst + overlap, src + overlap, size - overlap);
+}
+
+static size_t GetRewindDeltaMemory(const RewindDelta& delta)
+{
+	size_t memory = 0;
+	for (const std::vector<u8>& chunk : delta.chunks)
+		memory += chunk.size();
+	return memory;
+}
+
+static RewindDelta MakeRewindDelta(const std::vector<u8>& older, const std::vector<u8>& newer)
+{
+	RewindDelta delta;
+	delta.size = static_cast<u32>(older.size());
+	delta.chunks.resize((older.size() + STATE_CHUNK_SIZE - 1) / STATE_CHUNK_SIZE);
+	Common::ThreadPool::ParallelFor(0, static_cast<s32>(delta.chunks.size()), 1, [&](s32 begin, s32 end) {
+		std::vector<u8> diff;
+		for (s32 i = begin; i < end; i++)
+		{
+			const size_t offset = static_cast<size_t>(i) * STATE_CHUNK_SIZE;
+			const u32 size = static_cast<u32>(std::min<size_t>(STATE_CHUNK_SIZE, older.size() - offset));
+			diff.resize(size);
+			XorWithState(older.data() + offset, newer, offset, size, diff.data());
+			CompressChunk(STATE_CODEC_LZO, diff.data(), size, &delta.chunks[i]);
+		}
+	});
+	return delta;
+}
+
+static bool ApplyRewindDelta(const RewindDelta& delta, const std::vector<u8>& newer, std::vector<u8>* older)
+{
+	older->resize(delta.size);
+	std::atomic<bool> success(true);
+	Common::ThreadPool::ParallelFor(0, static_cast<s32>(delta.chunks.size()), 1, [&](s32 begin, s32 end) {
+		for (s32 i = begin; i < end; i++)
+		{
+			const size_t offset = static_cast<size_t>(i) * STATE_CHUNK_SIZE;
+			const u32 size = static_cast<u32>(std::min<size_t>(STATE_CHUNK_SIZE, older->size() - offset));
+			u8* dst = older->data() + offset;
+			if (!DecompressChunk(STATE_CODEC_LZO, delta.chunks[i].data(), static_cast<u32>(delta.chunks[i].size()), dst, size))
+			{
+				success.store(false);
+				continue;
+			}
+			XorWithState(dst, newer, offset, size, dst);
+		}
+	});
+	return success.load();
+}
+
+static void UpdateRewindStats(float capture_ms)
+{
+	SETSTAT(stats.numRewindStates, s_rewind_newest.empty() ? 0 : s_rewind_deltas.size() + 1);
+	SETSTAT(stats.rewindMemoryKB, s_rewind_memory / 1024);
+	SETSTAT_FT(stats.rewindCaptureMs, capture_ms);
+}
+
+// Runs on the rewind thread, so the CPU thread doesn't wait for the compression
+static void AddRewindState(std::vector<u8> state, float capture_ms)
+{
+	Common::SetCurrentThreadName("Rewind thread");
+
+	const SConfig& config = SConfig::GetInstance();
+	std::lock_guard<std::mutex> lk(s_rewind_mutex);
+	if (!s_rewind_newest.empty())
+	{
+		s_rewind_deltas.push_back(MakeRewindDelta(s_rewind_newest, state));
+		s_rewind_memory -= s_rewind_newest.size();
+		s_rewind_memory += GetRewindDeltaMemory(s_rewind_deltas.back());
+	}
+	s_rewind_memory += state.size();
+	s_rewind_newest.swap(state);
+
+	// The newest state counts as one of the iRewindStates
+	while (s_rewind_deltas.size() >= static_cast<size_t>(std::max(config.iRewindStates, 1)))
+	{
+		s_rewind_memory -= GetRewindDeltaMemory(s_rewind_deltas.front());
+		s_rewind_deltas.pop_front();
+	}
+
+	UpdateRewindStats(capture_ms);
+}
+
+static void FlushRewindThread()
+{
+	if (s_rewind_thread.joinable())
+		s_rewind_thread.join();
+}
+
+// Host job queued by CaptureRewindState
+static void SaveRewindState()
+{
+	// Rewind and ClearRewindBuffer drop a capture that was queued before them
+	if (!s_rewind_capture_pending.TestAndClear())
+		return;
+
+	const u64 start_time = Common::Timer::GetTimeUs();
+
+	// Stops the CPU between two slices and waits for the GPU thread, like SaveAs
+	bool was_unpaused = Core::PauseAndLock(true);
+
+	std::vector<u8> state;
+	u8* ptr = nullptr;
+	PointerWrap p(&ptr, PointerWrap::MODE_MEASURE);
+	DoState(p);
+	state.resize(reinterpret_cast<size_t>(ptr));
+	ptr = state.data();
+	p.SetMode(PointerWrap::MODE_WRITE);
+	DoState(p);
+
+	Core::PauseAndLock(false, was_unpaused);
+
+	const float capture_ms = (Common::Timer::GetTimeUs() - start_time) / 1000.0f;
+	FlushRewindThread();
+	s_rewind_thread = std::thread(AddRewindState, std::move(state), capture_ms);
+}
+
+void CaptureRewindState()
+{
+	const SConfig& config = SConfig::GetInstance();
+	if (!config.bRewind || NetPlay::IsNetPlayRunning())
+		return;
+	if (++s_rewind_frame_count < std::max(config.iRewindInterval, 1))
+		return;
+	s_rewind_frame_count = 0;
+
+	// This runs from a CoreTiming event, in the middle of a slice, where a state would be
+	// inconsistent. The host thread saves it once the CPU has been stopped.
+	if (s_rewind_capture_pending.TestAndSet())
+		Core::QueueHostJob(SaveRewindState);
+}
+
+bool Rewind()
+{
+	if (NetPlay::IsNetPlayRunning())
+		return false;
+
+	bool was_unpaused = Core::PauseAndLock(true);
+	s_rewind_capture_pending.Clear();
+	FlushRewindThread();
+	bool success = false;
+	{
+		std::lock_guard<std::mutex> lk(s_rewind_mutex);
+		if (!s_rewind_newest.empty())
+		{
+			LoadFromBuffer(s_rewind_newest);
+			success = true;
+
+			std::vector<u8> older;
+			if (!s_rewind_deltas.empty() &&
+				ApplyRewindDelta(s_rewind_deltas.back(), s_rewind_newest, &older))
+			{
+				s_rewind_memory -= GetRewindDeltaMemory(s_rewind_deltas.back());
+				s_rewind_memory += older.size();
+				s_rewind_deltas.pop_back();
+			}
+			else
+			{
+				s_rewind_deltas.clear();
+				s_rewind_memory = s_rewind_newest.size();
+			}
+			s_rewind_memory -= s_rewind_newest.size();
+			s_rewind_newest.swap(older);
+		}
+		s_rewind_frame_count = 0;
+		UpdateRewindStats(stats.rewindCaptureMs);
+	}
+	Core::PauseAndLock(false, was_unpaused);
+
+	if (!success)
+		OSD::AddMessage("Rewind buffer is empty");
+	return success;
+}
+
+void ClearRewindBuffer()
+{
+	s_rewind_capture_pending.Clear();
+	FlushRewindThread();
+	std::lock_guard<std::mutex> lk(s_rewind_mutex);
+	std::vector<u8>().swap(s_rewind_newest);
+	s_rewind_deltas.clear();
+	s_rewind_memory = 0;
+	s_rewind_frame_count = 0;
+	UpdateRewindStats(0.0f);
+}
+
 void Init()
 {
 	if (lzo_init() != LZO_E_OK)
@@ -639,6 +991,7 @@ void Init()
 void Shutdown()
 {
 	Flush();
+	ClearRewindBuffer();
 
 	// swapping with an empty vector, rather than clear()ing
 	// this gives a better guarantee to free the allocated memory right NOW (as opposed to, actually,
@@ -16,6 +16,13 @@ namespace State
 // number of states
 static const u32 NUM_STATES = 10;
 
+// Codecs for compressed states, selected with SConfig::iStateCompression
+enum StateCompressionCodec
+{
+	STATE_CODEC_LZO = 0,
+	STATE_CODEC_ZLIB = 1,
+};
+
 struct StateHeader
 {
 	char gameID[6];
@@ -57,6 +64,14 @@ void SaveFirstSaved();
 void UndoSaveState();
 void UndoLoadState();
 
+// Rewind buffer, keeps SConfig::iRewindStates states in memory when SConfig::bRewind is set.
+// Called once per frame on the CPU thread. Every SConfig::iRewindInterval frames it queues a
+// host job that saves a state while the core is paused and compresses it on the rewind thread.
+void CaptureRewindState();
+// Goes back to the newest state in the rewind buffer and removes it from the buffer.
+bool Rewind();
+void ClearRewindBuffer();
+
 // wait until previously scheduled savestate event (if any) is done
 void Flush();
 
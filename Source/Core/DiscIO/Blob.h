@@ -44,6 +44,12 @@ public:
   // NOT thread-safe - can't call this from multiple threads.
   virtual bool Read(u64 offset, u64 size, u8* out_ptr) = 0;
 
+  // For readers backed by a memory mapping of the image: the data at offset, which the
+  // returned pointer keeps mapped. nullptr if the range can't be read without a copy.
+  virtual std::shared_ptr<const u8> GetMappedData(u64 offset, u64 size) { return nullptr; }
+  // Hint that the range is going to be read soon, so it can be fetched in the background.
+  virtual void WillRead(u64 offset, u64 size) {}
+
 protected:
   IBlobReader() {}
 };
@@ -8,6 +8,7 @@
 #endif
 
 #include <algorithm>
+#include <atomic>
 #include <cinttypes>
 #include <cstdio>
 #include <cstring>
@@ -17,12 +18,15 @@
 #include <vector>
 #include <zlib.h>
 
+#include "Common/Common.h"
 #include "Common/CommonTypes.h"
 #include "Common/FileUtil.h"
 #include "Common/Hash.h"
 #include "Common/Logging/Log.h"
 #include "Common/MsgHandler.h"
 #include "Common/StringUtil.h"
+#include "Common/Thread.h"
+#include "Common/ThreadPool.h"
 #include "DiscIO/Blob.h"
 #include "DiscIO/CompressedBlob.h"
 #include "DiscIO/DiscScrubber.h"
@@ -31,6 +35,13 @@ namespace DiscIO
 {
 bool IsGCZBlob(File::IOFile& file);
 
+// Blocks compressed per thread at a time by CompressFileToBlob
+static constexpr u32 BLOCKS_PER_THREAD = 8;
+
+// Sequential reads are served in chunks of this size, which are decompressed in parallel and
+// read ahead.
+static constexpr u32 READ_CHUNK_SIZE = 128 * 1024;
+
 CompressedBlobReader::CompressedBlobReader(File::IOFile file, const std::string& filename)
     : m_file(std::move(file)), m_file_name(filename)
 {
@@ -39,6 +50,7 @@ CompressedBlobReader::CompressedBlobReader(File::IOFile file, const std::string&
   m_file.ReadArray(&m_header, 1);
 
   SetSectorSize(m_header.block_size);
+  SetChunkSize(std::max<u32>(1, READ_CHUNK_SIZE / std::max<u32>(1, m_header.block_size)));
 
   // cache block pointers and hashes
   m_block_pointers.resize(m_header.num_blocks);
@@ -49,12 +61,6 @@ CompressedBlobReader::CompressedBlobReader(File::IOFile file, const std::string&
   m_data_offset = (sizeof(CompressedBlobHeader)) +
                   (sizeof(u64)) * m_header.num_blocks     // skip block pointers
                   + (sizeof(u32)) * m_header.num_blocks;  // skip hashes
-
-  // A compressed block is never ever longer than a decompressed block, so just header.block_size
-  // should be fine.
-  // I still add some safety margin.
-  const u32 zlib_buffer_size = m_header.block_size + 64;
-  m_zlib_buffer.resize(zlib_buffer_size);
 }
 
 std::unique_ptr<CompressedBlobReader> CompressedBlobReader::Create(File::IOFile file,
@@ -69,6 +75,15 @@ std::unique_ptr<CompressedBlobReader> CompressedBlobReader::Create(File::IOFile
 
 CompressedBlobReader::~CompressedBlobReader()
 {
+  if (m_read_ahead_thread.joinable())
+  {
+    {
+      std::lock_guard<std::mutex> lk(m_read_ahead_lock);
+      m_read_ahead_running = false;
+    }
+    m_read_ahead_wakeup.notify_one();
+    m_read_ahead_thread.join();
+  }
 }
 
 // IMPORTANT: Calling this function invalidates all earlier pointers gotten from this function.
@@ -86,32 +101,72 @@ u64 CompressedBlobReader::GetBlockCompressedSize(u64 block_num) const
 
 bool CompressedBlobReader::GetBlock(u64 block_num, u8* out_ptr)
 {
-  bool uncompressed = false;
-  u32 comp_block_size = (u32)GetBlockCompressedSize(block_num);
-  u64 offset = m_block_pointers[block_num] + m_data_offset;
+  return DecompressBlocks(block_num, 1, out_ptr);
+}
+
+bool CompressedBlobReader::ReadMultipleAlignedBlocks(u64 block_num, u64 num_blocks, u8* out_ptr)
+{
+  bool success;
+  if (!TakeReadAhead(block_num, num_blocks, out_ptr, &success))
+    success = DecompressBlocks(block_num, num_blocks, out_ptr);
+
+  const u64 next_block = block_num + num_blocks;
+  if (success && block_num == m_next_sequential_block && next_block < m_header.num_blocks)
+    StartReadAhead(next_block, std::min<u64>(num_blocks, m_header.num_blocks - next_block));
+  m_next_sequential_block = next_block;
+  return success;
+}
 
-  if (offset & (1ULL << 63))
+bool CompressedBlobReader::DecompressBlocks(u64 block_num, u64 num_blocks, u8* out_ptr)
+{
+  // Blocks are stored back to back, the top bit of the pointers only marks uncompressed ones
+  static constexpr u64 UNCOMPRESSED_FLAG = 1ULL << 63;
+  const u64 end_block = block_num + num_blocks;
+  const u64 start_offset = m_block_pointers[block_num] & ~UNCOMPRESSED_FLAG;
+  const u64 end_offset = end_block < m_header.num_blocks ?
+                             m_block_pointers[end_block] & ~UNCOMPRESSED_FLAG :
+                             m_header.compressed_data_size;
+
+  std::vector<u8> compressed(end_offset - start_offset);
   {
-    if (comp_block_size != m_header.block_size)
-      PanicAlert("Uncompressed block with wrong size");
-    uncompressed = true;
-    offset &= ~(1ULL << 63);
+    std::lock_guard<std::mutex> lk(m_file_lock);
+    m_file.Seek(start_offset + m_data_offset, SEEK_SET);
+    if (!m_file.ReadBytes(compressed.data(), compressed.size()))
+    {
+      PanicAlertT("The disc image \"%s\" is truncated, some of the data is missing.",
+                  m_file_name.c_str());
+      m_file.Clear();
+      return false;
+    }
   }
 
-  // clear unused part of zlib buffer. maybe this can be deleted when it works fully.
-  memset(&m_zlib_buffer[comp_block_size], 0, m_zlib_buffer.size() - comp_block_size);
+  std::atomic<bool> success(true);
+  Common::ThreadPool::ParallelFor(0, static_cast<s32>(num_blocks), 1, [&](s32 begin, s32 end) {
+    for (s32 i = begin; i < end; i++)
+    {
+      const u64 block = block_num + i;
+      const u64 offset = (m_block_pointers[block] & ~UNCOMPRESSED_FLAG) - start_offset;
+      const u8* src = compressed.data() + offset;
+      if (!DecompressBlock(block, src, out_ptr + i * static_cast<u64>(m_header.block_size)))
+        success.store(false);
+    }
+  });
+  return success.load();
+}
 
-  m_file.Seek(offset, SEEK_SET);
-  if (!m_file.ReadBytes(m_zlib_buffer.data(), comp_block_size))
+bool CompressedBlobReader::DecompressBlock(u64 block_num, const u8* compressed, u8* out_ptr) const
+{
+  bool uncompressed = false;
+  u32 comp_block_size = (u32)GetBlockCompressedSize(block_num);
+  if (m_block_pointers[block_num] & (1ULL << 63))
   {
-    PanicAlertT("The disc image \"%s\" is truncated, some of the data is missing.",
-                m_file_name.c_str());
-    m_file.Clear();
-    return false;
+    if (comp_block_size != m_header.block_size)
+      PanicAlert("Uncompressed block with wrong size");
+    uncompressed = true;
   }
 
   // First, check hash.
-  u32 block_hash = HashAdler32(m_zlib_buffer.data(), comp_block_size);
+  u32 block_hash = HashAdler32(compressed, comp_block_size);
   if (block_hash != m_hashes[block_num])
     PanicAlertT("The disc image \"%s\" is corrupt.\n"
                 "Hash of block %" PRIu64 " is %08x instead of %08x.",
@@ -119,12 +174,12 @@ bool CompressedBlobReader::GetBlock(u64 block_num, u8* out_ptr)
 
   if (uncompressed)
   {
-    std::copy(m_zlib_buffer.begin(), m_zlib_buffer.begin() + comp_block_size, out_ptr);
+    std::copy(compressed, compressed + comp_block_size, out_ptr);
   }
   else
   {
     z_stream z = {};
-    z.next_in = m_zlib_buffer.data();
+    z.next_in = const_cast<u8*>(compressed);
     z.avail_in = comp_block_size;
     if (z.avail_in > m_header.block_size)
     {
@@ -151,6 +206,74 @@ bool CompressedBlobReader::GetBlock(u64 block_num, u8* out_ptr)
   return true;
 }
 
+bool CompressedBlobReader::TakeReadAhead(u64 block_num, u64 num_blocks, u8* out_ptr,
+                                         bool* success)
+{
+  std::unique_lock<std::mutex> lk(m_read_ahead_lock);
+  if (m_read_ahead_count == 0 || m_read_ahead_block != block_num ||
+      m_read_ahead_count != num_blocks)
+  {
+    return false;
+  }
+
+  m_read_ahead_done.wait(lk, [this] { return m_read_ahead_ready; });
+  std::copy(m_read_ahead_buffer.begin(),
+            m_read_ahead_buffer.begin() + num_blocks * m_header.block_size, out_ptr);
+  *success = m_read_ahead_success;
+  m_read_ahead_ready = false;
+  m_read_ahead_count = 0;
+  return true;
+}
+
+void CompressedBlobReader::StartReadAhead(u64 block_num, u64 num_blocks)
+{
+  {
+    std::lock_guard<std::mutex> lk(m_read_ahead_lock);
+    m_read_ahead_block = block_num;
+    m_read_ahead_count = num_blocks;
+    m_read_ahead_requested = true;
+    m_read_ahead_ready = false;
+    if (!m_read_ahead_running)
+    {
+      // Only started once the image is streamed, game list scans don't need it
+      m_read_ahead_running = true;
+      m_read_ahead_thread = std::thread(&CompressedBlobReader::ReadAheadThread, this);
+    }
+  }
+  m_read_ahead_wakeup.notify_one();
+}
+
+void CompressedBlobReader::ReadAheadThread()
+{
+  Common::SetCurrentThreadName("GCZ Read Ahead");
+  std::vector<u8> buffer;
+  std::unique_lock<std::mutex> lk(m_read_ahead_lock);
+  while (true)
+  {
+    m_read_ahead_wakeup.wait(lk, [this] { return !m_read_ahead_running || m_read_ahead_requested; });
+    if (!m_read_ahead_running)
+      break;
+    m_read_ahead_requested = false;
+    const u64 block_num = m_read_ahead_block;
+    const u64 num_blocks = m_read_ahead_count;
+    lk.unlock();
+
+    buffer.resize(num_blocks * m_header.block_size);
+    const bool success = DecompressBlocks(block_num, num_blocks, buffer.data());
+
+    lk.lock();
+    // Drop the result if a different chunk was requested in the meantime
+    if (!m_read_ahead_requested && m_read_ahead_block == block_num &&
+        m_read_ahead_count == num_blocks)
+    {
+      m_read_ahead_buffer.swap(buffer);
+      m_read_ahead_success = success;
+      m_read_ahead_ready = true;
+      m_read_ahead_done.notify_all();
+    }
+  }
+}
+
 bool CompressFileToBlob(const std::string& infile_path, const std::string& outfile_path,
                         u32 sub_type, int block_size, CompressCB callback, void* arg)
 {
@@ -192,10 +315,6 @@ bool CompressFileToBlob(const std::string& infile_path, const std::string& outfi
     scrubbing = true;
   }
 
-  z_stream z = {};
-  if (deflateInit(&z, 9) != Z_OK)
-    return false;
-
   callback(GetStringT("Files opened, ready to compress."), 0, arg);
 
   CompressedBlobHeader header;
@@ -207,16 +326,22 @@ bool CompressFileToBlob(const std::string& infile_path, const std::string& outfi
   // round upwards!
   header.num_blocks = (u32)((header.data_size + (block_size - 1)) / block_size);
 
+  // Blocks are read and written in batches, the blocks of a batch are compressed in parallel.
+  const u32 batch_blocks = Common::ThreadPool::GetThreadCount() * BLOCKS_PER_THREAD;
   std::vector<u64> offsets(header.num_blocks);
   std::vector<u32> hashes(header.num_blocks);
-  std::vector<u8> out_buf(block_size);
-  std::vector<u8> in_buf(block_size);
+  std::vector<u8> in_buf(static_cast<size_t>(batch_blocks) * block_size);
+  std::vector<std::vector<u8>> out_bufs(batch_blocks, std::vector<u8>(block_size));
+  std::vector<int> comp_sizes(batch_blocks);
 
   // seek past the header (we will write it at the end)
   outfile.Seek(sizeof(CompressedBlobHeader), SEEK_CUR);
   // seek past the offset and hash tables (we will write them at the end)
   outfile.Seek((sizeof(u64) + sizeof(u32)) * header.num_blocks, SEEK_CUR);
 
+  // IsGCZBlob has read the start of the input file
+  infile.Seek(0, SEEK_SET);
+
   // Now we are ready to write compressed data!
   u64 position = 0;
   int num_compressed = 0;
@@ -224,9 +349,12 @@ bool CompressFileToBlob(const std::string& infile_path, const std::string& outfi
   int progress_monitor = std::max<int>(1, header.num_blocks / 1000);
   bool success = true;
 
-  for (u32 i = 0; i < header.num_blocks; i++)
+  for (u32 batch_start = 0; batch_start < header.num_blocks && success; batch_start += batch_blocks)
   {
-    if (i % progress_monitor == 0)
+    const u32 count = std::min(batch_blocks, header.num_blocks - batch_start);
+
+    if (batch_start / progress_monitor != (batch_start + count - 1) / progress_monitor ||
+        batch_start % progress_monitor == 0)
     {
       const u64 inpos = infile.Tell();
       int ratio = 0;
@@ -234,9 +362,9 @@ bool CompressFileToBlob(const std::string& infile_path, const std::string& outfi
         ratio = (int)(100 * position / inpos);
 
       std::string temp =
-          StringFromFormat(GetStringT("%i of %i blocks. Compression ratio %i%%").c_str(), i,
-                           header.num_blocks, ratio);
-      bool was_cancelled = !callback(temp, (float)i / (float)header.num_blocks, arg);
+          StringFromFormat(GetStringT("%i of %i blocks. Compression ratio %i%%").c_str(),
+                           batch_start, header.num_blocks, ratio);
+      bool was_cancelled = !callback(temp, (float)batch_start / (float)header.num_blocks, arg);
       if (was_cancelled)
       {
         success = false;
@@ -244,64 +372,97 @@ bool CompressFileToBlob(const std::string& infile_path, const std::string& outfi
       }
     }
 
-    offsets[i] = position;
-
-    size_t read_bytes;
-    if (scrubbing)
-      read_bytes = disc_scrubber.GetNextBlock(infile, in_buf.data());
-    else
-      infile.ReadArray(in_buf.data(), header.block_size, &read_bytes);
-    if (read_bytes < header.block_size)
-      std::fill(in_buf.begin() + read_bytes, in_buf.begin() + header.block_size, 0);
-
-    int retval = deflateReset(&z);
-    z.next_in = in_buf.data();
-    z.avail_in = header.block_size;
-    z.next_out = out_buf.data();
-    z.avail_out = block_size;
+    for (u32 i = 0; i < count; i++)
+    {
+      u8* block = &in_buf[static_cast<size_t>(i) * block_size];
+      size_t read_bytes;
+      if (scrubbing)
+        read_bytes = disc_scrubber.GetNextBlock(infile, block);
+      else
+        infile.ReadArray(block, header.block_size, &read_bytes);
+      if (read_bytes < header.block_size)
+        std::fill(block + read_bytes, block + header.block_size, 0);
+    }
 
-    if (retval != Z_OK)
+    // A compressed size of zero means the block is stored uncompressed.
+    // The hashes are of the data as stored.
+    std::atomic<bool> deflate_failed(false);
+    Common::ThreadPool::ParallelFor(0, static_cast<s32>(count), 1, [&](s32 begin, s32 end) {
+      z_stream z = {};
+      if (deflateInit(&z, 9) != Z_OK)
+      {
+        deflate_failed.store(true);
+        return;
+      }
+      for (s32 i = begin; i < end; i++)
+      {
+        if (deflateReset(&z) != Z_OK)
+        {
+          deflate_failed.store(true);
+          break;
+        }
+        u8* in = &in_buf[static_cast<size_t>(i) * block_size];
+        z.next_in = in;
+        z.avail_in = header.block_size;
+        z.next_out = out_bufs[i].data();
+        z.avail_out = block_size;
+
+        int status = deflate(&z, Z_FINISH);
+        if ((status != Z_STREAM_END) || (z.avail_out < 10))
+        {
+          comp_sizes[i] = 0;
+          hashes[batch_start + i] = HashAdler32(in, block_size);
+        }
+        else
+        {
+          comp_sizes[i] = block_size - z.avail_out;
+          hashes[batch_start + i] = HashAdler32(out_bufs[i].data(), comp_sizes[i]);
+        }
+      }
+      deflateEnd(&z);
+    });
+    if (deflate_failed.load())
     {
       ERROR_LOG(DISCIO, "Deflate failed");
       success = false;
       break;
     }
 
-    int status = deflate(&z, Z_FINISH);
-    int comp_size = block_size - z.avail_out;
-
-    u8* write_buf;
-    int write_size;
-    if ((status != Z_STREAM_END) || (z.avail_out < 10))
-    {
-      // PanicAlert("%i %i Store %i", i*block_size, position, comp_size);
-      // let's store uncompressed
-      write_buf = in_buf.data();
-      offsets[i] |= 0x8000000000000000ULL;
-      write_size = block_size;
-      num_stored++;
-    }
-    else
+    // Write the batch in order
+    for (u32 i = 0; i < count; i++)
     {
-      // let's store compressed
-      // PanicAlert("Comp %i to %i", block_size, comp_size);
-      write_buf = out_buf.data();
-      write_size = comp_size;
-      num_compressed++;
-    }
+      const u32 block_index = batch_start + i;
+      offsets[block_index] = position;
 
-    if (!outfile.WriteBytes(write_buf, write_size))
-    {
-      PanicAlertT("Failed to write the output file \"%s\".\n"
-                  "Check that you have enough space available on the target drive.",
-                  outfile_path.c_str());
-      success = false;
-      break;
-    }
+      u8* write_buf;
+      int write_size;
+      if (comp_sizes[i] == 0)
+      {
+        // let's store uncompressed
+        write_buf = &in_buf[static_cast<size_t>(i) * block_size];
+        offsets[block_index] |= 0x8000000000000000ULL;
+        write_size = block_size;
+        num_stored++;
+      }
+      else
+      {
+        // let's store compressed
+        write_buf = out_bufs[i].data();
+        write_size = comp_sizes[i];
+        num_compressed++;
+      }
 
-    position += write_size;
+      if (!outfile.WriteBytes(write_buf, write_size))
+      {
+        PanicAlertT("Failed to write the output file \"%s\".\n"
+                    "Check that you have enough space available on the target drive.",
+                    outfile_path.c_str());
+        success = false;
+        break;
+      }
 
-    hashes[i] = HashAdler32(write_buf, write_size);
+      position += write_size;
+    }
   }
 
   header.compressed_data_size = position;
@@ -321,9 +482,6 @@ bool CompressFileToBlob(const std::string& infile_path, const std::string& outfi
     outfile.WriteArray(hashes.data(), header.num_blocks);
   }
 
-  // Cleanup
-  deflateEnd(&z);
-
   if (success)
   {
     callback(GetStringT("Done compressing disc image."), 1.0f, arg);
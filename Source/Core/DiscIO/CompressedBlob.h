@@ -13,8 +13,11 @@
 
 #pragma once
 
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "Common/CommonTypes.h"
@@ -54,17 +57,44 @@ public:
   u64 GetBlockCompressedSize(u64 block_num) const;
   bool GetBlock(u64 block_num, u8* out_ptr) override;
 
+protected:
+  bool ReadMultipleAlignedBlocks(u64 block_num, u64 num_blocks, u8* out_ptr) override;
+
 private:
   CompressedBlobReader(File::IOFile file, const std::string& filename);
 
+  // Reads the blocks with a single file read and inflates them in parallel.
+  // Can be called from the read ahead thread, the file access is locked.
+  bool DecompressBlocks(u64 block_num, u64 num_blocks, u8* out_ptr);
+  bool DecompressBlock(u64 block_num, const u8* compressed, u8* out_ptr) const;
+
+  // Sequential reads decompress the following chunk on a background thread while the current
+  // one is being used. Returns false if the blocks weren't read ahead.
+  bool TakeReadAhead(u64 block_num, u64 num_blocks, u8* out_ptr, bool* success);
+  void StartReadAhead(u64 block_num, u64 num_blocks);
+  void ReadAheadThread();
+
   CompressedBlobHeader m_header;
   std::vector<u64> m_block_pointers;
   std::vector<u32> m_hashes;
   int m_data_offset;
   File::IOFile m_file;
+  std::mutex m_file_lock;
   u64 m_file_size;
-  std::vector<u8> m_zlib_buffer;
   std::string m_file_name;
+
+  u64 m_next_sequential_block = 0;
+  std::thread m_read_ahead_thread;
+  std::mutex m_read_ahead_lock;
+  std::condition_variable m_read_ahead_wakeup;
+  std::condition_variable m_read_ahead_done;
+  bool m_read_ahead_running = false;
+  bool m_read_ahead_requested = false;
+  bool m_read_ahead_ready = false;
+  bool m_read_ahead_success = false;
+  u64 m_read_ahead_block = 0;
+  u64 m_read_ahead_count = 0;
+  std::vector<u8> m_read_ahead_buffer;
 };
 
 }  // namespace
@@ -2,17 +2,40 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <cstring>
 #include <memory>
 #include <string>
 #include <utility>
 
+#include "Common/Logging/Log.h"
 #include "DiscIO/FileBlob.h"
 
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 namespace DiscIO
 {
+static u64 GetPageSize()
+{
+#ifdef _WIN32
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return info.dwPageSize;
+#else
+  return sysconf(_SC_PAGESIZE);
+#endif
+}
+
 PlainFileReader::PlainFileReader(File::IOFile file) : m_file(std::move(file))
 {
   m_size = m_file.GetSize();
+  MapFile();
 }
 
 std::unique_ptr<PlainFileReader> PlainFileReader::Create(File::IOFile file)
@@ -23,8 +46,46 @@ std::unique_ptr<PlainFileReader> PlainFileReader::Create(File::IOFile file)
   return nullptr;
 }
 
+void PlainFileReader::MapFile()
+{
+  // Mapping a whole disc image takes gigabytes of address space
+  if (sizeof(void*) < 8 || m_size <= 0)
+    return;
+
+#ifdef _WIN32
+  HANDLE file = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(m_file.GetHandle())));
+  HANDLE mapping = CreateFileMapping(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!mapping)
+    return;
+  // The view keeps the mapping object alive
+  void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(mapping);
+  if (!view)
+    return;
+  m_mapping = std::shared_ptr<u8>(static_cast<u8*>(view), [](u8* ptr) { UnmapViewOfFile(ptr); });
+#else
+  const size_t size = static_cast<size_t>(m_size);
+  void* view = mmap(nullptr, size, PROT_READ, MAP_SHARED, fileno(m_file.GetHandle()), 0);
+  if (view == MAP_FAILED)
+  {
+    WARN_LOG(DISCIO, "Could not map the disc image, reading it through stdio");
+    return;
+  }
+  m_mapping = std::shared_ptr<u8>(static_cast<u8*>(view), [size](u8* ptr) { munmap(ptr, size); });
+#endif
+}
+
 bool PlainFileReader::Read(u64 offset, u64 nbytes, u8* out_ptr)
 {
+  if (m_mapping)
+  {
+    if (offset > static_cast<u64>(m_size) || nbytes > static_cast<u64>(m_size) - offset)
+      return false;
+
+    memcpy(out_ptr, m_mapping.get() + offset, static_cast<size_t>(nbytes));
+    return true;
+  }
+
   if (m_file.Seek(offset, SEEK_SET) && m_file.ReadBytes(out_ptr, nbytes))
   {
     return true;
@@ -36,4 +97,33 @@ bool PlainFileReader::Read(u64 offset, u64 nbytes, u8* out_ptr)
   }
 }
 
+std::shared_ptr<const u8> PlainFileReader::GetMappedData(u64 offset, u64 size)
+{
+  if (!m_mapping || offset > static_cast<u64>(m_size) || size > static_cast<u64>(m_size) - offset)
+    return nullptr;
+
+  // Fault the pages in now, so that the thread asking for the data waits for the disk
+  // rather than the one that copies it later
+  static const u64 page_size = GetPageSize();
+  volatile const u8* data = m_mapping.get() + offset;
+  for (u64 i = 0; i < size; i += page_size - (offset + i) % page_size)
+    data[i];
+
+  return std::shared_ptr<const u8>(m_mapping, m_mapping.get() + offset);
+}
+
+void PlainFileReader::WillRead(u64 offset, u64 size)
+{
+#ifndef _WIN32
+  if (!m_mapping || offset >= static_cast<u64>(m_size))
+    return;
+
+  // Start paging the range in while the emulated game is busy with the previous one
+  static const u64 page_size = GetPageSize();
+  const u64 start = offset - offset % page_size;
+  const u64 end = std::min<u64>(offset + size, m_size);
+  madvise(m_mapping.get() + start, static_cast<size_t>(end - start), MADV_WILLNEED);
+#endif
+}
+
 }  // namespace
@@ -14,6 +14,8 @@
 
 namespace DiscIO
 {
+// Reads uncompressed images. On 64-bit hosts the whole file is memory mapped, so reads are
+// plain copies out of the page cache; if the mapping can't be created, reads go through stdio.
 class PlainFileReader : public IBlobReader
 {
 public:
@@ -23,12 +25,17 @@ public:
   u64 GetDataSize() const override { return m_size; }
   u64 GetRawSize() const override { return m_size; }
   bool Read(u64 offset, u64 nbytes, u8* out_ptr) override;
+  std::shared_ptr<const u8> GetMappedData(u64 offset, u64 size) override;
+  void WillRead(u64 offset, u64 size) override;
 
 private:
   PlainFileReader(File::IOFile file);
+  void MapFile();
 
   File::IOFile m_file;
   s64 m_size;
+  // Unmaps the file when the last reference goes away, which may be after the reader is gone
+  std::shared_ptr<u8> m_mapping;
 };
 
 }  // namespace
@@ -6,6 +6,7 @@
 
 #include <cstring>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -25,6 +26,12 @@ public:
 	virtual ~IVolume() {}
 	// decrypt parameter must be false if not reading a Wii disc
 	virtual bool Read(u64 _Offset, u64 _Length, u8* _pBuffer, bool decrypt) const = 0;
+	// See IBlobReader::GetMappedData and IBlobReader::WillRead
+	virtual std::shared_ptr<const u8> GetMappedData(u64 offset, u64 length, bool decrypt) const
+	{
+		return nullptr;
+	}
+	virtual void WillRead(u64 offset, u64 length, bool decrypt) const {}
 	template <typename T>
 	bool ReadSwapped(u64 offset, T* buffer, bool decrypt) const
 	{
@@ -44,6 +44,22 @@ bool CVolumeGC::Read(u64 _Offset, u64 _Length, u8* _pBuffer, bool decrypt) const
 	return m_pReader->Read(_Offset, _Length, _pBuffer);
 }
 
+std::shared_ptr<const u8> CVolumeGC::GetMappedData(u64 offset, u64 length, bool decrypt) const
+{
+	if (decrypt || m_pReader == nullptr)
+		return nullptr;
+
+	FileMon::FindFilename(offset);
+
+	return m_pReader->GetMappedData(offset, length);
+}
+
+void CVolumeGC::WillRead(u64 offset, u64 length, bool decrypt) const
+{
+	if (m_pReader != nullptr)
+		m_pReader->WillRead(offset, length);
+}
+
 std::string CVolumeGC::GetGameID() const
 {
 	static const std::string NO_UID("NO_UID");
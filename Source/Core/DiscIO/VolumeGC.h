@@ -27,6 +27,8 @@ public:
 	CVolumeGC(std::unique_ptr<IBlobReader> reader);
 	~CVolumeGC();
 	bool Read(u64 _Offset, u64 _Length, u8* _pBuffer, bool decrypt = false) const override;
+	std::shared_ptr<const u8> GetMappedData(u64 offset, u64 length, bool decrypt) const override;
+	void WillRead(u64 offset, u64 length, bool decrypt) const override;
 	std::string GetGameID() const override;
 	std::string GetMakerID() const override;
 	u16 GetRevision() const override;
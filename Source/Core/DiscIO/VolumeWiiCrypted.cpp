@@ -2,6 +2,9 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
 #include <cstddef>
 #include <cstring>
 #include <map>
@@ -12,8 +15,10 @@
 #include <utility>
 #include <vector>
 
+#include "Common/CPUDetect.h"
 #include "Common/CommonFuncs.h"
 #include "Common/CommonTypes.h"
+#include "Common/Intrinsics.h"
 #include "Common/Logging/Log.h"
 #include "Common/MsgHandler.h"
 #include "DiscIO/Blob.h"
@@ -27,27 +32,173 @@
 
 namespace DiscIO
 {
+#ifdef _M_X86
+FUNCTION_TARGET_AES
+static inline __m128i ExpandKeyStep(__m128i key, __m128i keygen)
+{
+	keygen = _mm_shuffle_epi32(keygen, _MM_SHUFFLE(3, 3, 3, 3));
+	key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+	key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+	key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+	return _mm_xor_si128(key, keygen);
+}
+
+// AES-128-CBC decryption with AES-NI. Unlike encryption, the blocks of a CBC
+// ciphertext can be decrypted independently, so eight of them are kept in flight
+// to hide the latency of aesdec. <size> must be a multiple of 16.
+FUNCTION_TARGET_AES
+void DecryptCBC_AESNI(const u8* key, const u8* iv, const u8* src, u8* dst, size_t size)
+{
+	__m128i enc[11];
+	enc[0] = _mm_loadu_si128((const __m128i*)key);
+	enc[1] = ExpandKeyStep(enc[0], _mm_aeskeygenassist_si128(enc[0], 0x01));
+	enc[2] = ExpandKeyStep(enc[1], _mm_aeskeygenassist_si128(enc[1], 0x02));
+	enc[3] = ExpandKeyStep(enc[2], _mm_aeskeygenassist_si128(enc[2], 0x04));
+	enc[4] = ExpandKeyStep(enc[3], _mm_aeskeygenassist_si128(enc[3], 0x08));
+	enc[5] = ExpandKeyStep(enc[4], _mm_aeskeygenassist_si128(enc[4], 0x10));
+	enc[6] = ExpandKeyStep(enc[5], _mm_aeskeygenassist_si128(enc[5], 0x20));
+	enc[7] = ExpandKeyStep(enc[6], _mm_aeskeygenassist_si128(enc[6], 0x40));
+	enc[8] = ExpandKeyStep(enc[7], _mm_aeskeygenassist_si128(enc[7], 0x80));
+	enc[9] = ExpandKeyStep(enc[8], _mm_aeskeygenassist_si128(enc[8], 0x1B));
+	enc[10] = ExpandKeyStep(enc[9], _mm_aeskeygenassist_si128(enc[9], 0x36));
+
+	// Round keys of the equivalent inverse cipher
+	__m128i dec[11];
+	dec[0] = enc[10];
+	for (int round = 1; round < 10; round++)
+		dec[round] = _mm_aesimc_si128(enc[10 - round]);
+	dec[10] = enc[0];
+
+	__m128i prev = _mm_loadu_si128((const __m128i*)iv);
+	size_t i = 0;
+	for (; i + 8 * 16 <= size; i += 8 * 16)
+	{
+		__m128i cipher[8], block[8];
+		for (int j = 0; j < 8; j++)
+		{
+			cipher[j] = _mm_loadu_si128((const __m128i*)(src + i + j * 16));
+			block[j] = _mm_xor_si128(cipher[j], dec[0]);
+		}
+		for (int round = 1; round < 10; round++)
+		{
+			for (int j = 0; j < 8; j++)
+				block[j] = _mm_aesdec_si128(block[j], dec[round]);
+		}
+		for (int j = 0; j < 8; j++)
+		{
+			block[j] = _mm_xor_si128(_mm_aesdeclast_si128(block[j], dec[10]), prev);
+			_mm_storeu_si128((__m128i*)(dst + i + j * 16), block[j]);
+			prev = cipher[j];
+		}
+	}
+	for (; i < size; i += 16)
+	{
+		const __m128i cipher = _mm_loadu_si128((const __m128i*)(src + i));
+		__m128i block = _mm_xor_si128(cipher, dec[0]);
+		for (int round = 1; round < 10; round++)
+			block = _mm_aesdec_si128(block, dec[round]);
+		block = _mm_xor_si128(_mm_aesdeclast_si128(block, dec[10]), prev);
+		_mm_storeu_si128((__m128i*)(dst + i), block);
+		prev = cipher;
+	}
+}
+#endif
+
 CVolumeWiiCrypted::CVolumeWiiCrypted(std::unique_ptr<IBlobReader> reader, u64 _VolumeOffset,
 	const unsigned char* _pVolumeKey)
 	: m_pReader(std::move(reader)), m_AES_ctx(std::make_unique<mbedtls_aes_context>()),
-	m_VolumeOffset(_VolumeOffset), m_dataOffset(0x20000), m_LastDecryptedBlockOffset(-1)
+	m_VolumeOffset(_VolumeOffset), m_dataOffset(0x20000), m_cluster_cache(s_cluster_cache_size)
 {
+	std::copy(_pVolumeKey, _pVolumeKey + m_volume_key.size(), m_volume_key.begin());
 	mbedtls_aes_setkey_dec(m_AES_ctx.get(), _pVolumeKey, 128);
 }
 
 bool CVolumeWiiCrypted::ChangePartition(u64 offset)
 {
 	m_VolumeOffset = offset;
-	m_LastDecryptedBlockOffset = -1;
+	ClearClusterCache();
 
-	u8 volume_key[16];
-	DiscIO::VolumeKeyForPartition(*m_pReader, offset, volume_key);
-	mbedtls_aes_setkey_dec(m_AES_ctx.get(), volume_key, 128);
+	DiscIO::VolumeKeyForPartition(*m_pReader, offset, m_volume_key.data());
+	mbedtls_aes_setkey_dec(m_AES_ctx.get(), m_volume_key.data(), 128);
 	return true;
 }
 
 CVolumeWiiCrypted::~CVolumeWiiCrypted()
 {
+	if (m_stats.clusters_decrypted != 0)
+	{
+		const double seconds = std::max<u64>(m_stats.decrypt_microseconds, 1) / 1000000.0;
+		INFO_LOG(DISCIO, "Decrypted %" PRIu64 " clusters (%.1f MiB/s), %" PRIu64 " cache hits",
+			m_stats.clusters_decrypted,
+			m_stats.clusters_decrypted * s_block_data_size / seconds / (1024 * 1024),
+			m_stats.cache_hits);
+	}
+}
+
+void CVolumeWiiCrypted::ClearClusterCache()
+{
+	for (DecryptedCluster& cluster : m_cluster_cache)
+	{
+		cluster.block = static_cast<u64>(-1);
+		cluster.last_use = 0;
+	}
+}
+
+const CVolumeWiiCrypted::DecryptedCluster* CVolumeWiiCrypted::FindCluster(u64 block) const
+{
+	for (DecryptedCluster& cluster : m_cluster_cache)
+	{
+		if (cluster.block == block)
+		{
+			cluster.last_use = ++m_cluster_use_counter;
+			return &cluster;
+		}
+	}
+	return nullptr;
+}
+
+bool CVolumeWiiCrypted::DecryptClusters(u64 first_block, u64 count) const
+{
+	// Consecutive clusters are read with a single request to the blob
+	m_read_buffer.resize(count * s_block_total_size);
+	if (!m_pReader->Read(m_VolumeOffset + m_dataOffset + first_block * s_block_total_size,
+		count * s_block_total_size, m_read_buffer.data()))
+		return false;
+
+	const auto start = std::chrono::steady_clock::now();
+	for (u64 i = 0; i < count; i++)
+	{
+		DecryptedCluster& entry = *std::min_element(m_cluster_cache.begin(), m_cluster_cache.end(),
+			[](const DecryptedCluster& a, const DecryptedCluster& b) { return a.last_use < b.last_use; });
+		u8* cluster = &m_read_buffer[i * s_block_total_size];
+
+		// The only thing we currently use from the 0x000 - 0x3FF part
+		// of the block is the IV (at 0x3D0), but it also contains SHA-1
+		// hashes that IOS uses to check that discs aren't tampered with.
+		// http://wiibrew.org/wiki/Wii_Disc#Encrypted
+#ifdef _M_X86
+		if (cpu_info.bAES)
+		{
+			DecryptCBC_AESNI(m_volume_key.data(), &cluster[0x3D0], &cluster[s_block_header_size],
+				entry.data.data(), s_block_data_size);
+		}
+		else
+#endif
+		{
+			// 0x3D0 - 0x3DF will be overwritten, but that won't affect anything,
+			// because we won't use the content of the read buffer anymore after this
+			mbedtls_aes_crypt_cbc(m_AES_ctx.get(), MBEDTLS_AES_DECRYPT, s_block_data_size,
+				&cluster[0x3D0], &cluster[s_block_header_size], entry.data.data());
+		}
+
+		entry.block = first_block + i;
+		entry.last_use = ++m_cluster_use_counter;
+	}
+
+	m_stats.clusters_decrypted += count;
+	m_stats.decrypt_microseconds += std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now() - start).count();
+	return true;
 }
 
 bool CVolumeWiiCrypted::Read(u64 _ReadOffset, u64 _Length, u8* _pBuffer, bool decrypt) const
@@ -60,39 +211,36 @@ bool CVolumeWiiCrypted::Read(u64 _ReadOffset, u64 _Length, u8* _pBuffer, bool de
 
 	FileMon::FindFilename(_ReadOffset);
 
-	std::vector<u8> read_buffer(s_block_total_size);
 	while (_Length > 0)
 	{
 		// Calculate block offset
 		u64 Block = _ReadOffset / s_block_data_size;
 		u64 Offset = _ReadOffset % s_block_data_size;
 
-		if (m_LastDecryptedBlockOffset != Block)
+		const DecryptedCluster* cluster = FindCluster(Block);
+		if (cluster)
+		{
+			m_stats.cache_hits++;
+		}
+		else
 		{
-			// Read the current block
-			if (!m_pReader->Read(m_VolumeOffset + m_dataOffset + Block * s_block_total_size,
-				s_block_total_size, read_buffer.data()))
+			// Decrypt the run of missing clusters that this read is going to need in one go.
+			// Half the cache at most, so that the batch never evicts its own clusters.
+			const u64 last_block = (_ReadOffset + _Length - 1) / s_block_data_size;
+			u64 count = 1;
+			while (Block + count <= last_block && count < s_cluster_cache_size / 2 &&
+				!FindCluster(Block + count))
+				count++;
+
+			if (!DecryptClusters(Block, count))
 				return false;
-
-			// Decrypt the block's data.
-			// 0x3D0 - 0x3DF in m_pBuffer will be overwritten,
-			// but that won't affect anything, because we won't
-			// use the content of m_pBuffer anymore after this
-			mbedtls_aes_crypt_cbc(m_AES_ctx.get(), MBEDTLS_AES_DECRYPT, s_block_data_size,
-				&read_buffer[0x3D0], &read_buffer[s_block_header_size],
-				m_LastDecryptedBlock);
-			m_LastDecryptedBlockOffset = Block;
-
-			// The only thing we currently use from the 0x000 - 0x3FF part
-			// of the block is the IV (at 0x3D0), but it also contains SHA-1
-			// hashes that IOS uses to check that discs aren't tampered with.
-			// http://wiibrew.org/wiki/Wii_Disc#Encrypted
+			cluster = FindCluster(Block);
 		}
 
 		// Copy the decrypted data
 		u64 MaxSizeToCopy = s_block_data_size - Offset;
 		u64 CopySize = (_Length > MaxSizeToCopy) ? MaxSizeToCopy : _Length;
-		memcpy(_pBuffer, &m_LastDecryptedBlock[Offset], (size_t)CopySize);
+		memcpy(_pBuffer, &cluster->data[Offset], (size_t)CopySize);
 
 		// Update offsets
 		_Length -= CopySize;
@@ -103,6 +251,34 @@ bool CVolumeWiiCrypted::Read(u64 _ReadOffset, u64 _Length, u8* _pBuffer, bool de
 	return true;
 }
 
+std::shared_ptr<const u8> CVolumeWiiCrypted::GetMappedData(u64 offset, u64 length,
+	bool decrypt) const
+{
+	// Decrypted data only exists in the cluster cache
+	if (decrypt || m_pReader == nullptr)
+		return nullptr;
+
+	return m_pReader->GetMappedData(offset, length);
+}
+
+void CVolumeWiiCrypted::WillRead(u64 offset, u64 length, bool decrypt) const
+{
+	if (m_pReader == nullptr || length == 0)
+		return;
+
+	if (!decrypt)
+	{
+		m_pReader->WillRead(offset, length);
+		return;
+	}
+
+	// The clusters holding the range, with their headers
+	const u64 first_block = offset / s_block_data_size;
+	const u64 last_block = (offset + length - 1) / s_block_data_size;
+	m_pReader->WillRead(m_VolumeOffset + m_dataOffset + first_block * s_block_total_size,
+		(last_block - first_block + 1) * s_block_total_size);
+}
+
 bool CVolumeWiiCrypted::GetTitleID(u64* buffer) const
 {
 	// Tik is at m_VolumeOffset size 0x2A4
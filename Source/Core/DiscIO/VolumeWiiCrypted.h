@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <array>
 #include <map>
 #include <mbedtls/aes.h>
 #include <memory>
@@ -21,6 +22,13 @@ enum class BlobType;
 enum class Country;
 enum class Language;
 enum class Platform;
+class IBlobReader;
+
+#ifdef _M_X86
+// AES-128-CBC decryption of <size> bytes, a multiple of 16, with AES-NI.
+// Only call it when cpu_info.bAES is set.
+void DecryptCBC_AESNI(const u8* key, const u8* iv, const u8* src, u8* dst, size_t size);
+#endif
 
 class CVolumeWiiCrypted : public IVolume
 {
@@ -29,6 +37,8 @@ public:
 		const unsigned char* _pVolumeKey);
 	~CVolumeWiiCrypted();
 	bool Read(u64 _Offset, u64 _Length, u8* _pBuffer, bool decrypt) const override;
+	std::shared_ptr<const u8> GetMappedData(u64 offset, u64 length, bool decrypt) const override;
+	void WillRead(u64 offset, u64 length, bool decrypt) const override;
 	bool GetTitleID(u64* buffer) const override;
 	std::vector<u8> GetTMD() const override;
 	std::string GetGameID() const override;
@@ -51,10 +61,31 @@ public:
 	u64 GetSize() const override;
 	u64 GetRawSize() const override;
 
+	struct DecryptionStats
+	{
+		u64 cache_hits = 0;
+		u64 clusters_decrypted = 0;
+		u64 decrypt_microseconds = 0;
+	};
+	DecryptionStats GetDecryptionStats() const { return m_stats; }
+
 private:
 	static const unsigned int s_block_header_size = 0x0400;
 	static const unsigned int s_block_data_size = 0x7C00;
 	static const unsigned int s_block_total_size = s_block_header_size + s_block_data_size;
+	// Decrypted clusters kept around, 992 KiB in total
+	static const size_t s_cluster_cache_size = 32;
+
+	struct DecryptedCluster
+	{
+		u64 block = static_cast<u64>(-1);
+		u64 last_use = 0;
+		std::array<u8, s_block_data_size> data;
+	};
+
+	const DecryptedCluster* FindCluster(u64 block) const;
+	bool DecryptClusters(u64 first_block, u64 count) const;
+	void ClearClusterCache();
 
 	std::unique_ptr<IBlobReader> m_pReader;
 	std::unique_ptr<mbedtls_aes_context> m_AES_ctx;
@@ -62,8 +93,12 @@ private:
 	u64 m_VolumeOffset;
 	u64 m_dataOffset;
 
-	mutable u64 m_LastDecryptedBlockOffset;
-	mutable unsigned char m_LastDecryptedBlock[s_block_data_size];
+	std::array<u8, 16> m_volume_key;
+
+	mutable std::vector<DecryptedCluster> m_cluster_cache;
+	mutable u64 m_cluster_use_counter = 0;
+	mutable std::vector<u8> m_read_buffer;
+	mutable DecryptionStats m_stats;
 };
 
 }  // namespace
@@ -2,25 +2,33 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <getopt.h>
 #include <signal.h>
+#include <sstream>
 #include <string>
 #include <thread>
 #include <unistd.h>
+#include <vector>
 
 #include "Common/CommonTypes.h"
 #include "Common/Event.h"
+#include "Common/FileUtil.h"
 #include "Common/Flag.h"
 #include "Common/Logging/LogManager.h"
 #include "Common/MsgHandler.h"
+#include "Common/StringUtil.h"
+#include "Common/Timer.h"
 
 #include "Core/Analytics.h"
 #include "Core/BootManager.h"
 #include "Core/ConfigManager.h"
 #include "Core/Core.h"
+#include "Core/FifoPlayer/FifoPlayer.h"
 #include "Core/HW/Wiimote.h"
 #include "Core/Host.h"
 #include "Core/IPC_HLE/WII_IPC_HLE.h"
@@ -31,6 +39,7 @@
 
 #include "UICommon/UICommon.h"
 
+#include "VideoCommon/FrameProfiler.h"
 #include "VideoCommon/RenderBase.h"
 #include "VideoCommon/VideoBackendBase.h"
 
@@ -373,20 +382,139 @@ static Platform* GetPlatform()
 	return nullptr;
 }
 
+static std::string EscapeJSON(const std::string& str)
+{
+	std::string result;
+	for (char c : str)
+	{
+		if (c == '"' || c == '\\')
+			result += '\\';
+		if (static_cast<unsigned char>(c) < 0x20)
+			result += StringFromFormat("\\u%04x", c);
+		else
+			result += c;
+	}
+	return result;
+}
+
+// Boots the file and runs it until the emulation stops by itself
+static bool RunUntilStopped(const std::string& filename)
+{
+	s_running.Set();
+	if (!BootManager::BootCore(filename))
+	{
+		fprintf(stderr, "Could not boot %s\n", filename.c_str());
+		return false;
+	}
+
+	while (!Core::IsRunning() && s_running.IsSet())
+	{
+		Core::HostDispatchJobs();
+		updateMainFrameEvent.Wait();
+	}
+
+	if (s_running.IsSet())
+		platform->MainLoop();
+	Core::Stop();
+	Core::Shutdown();
+	return true;
+}
+
+// Replays each fifo log <loops> times with the frame profiler on, and writes the per frame
+// timings to <output> as JSON.
+static bool RunBenchmark(const std::vector<std::string>& files, u32 loops, const std::string& output)
+{
+	SConfig& config = SConfig::GetInstance();
+	const bool cpu_thread = config.bCPUThread;
+	const float emulation_speed = config.m_EmulationSpeed;
+	// Dual core gives the video emulation its own thread, and the replay shouldn't be throttled
+	config.bCPUThread = true;
+	config.m_EmulationSpeed = 0.0f;
+	FifoPlayer::GetInstance().SetLoopCount(loops);
+	FrameProfiler::SetEnabled(true);
+
+	std::ostringstream json;
+	json << "{\n  \"video_backend\": \"" << EscapeJSON(config.m_strVideoBackend) << "\",\n";
+	json << "  \"loops\": " << loops << ",\n  \"runs\": [";
+
+	bool success = true;
+	for (size_t i = 0; i < files.size() && success; i++)
+	{
+		const u64 start_us = Common::Timer::GetTimeUs();
+		success = RunUntilStopped(files[i]);
+		const u64 wall_time_us = Common::Timer::GetTimeUs() - start_us;
+		const std::vector<FrameProfiler::FrameTimes> frames = FrameProfiler::TakeFrames();
+
+		json << (i ? ",\n" : "\n") << "    {\n      \"file\": \"" << EscapeJSON(files[i]) << "\",\n";
+		json << "      \"frames\": " << frames.size() << ",\n";
+		json << "      \"wall_time_ms\": " << StringFromFormat("%.3f", wall_time_us / 1000.0) << ",\n";
+
+		std::ostringstream totals, per_frame;
+		for (int section = 0; section < FrameProfiler::NUM_SECTIONS; section++)
+		{
+			const char* name = FrameProfiler::GetSectionName(static_cast<FrameProfiler::Section>(section));
+			u64 total_ns = 0;
+			per_frame << (section ? ",\n" : "") << "        \"" << name << "\": [";
+			for (size_t frame = 0; frame < frames.size(); frame++)
+			{
+				total_ns += frames[frame].nanoseconds[section];
+				per_frame << (frame ? ", " : "")
+					<< StringFromFormat("%.1f", frames[frame].nanoseconds[section] / 1000.0);
+			}
+			per_frame << "]";
+			totals << (section ? ", " : "") << "\"" << name << "\": "
+				<< StringFromFormat("%.3f", total_ns / 1000000.0);
+
+			fprintf(stderr, "%s: %-14s %10.3f ms over %zu frames\n", files[i].c_str(), name,
+				total_ns / 1000000.0, frames.size());
+		}
+		json << "      \"total_ms\": {" << totals.str() << "},\n";
+		json << "      \"frame_times_us\": {\n" << per_frame.str() << "\n      }\n    }";
+	}
+	json << "\n  ]\n}\n";
+
+	FrameProfiler::SetEnabled(false);
+	FifoPlayer::GetInstance().SetLoopCount(0);
+	config.bCPUThread = cpu_thread;
+	config.m_EmulationSpeed = emulation_speed;
+
+	if (success && !File::WriteStringToFile(json.str(), output))
+	{
+		fprintf(stderr, "Could not write %s\n", output.c_str());
+		success = false;
+	}
+	return success;
+}
+
 int main(int argc, char* argv[])
 {
 	int ch, help = 0;
+	std::string benchmark_output;
+	std::string video_backend;
+	u32 benchmark_loops = 1;
 	struct option longopts[] = { { "exec", no_argument, nullptr, 'e' },
 	{ "help", no_argument, nullptr, 'h' },
 	{ "version", no_argument, nullptr, 'v' },
+	{ "benchmark", required_argument, nullptr, 'b' },
+	{ "loops", required_argument, nullptr, 'l' },
+	{ "video_backend", required_argument, nullptr, 'V' },
 	{ nullptr, 0, nullptr, 0 } };
 
-	while ((ch = getopt_long(argc, argv, "eh?v", longopts, 0)) != -1)
+	while ((ch = getopt_long(argc, argv, "eh?vb:l:V:", longopts, 0)) != -1)
 	{
 		switch (ch)
 		{
 		case 'e':
 			break;
+		case 'b':
+			benchmark_output = optarg;
+			break;
+		case 'l':
+			benchmark_loops = std::max(atoi(optarg), 1);
+			break;
+		case 'V':
+			video_backend = optarg;
+			break;
 		case 'h':
 		case '?':
 			help = 1;
@@ -402,9 +530,13 @@ int main(int argc, char* argv[])
 		fprintf(stderr, "%s\n\n", scm_rev_str.c_str());
 		fprintf(stderr, "A multi-platform GameCube/Wii emulator\n\n");
 		fprintf(stderr, "Usage: %s [-e <file>] [-h] [-v]\n", argv[0]);
-		fprintf(stderr, "  -e, --exec     Load the specified file\n");
-		fprintf(stderr, "  -h, --help     Show this help message\n");
-		fprintf(stderr, "  -v, --version  Print version and exit\n");
+		fprintf(stderr, "       %s -b <output.json> [-l <loops>] [-V <backend>] <file.dff>...\n", argv[0]);
+		fprintf(stderr, "  -e, --exec           Load the specified file\n");
+		fprintf(stderr, "  -h, --help           Show this help message\n");
+		fprintf(stderr, "  -v, --version        Print version and exit\n");
+		fprintf(stderr, "  -b, --benchmark      Replay the fifo logs and write per frame timings as JSON\n");
+		fprintf(stderr, "  -l, --loops          Number of times each fifo log is replayed (default 1)\n");
+		fprintf(stderr, "  -V, --video_backend  Video backend to use, e.g. \"Software Renderer\" or \"OGL\"\n");
 		return 1;
 	}
 
@@ -418,6 +550,10 @@ int main(int argc, char* argv[])
 	UICommon::SetUserDirectory("");  // Auto-detect user folder
 	UICommon::Init();
 
+	const std::string saved_video_backend = SConfig::GetInstance().m_strVideoBackend;
+	if (!video_backend.empty())
+		SConfig::GetInstance().m_strVideoBackend = video_backend;
+
 	Core::SetOnStoppedCallback([]() { s_running.Clear(); });
 	platform->Init();
 
@@ -431,21 +567,34 @@ int main(int argc, char* argv[])
 
 	DolphinAnalytics::Instance()->ReportDolphinStart("nogui");
 
-	if (!BootManager::BootCore(argv[optind]))
+	int result = 0;
+	if (!benchmark_output.empty())
 	{
-		fprintf(stderr, "Could not boot %s\n", argv[optind]);
-		return 1;
+		const std::vector<std::string> files(argv + optind, argv + argc);
+		if (!RunBenchmark(files, benchmark_loops, benchmark_output))
+			result = 1;
 	}
-
-	while (!Core::IsRunning() && s_running.IsSet())
+	else
 	{
-		Core::HostDispatchJobs();
-		updateMainFrameEvent.Wait();
+		if (!BootManager::BootCore(argv[optind]))
+		{
+			fprintf(stderr, "Could not boot %s\n", argv[optind]);
+			return 1;
+		}
+
+		while (!Core::IsRunning() && s_running.IsSet())
+		{
+			Core::HostDispatchJobs();
+			updateMainFrameEvent.Wait();
+		}
+
+		if (s_running.IsSet())
+			platform->MainLoop();
+		Core::Stop();
 	}
 
-	if (s_running.IsSet())
-		platform->MainLoop();
-	Core::Stop();
+	// The backend chosen on the command line is only for this run
+	SConfig::GetInstance().m_strVideoBackend = saved_video_backend;
 
 	Core::Shutdown();
 	platform->Shutdown();
@@ -453,5 +602,5 @@ int main(int argc, char* argv[])
 
 	delete platform;
 
-	return 0;
+	return result;
 }
@@ -134,6 +134,8 @@ static wxString efb_fast_access_desc = _("Use a fast efb caching method to speed
 static wxString efb_emulate_format_changes_desc = _("Ignore any changes to the EFB format.\nImproves performance in many games without any negative effect. Causes graphical defects in a small number of other games though.\n\nIf unsure, leave this checked.");
 static wxString viewport_correction_desc = _("Some games uses viewport values that are not compatible with D3D backends, to solve issues on those games check this.\n\nIf unsure, leave this unchecked.");
 static wxString skip_efb_copy_to_ram_desc = _("Stores EFB Copies exclusively on the GPU, bypassing system memory. Causes graphical defects in a small number of games.\n\nEnabled = EFB Copies to Texture\nDisabled = EFB Copies to RAM (and Texture)\n\nIf unsure, leave this checked.");
+static wxString xxhash3_desc = _("Use xxHash3 to detect texture changes instead of the default hash.\nIt is faster on most CPUs, especially with the accuracy slider set to Safe.\n\nIf unsure, leave this unchecked.");
+static wxString parallel_decoding_desc = _("Decodes large textures on several threads.\nReduces stuttering when games load big textures, on CPUs with more than two cores.\n\nIf unsure, leave this checked.");
 static wxString stc_desc = _("The safer you adjust this, the less likely the emulator will be missing any texture updates from RAM.\n\nIf unsure, use the rightmost value.");
 static wxString bbox_desc = _("Selects wish implementation is used to emulate Bounding Box. By Default GPU will be used if supported.");
 static wxString wireframe_desc = _("Render the scene as a wireframe.\n\nIf unsure, leave this unchecked.");
@@ -168,6 +170,7 @@ static wxString fullAsyncShaderCompilation_desc = _("Make shader compilation pro
 static wxString compute_texture_decoding_desc = _("Decode Textures using compute shaders. Can Increase Performance in some scenarios.");
 static wxString Compute_texture_encoding_desc = _("Encode Textures using compute shaders. Can Increase Performance in some scenarios.");
 static wxString waitforshadercompilation_desc = _("Wait for shader compilation in the cpu to avoid fifo problems. This option prevents loops in F-Zero, Metroid Prime fifo resets and others.");
+static wxString dlist_caching_desc = _("Cache display lists that games call repeatedly and replay them with their vertices already converted.\nReduces the GPU thread load in games that use many static display lists.\n\nIf unsure, leave this unchecked.");
 static wxString predictiveFifo_desc = _("Generate a secondary fifo to predict resource usage and improve loading time.");
 static wxString load_hires_textures_desc = _("Load custom textures from User/Load/Textures/<game_id>/\n\nIf unsure, leave this unchecked.");
 static wxString load_hires_material_maps_desc = _("Load custom material maps from User/Load/Textures/<game_id>/\nUsed to Enable Advanced lighting, Requires Pixel Lighting and Hires Textures Enabled\nIf unsure, leave this unchecked.");
@@ -184,6 +187,7 @@ static wxString dump_frames_desc = _("Dump all rendered frames to an AVI file in
 static wxString use_ffv1_desc = _("Encode frame dumps using the FFV1 codec.\n\nIf unsure, leave this unchecked.");
 #endif
 static wxString free_look_desc = _("This feature allows you to change the game's camera.\nMove the mouse while holding the right mouse button to pan and while holding the middle button to move.\nHold SHIFT and press one of the WASD keys to move the camera by a certain step distance (SHIFT+0 to move faster and SHIFT+9 to move slower). Press SHIFT+R to reset the camera.\n\nIf unsure, leave this unchecked.");
+static wxString vertex_loader_precompile_desc = _("Remembers the vertex formats used by each game, and generates their vertex loaders in the background when the game is started again, instead of when they are first drawn.\n\nIf unsure, leave this checked.");
 static wxString shader_precompile_desc = _("If a database of shader for the current game exists, precompile all known shaders to void issues and stutering during gameplay. This option will increase startup time but will improve gaming experience. Warning: with a clean shader cache dx9 can have up to 20 minutes shader compilation time in some games.");
 static wxString crop_desc = _("Crop the picture from its native aspect ratio to 4:3 or 16:9.\n\nIf unsure, leave this unchecked.");
 static wxString opencl_desc = _("[EXPERIMENTAL]\nAims to speed up emulation by offloading texture decoding to the GPU using the OpenCL framework.\nHowever, right now it's known to cause texture defects in various games. Also it's slower than regular CPU texture decoding in most cases.\n\nIf unsure, leave this unchecked.");
@@ -208,6 +212,8 @@ static wxString Tessellation_round_desc = _("Select the intensity of the roundin
 static wxString Tessellation_displacement_desc = _("Select the intensity of the displacement effect when using custom materials.");
 static wxString scaling_factor_desc = _("Multiplier applied to the texture size.");
 static wxString texture_deposterize_desc = _("Decrease some gradient's artifacts caused by scaling.");
+static wxString texture_scaling_async_desc = _("Scale textures on a background thread. New textures are shown at their original resolution until the scaled version is ready, instead of stalling the game.\n\nIf unsure, leave this unchecked.");
+static wxString texture_scaling_cache_desc = _("Store scaled textures on disk, so they don't have to be scaled again the next time they are used.\nOnly used by asynchronous texture scaling.\n\nIf unsure, leave this unchecked.");
 static wxString stereoshader_desc = _("Selects which shader will be used to transform the two images when stereoscopy is enabled.");
 static wxString forcedLogivOp_desc = _("Force Logic blending support.\nBy default dx11/12 supports logic op blending only on UINT formats, but in some drivers UNORM is also supported but is not detectable.\nThis option will allow you to test if your driver really supports logic blending, but it will crash the emulator if enabled in a platform that does not support it.\n\nIf unsure, leave this unchecked.");
 static wxString backend_multithreading_desc =
@@ -512,6 +518,10 @@ VideoConfigDiag::VideoConfigDiag(wxWindow* parent, const std::string &title)
 			const wxString sf_choices[] = { wxT("1x"), wxT("2x"), wxT("3x"), wxT("4x"), wxT("5x") };
 			szr_texturescaling->Add(label_TextureScale = new wxStaticText(page_enh, wxID_ANY, sf_choices[vconfig.iTexScalingFactor - 1]), 1, wxRIGHT | wxTOP | wxBOTTOM, 5);
 
+			szr_texturescaling->Add(CreateCheckBox(page_enh, _("Asynchronous"), (texture_scaling_async_desc), vconfig.bTexScalingAsync), 1, wxALIGN_CENTER_VERTICAL);
+			szr_texturescaling->Add(CreateCheckBox(page_enh, _("Cache Scaled Textures"), (texture_scaling_cache_desc), vconfig.bTexScalingCache), 1, wxALIGN_CENTER_VERTICAL);
+			szr_texturescaling->AddStretchSpacer();
+
 			wxStaticBoxSizer* const group_scaling = new wxStaticBoxSizer(wxVERTICAL, page_enh, _("Texture Scaling"));
 			group_scaling->Add(szr_texturescaling, 1, wxEXPAND | wxLEFT | wxRIGHT | wxBOTTOM, 5);
 			szr_enh_main->Add(group_scaling, 0, wxEXPAND | wxALL, 5);
@@ -836,6 +846,8 @@ VideoConfigDiag::VideoConfigDiag(wxWindow* parent, const std::string &title)
 			szr_safetex->Add(new wxStaticText(page_hacks, wxID_ANY, _("Safe")), 0, wxLEFT | wxTOP | wxBOTTOM, 5);
 			szr_safetex->Add(stc_slider, 2, wxRIGHT, 0);
 			szr_safetex->Add(new wxStaticText(page_hacks, wxID_ANY, _("Fast")), 0, wxRIGHT | wxTOP | wxBOTTOM, 5);
+			szr_safetex->Add(CreateCheckBox(page_hacks, _("Use xxHash3"), (xxhash3_desc), vconfig.bXXHash3TextureHashing), 0, wxLEFT | wxTOP | wxBOTTOM, 5);
+			szr_safetex->Add(CreateCheckBox(page_hacks, _("Parallel Decoding"), (parallel_decoding_desc), vconfig.bParallelTextureDecoding), 0, wxLEFT | wxTOP | wxBOTTOM, 5);
 			szr_hacks->Add(szr_safetex, 0, wxEXPAND | wxALL, 5);
 		}
 		// - XFB
@@ -887,6 +899,7 @@ VideoConfigDiag::VideoConfigDiag(wxWindow* parent, const std::string &title)
 			szr_other->Add(Async_Shader_compilation = CreateCheckBox(page_hacks, _("Full Async Shader Compilation"), (fullAsyncShaderCompilation_desc), vconfig.bFullAsyncShaderCompilation));
 			szr_other->Add(Compute_Shader_decoding = CreateCheckBox(page_hacks, _("Compute Texture Decoding"), (compute_texture_decoding_desc), vconfig.bEnableComputeTextureDecoding));
 			szr_other->Add(Compute_Shader_encoding = CreateCheckBox(page_hacks, _("Compute Texture Encoding"), (Compute_texture_encoding_desc), vconfig.bEnableComputeTextureEncoding));
+			szr_other->Add(CreateCheckBox(page_hacks, _("Cache Display Lists"), (dlist_caching_desc), vconfig.bDlistCachingEnable));
 			wxStaticBoxSizer* const group_other = new wxStaticBoxSizer(wxVERTICAL, page_hacks, _("Other"));
 			group_other->Add(szr_other, 1, wxEXPAND | wxLEFT | wxRIGHT | wxBOTTOM, 5);
 			szr_hacks->Add(group_other, 0, wxEXPAND | wxALL, 5);
@@ -943,6 +956,7 @@ VideoConfigDiag::VideoConfigDiag(wxWindow* parent, const std::string &title)
 			szr_utility->Add(CreateCheckBox(page_advanced, _("Dump EFB Target"), (dump_efb_desc), vconfig.bDumpEFBTarget));
 			szr_utility->Add(CreateCheckBox(page_advanced, _("Free Look"), (free_look_desc), vconfig.bFreeLook));
 			szr_utility->Add(shaderprecompile = CreateCheckBox(page_advanced, _("Compile Shaders on Startup"), (shader_precompile_desc), vconfig.bCompileShaderOnStartup));
+			szr_utility->Add(CreateCheckBox(page_advanced, _("Compile Vertex Loaders on Startup"), (vertex_loader_precompile_desc), vconfig.bCompileVertexLoadersOnStartup));
 
 #if !defined WIN32 && defined HAVE_LIBAV
 			szr_utility->Add(CreateCheckBox(page_advanced, _("Frame Dumps Use FFV1"), (use_ffv1_desc), vconfig.bUseFFV1));
@@ -388,7 +388,7 @@ void ShaderCache::HandleGSUIDChange(
 	wunit->GenerateCodeHandler = [gs_uid](ShaderCompilerWorkUnit* wunit)
 	{
 		ShaderCode code;
-		code.SetBuffer(wunit->code.data());
+		code.SetBuffer(wunit->code.data(), wunit->code.size());
 		GenerateGeometryShaderCode(code, gs_uid.GetUidData(), API_D3D11);
 		wunit->codesize = (u32)code.BufferSize();
 	};
@@ -448,7 +448,7 @@ void ShaderCache::HandlePSUIDChange(
 	wunit->GenerateCodeHandler = [ps_uid](ShaderCompilerWorkUnit* wunit)
 	{
 		ShaderCode code;
-		code.SetBuffer(wunit->code.data());
+		code.SetBuffer(wunit->code.data(), wunit->code.size());
 		GeneratePixelShaderCodeD3D11(code, ps_uid.GetUidData());
 		wunit->codesize = (u32)code.BufferSize();
 	};
@@ -505,7 +505,7 @@ void ShaderCache::HandleVSUIDChange(
 	wunit->GenerateCodeHandler = [vs_uid](ShaderCompilerWorkUnit* wunit)
 	{
 		ShaderCode code;
-		code.SetBuffer(wunit->code.data());
+		code.SetBuffer(wunit->code.data(), wunit->code.size());
 		GenerateVertexShaderCodeD3D11(code, vs_uid.GetUidData());
 		wunit->codesize = (u32)code.BufferSize();
 	};
@@ -574,7 +574,7 @@ void ShaderCache::HandleTSUIDChange(
 	ShaderCode code;
 	ShaderCompilerWorkUnit *wunit = s_compiler->NewUnit(TESSELLATIONSHADERGEN_BUFFERSIZE);
 	ShaderCompilerWorkUnit *wunitd = s_compiler->NewUnit(TESSELLATIONSHADERGEN_BUFFERSIZE);
-	code.SetBuffer(wunit->code.data());
+	code.SetBuffer(wunit->code.data(), wunit->code.size());
 	GenerateTessellationShaderCode(code, API_D3D11, ts_uid.GetUidData());
 	memcpy(wunitd->code.data(), wunit->code.data(), code.BufferSize());
 
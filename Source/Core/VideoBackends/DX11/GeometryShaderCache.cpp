@@ -272,7 +272,7 @@ void GeometryShaderCache::CompileGShader(const GeometryShaderUid& uid, bool ongp
 	wunit->GenerateCodeHandler = [uid](ShaderCompilerWorkUnit* wunit)
 	{
 		ShaderCode code;
-		code.SetBuffer(wunit->code.data());
+		code.SetBuffer(wunit->code.data(), wunit->code.size());
 		GenerateGeometryShaderCode(code, uid.GetUidData(), API_D3D11);
 		wunit->codesize = (u32)code.BufferSize();
 	};
@@ -189,7 +189,7 @@ void HullDomainShaderCache::CompileHDShader(const TessellationShaderUid& uid, bo
 	ShaderCode code;
 	ShaderCompilerWorkUnit *wunit = s_compiler->NewUnit(TESSELLATIONSHADERGEN_BUFFERSIZE);
 	ShaderCompilerWorkUnit *wunitd = s_compiler->NewUnit(TESSELLATIONSHADERGEN_BUFFERSIZE);
-	code.SetBuffer(wunit->code.data());
+	code.SetBuffer(wunit->code.data(), wunit->code.size());
 	GenerateTessellationShaderCode(code, API_D3D11, uid.GetUidData());
 	memcpy(wunitd->code.data(), wunit->code.data(), code.BufferSize());
 
@@ -617,7 +617,7 @@ void PixelShaderCache::CompilePShader(const PixelShaderUid& uid, bool ongputhrea
 	wunit->GenerateCodeHandler = [uid](ShaderCompilerWorkUnit* wunit)
 	{
 		ShaderCode code;
-		code.SetBuffer(wunit->code.data());
+		code.SetBuffer(wunit->code.data(), wunit->code.size());
 		GeneratePixelShaderCodeD3D11(code, uid.GetUidData());
 		wunit->codesize = (u32)code.BufferSize();
 	};
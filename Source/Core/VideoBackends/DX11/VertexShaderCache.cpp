@@ -263,7 +263,7 @@ void VertexShaderCache::CompileVShader(const VertexShaderUid& uid, bool ongputhr
 	wunit->GenerateCodeHandler = [uid](ShaderCompilerWorkUnit* wunit)
 	{
 		ShaderCode code;
-		code.SetBuffer(wunit->code.data());
+		code.SetBuffer(wunit->code.data(), wunit->code.size());
 		GenerateVertexShaderCodeD3D11(code, uid.GetUidData());
 		wunit->codesize = (u32)code.BufferSize();
 	};
@@ -425,7 +425,7 @@ void PixelShaderCache::CompilePShader(const PixelShaderUid& uid, PIXEL_SHADER_RE
 	wunit->GenerateCodeHandler = [uid, api](ShaderCompilerWorkUnit* wunit)
 	{
 		ShaderCode code;
-		code.SetBuffer(wunit->code.data());
+		code.SetBuffer(wunit->code.data(), wunit->code.size());
 		if (api == API_D3D9_SM20)
 		{
 			GeneratePixelShaderCodeD3D9SM2(code, uid.GetUidData());
@@ -21,6 +21,7 @@
 #include "VideoCommon/GeometryShaderManager.h"
 #include "VideoCommon/ImageWrite.h"
 #include "VideoCommon/PixelShaderManager.h"
+#include "VideoCommon/ShaderSourceCache.h"
 #include "VideoCommon/Statistics.h"
 #include "VideoCommon/VertexShaderManager.h"
 
@@ -43,6 +44,11 @@ std::array<SHADERUID, PIXEL_SHADER_RENDER_MODE::PSRM_DEPTH_ONLY + 1> ProgramShad
 
 static char s_glsl_header[2048] = "";
 
+// Programs are keyed by all three UIDs, so the same vertex and geometry shaders are
+// linked into many of them. Keep their source around instead of regenerating it.
+static ShaderSourceCache<VertexShaderUid> s_vertex_sources(VERTEXSHADERGEN_BUFFERSIZE, 4096);
+static ShaderSourceCache<GeometryShaderUid> s_geometry_sources(GEOMETRYSHADERGEN_BUFFERSIZE, 256);
+
 static std::string GetGLSLVersionString()
 {
 	GLSL_VERSION v = g_ogl_config.eSupportedGLSLVersion;
@@ -225,33 +231,42 @@ SHADER* ProgramShaderCache::CompileShader(const SHADERUID& uid)
 	last_entry[render_mode] = &newentry;
 	newentry.in_cache = 0;
 
-	ShaderCode vcode;
+	const std::string& vcode = s_vertex_sources.GetOrGenerate(uid.vuid,
+		[](ShaderCode& code, const VertexShaderUid& vuid)
+	{
+		GenerateVertexShaderCodeGL(code, vuid.GetUidData());
+	});
 	ShaderCode pcode;
-	ShaderCode gcode;
-	GenerateVertexShaderCodeGL(vcode, uid.vuid.GetUidData());
 	GeneratePixelShaderCodeGL(pcode, uid.puid.GetUidData());
+	const char* gcode = nullptr;
 	if (g_ActiveConfig.backend_info.bSupportsGeometryShaders && !uid.guid.GetUidData().IsPassthrough())
-		GenerateGeometryShaderCode(gcode, uid.guid.GetUidData(), API_OPENGL);
+	{
+		gcode = s_geometry_sources.GetOrGenerate(uid.guid,
+			[](ShaderCode& code, const GeometryShaderUid& guid)
+		{
+			GenerateGeometryShaderCode(code, guid.GetUidData(), API_OPENGL);
+		}).c_str();
+	}
 
 #if defined(_DEBUG) || defined(DEBUGFAST)
 	if (g_ActiveConfig.iLog & CONF_SAVESHADERS)
 	{
 		static int counter = 0;
 		std::string filename = StringFromFormat("%svs_%04i.txt", File::GetUserPath(D_DUMP_IDX).c_str(), counter++);
-		SaveData(filename, vcode.GetBuffer());
+		SaveData(filename, vcode);
 
 		filename = StringFromFormat("%sps_%04i.txt", File::GetUserPath(D_DUMP_IDX).c_str(), counter++);
 		SaveData(filename, pcode.GetBuffer());
 
-		if (gcode.GetBuffer() != nullptr)
+		if (gcode != nullptr)
 		{
 			filename = StringFromFormat("%sgs_%04i.txt", File::GetUserPath(D_DUMP_IDX).c_str(), counter++);
-			SaveData(filename, gcode.GetBuffer());
+			SaveData(filename, gcode);
 		}
 	}
 #endif
 
-	if (!CompileShader(newentry.shader, vcode.GetBuffer(), pcode.GetBuffer(), gcode.GetBuffer()))
+	if (!CompileShader(newentry.shader, vcode.c_str(), pcode.GetBuffer(), gcode))
 	{
 		GFX_DEBUGGER_PAUSE_AT(NEXT_ERROR, true);
 		return nullptr;
@@ -554,6 +569,9 @@ void ProgramShaderCache::Shutdown()
 		g_program_disk_cache.Sync();
 		g_program_disk_cache.Close();
 	}
+	// The generated source depends on the configuration, which may change before Init
+	s_vertex_sources.Clear();
+	s_geometry_sources.Clear();
 	s_buffer.reset();
 }
 
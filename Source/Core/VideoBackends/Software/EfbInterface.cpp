@@ -8,6 +8,7 @@
 #include "Common/CommonTypes.h"
 #include "Common/Logging/Log.h"
 #include "VideoBackends/Software/EfbInterface.h"
+#include "VideoBackends/Software/PixelKernels.h"
 #include "VideoCommon/BPMemory.h"
 #include "VideoCommon/LookUpTables.h"
 #include "VideoCommon/PerfQueryBase.h"
@@ -18,6 +19,18 @@ static u8 efb[EFB_WIDTH*EFB_HEIGHT * 6];
 namespace EfbInterface
 {
 u32 perf_values[PQ_NUM_MEMBERS];
+static u32 perf_quad_pixels[PQ_NUM_MEMBERS];
+
+void AddPerfCounterPixels(PerfQueryType type, u32 pixels)
+{
+	// NOTE: hardware doesn't process individual pixels but quads instead.
+	// Current software renderer architecture works on pixels though, so
+	// we have this "quad" hack here to only increment the registers on
+	// every fourth rendered pixel
+	perf_quad_pixels[type] += pixels;
+	perf_values[type] += perf_quad_pixels[type] / 3;
+	perf_quad_pixels[type] %= 3;
+}
 
 static inline u32 GetColorOffset(u16 x, u16 y)
 {
@@ -29,6 +42,19 @@ static inline u32 GetDepthOffset(u16 x, u16 y)
 	return (x + y * EFB_WIDTH) * 3 + DEPTH_BUFFER_START;
 }
 
+// Pixels are packed in 3 bytes, only those are touched so neighbouring pixels can be drawn from other threads
+static inline u32 ReadPixel(u32 offset)
+{
+	return efb[offset] | efb[offset + 1] << 8 | efb[offset + 2] << 16;
+}
+
+static inline void WritePixel(u32 offset, u32 val)
+{
+	efb[offset] = val & 0xff;
+	efb[offset + 1] = (val >> 8) & 0xff;
+	efb[offset + 2] = (val >> 16) & 0xff;
+}
+
 static void SetPixelAlphaOnly(u32 offset, u8 a)
 {
 	switch (bpmem.zcontrol.pixel_format)
@@ -41,10 +67,9 @@ static void SetPixelAlphaOnly(u32 offset, u8 a)
 	case PEControl::RGBA6_Z24:
 	{
 		u32 a32 = a;
-		u32 *dst = (u32*)&efb[offset];
-		u32 val = *dst & 0xffffffc0;
+		u32 val = ReadPixel(offset) & 0xffffffc0;
 		val |= (a32 >> 2) & 0x0000003f;
-		*dst = val;
+		WritePixel(offset, val);
 	}
 	break;
 	default:
@@ -60,31 +85,26 @@ static void SetPixelColorOnly(u32 offset, u8 *rgb)
 	case PEControl::Z24:
 	{
 		u32 src = *(u32*)rgb;
-		u32 *dst = (u32*)&efb[offset];
-		u32 val = *dst & 0xff000000;
-		val |= src >> 8;
-		*dst = val;
+		u32 val = src >> 8;
+		WritePixel(offset, val);
 	}
 	break;
 	case PEControl::RGBA6_Z24:
 	{
 		u32 src = *(u32*)rgb;
-		u32 *dst = (u32*)&efb[offset];
-		u32 val = *dst & 0xff00003f;
+		u32 val = ReadPixel(offset) & 0xff00003f;
 		val |= (src >> 4) & 0x00000fc0; // blue
 		val |= (src >> 6) & 0x0003f000; // green
 		val |= (src >> 8) & 0x00fc0000; // red
-		*dst = val;
+		WritePixel(offset, val);
 	}
 	break;
 	case PEControl::RGB565_Z16:
 	{
 		INFO_LOG(VIDEO, "RGB565_Z16 is not supported correctly yet");
 		u32 src = *(u32*)rgb;
-		u32 *dst = (u32*)&efb[offset];
-		u32 val = *dst & 0xff000000;
-		val |= src >> 8;
-		*dst = val;
+		u32 val = src >> 8;
+		WritePixel(offset, val);
 	}
 	break;
 	default:
@@ -100,32 +120,26 @@ static void SetPixelAlphaColor(u32 offset, u8 *color)
 	case PEControl::Z24:
 	{
 		u32 src = *(u32*)color;
-		u32 *dst = (u32*)&efb[offset];
-		u32 val = *dst & 0xff000000;
-		val |= src >> 8;
-		*dst = val;
+		u32 val = src >> 8;
+		WritePixel(offset, val);
 	}
 	break;
 	case PEControl::RGBA6_Z24:
 	{
 		u32 src = *(u32*)color;
-		u32 *dst = (u32*)&efb[offset];
-		u32 val = *dst & 0xff000000;
-		val |= (src >> 2) & 0x0000003f; // alpha
+		u32 val = (src >> 2) & 0x0000003f; // alpha
 		val |= (src >> 4) & 0x00000fc0; // blue
 		val |= (src >> 6) & 0x0003f000; // green
 		val |= (src >> 8) & 0x00fc0000; // red
-		*dst = val;
+		WritePixel(offset, val);
 	}
 	break;
 	case PEControl::RGB565_Z16:
 	{
 		INFO_LOG(VIDEO, "RGB565_Z16 is not supported correctly yet");
 		u32 src = *(u32*)color;
-		u32 *dst = (u32*)&efb[offset];
-		u32 val = *dst & 0xff000000;
-		val |= src >> 8;
-		*dst = val;
+		u32 val = src >> 8;
+		WritePixel(offset, val);
 	}
 	break;
 	default:
@@ -140,7 +154,7 @@ static void GetPixelColor(u32 offset, u8 *color)
 	case PEControl::RGB8_Z24:
 	case PEControl::Z24:
 	{
-		u32 src = *(u32*)&efb[offset];
+		u32 src = ReadPixel(offset);
 		u32 *dst = (u32*)color;
 		u32 val = 0xff | ((src & 0x00ffffff) << 8);
 		*dst = val;
@@ -148,7 +162,7 @@ static void GetPixelColor(u32 offset, u8 *color)
 	break;
 	case PEControl::RGBA6_Z24:
 	{
-		u32 src = *(u32*)&efb[offset];
+		u32 src = ReadPixel(offset);
 		color[ALP_C] = Convert6To8(src & 0x3f);
 		color[BLU_C] = Convert6To8((src >> 6) & 0x3f);
 		color[GRN_C] = Convert6To8((src >> 12) & 0x3f);
@@ -158,7 +172,7 @@ static void GetPixelColor(u32 offset, u8 *color)
 	case PEControl::RGB565_Z16:
 	{
 		INFO_LOG(VIDEO, "RGB565_Z16 is not supported correctly yet");
-		u32 src = *(u32*)&efb[offset];
+		u32 src = ReadPixel(offset);
 		u32 *dst = (u32*)color;
 		u32 val = 0xff | ((src & 0x00ffffff) << 8);
 		*dst = val;
@@ -177,19 +191,15 @@ static void SetPixelDepth(u32 offset, u32 depth)
 	case PEControl::RGBA6_Z24:
 	case PEControl::Z24:
 	{
-		u32 *dst = (u32*)&efb[offset];
-		u32 val = *dst & 0xff000000;
-		val |= depth & 0x00ffffff;
-		*dst = val;
+		u32 val = depth & 0x00ffffff;
+		WritePixel(offset, val);
 	}
 	break;
 	case PEControl::RGB565_Z16:
 	{
 		INFO_LOG(VIDEO, "RGB565_Z16 is not supported correctly yet");
-		u32 *dst = (u32*)&efb[offset];
-		u32 val = *dst & 0xff000000;
-		val |= depth & 0x00ffffff;
-		*dst = val;
+		u32 val = depth & 0x00ffffff;
+		WritePixel(offset, val);
 	}
 	break;
 	default:
@@ -207,13 +217,13 @@ static u32 GetPixelDepth(u32 offset)
 	case PEControl::RGBA6_Z24:
 	case PEControl::Z24:
 	{
-		depth = (*(u32*)&efb[offset]) & 0x00ffffff;
+		depth = ReadPixel(offset) & 0x00ffffff;
 	}
 	break;
 	case PEControl::RGB565_Z16:
 	{
 		INFO_LOG(VIDEO, "RGB565_Z16 is not supported correctly yet");
-		depth = (*(u32*)&efb[offset]) & 0x00ffffff;
+		depth = ReadPixel(offset) & 0x00ffffff;
 	}
 	break;
 	default:
@@ -310,21 +320,7 @@ static void BlendColor(u8 *srcClr, u8 *dstClr)
 	u32 srcFactor = GetSourceFactor(srcClr, dstClr, bpmem.blendmode.srcfactor);
 	u32 dstFactor = GetDestinationFactor(srcClr, dstClr, bpmem.blendmode.dstfactor);
 
-	for (int i = 0; i < 4; i++)
-	{
-		// add MSB of factors to make their range 0 -> 256
-		u32 sf = (srcFactor & 0xff);
-		sf += sf >> 7;
-
-		u32 df = (dstFactor & 0xff);
-		df += df >> 7;
-
-		u32 color = (srcClr[i] * sf + dstClr[i] * df) >> 8;
-		dstClr[i] = (color > 255) ? 255 : color;
-
-		dstFactor >>= 8;
-		srcFactor >>= 8;
-	}
+	PixelKernels::Blend(srcClr, dstClr, srcFactor, dstFactor, dstClr);
 }
 
 static void LogicBlend(u32 srcClr, u32* dstClr, BlendMode::LogicOp op)
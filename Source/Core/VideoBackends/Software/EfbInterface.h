@@ -61,16 +61,7 @@ void CopyToXFB(yuv422_packed* xfb_in_ram, u32 fbWidth, u32 fbHeight, const EFBRe
 void BypassXFB(u8* texture, u32 fbWidth, u32 fbHeight, const EFBRectangle& sourceRc, float Gamma);
 
 extern u32 perf_values[PQ_NUM_MEMBERS];
-inline void IncPerfCounterQuadCount(PerfQueryType type)
-{
-	// NOTE: hardware doesn't process individual pixels but quads instead.
-	// Current software renderer architecture works on pixels though, so
-	// we have this "quad" hack here to only increment the registers on
-	// every fourth rendered pixel
-	static u32 quad[PQ_NUM_MEMBERS];
-	if (++quad[type] != 3)
-		return;
-	quad[type] = 0;
-	++perf_values[type];
-}
+// Adds the given number of drawn pixels to a perf counter. The rasterizer threads count
+// pixels on their own and hand the totals over here once they are done.
+void AddPerfCounterPixels(PerfQueryType type, u32 pixels);
 }
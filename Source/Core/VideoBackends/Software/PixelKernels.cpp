@@ -0,0 +1,198 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <cstring>
+
+#include "Common/CommonTypes.h"
+#include "Common/Intrinsics.h"
+#include "VideoBackends/Software/PixelKernels.h"
+
+namespace PixelKernels
+{
+static const s16 s_bias[4] = { 0, 128, -128, 0 };
+static const u8 s_scale_lshift[4] = { 0, 1, 2, 0 };
+static const u8 s_scale_rshift[4] = { 0, 0, 0, 1 };
+
+enum
+{
+	ALP_C,
+	BLU_C,
+	GRN_C,
+	RED_C
+};
+
+struct InputRegType
+{
+	unsigned a : 8;
+	unsigned b : 8;
+	unsigned c : 8;
+	signed   d : 11;
+};
+
+static inline s16 Clamp255(s16 in)
+{
+	return in > 255 ? 255 : (in < 0 ? 0 : in);
+}
+
+static inline s16 Clamp1024(s16 in)
+{
+	return in > 1023 ? 1023 : (in < -1024 ? -1024 : in);
+}
+
+void CombineRegularScalar(const CombinerInputs& in, const TevStageCombiner::ColorCombiner& cc,
+	const TevStageCombiner::AlphaCombiner& ac, s16 out[4])
+{
+	InputRegType inputs[4];
+	for (int i = 0; i < 4; i++)
+	{
+		inputs[i].a = in.a[i];
+		inputs[i].b = in.b[i];
+		inputs[i].c = in.c[i];
+		inputs[i].d = in.d[i];
+	}
+
+	for (int i = BLU_C; i <= RED_C; i++)
+	{
+		const InputRegType& InputReg = inputs[i];
+
+		u16 c = InputReg.c + (InputReg.c >> 7);
+
+		s32 temp = InputReg.a * (256 - c) + (InputReg.b * c);
+		temp <<= s_scale_lshift[cc.shift];
+		temp += (cc.shift == 3) ? 0 : (cc.op == 1) ? 127 : 128;
+		temp >>= 8;
+		temp = cc.op ? -temp : temp;
+
+		s32 result = ((InputReg.d + s_bias[cc.bias]) << s_scale_lshift[cc.shift]) + temp;
+		result = result >> s_scale_rshift[cc.shift];
+
+		out[i] = result;
+		out[i] = cc.clamp ? Clamp255(out[i]) : Clamp1024(out[i]);
+	}
+
+	const InputRegType& InputReg = inputs[ALP_C];
+
+	u16 c = InputReg.c + (InputReg.c >> 7);
+
+	s32 temp = InputReg.a * (256 - c) + (InputReg.b * c);
+	temp <<= s_scale_lshift[ac.shift];
+	temp += (ac.shift != 3) ? 0 : (ac.op == 1) ? 127 : 128;
+	temp = ac.op ? (-temp >> 8) : (temp >> 8);
+
+	s32 result = ((InputReg.d + s_bias[ac.bias]) << s_scale_lshift[ac.shift]) + temp;
+	result = result >> s_scale_rshift[ac.shift];
+
+	out[ALP_C] = result;
+	out[ALP_C] = ac.clamp ? Clamp255(out[ALP_C]) : Clamp1024(out[ALP_C]);
+}
+
+void BlendScalar(const u8* src, const u8* dst, u32 srcFactor, u32 dstFactor, u8* out)
+{
+	for (int i = 0; i < 4; i++)
+	{
+		// add MSB of factors to make their range 0 -> 256
+		u32 sf = (srcFactor & 0xff);
+		sf += sf >> 7;
+
+		u32 df = (dstFactor & 0xff);
+		df += df >> 7;
+
+		u32 color = (src[i] * sf + dst[i] * df) >> 8;
+		out[i] = (color > 255) ? 255 : color;
+
+		dstFactor >>= 8;
+		srcFactor >>= 8;
+	}
+}
+
+#ifdef _M_X86
+
+// Takes the alpha lane from alpha and the color lanes from color
+static inline __m128i SelectLanes(__m128i alpha, __m128i color)
+{
+	const __m128i alpha_mask = _mm_set_epi32(0, 0, 0, -1);
+	return _mm_or_si128(_mm_and_si128(alpha_mask, alpha), _mm_andnot_si128(alpha_mask, color));
+}
+
+static inline __m128i ShiftLeftLanes(__m128i v, int alpha_shift, int color_shift)
+{
+	return SelectLanes(_mm_sll_epi32(v, _mm_cvtsi32_si128(alpha_shift)), _mm_sll_epi32(v, _mm_cvtsi32_si128(color_shift)));
+}
+
+void CombineRegularSSE2(const CombinerInputs& in, const TevStageCombiner::ColorCombiner& cc,
+	const TevStageCombiner::AlphaCombiner& ac, s16 out[4])
+{
+	const __m128i byte_mask = _mm_set1_epi16(0xff);
+	const __m128i a = _mm_and_si128(_mm_loadl_epi64((const __m128i*)in.a), byte_mask);
+	const __m128i b = _mm_and_si128(_mm_loadl_epi64((const __m128i*)in.b), byte_mask);
+	__m128i c = _mm_and_si128(_mm_loadl_epi64((const __m128i*)in.c), byte_mask);
+	c = _mm_add_epi16(c, _mm_srli_epi16(c, 7));
+
+	// a * (256 - c) + b * c, in 32 bits
+	__m128i temp = _mm_madd_epi16(_mm_unpacklo_epi16(a, b), _mm_unpacklo_epi16(_mm_sub_epi16(_mm_set1_epi16(256), c), c));
+	temp = ShiftLeftLanes(temp, s_scale_lshift[ac.shift], s_scale_lshift[cc.shift]);
+
+	const s32 color_round = (cc.shift == 3) ? 0 : (cc.op == 1) ? 127 : 128;
+	const s32 alpha_round = (ac.shift != 3) ? 0 : (ac.op == 1) ? 127 : 128;
+	temp = _mm_add_epi32(temp, _mm_set_epi32(color_round, color_round, color_round, alpha_round));
+
+	// alpha is negated before dropping the fraction, color after it
+	const s32 color_negate = cc.op ? -1 : 0;
+	const __m128i negate_alpha = _mm_set_epi32(0, 0, 0, ac.op ? -1 : 0);
+	const __m128i negate_color = _mm_set_epi32(color_negate, color_negate, color_negate, 0);
+	temp = _mm_sub_epi32(_mm_xor_si128(temp, negate_alpha), negate_alpha);
+	temp = _mm_srai_epi32(temp, 8);
+	temp = _mm_sub_epi32(_mm_xor_si128(temp, negate_color), negate_color);
+
+	// d is signed 11 bit
+	__m128i d = _mm_srai_epi16(_mm_slli_epi16(_mm_loadl_epi64((const __m128i*)in.d), 5), 5);
+	d = _mm_srai_epi32(_mm_unpacklo_epi16(d, d), 16);
+	const s32 color_bias = s_bias[cc.bias];
+	d = _mm_add_epi32(d, _mm_set_epi32(color_bias, color_bias, color_bias, s_bias[ac.bias]));
+	d = ShiftLeftLanes(d, s_scale_lshift[ac.shift], s_scale_lshift[cc.shift]);
+
+	__m128i result = _mm_add_epi32(d, temp);
+	result = SelectLanes(_mm_sra_epi32(result, _mm_cvtsi32_si128(s_scale_rshift[ac.shift])),
+		_mm_sra_epi32(result, _mm_cvtsi32_si128(s_scale_rshift[cc.shift])));
+
+	// wrap to the 16 bits of the registers, then clamp
+	result = _mm_srai_epi32(_mm_slli_epi32(result, 16), 16);
+	__m128i result16 = _mm_packs_epi32(result, result);
+	const s16 color_min = cc.clamp ? 0 : -1024;
+	const s16 color_max = cc.clamp ? 255 : 1023;
+	const s16 alpha_min = ac.clamp ? 0 : -1024;
+	const s16 alpha_max = ac.clamp ? 255 : 1023;
+	result16 = _mm_min_epi16(result16, _mm_set_epi16(0, 0, 0, 0, color_max, color_max, color_max, alpha_max));
+	result16 = _mm_max_epi16(result16, _mm_set_epi16(0, 0, 0, 0, color_min, color_min, color_min, alpha_min));
+	_mm_storel_epi64((__m128i*)out, result16);
+}
+
+void BlendSSE2(const u8* src, const u8* dst, u32 srcFactor, u32 dstFactor, u8* out)
+{
+	u32 src32, dst32;
+	std::memcpy(&src32, src, sizeof(u32));
+	std::memcpy(&dst32, dst, sizeof(u32));
+
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i s = _mm_unpacklo_epi8(_mm_cvtsi32_si128(src32), zero);
+	const __m128i d = _mm_unpacklo_epi8(_mm_cvtsi32_si128(dst32), zero);
+	__m128i sf = _mm_unpacklo_epi8(_mm_cvtsi32_si128(srcFactor), zero);
+	__m128i df = _mm_unpacklo_epi8(_mm_cvtsi32_si128(dstFactor), zero);
+
+	// add MSB of factors to make their range 0 -> 256
+	sf = _mm_add_epi16(sf, _mm_srli_epi16(sf, 7));
+	df = _mm_add_epi16(df, _mm_srli_epi16(df, 7));
+
+	__m128i color = _mm_madd_epi16(_mm_unpacklo_epi16(s, d), _mm_unpacklo_epi16(sf, df));
+	color = _mm_srli_epi32(color, 8);
+	// the unsigned saturation clamps to 255
+	color = _mm_packs_epi32(color, color);
+	color = _mm_packus_epi16(color, color);
+
+	u32 result = _mm_cvtsi128_si32(color);
+	std::memcpy(out, &result, sizeof(u32));
+}
+
+#endif
+}
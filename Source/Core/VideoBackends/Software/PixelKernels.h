@@ -0,0 +1,57 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "Common/CommonTypes.h"
+#include "VideoCommon/BPMemory.h"
+
+// Per pixel math of the TEV combiners and the blender, working on all four components of a pixel
+// at once. Components are in ABGR order, like the TEV registers.
+// The scalar versions are the reference, the SIMD ones must match them bit for bit.
+namespace PixelKernels
+{
+// Raw register values feeding a combiner stage. a, b and c are truncated to 8 bits and d to 11,
+// which is the precision of the TEV inputs.
+struct CombinerInputs
+{
+	s16 a[4];
+	s16 b[4];
+	s16 c[4];
+	s16 d[4];
+};
+
+// Runs a stage whose color and alpha combiners are both in regular (non compare) mode,
+// including the final clamping. Alpha goes to out[0], color to out[1..3].
+void CombineRegularScalar(const CombinerInputs& in, const TevStageCombiner::ColorCombiner& cc,
+	const TevStageCombiner::AlphaCombiner& ac, s16 out[4]);
+
+// Blends src over dst with the given per component factors, stored one per byte.
+void BlendScalar(const u8* src, const u8* dst, u32 srcFactor, u32 dstFactor, u8* out);
+
+#ifdef _M_X86
+void CombineRegularSSE2(const CombinerInputs& in, const TevStageCombiner::ColorCombiner& cc,
+	const TevStageCombiner::AlphaCombiner& ac, s16 out[4]);
+void BlendSSE2(const u8* src, const u8* dst, u32 srcFactor, u32 dstFactor, u8* out);
+#endif
+
+inline void CombineRegular(const CombinerInputs& in, const TevStageCombiner::ColorCombiner& cc,
+	const TevStageCombiner::AlphaCombiner& ac, s16 out[4])
+{
+#ifdef _M_X86
+	CombineRegularSSE2(in, cc, ac, out);
+#else
+	CombineRegularScalar(in, cc, ac, out);
+#endif
+}
+
+inline void Blend(const u8* src, const u8* dst, u32 srcFactor, u32 dstFactor, u8* out)
+{
+#ifdef _M_X86
+	BlendSSE2(src, dst, srcFactor, dstFactor, out);
+#else
+	BlendScalar(src, dst, srcFactor, dstFactor, out);
+#endif
+}
+}
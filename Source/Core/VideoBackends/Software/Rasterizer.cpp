@@ -4,8 +4,11 @@
 
 #include <algorithm>
 #include <cstring>
+#include <mutex>
+#include <vector>
 
 #include "Common/CommonTypes.h"
+#include "Common/ThreadPool.h"
 #include "VideoBackends/Software/EfbInterface.h"
 #include "VideoBackends/Software/NativeVertexFormat.h"
 #include "VideoBackends/Software/Rasterizer.h"
@@ -20,27 +23,65 @@ namespace Rasterizer
 {
 static constexpr int BLOCK_SIZE = 2;
 
-static Slope ZSlope;
-static Slope WSlope;
-static Slope ColorSlopes[2][4];
-static Slope TexSlopes[8][3];
+// Triangles are sorted into tiles of the EFB, which are shaded in parallel.
+// Tiles are aligned to blocks, so no block is ever split between two threads.
+static constexpr int TILE_SIZE = 32;
+static constexpr int TILES_X = (EFB_WIDTH + TILE_SIZE - 1) / TILE_SIZE;
+static constexpr int TILES_Y = (EFB_HEIGHT + TILE_SIZE - 1) / TILE_SIZE;
+static_assert(TILE_SIZE % BLOCK_SIZE == 0, "Tiles must be made of whole blocks");
 
-static s32 vertex0X;
-static s32 vertex0Y;
-static float vertexOffsetX;
-static float vertexOffsetY;
+// A triangle after setup, which is all the rasterizer needs to draw it.
+struct Triangle
+{
+	Slope ZSlope;
+	Slope WSlope;
+	Slope ColorSlopes[2][4];
+	Slope TexSlopes[8][3];
+
+	s32 vertex0X;
+	s32 vertex0Y;
+	float vertexOffsetX;
+	float vertexOffsetY;
+
+	// 28.4 fixed point deltas and half-edge constants
+	s32 DX12, DX23, DX31;
+	s32 DY12, DY23, DY31;
+	s32 C1, C2, C3;
+
+	// Scissored bounding rectangle
+	s32 minx, maxx, miny, maxy;
+};
+
+// Pixel pipeline state of a thread drawing triangles
+struct RasterContext
+{
+	Tev tev;
+	RasterBlock rasterBlock;
+	s32 blockX;
+	s32 blockY;
+	u32 rasterizedPixels;
+};
+
+// Kept across triangles for zfreeze
+static Slope ZSlope;
 
 static s32 scissorLeft = 0;
 static s32 scissorTop = 0;
 static s32 scissorRight = 0;
 static s32 scissorBottom = 0;
 
-static Tev tev;
-static RasterBlock rasterBlock;
+// Holds the TEV registers, and draws the triangles of the bounding box pass which isn't binned
+static RasterContext s_context;
+
+static std::vector<Triangle> s_triangles;
+static std::vector<u32> s_tile_triangles[TILES_X * TILES_Y];
+static std::vector<s32> s_used_tiles;
+static std::mutex s_counters_lock;
 
 void Init()
 {
-	tev.Init();
+	s_context.tev.Init();
+	s_context.rasterizedPixels = 0;
 
 	// Set initial z reference plane in the unlikely case that zfreeze is enabled when drawing the first primitive.
 	// TODO: This is just a guess!
@@ -94,32 +135,34 @@ void SetScissor()
 
 void SetTevReg(int reg, int comp, bool konst, s16 color)
 {
-	tev.SetRegColor(reg, comp, konst, color);
+	s_context.tev.SetRegColor(reg, comp, konst, color);
 }
 
-static void Draw(s32 x, s32 y, s32 xi, s32 yi)
+static void Draw(const Triangle& tri, RasterContext& ctx, s32 x, s32 y, s32 xi, s32 yi)
 {
-	INCSTAT(stats.thisFrame.rasterizedPixels);
+	Tev& tev = ctx.tev;
+	const RasterBlock& rasterBlock = ctx.rasterBlock;
+	ctx.rasterizedPixels++;
 
-	float dx = vertexOffsetX + (float)(x - vertex0X);
-	float dy = vertexOffsetY + (float)(y - vertex0Y);
+	float dx = tri.vertexOffsetX + (float)(x - tri.vertex0X);
+	float dy = tri.vertexOffsetY + (float)(y - tri.vertex0Y);
 
-	s32 z = (s32)MathUtil::Clamp<float>(ZSlope.GetValue(dx, dy), 0.0f, 16777215.0f);
+	s32 z = (s32)MathUtil::Clamp<float>(tri.ZSlope.GetValue(dx, dy), 0.0f, 16777215.0f);
 
 	if (!BoundingBox::active && bpmem.UseEarlyDepthTest() && g_ActiveConfig.bZComploc)
 	{
 		// TODO: Test if perf regs are incremented even if test is disabled
-		EfbInterface::IncPerfCounterQuadCount(PQ_ZCOMP_INPUT_ZCOMPLOC);
+		tev.PerfPixels[PQ_ZCOMP_INPUT_ZCOMPLOC]++;
 		if (bpmem.zmode.testenable)
 		{
 			// early z
 			if (!EfbInterface::ZCompare(x, y, z))
 				return;
 		}
-		EfbInterface::IncPerfCounterQuadCount(PQ_ZCOMP_OUTPUT_ZCOMPLOC);
+		tev.PerfPixels[PQ_ZCOMP_OUTPUT_ZCOMPLOC]++;
 	}
 
-	RasterBlockPixel& pixel = rasterBlock.Pixel[xi][yi];
+	const RasterBlockPixel& pixel = rasterBlock.Pixel[xi][yi];
 
 	tev.Position[0] = x;
 	tev.Position[1] = y;
@@ -130,7 +173,7 @@ static void Draw(s32 x, s32 y, s32 xi, s32 yi)
 	{
 		for (int comp = 0; comp < 4; comp++)
 		{
-			u16 color = (u16)ColorSlopes[i][comp].GetValue(dx, dy);
+			u16 color = (u16)tri.ColorSlopes[i][comp].GetValue(dx, dy);
 
 			// clamp color value to 0
 			u16 mask = ~(color >> 8);
@@ -162,16 +205,16 @@ static void Draw(s32 x, s32 y, s32 xi, s32 yi)
 	tev.Draw();
 }
 
-static void InitTriangle(float X1, float Y1, s32 xi, s32 yi)
+static void InitTriangle(Triangle* tri, float X1, float Y1, s32 xi, s32 yi)
 {
-	vertex0X = xi;
-	vertex0Y = yi;
+	tri->vertex0X = xi;
+	tri->vertex0Y = yi;
 
 	// adjust a little less than 0.5
 	const float adjust = 0.495f;
 
-	vertexOffsetX = ((float)xi - X1) + adjust;
-	vertexOffsetY = ((float)yi - Y1) + adjust;
+	tri->vertexOffsetX = ((float)xi - X1) + adjust;
+	tri->vertexOffsetY = ((float)yi - Y1) + adjust;
 }
 
 static void InitSlope(Slope *slope, float f1, float f2, float f3, float DX31, float DX12, float DY12, float DY31)
@@ -186,7 +229,7 @@ static void InitSlope(Slope *slope, float f1, float f2, float f3, float DX31, fl
 	slope->f0 = f1;
 }
 
-static inline void CalculateLOD(s32* lodp, bool* linear, u32 texmap, u32 texcoord)
+static inline void CalculateLOD(const RasterBlock& rasterBlock, s32* lodp, bool* linear, u32 texmap, u32 texcoord)
 {
 	const FourTexUnits& texUnit = bpmem.tex[(texmap >> 2) & 1];
 	const u8 subTexmap = texmap & 3;
@@ -199,17 +242,17 @@ static inline void CalculateLOD(s32* lodp, bool* linear, u32 texmap, u32 texcoor
 	float sDelta, tDelta;
 	if (tm0.diag_lod)
 	{
-		float *uv0 = rasterBlock.Pixel[0][0].Uv[texcoord];
-		float *uv1 = rasterBlock.Pixel[1][1].Uv[texcoord];
+		const float *uv0 = rasterBlock.Pixel[0][0].Uv[texcoord];
+		const float *uv1 = rasterBlock.Pixel[1][1].Uv[texcoord];
 
 		sDelta = fabsf(uv0[0] - uv1[0]);
 		tDelta = fabsf(uv0[1] - uv1[1]);
 	}
 	else
 	{
-		float *uv0 = rasterBlock.Pixel[0][0].Uv[texcoord];
-		float *uv1 = rasterBlock.Pixel[1][0].Uv[texcoord];
-		float *uv2 = rasterBlock.Pixel[0][1].Uv[texcoord];
+		const float *uv0 = rasterBlock.Pixel[0][0].Uv[texcoord];
+		const float *uv1 = rasterBlock.Pixel[1][0].Uv[texcoord];
+		const float *uv2 = rasterBlock.Pixel[0][1].Uv[texcoord];
 
 		sDelta = std::max(fabsf(uv0[0] - uv1[0]), fabsf(uv0[0] - uv2[0]));
 		tDelta = std::max(fabsf(uv0[1] - uv1[1]), fabsf(uv0[1] - uv2[1]));
@@ -234,7 +277,7 @@ static inline void CalculateLOD(s32* lodp, bool* linear, u32 texmap, u32 texcoor
 	*lodp = lod;
 }
 
-static void BuildBlock(s32 blockX, s32 blockY)
+static void BuildBlock(const Triangle& tri, RasterBlock& rasterBlock, s32 blockX, s32 blockY)
 {
 	for (s32 yi = 0; yi < BLOCK_SIZE; yi++)
 	{
@@ -242,10 +285,10 @@ static void BuildBlock(s32 blockX, s32 blockY)
 		{
 			RasterBlockPixel& pixel = rasterBlock.Pixel[xi][yi];
 
-			float dx = vertexOffsetX + (float)(xi + blockX - vertex0X);
-			float dy = vertexOffsetY + (float)(yi + blockY - vertex0Y);
+			float dx = tri.vertexOffsetX + (float)(xi + blockX - tri.vertex0X);
+			float dy = tri.vertexOffsetY + (float)(yi + blockY - tri.vertex0Y);
 
-			float invW = 1.0f / WSlope.GetValue(dx, dy);
+			float invW = 1.0f / tri.WSlope.GetValue(dx, dy);
 			pixel.InvW = invW;
 
 			// tex coords
@@ -254,13 +297,13 @@ static void BuildBlock(s32 blockX, s32 blockY)
 				float projection = invW;
 				if (xfmem.texMtxInfo[i].projection)
 				{
-					float q = TexSlopes[i][2].GetValue(dx, dy) * invW;
+					float q = tri.TexSlopes[i][2].GetValue(dx, dy) * invW;
 					if (q != 0.0f)
 						projection = invW / q;
 				}
 
-				pixel.Uv[i][0] = TexSlopes[i][0].GetValue(dx, dy) * projection;
-				pixel.Uv[i][1] = TexSlopes[i][1].GetValue(dx, dy) * projection;
+				pixel.Uv[i][0] = tri.TexSlopes[i][0].GetValue(dx, dy) * projection;
+				pixel.Uv[i][1] = tri.TexSlopes[i][1].GetValue(dx, dy) * projection;
 			}
 		}
 	}
@@ -273,7 +316,7 @@ static void BuildBlock(s32 blockX, s32 blockY)
 		u32 texcoord = indref & 3;
 		indref >>= 3;
 
-		CalculateLOD(&rasterBlock.IndirectLod[i], &rasterBlock.IndirectLinear[i], texmap, texcoord);
+		CalculateLOD(rasterBlock, &rasterBlock.IndirectLod[i], &rasterBlock.IndirectLinear[i], texmap, texcoord);
 	}
 
 	for (unsigned int i = 0; i <= bpmem.genMode.numtevstages; i++)
@@ -285,31 +328,351 @@ static void BuildBlock(s32 blockX, s32 blockY)
 			u32 texmap = order.getTexMap(stageOdd);
 			u32 texcoord = order.getTexCoord(stageOdd);
 
-			CalculateLOD(&rasterBlock.TextureLod[i], &rasterBlock.TextureLinear[i], texmap, texcoord);
+			CalculateLOD(rasterBlock, &rasterBlock.TextureLod[i], &rasterBlock.TextureLinear[i], texmap, texcoord);
 		}
 	}
 }
 
-static inline void PrepareBlock(s32 blockX, s32 blockY)
+static inline void PrepareBlock(const Triangle& tri, RasterContext& ctx, s32 blockX, s32 blockY)
 {
-	static s32 x = -1;
-	static s32 y = -1;
-
 	blockX &= ~(BLOCK_SIZE - 1);
 	blockY &= ~(BLOCK_SIZE - 1);
 
-	if (x != blockX || y != blockY)
+	if (ctx.blockX != blockX || ctx.blockY != blockY)
 	{
-		x = blockX;
-		y = blockY;
-		BuildBlock(x, y);
+		ctx.blockX = blockX;
+		ctx.blockY = blockY;
+		BuildBlock(tri, ctx.rasterBlock, blockX, blockY);
 	}
 }
 
-void DrawTriangleFrontFace(OutputVertexData *v0, OutputVertexData *v1, OutputVertexData *v2)
+// Draws the part of the triangle that lies within [minx, maxx) x [miny, maxy)
+static void DrawBlocks(const Triangle& tri, RasterContext& ctx, s32 minx, s32 maxx, s32 miny, s32 maxy)
 {
-	INCSTAT(stats.thisFrame.numTrianglesDrawn);
+	const s32 C1 = tri.C1;
+	const s32 C2 = tri.C2;
+	const s32 C3 = tri.C3;
+
+	const s32 DX12 = tri.DX12;
+	const s32 DX23 = tri.DX23;
+	const s32 DX31 = tri.DX31;
+
+	const s32 DY12 = tri.DY12;
+	const s32 DY23 = tri.DY23;
+	const s32 DY31 = tri.DY31;
+
+	// Fixed-pos32 deltas
+	const s32 FDX12 = DX12 * 16;
+	const s32 FDX23 = DX23 * 16;
+	const s32 FDX31 = DX31 * 16;
+
+	const s32 FDY12 = DY12 * 16;
+	const s32 FDY23 = DY23 * 16;
+	const s32 FDY31 = DY31 * 16;
+
+	// Start in corner of 8x8 block
+	minx &= ~(BLOCK_SIZE - 1);
+	miny &= ~(BLOCK_SIZE - 1);
+	// Loop through blocks
+	for (s32 y = miny; y < maxy; y += BLOCK_SIZE)
+	{
+		for (s32 x = minx; x < maxx; x += BLOCK_SIZE)
+		{
+			// Corners of block
+			s32 x0 = x << 4;
+			s32 x1 = (x + BLOCK_SIZE - 1) << 4;
+			s32 y0 = y << 4;
+			s32 y1 = (y + BLOCK_SIZE - 1) << 4;
+
+			// Evaluate half-space functions
+			bool a00 = C1 + DX12 * y0 - DY12 * x0 > 0;
+			bool a10 = C1 + DX12 * y0 - DY12 * x1 > 0;
+			bool a01 = C1 + DX12 * y1 - DY12 * x0 > 0;
+			bool a11 = C1 + DX12 * y1 - DY12 * x1 > 0;
+			int a = (a00 << 0) | (a10 << 1) | (a01 << 2) | (a11 << 3);
+
+			bool b00 = C2 + DX23 * y0 - DY23 * x0 > 0;
+			bool b10 = C2 + DX23 * y0 - DY23 * x1 > 0;
+			bool b01 = C2 + DX23 * y1 - DY23 * x0 > 0;
+			bool b11 = C2 + DX23 * y1 - DY23 * x1 > 0;
+			int b = (b00 << 0) | (b10 << 1) | (b01 << 2) | (b11 << 3);
+
+			bool c00 = C3 + DX31 * y0 - DY31 * x0 > 0;
+			bool c10 = C3 + DX31 * y0 - DY31 * x1 > 0;
+			bool c01 = C3 + DX31 * y1 - DY31 * x0 > 0;
+			bool c11 = C3 + DX31 * y1 - DY31 * x1 > 0;
+			int c = (c00 << 0) | (c10 << 1) | (c01 << 2) | (c11 << 3);
+
+			// Skip block when outside an edge
+			if (a == 0x0 || b == 0x0 || c == 0x0)
+				continue;
+
+			BuildBlock(tri, ctx.rasterBlock, x, y);
+
+			// Accept whole block when totally covered
+			if (a == 0xF && b == 0xF && c == 0xF)
+			{
+				for (s32 iy = 0; iy < BLOCK_SIZE; iy++)
+				{
+					for (s32 ix = 0; ix < BLOCK_SIZE; ix++)
+					{
+						Draw(tri, ctx, x + ix, y + iy, ix, iy);
+					}
+				}
+			}
+			else // Partially covered block
+			{
+				s32 CY1 = C1 + DX12 * y0 - DY12 * x0;
+				s32 CY2 = C2 + DX23 * y0 - DY23 * x0;
+				s32 CY3 = C3 + DX31 * y0 - DY31 * x0;
+
+				for (s32 iy = 0; iy < BLOCK_SIZE; iy++)
+				{
+					s32 CX1 = CY1;
+					s32 CX2 = CY2;
+					s32 CX3 = CY3;
+
+					for (s32 ix = 0; ix < BLOCK_SIZE; ix++)
+					{
+						if (CX1 > 0 && CX2 > 0 && CX3 > 0)
+						{
+							Draw(tri, ctx, x + ix, y + iy, ix, iy);
+						}
+
+						CX1 -= FDY12;
+						CX2 -= FDY23;
+						CX3 -= FDY31;
+					}
+
+					CY1 += FDX12;
+					CY2 += FDX23;
+					CY3 += FDX31;
+				}
+			}
+		}
+	}
+}
+
+static void DrawBoundingBox(const Triangle& tri, RasterContext& ctx)
+{
+	const s32 C1 = tri.C1;
+	const s32 C2 = tri.C2;
+	const s32 C3 = tri.C3;
+
+	const s32 DX12 = tri.DX12;
+	const s32 DX23 = tri.DX23;
+	const s32 DX31 = tri.DX31;
+
+	const s32 DY12 = tri.DY12;
+	const s32 DY23 = tri.DY23;
+	const s32 DY31 = tri.DY31;
+
+	const s32 FDX12 = DX12 * 16;
+	const s32 FDX23 = DX23 * 16;
+	const s32 FDX31 = DX31 * 16;
+
+	const s32 FDY12 = DY12 * 16;
+	const s32 FDY23 = DY23 * 16;
+	const s32 FDY31 = DY31 * 16;
+
+	s32 minx = tri.minx;
+	s32 maxx = tri.maxx;
+	s32 miny = tri.miny;
+	s32 maxy = tri.maxy;
+
+	// The block from an earlier triangle can't be reused
+	ctx.blockX = ctx.blockY = -1;
+
+	// Calculating bbox
+	// First check for alpha channel - don't do anything it if always fails,
+	// Change bbox to primitive size if it always passes
+	AlphaTest::TEST_RESULT alphaRes = bpmem.alpha_test.TestResult();
+
+	if (alphaRes != AlphaTest::UNDETERMINED)
+	{
+		if (alphaRes == AlphaTest::PASS)
+		{
+			BoundingBox::coords[BoundingBox::TOP] = std::min(BoundingBox::coords[BoundingBox::TOP], (u16)miny);
+			BoundingBox::coords[BoundingBox::LEFT] = std::min(BoundingBox::coords[BoundingBox::LEFT], (u16)minx);
+			BoundingBox::coords[BoundingBox::BOTTOM] = std::max(BoundingBox::coords[BoundingBox::BOTTOM], (u16)maxy);
+			BoundingBox::coords[BoundingBox::RIGHT] = std::max(BoundingBox::coords[BoundingBox::RIGHT], (u16)maxx);
+		}
+		return;
+	}
+
+	// If we are calculating bbox with alpha, we only need to find the
+	// topmost, leftmost, bottom most and rightmost pixels to be drawn.
+	// So instead of drawing every single one of the triangle's pixels,
+	// four loops are run: one for the top pixel, one for the left, one for
+	// the bottom and one for the right. As soon as a pixel that is to be
+	// drawn is found, the loop breaks. This enables a ~150% speedbost in
+	// bbox calculation, albeit at the cost of some ugly repetitive code.
+	const s32 FLEFT = minx << 4;
+	const s32 FRIGHT = maxx << 4;
+	s32 FTOP = miny << 4;
+	s32 FBOTTOM = maxy << 4;
+
+	// Start checking for bbox top
+	s32 CY1 = C1 + DX12 * FTOP - DY12 * FLEFT;
+	s32 CY2 = C2 + DX23 * FTOP - DY23 * FLEFT;
+	s32 CY3 = C3 + DX31 * FTOP - DY31 * FLEFT;
+
+	// Loop
+	for (s32 y = miny; y <= maxy; ++y)
+	{
+		if (y >= BoundingBox::coords[BoundingBox::TOP])
+			break;
+
+		s32 CX1 = CY1;
+		s32 CX2 = CY2;
+		s32 CX3 = CY3;
+
+		for (s32 x = minx; x <= maxx; ++x)
+		{
+			if (CX1 > 0 && CX2 > 0 && CX3 > 0)
+			{
+				// Build the new raster block every other pixel
+				PrepareBlock(tri, ctx, x, y);
+				Draw(tri, ctx, x, y, x & (BLOCK_SIZE - 1), y & (BLOCK_SIZE - 1));
+
+				if (y >= BoundingBox::coords[BoundingBox::TOP])
+					break;
+			}
+
+			CX1 -= FDY12;
+			CX2 -= FDY23;
+			CX3 -= FDY31;
+		}
+
+		CY1 += FDX12;
+		CY2 += FDX23;
+		CY3 += FDX31;
+	}
+
+	// Update top limit
+	miny = std::max((s32)BoundingBox::coords[BoundingBox::TOP], miny);
+	FTOP = miny << 4;
+
+	// Checking for bbox left
+	s32 CX1 = C1 + DX12 * FTOP - DY12 * FLEFT;
+	s32 CX2 = C2 + DX23 * FTOP - DY23 * FLEFT;
+	s32 CX3 = C3 + DX31 * FTOP - DY31 * FLEFT;
+
+	// Loop
+	for (s32 x = minx; x <= maxx; ++x)
+	{
+		if (x >= BoundingBox::coords[BoundingBox::LEFT])
+			break;
+
+		CY1 = CX1;
+		CY2 = CX2;
+		CY3 = CX3;
+
+		for (s32 y = miny; y <= maxy; ++y)
+		{
+			if (CY1 > 0 && CY2 > 0 && CY3 > 0)
+			{
+				PrepareBlock(tri, ctx, x, y);
+				Draw(tri, ctx, x, y, x & (BLOCK_SIZE - 1), y & (BLOCK_SIZE - 1));
+
+				if (x >= BoundingBox::coords[BoundingBox::LEFT])
+					break;
+			}
 
+			CY1 += FDX12;
+			CY2 += FDX23;
+			CY3 += FDX31;
+		}
+
+		CX1 -= FDY12;
+		CX2 -= FDY23;
+		CX3 -= FDY31;
+	}
+
+	// Update left limit
+	minx = std::max((s32)BoundingBox::coords[BoundingBox::LEFT], minx);
+
+	// Checking for bbox bottom
+	CY1 = C1 + DX12 * FBOTTOM - DY12 * FRIGHT;
+	CY2 = C2 + DX23 * FBOTTOM - DY23 * FRIGHT;
+	CY3 = C3 + DX31 * FBOTTOM - DY31 * FRIGHT;
+
+	// Loop
+	for (s32 y = maxy; y >= miny; --y)
+	{
+		CX1 = CY1;
+		CX2 = CY2;
+		CX3 = CY3;
+
+		if (y <= BoundingBox::coords[BoundingBox::BOTTOM])
+			break;
+
+		for (s32 x = maxx; x >= minx; --x)
+		{
+			if (CX1 > 0 && CX2 > 0 && CX3 > 0)
+			{
+				// Build the new raster block every other pixel
+				PrepareBlock(tri, ctx, x, y);
+				Draw(tri, ctx, x, y, x & (BLOCK_SIZE - 1), y & (BLOCK_SIZE - 1));
+
+				if (y <= BoundingBox::coords[BoundingBox::BOTTOM])
+					break;
+			}
+
+			CX1 += FDY12;
+			CX2 += FDY23;
+			CX3 += FDY31;
+		}
+
+		CY1 -= FDX12;
+		CY2 -= FDX23;
+		CY3 -= FDX31;
+	}
+
+	// Update bottom limit
+	maxy = std::min((s32)BoundingBox::coords[BoundingBox::BOTTOM], maxy);
+	FBOTTOM = maxy << 4;
+
+	// Checking for bbox right
+	CX1 = C1 + DX12 * FBOTTOM - DY12 * FRIGHT;
+	CX2 = C2 + DX23 * FBOTTOM - DY23 * FRIGHT;
+	CX3 = C3 + DX31 * FBOTTOM - DY31 * FRIGHT;
+
+	// Loop
+	for (s32 x = maxx; x >= minx; --x)
+	{
+		if (x <= BoundingBox::coords[BoundingBox::RIGHT])
+			break;
+
+		CY1 = CX1;
+		CY2 = CX2;
+		CY3 = CX3;
+
+		for (s32 y = maxy; y >= miny; --y)
+		{
+			if (CY1 > 0 && CY2 > 0 && CY3 > 0)
+			{
+				// Build the new raster block every other pixel
+				PrepareBlock(tri, ctx, x, y);
+				Draw(tri, ctx, x, y, x & (BLOCK_SIZE - 1), y & (BLOCK_SIZE - 1));
+
+				if (x <= BoundingBox::coords[BoundingBox::RIGHT])
+					break;
+			}
+
+			CY1 -= FDX12;
+			CY2 -= FDX23;
+			CY3 -= FDX31;
+		}
+
+		CX1 += FDY12;
+		CX2 += FDY23;
+		CX3 += FDY31;
+	}
+}
+
+static bool SetupTriangle(Triangle* tri, OutputVertexData *v0, OutputVertexData *v1, OutputVertexData *v2)
+{
 	// adapted from http://devmaster.net/posts/6145/advanced-rasterization
 
 	// 28.4 fixed-pou32 coordinates. rounded to nearest and adjusted to match hardware output
@@ -331,15 +694,6 @@ void DrawTriangleFrontFace(OutputVertexData *v0, OutputVertexData *v1, OutputVer
 	const s32 DY23 = Y2 - Y3;
 	const s32 DY31 = Y3 - Y1;
 
-	// Fixed-pos32 deltas
-	const s32 FDX12 = DX12 * 16;
-	const s32 FDX23 = DX23 * 16;
-	const s32 FDX31 = DX31 * 16;
-
-	const s32 FDY12 = DY12 * 16;
-	const s32 FDY23 = DY23 * 16;
-	const s32 FDY31 = DY31 * 16;
-
 	// Bounding rectangle
 	s32 minx = (std::min(std::min(X1, X2), X3) + 0xF) >> 4;
 	s32 maxx = (std::max(std::max(X1, X2), X3) + 0xF) >> 4;
@@ -353,7 +707,7 @@ void DrawTriangleFrontFace(OutputVertexData *v0, OutputVertexData *v1, OutputVer
 	maxy = std::min(maxy, scissorBottom);
 
 	if (minx >= maxx || miny >= maxy)
-		return;
+		return false;
 
 	// Setup slopes
 	float fltx1 = v0->screenPosition.x;
@@ -363,10 +717,10 @@ void DrawTriangleFrontFace(OutputVertexData *v0, OutputVertexData *v1, OutputVer
 	float fltdy12 = flty1 - v1->screenPosition.y;
 	float fltdy31 = v2->screenPosition.y - flty1;
 
-	InitTriangle(fltx1, flty1, (X1 + 0xF) >> 4, (Y1 + 0xF) >> 4);
+	InitTriangle(tri, fltx1, flty1, (X1 + 0xF) >> 4, (Y1 + 0xF) >> 4);
 
 	float w[3] = {1.0f / v0->projectedPosition.w, 1.0f / v1->projectedPosition.w, 1.0f / v2->projectedPosition.w};
-	InitSlope(&WSlope, w[0], w[1], w[2], fltdx31, fltdx12, fltdy12, fltdy31);
+	InitSlope(&tri->WSlope, w[0], w[1], w[2], fltdx31, fltdx12, fltdy12, fltdy31);
 
 	// TODO: The zfreeze emulation is not quite correct, yet!
 	// Many things might prevent us from reaching this line (culling, clipping, scissoring).
@@ -374,17 +728,18 @@ void DrawTriangleFrontFace(OutputVertexData *v0, OutputVertexData *v1, OutputVer
 	// We're currently sloppy at this since we abort early if any of the culling/clipping/scissoring tests fail.
 	if (!bpmem.genMode.zfreeze || !g_ActiveConfig.bZFreeze)
 		InitSlope(&ZSlope, v0->screenPosition[2], v1->screenPosition[2], v2->screenPosition[2], fltdx31, fltdx12, fltdy12, fltdy31);
+	tri->ZSlope = ZSlope;
 
 	for (unsigned int i = 0; i < bpmem.genMode.numcolchans; i++)
 	{
 		for (int comp = 0; comp < 4; comp++)
-			InitSlope(&ColorSlopes[i][comp], v0->color[i][comp], v1->color[i][comp], v2->color[i][comp], fltdx31, fltdx12, fltdy12, fltdy31);
+			InitSlope(&tri->ColorSlopes[i][comp], v0->color[i][comp], v1->color[i][comp], v2->color[i][comp], fltdx31, fltdx12, fltdy12, fltdy31);
 	}
 
 	for (unsigned int i = 0; i < bpmem.genMode.numtexgens; i++)
 	{
 		for (int comp = 0; comp < 3; comp++)
-			InitSlope(&TexSlopes[i][comp], v0->texCoords[i][comp] * w[0], v1->texCoords[i][comp] * w[1], v2->texCoords[i][comp] * w[2], fltdx31, fltdx12, fltdy12, fltdy31);
+			InitSlope(&tri->TexSlopes[i][comp], v0->texCoords[i][comp] * w[0], v1->texCoords[i][comp] * w[1], v2->texCoords[i][comp] * w[2], fltdx31, fltdx12, fltdy12, fltdy31);
 	}
 
 	// Half-edge constants
@@ -397,279 +752,105 @@ void DrawTriangleFrontFace(OutputVertexData *v0, OutputVertexData *v1, OutputVer
 	if (DY23 < 0 || (DY23 == 0 && DX23 > 0)) C2++;
 	if (DY31 < 0 || (DY31 == 0 && DX31 > 0)) C3++;
 
-	if (!BoundingBox::active)
-	{
-		// Start in corner of 8x8 block
-		minx &= ~(BLOCK_SIZE - 1);
-		miny &= ~(BLOCK_SIZE - 1);
-		// Loop through blocks
-		for (s32 y = miny; y < maxy; y += BLOCK_SIZE)
-		{
-			for (s32 x = minx; x < maxx; x += BLOCK_SIZE)
-			{
-				// Corners of block
-				s32 x0 = x << 4;
-				s32 x1 = (x + BLOCK_SIZE - 1) << 4;
-				s32 y0 = y << 4;
-				s32 y1 = (y + BLOCK_SIZE - 1) << 4;
-
-				// Evaluate half-space functions
-				bool a00 = C1 + DX12 * y0 - DY12 * x0 > 0;
-				bool a10 = C1 + DX12 * y0 - DY12 * x1 > 0;
-				bool a01 = C1 + DX12 * y1 - DY12 * x0 > 0;
-				bool a11 = C1 + DX12 * y1 - DY12 * x1 > 0;
-				int a = (a00 << 0) | (a10 << 1) | (a01 << 2) | (a11 << 3);
-
-				bool b00 = C2 + DX23 * y0 - DY23 * x0 > 0;
-				bool b10 = C2 + DX23 * y0 - DY23 * x1 > 0;
-				bool b01 = C2 + DX23 * y1 - DY23 * x0 > 0;
-				bool b11 = C2 + DX23 * y1 - DY23 * x1 > 0;
-				int b = (b00 << 0) | (b10 << 1) | (b01 << 2) | (b11 << 3);
-
-				bool c00 = C3 + DX31 * y0 - DY31 * x0 > 0;
-				bool c10 = C3 + DX31 * y0 - DY31 * x1 > 0;
-				bool c01 = C3 + DX31 * y1 - DY31 * x0 > 0;
-				bool c11 = C3 + DX31 * y1 - DY31 * x1 > 0;
-				int c = (c00 << 0) | (c10 << 1) | (c01 << 2) | (c11 << 3);
-
-				// Skip block when outside an edge
-				if (a == 0x0 || b == 0x0 || c == 0x0)
-					continue;
-
-				BuildBlock(x, y);
-
-				// Accept whole block when totally covered
-				if (a == 0xF && b == 0xF && c == 0xF)
-				{
-					for (s32 iy = 0; iy < BLOCK_SIZE; iy++)
-					{
-						for (s32 ix = 0; ix < BLOCK_SIZE; ix++)
-						{
-							Draw(x + ix, y + iy, ix, iy);
-						}
-					}
-				}
-				else // Partially covered block
-				{
-					s32 CY1 = C1 + DX12 * y0 - DY12 * x0;
-					s32 CY2 = C2 + DX23 * y0 - DY23 * x0;
-					s32 CY3 = C3 + DX31 * y0 - DY31 * x0;
-
-					for (s32 iy = 0; iy < BLOCK_SIZE; iy++)
-					{
-						s32 CX1 = CY1;
-						s32 CX2 = CY2;
-						s32 CX3 = CY3;
+	tri->DX12 = DX12;
+	tri->DX23 = DX23;
+	tri->DX31 = DX31;
+	tri->DY12 = DY12;
+	tri->DY23 = DY23;
+	tri->DY31 = DY31;
+	tri->C1 = C1;
+	tri->C2 = C2;
+	tri->C3 = C3;
+	tri->minx = minx;
+	tri->maxx = maxx;
+	tri->miny = miny;
+	tri->maxy = maxy;
+	return true;
+}
 
-						for (s32 ix = 0; ix < BLOCK_SIZE; ix++)
-						{
-							if (CX1 > 0 && CX2 > 0 && CX3 > 0)
-							{
-								Draw(x + ix, y + iy, ix, iy);
-							}
-
-							CX1 -= FDY12;
-							CX2 -= FDY23;
-							CX3 -= FDY31;
-						}
+static void BinTriangle(const Triangle& tri)
+{
+	const u32 index = static_cast<u32>(s_triangles.size());
+	s_triangles.push_back(tri);
 
-						CY1 += FDX12;
-						CY2 += FDX23;
-						CY3 += FDX31;
-					}
-				}
-			}
-		}
-	}
-	else
+	for (s32 y = tri.miny / TILE_SIZE; y <= (tri.maxy - 1) / TILE_SIZE; y++)
 	{
-		// Calculating bbox
-		// First check for alpha channel - don't do anything it if always fails,
-		// Change bbox to primitive size if it always passes
-		AlphaTest::TEST_RESULT alphaRes = bpmem.alpha_test.TestResult();
-
-		if (alphaRes != AlphaTest::UNDETERMINED)
+		for (s32 x = tri.minx / TILE_SIZE; x <= (tri.maxx - 1) / TILE_SIZE; x++)
 		{
-			if (alphaRes == AlphaTest::PASS)
-			{
-				BoundingBox::coords[BoundingBox::TOP] = std::min(BoundingBox::coords[BoundingBox::TOP], (u16)miny);
-				BoundingBox::coords[BoundingBox::LEFT] = std::min(BoundingBox::coords[BoundingBox::LEFT], (u16)minx);
-				BoundingBox::coords[BoundingBox::BOTTOM] = std::max(BoundingBox::coords[BoundingBox::BOTTOM], (u16)maxy);
-				BoundingBox::coords[BoundingBox::RIGHT] = std::max(BoundingBox::coords[BoundingBox::RIGHT], (u16)maxx);
-			}
-			return;
+			std::vector<u32>& bin = s_tile_triangles[y * TILES_X + x];
+			if (bin.empty())
+				s_used_tiles.push_back(y * TILES_X + x);
+			bin.push_back(index);
 		}
+	}
+}
 
-		// If we are calculating bbox with alpha, we only need to find the
-		// topmost, leftmost, bottom most and rightmost pixels to be drawn.
-		// So instead of drawing every single one of the triangle's pixels,
-		// four loops are run: one for the top pixel, one for the left, one for
-		// the bottom and one for the right. As soon as a pixel that is to be
-		// drawn is found, the loop breaks. This enables a ~150% speedbost in
-		// bbox calculation, albeit at the cost of some ugly repetitive code.
-		const s32 FLEFT = minx << 4;
-		const s32 FRIGHT = maxx << 4;
-		s32 FTOP = miny << 4;
-		s32 FBOTTOM = maxy << 4;
-
-		// Start checking for bbox top
-		s32 CY1 = C1 + DX12 * FTOP - DY12 * FLEFT;
-		s32 CY2 = C2 + DX23 * FTOP - DY23 * FLEFT;
-		s32 CY3 = C3 + DX31 * FTOP - DY31 * FLEFT;
-
-		// Loop
-		for (s32 y = miny; y <= maxy; ++y)
-		{
-			if (y >= BoundingBox::coords[BoundingBox::TOP])
-				break;
-
-			s32 CX1 = CY1;
-			s32 CX2 = CY2;
-			s32 CX3 = CY3;
-
-			for (s32 x = minx; x <= maxx; ++x)
-			{
-				if (CX1 > 0 && CX2 > 0 && CX3 > 0)
-				{
-					// Build the new raster block every other pixel
-					PrepareBlock(x, y);
-					Draw(x, y, x & (BLOCK_SIZE - 1), y & (BLOCK_SIZE - 1));
-
-					if (y >= BoundingBox::coords[BoundingBox::TOP])
-						break;
-				}
-
-				CX1 -= FDY12;
-				CX2 -= FDY23;
-				CX3 -= FDY31;
-			}
-
-			CY1 += FDX12;
-			CY2 += FDX23;
-			CY3 += FDX31;
-		}
-
-		// Update top limit
-		miny = std::max((s32)BoundingBox::coords[BoundingBox::TOP], miny);
-		FTOP = miny << 4;
-
-		// Checking for bbox left
-		s32 CX1 = C1 + DX12 * FTOP - DY12 * FLEFT;
-		s32 CX2 = C2 + DX23 * FTOP - DY23 * FLEFT;
-		s32 CX3 = C3 + DX31 * FTOP - DY31 * FLEFT;
-
-		// Loop
-		for (s32 x = minx; x <= maxx; ++x)
-		{
-			if (x >= BoundingBox::coords[BoundingBox::LEFT])
-				break;
-
-			CY1 = CX1;
-			CY2 = CX2;
-			CY3 = CX3;
-
-			for (s32 y = miny; y <= maxy; ++y)
-			{
-				if (CY1 > 0 && CY2 > 0 && CY3 > 0)
-				{
-					PrepareBlock(x, y);
-					Draw(x, y, x & (BLOCK_SIZE - 1), y & (BLOCK_SIZE - 1));
-
-					if (x >= BoundingBox::coords[BoundingBox::LEFT])
-						break;
-				}
-
-				CY1 += FDX12;
-				CY2 += FDX23;
-				CY3 += FDX31;
-			}
-
-			CX1 -= FDY12;
-			CX2 -= FDY23;
-			CX3 -= FDY31;
-		}
-
-		// Update left limit
-		minx = std::max((s32)BoundingBox::coords[BoundingBox::LEFT], minx);
-
-		// Checking for bbox bottom
-		CY1 = C1 + DX12 * FBOTTOM - DY12 * FRIGHT;
-		CY2 = C2 + DX23 * FBOTTOM - DY23 * FRIGHT;
-		CY3 = C3 + DX31 * FBOTTOM - DY31 * FRIGHT;
-
-		// Loop
-		for (s32 y = maxy; y >= miny; --y)
-		{
-			CX1 = CY1;
-			CX2 = CY2;
-			CX3 = CY3;
-
-			if (y <= BoundingBox::coords[BoundingBox::BOTTOM])
-				break;
-
-			for (s32 x = maxx; x >= minx; --x)
-			{
-				if (CX1 > 0 && CX2 > 0 && CX3 > 0)
-				{
-					// Build the new raster block every other pixel
-					PrepareBlock(x, y);
-					Draw(x, y, x & (BLOCK_SIZE - 1), y & (BLOCK_SIZE - 1));
-
-					if (y <= BoundingBox::coords[BoundingBox::BOTTOM])
-						break;
-				}
-
-				CX1 += FDY12;
-				CX2 += FDY23;
-				CX3 += FDY31;
-			}
-
-			CY1 -= FDX12;
-			CY2 -= FDX23;
-			CY3 -= FDX31;
-		}
-
-		// Update bottom limit
-		maxy = std::min((s32)BoundingBox::coords[BoundingBox::BOTTOM], maxy);
-		FBOTTOM = maxy << 4;
-
-		// Checking for bbox right
-		CX1 = C1 + DX12 * FBOTTOM - DY12 * FRIGHT;
-		CX2 = C2 + DX23 * FBOTTOM - DY23 * FRIGHT;
-		CX3 = C3 + DX31 * FBOTTOM - DY31 * FRIGHT;
+// Triangles are drawn in submission order, so each pixel sees the same sequence of blends and depth tests
+// no matter how the tiles are spread over the threads.
+static void DrawTile(s32 tile, RasterContext& ctx)
+{
+	const s32 tileLeft = (tile % TILES_X) * TILE_SIZE;
+	const s32 tileTop = (tile / TILES_X) * TILE_SIZE;
 
-		// Loop
-		for (s32 x = maxx; x >= minx; --x)
-		{
-			if (x <= BoundingBox::coords[BoundingBox::RIGHT])
-				break;
+	for (u32 index : s_tile_triangles[tile])
+	{
+		const Triangle& tri = s_triangles[index];
+		DrawBlocks(tri, ctx, std::max(tri.minx, tileLeft), std::min(tri.maxx, tileLeft + TILE_SIZE),
+			std::max(tri.miny, tileTop), std::min(tri.maxy, tileTop + TILE_SIZE));
+	}
+}
 
-			CY1 = CX1;
-			CY2 = CX2;
-			CY3 = CX3;
+static void FlushCounters(RasterContext& ctx)
+{
+	ADDSTAT(stats.thisFrame.rasterizedPixels, ctx.rasterizedPixels);
+	ctx.rasterizedPixels = 0;
+	ctx.tev.FlushCounters();
+}
 
-			for (s32 y = maxy; y >= miny; --y)
-			{
-				if (CY1 > 0 && CY2 > 0 && CY3 > 0)
-				{
-					// Build the new raster block every other pixel
-					PrepareBlock(x, y);
-					Draw(x, y, x & (BLOCK_SIZE - 1), y & (BLOCK_SIZE - 1));
+void DrawTriangleFrontFace(OutputVertexData *v0, OutputVertexData *v1, OutputVertexData *v2)
+{
+	INCSTAT(stats.thisFrame.numTrianglesDrawn);
 
-					if (x <= BoundingBox::coords[BoundingBox::RIGHT])
-						break;
-				}
+	Triangle tri;
+	if (!SetupTriangle(&tri, v0, v1, v2))
+		return;
 
-				CY1 -= FDX12;
-				CY2 -= FDX23;
-				CY3 -= FDX31;
-			}
+	// The bounding box rasterizer stops early based on what the earlier pixels did, so it stays immediate
+	if (BoundingBox::active)
+		DrawBoundingBox(tri, s_context);
+	else
+		BinTriangle(tri);
+}
 
-			CX1 += FDY12;
-			CX2 += FDY23;
-			CX3 += FDY31;
-		}
+void Flush()
+{
+	if (!s_triangles.empty())
+	{
+		// TEV stage dumps go through buffers shared by all pixels
+		u32 max_threads = 0;
+		if (g_ActiveConfig.bDumpTevStages || g_ActiveConfig.bDumpTevTextureFetches)
+			max_threads = 1;
+
+		Common::ThreadPool::ParallelFor(0, static_cast<s32>(s_used_tiles.size()), 1, [](s32 begin, s32 end) {
+			RasterContext ctx;
+			ctx.tev.Init();
+			ctx.tev.CopyRegColors(s_context.tev);
+			ctx.rasterizedPixels = 0;
+
+			for (s32 i = begin; i < end; i++)
+				DrawTile(s_used_tiles[i], ctx);
+
+			std::lock_guard<std::mutex> lk(s_counters_lock);
+			FlushCounters(ctx);
+		}, max_threads);
+
+		for (s32 tile : s_used_tiles)
+			s_tile_triangles[tile].clear();
+		s_used_tiles.clear();
+		s_triangles.clear();
 	}
+
+	FlushCounters(s_context);
 }
 
 }
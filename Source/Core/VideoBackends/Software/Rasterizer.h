@@ -12,7 +12,10 @@ namespace Rasterizer
 {
 void Init();
 
+// Unless the bounding box is being computed, triangles are only binned here and drawn by Flush
 void DrawTriangleFrontFace(OutputVertexData *v0, OutputVertexData *v1, OutputVertexData *v2);
+// Draws the binned triangles, spreading the screen tiles over the thread pool
+void Flush();
 
 void SetScissor();
 
@@ -24,7 +27,7 @@ struct Slope
 	float dfdy;
 	float f0;
 
-	float GetValue(float dx, float dy)
+	float GetValue(float dx, float dy) const
 	{
 		return f0 + (dfdx * dx) + (dfdy * dy);
 	}
@@ -134,6 +134,8 @@ void SWVertexLoader::vFlush(bool useDstAlpha)
 		INCSTAT(stats.thisFrame.numVerticesLoaded)
 	}
 
+	Rasterizer::Flush();
+
 	DebugUtil::OnObjectEnd();
 }
 
@@ -2,12 +2,16 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <iterator>
 
 #include "Common/ChunkFile.h"
 #include "Common/CommonTypes.h"
 #include "VideoBackends/Software/DebugUtil.h"
 #include "VideoBackends/Software/EfbInterface.h"
+#include "VideoBackends/Software/PixelKernels.h"
 #include "VideoBackends/Software/Tev.h"
 #include "VideoBackends/Software/TextureSampler.h"
 
@@ -110,20 +114,7 @@ void Tev::Init()
 		m_KonstLUT[31][comp] = &KonstantColors[3][ALP_C];
 	}
 
-	m_BiasLUT[0] = 0;
-	m_BiasLUT[1] = 128;
-	m_BiasLUT[2] = -128;
-	m_BiasLUT[3] = 0;
-
-	m_ScaleLShiftLUT[0] = 0;
-	m_ScaleLShiftLUT[1] = 1;
-	m_ScaleLShiftLUT[2] = 2;
-	m_ScaleLShiftLUT[3] = 0;
-
-	m_ScaleRShiftLUT[0] = 0;
-	m_ScaleRShiftLUT[1] = 0;
-	m_ScaleRShiftLUT[2] = 0;
-	m_ScaleRShiftLUT[3] = 1;
+	ResetCounters();
 }
 
 static inline s16 Clamp255(s16 in)
@@ -188,27 +179,6 @@ void Tev::SetRasColor(int colorChan, int swaptable)
 	}
 }
 
-void Tev::DrawColorRegular(TevStageCombiner::ColorCombiner &cc, const InputRegType inputs[4])
-{
-	for (int i = 0; i < 3; i++)
-	{
-		const InputRegType& InputReg = inputs[BLU_C + i];
-
-		u16 c = InputReg.c + (InputReg.c >> 7);
-
-		s32 temp = InputReg.a * (256 - c) + (InputReg.b * c);
-		temp <<= m_ScaleLShiftLUT[cc.shift];
-		temp += (cc.shift == 3) ? 0 : (cc.op == 1) ? 127 : 128;
-		temp >>= 8;
-		temp = cc.op ? -temp : temp;
-
-		s32 result = ((InputReg.d + m_BiasLUT[cc.bias]) << m_ScaleLShiftLUT[cc.shift]) + temp;
-		result = result >> m_ScaleRShiftLUT[cc.shift];
-
-		Reg[cc.dest][BLU_C + i] = result;
-	}
-}
-
 void Tev::DrawColorCompare(TevStageCombiner::ColorCombiner &cc, const InputRegType inputs[4])
 {
 	for (int i = BLU_C; i <= RED_C; i++)
@@ -266,23 +236,6 @@ void Tev::DrawColorCompare(TevStageCombiner::ColorCombiner &cc, const InputRegTy
 	}
 }
 
-void Tev::DrawAlphaRegular(TevStageCombiner::AlphaCombiner &ac, const InputRegType inputs[4])
-{
-	const InputRegType& InputReg = inputs[ALP_C];
-
-	u16 c = InputReg.c + (InputReg.c >> 7);
-
-	s32 temp = InputReg.a * (256 - c) + (InputReg.b * c);
-	temp <<= m_ScaleLShiftLUT[ac.shift];
-	temp += (ac.shift != 3) ? 0 : (ac.op == 1) ? 127 : 128;
-	temp = ac.op ? (-temp >> 8) : (temp >> 8);
-
-	s32 result = ((InputReg.d + m_BiasLUT[ac.bias]) << m_ScaleLShiftLUT[ac.shift]) + temp;
-	result = result >> m_ScaleRShiftLUT[ac.shift];
-
-	Reg[ac.dest][ALP_C] = result;
-}
-
 void Tev::DrawAlphaCompare(TevStageCombiner::AlphaCombiner& ac, const InputRegType inputs[4])
 {
 	switch ((ac.shift << 1) | ac.op | 8)  // encoded compare mode
@@ -511,7 +464,10 @@ void Tev::Draw()
 	_assert_(Position[0] >= 0 && Position[0] < EFB_WIDTH);
 	_assert_(Position[1] >= 0 && Position[1] < EFB_HEIGHT);
 
-	INCSTAT(stats.thisFrame.tevPixelsIn);
+	PixelsIn++;
+
+	// Stages only write the registers for the current pixel, every pixel starts from the values set through BP
+	std::memcpy(Reg, InitialReg, sizeof(Reg));
 
 	for (unsigned int stageNum = 0; stageNum < bpmem.genMode.numindstages.Value(); stageNum++)
 	{
@@ -592,46 +548,72 @@ void Tev::Draw()
 		SetRasColor(order.getColorChan(stageOdd), ac.rswap * 2);
 
 		// combine inputs
-		InputRegType inputs[4];
+		PixelKernels::CombinerInputs inputs;
 		for (int i = 0; i < 3; i++)
 		{
-			inputs[BLU_C + i].a = *m_ColorInputLUT[cc.a][i];
-			inputs[BLU_C + i].b = *m_ColorInputLUT[cc.b][i];
-			inputs[BLU_C + i].c = *m_ColorInputLUT[cc.c][i];
-			inputs[BLU_C + i].d = *m_ColorInputLUT[cc.d][i];
+			inputs.a[BLU_C + i] = *m_ColorInputLUT[cc.a][i];
+			inputs.b[BLU_C + i] = *m_ColorInputLUT[cc.b][i];
+			inputs.c[BLU_C + i] = *m_ColorInputLUT[cc.c][i];
+			inputs.d[BLU_C + i] = *m_ColorInputLUT[cc.d][i];
 		}
-		inputs[ALP_C].a = *m_AlphaInputLUT[ac.a];
-		inputs[ALP_C].b = *m_AlphaInputLUT[ac.b];
-		inputs[ALP_C].c = *m_AlphaInputLUT[ac.c];
-		inputs[ALP_C].d = *m_AlphaInputLUT[ac.d];
+		inputs.a[ALP_C] = *m_AlphaInputLUT[ac.a];
+		inputs.b[ALP_C] = *m_AlphaInputLUT[ac.b];
+		inputs.c[ALP_C] = *m_AlphaInputLUT[ac.c];
+		inputs.d[ALP_C] = *m_AlphaInputLUT[ac.d];
 
-		if (cc.bias != 3)
-			DrawColorRegular(cc, inputs);
-		else
-			DrawColorCompare(cc, inputs);
+		s16 regular[4];
+		if (cc.bias != 3 || ac.bias != 3)
+			PixelKernels::CombineRegular(inputs, cc, ac, regular);
+
+		InputRegType compareInputs[4];
+		if (cc.bias == 3 || ac.bias == 3)
+		{
+			for (int i = 0; i < 4; i++)
+			{
+				compareInputs[i].a = inputs.a[i];
+				compareInputs[i].b = inputs.b[i];
+				compareInputs[i].c = inputs.c[i];
+				compareInputs[i].d = inputs.d[i];
+			}
+		}
 
-		if (cc.clamp)
+		if (cc.bias != 3)
 		{
-			Reg[cc.dest][RED_C] = Clamp255(Reg[cc.dest][RED_C]);
-			Reg[cc.dest][GRN_C] = Clamp255(Reg[cc.dest][GRN_C]);
-			Reg[cc.dest][BLU_C] = Clamp255(Reg[cc.dest][BLU_C]);
+			Reg[cc.dest][RED_C] = regular[RED_C];
+			Reg[cc.dest][GRN_C] = regular[GRN_C];
+			Reg[cc.dest][BLU_C] = regular[BLU_C];
 		}
 		else
 		{
-			Reg[cc.dest][RED_C] = Clamp1024(Reg[cc.dest][RED_C]);
-			Reg[cc.dest][GRN_C] = Clamp1024(Reg[cc.dest][GRN_C]);
-			Reg[cc.dest][BLU_C] = Clamp1024(Reg[cc.dest][BLU_C]);
+			DrawColorCompare(cc, compareInputs);
+
+			if (cc.clamp)
+			{
+				Reg[cc.dest][RED_C] = Clamp255(Reg[cc.dest][RED_C]);
+				Reg[cc.dest][GRN_C] = Clamp255(Reg[cc.dest][GRN_C]);
+				Reg[cc.dest][BLU_C] = Clamp255(Reg[cc.dest][BLU_C]);
+			}
+			else
+			{
+				Reg[cc.dest][RED_C] = Clamp1024(Reg[cc.dest][RED_C]);
+				Reg[cc.dest][GRN_C] = Clamp1024(Reg[cc.dest][GRN_C]);
+				Reg[cc.dest][BLU_C] = Clamp1024(Reg[cc.dest][BLU_C]);
+			}
 		}
 
 		if (ac.bias != 3)
-			DrawAlphaRegular(ac, inputs);
+		{
+			Reg[ac.dest][ALP_C] = regular[ALP_C];
+		}
 		else
-			DrawAlphaCompare(ac, inputs);
+		{
+			DrawAlphaCompare(ac, compareInputs);
 
-		if (ac.clamp)
-			Reg[ac.dest][ALP_C] = Clamp255(Reg[ac.dest][ALP_C]);
-		else
-			Reg[ac.dest][ALP_C] = Clamp1024(Reg[ac.dest][ALP_C]);
+			if (ac.clamp)
+				Reg[ac.dest][ALP_C] = Clamp255(Reg[ac.dest][ALP_C]);
+			else
+				Reg[ac.dest][ALP_C] = Clamp1024(Reg[ac.dest][ALP_C]);
+		}
 
 #if ALLOW_TEV_DUMPS
 		if (g_ActiveConfig.bDumpTevStages)
@@ -763,19 +745,21 @@ void Tev::Draw()
 		if (late_ztest && bpmem.zmode.testenable)
 		{
 			// TODO: Check against hw if these values get incremented even if depth testing is disabled
-			EfbInterface::IncPerfCounterQuadCount(PQ_ZCOMP_INPUT);
+			PerfPixels[PQ_ZCOMP_INPUT]++;
 
 			if (!EfbInterface::ZCompare(Position[0], Position[1], Position[2]))
 				return;
 
-			EfbInterface::IncPerfCounterQuadCount(PQ_ZCOMP_OUTPUT);
+			PerfPixels[PQ_ZCOMP_OUTPUT]++;
 		}
 	}
 	// branchless bounding box update
-	BoundingBox::coords[BoundingBox::LEFT] = std::min((u16)Position[0], BoundingBox::coords[BoundingBox::LEFT]);
-	BoundingBox::coords[BoundingBox::RIGHT] = std::max((u16)Position[0], BoundingBox::coords[BoundingBox::RIGHT]);
-	BoundingBox::coords[BoundingBox::TOP] = std::min((u16)Position[1], BoundingBox::coords[BoundingBox::TOP]);
-	BoundingBox::coords[BoundingBox::BOTTOM] = std::max((u16)Position[1], BoundingBox::coords[BoundingBox::BOTTOM]);
+	// the bbox rasterizer checks the global one while drawing, otherwise it is merged in FlushCounters
+	u16* bbox = BoundingBox::active ? BoundingBox::coords : BoundingBoxCoords;
+	bbox[BoundingBox::LEFT] = std::min((u16)Position[0], bbox[BoundingBox::LEFT]);
+	bbox[BoundingBox::RIGHT] = std::max((u16)Position[0], bbox[BoundingBox::RIGHT]);
+	bbox[BoundingBox::TOP] = std::min((u16)Position[1], bbox[BoundingBox::TOP]);
+	bbox[BoundingBox::BOTTOM] = std::max((u16)Position[1], bbox[BoundingBox::BOTTOM]);
 
 	// if we are only calculating the bounding box,
 	// there's no need to actually draw anything
@@ -802,8 +786,8 @@ void Tev::Draw()
 	}
 #endif
 
-	INCSTAT(stats.thisFrame.tevPixelsOut);
-	EfbInterface::IncPerfCounterQuadCount(PQ_BLEND_INPUT);
+	PixelsOut++;
+	PerfPixels[PQ_BLEND_INPUT]++;
 
 	EfbInterface::BlendTev(Position[0], Position[1], output);
 }
@@ -816,7 +800,42 @@ void Tev::SetRegColor(int reg, int comp, bool konst, s16 color)
 	}
 	else
 	{
-		Reg[reg][comp] = color;
+		InitialReg[reg][comp] = color;
 	}
 }
 
+void Tev::CopyRegColors(const Tev& other)
+{
+	std::memcpy(InitialReg, other.InitialReg, sizeof(InitialReg));
+	std::memcpy(KonstantColors, other.KonstantColors, sizeof(KonstantColors));
+}
+
+void Tev::ResetCounters()
+{
+	PixelsIn = 0;
+	PixelsOut = 0;
+	std::fill(std::begin(PerfPixels), std::end(PerfPixels), 0);
+	BoundingBoxCoords[BoundingBox::LEFT] = 0xffff;
+	BoundingBoxCoords[BoundingBox::RIGHT] = 0;
+	BoundingBoxCoords[BoundingBox::TOP] = 0xffff;
+	BoundingBoxCoords[BoundingBox::BOTTOM] = 0;
+}
+
+void Tev::FlushCounters()
+{
+	ADDSTAT(stats.thisFrame.tevPixelsIn, PixelsIn);
+	ADDSTAT(stats.thisFrame.tevPixelsOut, PixelsOut);
+	for (int i = 0; i < PQ_NUM_MEMBERS; i++)
+	{
+		if (PerfPixels[i])
+			EfbInterface::AddPerfCounterPixels(static_cast<PerfQueryType>(i), PerfPixels[i]);
+	}
+
+	BoundingBox::coords[BoundingBox::LEFT] = std::min(BoundingBoxCoords[BoundingBox::LEFT], BoundingBox::coords[BoundingBox::LEFT]);
+	BoundingBox::coords[BoundingBox::RIGHT] = std::max(BoundingBoxCoords[BoundingBox::RIGHT], BoundingBox::coords[BoundingBox::RIGHT]);
+	BoundingBox::coords[BoundingBox::TOP] = std::min(BoundingBoxCoords[BoundingBox::TOP], BoundingBox::coords[BoundingBox::TOP]);
+	BoundingBox::coords[BoundingBox::BOTTOM] = std::max(BoundingBoxCoords[BoundingBox::BOTTOM], BoundingBox::coords[BoundingBox::BOTTOM]);
+
+	ResetCounters();
+}
+
@@ -5,6 +5,7 @@
 #pragma once
 
 #include "VideoCommon/BPMemory.h"
+#include "VideoCommon/PerfQueryBase.h"
 
 class Tev
 {
@@ -24,6 +25,7 @@ class Tev
 
 	// color order: ABGR
 	s16 Reg[4][4];
+	s16 InitialReg[4][4];
 	s16 KonstantColors[4][4];
 	s16 TexColor[4];
 	s16 RasColor[4];
@@ -38,9 +40,6 @@ class Tev
 	s16 *m_ColorInputLUT[16][3];
 	s16 *m_AlphaInputLUT[8];        // values must point to ABGR color
 	s16 *m_KonstLUT[32][4];
-	s16 m_BiasLUT[4];
-	u8 m_ScaleLShiftLUT[4];
-	u8 m_ScaleRShiftLUT[4];
 
 	// enumeration for color input LUT
 	enum
@@ -59,9 +58,7 @@ class Tev
 
 	void SetRasColor(int colorChan, int swaptable);
 
-	void DrawColorRegular(TevStageCombiner::ColorCombiner& cc, const InputRegType inputs[4]);
 	void DrawColorCompare(TevStageCombiner::ColorCombiner& cc, const InputRegType inputs[4]);
-	void DrawAlphaRegular(TevStageCombiner::AlphaCombiner& ac, const InputRegType inputs[4]);
 	void DrawAlphaCompare(TevStageCombiner::AlphaCombiner& ac, const InputRegType inputs[4]);
 
 	void Indirect(unsigned int stageNum, s32 s, s32 t);
@@ -83,9 +80,20 @@ public:
 		RED_C
 	};
 
+	// What the drawn pixels added to the statistics, perf queries and bounding box.
+	// Every rasterizer thread has its own Tev, so this is gathered here and merged with FlushCounters.
+	u32 PixelsIn;
+	u32 PixelsOut;
+	u32 PerfPixels[PQ_NUM_MEMBERS];
+	u16 BoundingBoxCoords[4];
+
 	void Init();
 
 	void Draw();
 
 	void SetRegColor(int reg, int comp, bool konst, s16 color);
+	void CopyRegColors(const Tev& other);
+
+	void ResetCounters();
+	void FlushCounters();
 };
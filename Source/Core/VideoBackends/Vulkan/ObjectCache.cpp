@@ -5,8 +5,11 @@
 #include "VideoBackends/Vulkan/ObjectCache.h"
 
 #include <algorithm>
+#include <mutex>
 #include <sstream>
 #include <type_traits>
+#include <utility>
+#include <vector>
 #include <xxhash.h>
 
 #include "Common/CommonFuncs.h"
@@ -18,6 +21,7 @@
 #include "VideoBackends/Vulkan/StreamBuffer.h"
 #include "VideoBackends/Vulkan/Util.h"
 #include "VideoBackends/Vulkan/VertexFormat.h"
+#include "VideoCommon/ShaderWarmup.h"
 #include "VideoBackends/Vulkan/VulkanContext.h"
 #include "VideoCommon/Statistics.h"
 
@@ -313,9 +317,14 @@ std::pair<VkPipeline, bool> ObjectCache::GetPipelineWithCacheResult(const Pipeli
 }
 
 std::string ObjectCache::GetDiskCacheFileName(const char* type)
+{
+	return GetDiskCacheFileName(SConfig::GetInstance().m_strGameID, type);
+}
+
+std::string ObjectCache::GetDiskCacheFileName(const std::string& game_id, const char* type)
 {
 	return StringFromFormat("%sIVK-%s-%s.cache", File::GetUserPath(D_SHADERCACHE_IDX).c_str(),
-		SConfig::GetInstance().m_strGameID.c_str(), type);
+		game_id.c_str(), type);
 }
 
 std::string ObjectCache::GetDiskUIDCacheFileName()
@@ -508,28 +517,72 @@ void ObjectCache::SavePipelineCache()
 	disk_cache.Close();
 }
 
-// Cache inserter that is called back when reading from the file
-template <typename Uid, typename UidHasher>
-struct ShaderCacheReader : public LinearDiskCacheReader<Uid, u32>
+template <typename Cache>
+void ObjectCache::LoadShaderCache(Cache& cache, const std::string& filename, const char* what)
 {
-	ShaderCacheReader(ObjectUsageProfiler<Uid, pKey_t, ObjectCache::vkShaderItem, UidHasher>* shader_map) : m_shader_map(shader_map) {}
-	void Read(const Uid& key, const u32* value, u32 value_size) override
+	using DiskCache = LinearDiskCache<typename Cache::uid_type, u32>;
+	typename DiskCache::MappedEntries entries;
+	cache.disk_cache.OpenAndReadMapped(filename, &entries);
+
+	// The shader map is not thread safe, look the entries up before creating the modules
+	std::vector<std::pair<const typename DiskCache::Entry*, vkShaderItem*>> pending;
+	pending.reserve(entries.GetEntries().size());
+	for (const auto& entry : entries.GetEntries())
+	{
+		// The cache may have been written on another machine (e.g. by vulkanshadertool),
+		// whose UID hashes need not match ours.
+		typename Cache::uid_type uid = entry.key;
+		uid.ClearHASH();
+		uid.CalculateUIDHash();
+		vkShaderItem& it = cache.shader_map->GetOrAdd(uid);
+		if (!it.initialized.test_and_set())
+			pending.emplace_back(&entry, &it);
+	}
+
+	ShaderWarmup::Run(what, pending.size(), [&](size_t i)
 	{
 		// We don't insert null modules into the shader map since creation could succeed later on.
 		// e.g. we're generating bad code, but fix this in a later version, and for some reason
 		// the cache is not invalidated.
-		VkShaderModule module = Util::CreateShaderModule(value, value_size);
+		vkShaderItem& it = *pending[i].second;
+		VkShaderModule module = Util::CreateShaderModule(pending[i].first->value, pending[i].first->value_size);
 		if (module == VK_NULL_HANDLE)
+		{
+			it.initialized.clear();
 			return;
-
-		ObjectCache::vkShaderItem& it = m_shader_map->GetOrAdd(key);
-		it.initialized.test_and_set();
+		}
 		it.compiled = true;
 		it.module = module;
+	});
+}
+
+template <typename Cache, typename Compile>
+void ObjectCache::WarmupShaderCache(Cache& cache, pKey_t gameid, const char* what, Compile compile)
+{
+	// Shaders only recorded in the UID cache, which would otherwise be compiled when first drawn
+	using Uid = typename Cache::uid_type;
+	std::vector<std::pair<Uid, vkShaderItem*>> pending;
+	cache.shader_map->ForEachMostUsedByCategory(gameid,
+		[&](const Uid& uid, size_t total)
+	{
+		Uid item = uid;
+		item.ClearHASH();
+		item.CalculateUIDHash();
+		vkShaderItem& it = cache.shader_map->GetOrAdd(item);
+		if (!it.initialized.test_and_set())
+			pending.emplace_back(item, &it);
+	},
+		[](vkShaderItem& entry)
+	{
+		return !entry.compiled;
 	}
+	, true);
 
-	ObjectUsageProfiler<Uid, pKey_t, ObjectCache::vkShaderItem, UidHasher>* m_shader_map;
-};
+	ShaderWarmup::Run(what, pending.size(), [&](size_t i)
+	{
+		(this->*compile)(pending[i].first, *pending[i].second);
+	});
+}
 
 void ObjectCache::LoadShaderCaches()
 {
@@ -552,81 +605,18 @@ void ObjectCache::LoadShaderCaches()
 		"Ishiiruka.gs",
 		StringFromFormat("%s.gs", SConfig::GetInstance().m_strGameID.c_str())
 	));
-	ShaderCacheReader<VertexShaderUid, VertexShaderUid::ShaderUidHasher> vs_reader(m_vs_cache.shader_map.get());
-	m_vs_cache.disk_cache.OpenAndRead(GetDiskCacheFileName("vs"), vs_reader);
-
-	ShaderCacheReader<PixelShaderUid, PixelShaderUid::ShaderUidHasher> ps_reader(m_ps_cache.shader_map.get());
-	m_ps_cache.disk_cache.OpenAndRead(GetDiskCacheFileName("ps"), ps_reader);
-
+	LoadShaderCache(m_vs_cache, GetDiskCacheFileName("vs"), "Loading Vertex Shaders");
+	LoadShaderCache(m_ps_cache, GetDiskCacheFileName("ps"), "Loading Pixel Shaders");
 	if (g_vulkan_context->SupportsGeometryShaders())
-	{
-		ShaderCacheReader<GeometryShaderUid, GeometryShaderUid::ShaderUidHasher> gs_reader(m_gs_cache.shader_map.get());
-		m_gs_cache.disk_cache.OpenAndRead(GetDiskCacheFileName("gs"), gs_reader);
-	}
+		LoadShaderCache(m_gs_cache, GetDiskCacheFileName("gs"), "Loading Geometry Shaders");
 
-	if (g_ActiveConfig.bCompileShaderOnStartup)
+	// glslang initializes itself on first use, which is not thread safe
+	if (g_ActiveConfig.bCompileShaderOnStartup && ShaderCompiler::InitializeGlslang())
 	{
-		int shader_count = 0;
-		m_vs_cache.shader_map->ForEachMostUsedByCategory(gameid,
-			[&](const VertexShaderUid& uid, size_t total)
-		{
-			VertexShaderUid item = uid;
-			item.ClearHASH();
-			item.CalculateUIDHash();
-			vkShaderItem& it = m_vs_cache.shader_map->GetOrAdd(item);
-			if (!it.initialized.test_and_set())
-			{
-				Host_UpdateTitle(StringFromFormat("Compiling Vertex Shaders %i %% (%i/%i)", (shader_count * 100) / total, shader_count, total));
-				CompileVertexShaderForUid(item, it);
-			}
-		},
-			[](vkShaderItem& entry)
-		{
-			return !entry.compiled;
-		}
-		, true);
-		shader_count = 0;
-		m_ps_cache.shader_map->ForEachMostUsedByCategory(gameid,
-			[&](const PixelShaderUid& uid, size_t total)
-		{
-			PixelShaderUid item = uid;
-			item.ClearHASH();
-			item.CalculateUIDHash();
-			vkShaderItem& it = m_ps_cache.shader_map->GetOrAdd(item);
-			if (!it.initialized.test_and_set())
-			{
-				Host_UpdateTitle(StringFromFormat("Compiling Pixel Shaders %i %% (%i/%i)", (shader_count * 100) / total, shader_count, total));
-				CompilePixelShaderForUid(item, it);
-			}
-		},
-			[](vkShaderItem& entry)
-		{
-			return !entry.compiled;
-		}
-		, true);
-
+		WarmupShaderCache(m_vs_cache, gameid, "Compiling Vertex Shaders", &ObjectCache::CompileVertexShaderForUid);
+		WarmupShaderCache(m_ps_cache, gameid, "Compiling Pixel Shaders", &ObjectCache::CompilePixelShaderForUid);
 		if (g_vulkan_context->SupportsGeometryShaders())
-		{
-			shader_count = 0;
-			m_gs_cache.shader_map->ForEachMostUsedByCategory(gameid,
-				[&](const GeometryShaderUid& uid, size_t total)
-			{
-				GeometryShaderUid item = uid;
-				item.ClearHASH();
-				item.CalculateUIDHash();
-				vkShaderItem& it = m_gs_cache.shader_map->GetOrAdd(item);
-				if (!it.initialized.test_and_set())
-				{
-					Host_UpdateTitle(StringFromFormat("Compiling Geometry Shaders %i %% (%i/%i)", (shader_count * 100) / total, shader_count, total));
-					CompileGeometryShaderForUid(item, it);
-				}
-			},
-				[](vkShaderItem& entry)
-			{
-				return !entry.compiled;
-			}
-			, true);
-		}
+			WarmupShaderCache(m_gs_cache, gameid, "Compiling Geometry Shaders", &ObjectCache::CompileGeometryShaderForUid);
 	}
 
 	SETSTAT(stats.numVertexShadersCreated, static_cast<int>(m_vs_cache.shader_map->size()));
@@ -656,12 +646,21 @@ void ObjectCache::DestroyShaderCaches()
 		DestroyShaderCache(m_gs_cache);
 }
 
+static void SetThreadCodeBuffer(ShaderCode& code)
+{
+	// The generators' default buffer is shared, but the warmup compiles on several threads
+	static thread_local std::vector<char> buffer(std::max({VERTEXSHADERGEN_BUFFERSIZE,
+		PIXELSHADERGEN_BUFFERSIZE, GEOMETRYSHADERGEN_BUFFERSIZE}));
+	code.SetBuffer(buffer.data(), buffer.size());
+}
+
 void ObjectCache::CompileVertexShaderForUid(const VertexShaderUid& uid, ObjectCache::vkShaderItem& it)
 {
 	// Not in the cache, so compile the shader.
 	ShaderCompiler::SPIRVCodeVector spv;
 	VkShaderModule module = VK_NULL_HANDLE;
 	ShaderCode source_code;
+	SetThreadCodeBuffer(source_code);
 	GenerateVertexShaderCodeVulkan(source_code, uid.GetUidData());
 	if (ShaderCompiler::CompileVertexShader(&spv, source_code.GetBuffer(),
 		source_code.BufferSize()))
@@ -671,9 +670,8 @@ void ObjectCache::CompileVertexShaderForUid(const VertexShaderUid& uid, ObjectCa
 		// Append to shader cache if it created successfully.
 		if (module != VK_NULL_HANDLE)
 		{
+			std::lock_guard<std::mutex> guard(m_vs_cache.disk_cache_lock);
 			m_vs_cache.disk_cache.Append(uid, spv.data(), static_cast<u32>(spv.size()));
-			INCSTAT(stats.numVertexShadersCreated);
-			INCSTAT(stats.numVertexShadersAlive);
 		}
 	}
 	it.compiled = true;
@@ -686,6 +684,7 @@ void ObjectCache::CompileGeometryShaderForUid(const GeometryShaderUid& uid, Obje
 	ShaderCompiler::SPIRVCodeVector spv;
 	VkShaderModule module = VK_NULL_HANDLE;
 	ShaderCode source_code;
+	SetThreadCodeBuffer(source_code);
 	GenerateGeometryShaderCode(source_code, uid.GetUidData(), API_VULKAN);
 	if (ShaderCompiler::CompileGeometryShader(&spv, source_code.GetBuffer(),
 		source_code.BufferSize()))
@@ -694,7 +693,10 @@ void ObjectCache::CompileGeometryShaderForUid(const GeometryShaderUid& uid, Obje
 
 		// Append to shader cache if it created successfully.
 		if (module != VK_NULL_HANDLE)
+		{
+			std::lock_guard<std::mutex> guard(m_gs_cache.disk_cache_lock);
 			m_gs_cache.disk_cache.Append(uid, spv.data(), static_cast<u32>(spv.size()));
+		}
 	}
 	it.compiled = true;
 	// We still insert null entries to prevent further compilation attempts.
@@ -707,6 +709,7 @@ void ObjectCache::CompilePixelShaderForUid(const PixelShaderUid& uid, ObjectCach
 	ShaderCompiler::SPIRVCodeVector spv;
 	VkShaderModule module = VK_NULL_HANDLE;
 	ShaderCode source_code;
+	SetThreadCodeBuffer(source_code);
 	GeneratePixelShaderCodeVulkan(source_code, uid.GetUidData());
 	if (ShaderCompiler::CompileFragmentShader(&spv, source_code.GetBuffer(),
 		source_code.BufferSize()))
@@ -716,9 +719,8 @@ void ObjectCache::CompilePixelShaderForUid(const PixelShaderUid& uid, ObjectCach
 		// Append to shader cache if it created successfully.
 		if (module != VK_NULL_HANDLE)
 		{
+			std::lock_guard<std::mutex> guard(m_ps_cache.disk_cache_lock);
 			m_ps_cache.disk_cache.Append(uid, spv.data(), static_cast<u32>(spv.size()));
-			INCSTAT(stats.numPixelShadersCreated);
-			INCSTAT(stats.numPixelShadersAlive);
 		}
 	}
 	it.compiled = true;
@@ -733,6 +735,11 @@ VkShaderModule ObjectCache::GetVertexShaderForUid(const VertexShaderUid& uid)
 		return it.module;
 
 	CompileVertexShaderForUid(uid, it);
+	if (it.module != VK_NULL_HANDLE)
+	{
+		INCSTAT(stats.numVertexShadersCreated);
+		INCSTAT(stats.numVertexShadersAlive);
+	}
 	return it.module;
 }
 
@@ -754,6 +761,11 @@ VkShaderModule ObjectCache::GetPixelShaderForUid(const PixelShaderUid& uid)
 		return it.module;
 
 	CompilePixelShaderForUid(uid, it);
+	if (it.module != VK_NULL_HANDLE)
+	{
+		INCSTAT(stats.numPixelShadersCreated);
+		INCSTAT(stats.numPixelShadersAlive);
+	}
 	return it.module;
 }
 
@@ -8,6 +8,7 @@
 #include <cstddef>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 
@@ -154,6 +155,7 @@ public:
 	VkShaderModule GetPassthroughGeometryShader() const { return m_passthrough_geometry_shader; }
 	// Gets the filename of the specified type of cache object (e.g. vertex shader, pipeline).
 	std::string GetDiskCacheFileName(const char* type);
+	static std::string GetDiskCacheFileName(const std::string& game_id, const char* type);
 	std::string GetDiskUIDCacheFileName();
 	class vkShaderItem
 	{
@@ -168,6 +170,12 @@ private:
 	bool ValidatePipelineCache(const u8* data, size_t data_length);
 	void DestroyPipelineCache();
 	void LoadShaderCaches();
+	// Creates the modules of a SPIR-V disk cache on the thread pool.
+	template <typename Cache>
+	void LoadShaderCache(Cache& cache, const std::string& filename, const char* what);
+	// Compiles the shaders of the game's UID cache that are not in the disk cache yet.
+	template <typename Cache, typename Compile>
+	void WarmupShaderCache(Cache& cache, pKey_t gameid, const char* what, Compile compile);
 	void DestroyShaderCaches();
 	bool CreateDescriptorSetLayouts();
 	void DestroyDescriptorSetLayouts();
@@ -194,9 +202,12 @@ private:
 	class ShaderCache
 	{
 	public:
+		typedef Uid uid_type;
 		typedef ObjectUsageProfiler<Uid, pKey_t, vkShaderItem, UidHasher> cache_type;
 		std::unique_ptr<cache_type> shader_map{};
 		LinearDiskCache<Uid, u32> disk_cache{};
+		// Shaders are compiled on several threads during warmup
+		std::mutex disk_cache_lock;
 		ShaderCache(){}
 	};
 	typedef ShaderCache<VertexShaderUid, VertexShaderUid::ShaderUidHasher> VShaderCache;
@@ -26,9 +26,6 @@ namespace Vulkan
 {
 namespace ShaderCompiler
 {
-// Registers itself for cleanup via atexit
-bool InitializeGlslang();
-
 // Resource limits used when compiling shaders
 static const TBuiltInResource* GetCompilerResourceLimits();
 
@@ -17,6 +17,10 @@ namespace ShaderCompiler
 using SPIRVCodeType = u32;
 using SPIRVCodeVector = std::vector<SPIRVCodeType>;
 
+// Initializes glslang, which the compile functions do on first use.
+// Call this first when compiling from several threads.
+bool InitializeGlslang();
+
 // Compile a vertex shader to SPIR-V.
 bool CompileVertexShader(SPIRVCodeVector* out_code, const char* source_code,
 	size_t source_code_length, bool prepend_header = true);
@@ -0,0 +1,186 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <cinttypes>
+#include <utility>
+
+#include "Common/FileUtil.h"
+#include "Common/StringUtil.h"
+#include "Common/Thread.h"
+
+#include "Core/ConfigManager.h"
+
+#include "VideoCommon/AsyncTextureScaler.h"
+
+static const u32 CACHE_FILE_MAGIC = 0x53435854; // "TXCS"
+static const u32 CACHE_FILE_VERSION = 1;
+
+struct CacheFileHeader
+{
+	u32 magic;
+	u32 version;
+	u64 key;
+	u32 factor;
+	u32 level_count;
+};
+
+struct CacheFileLevel
+{
+	u32 width;
+	u32 height;
+	u32 expanded_width;
+};
+
+AsyncTextureScaler::AsyncTextureScaler() : m_has_results(false), m_running(true)
+{
+	m_thread = std::thread(&AsyncTextureScaler::WorkerThread, this);
+}
+
+AsyncTextureScaler::~AsyncTextureScaler()
+{
+	{
+		std::lock_guard<std::mutex> lk(m_mutex);
+		m_running = false;
+	}
+	m_wakeup.notify_one();
+	m_thread.join();
+}
+
+std::string AsyncTextureScaler::GetCacheFilename(u64 key)
+{
+	return StringFromFormat("%sScaledTextures/%s/%016" PRIx64 ".bin",
+		File::GetUserPath(D_CACHE_IDX).c_str(), SConfig::GetInstance().GetGameID().c_str(), key);
+}
+
+void AsyncTextureScaler::Queue(Request&& request)
+{
+	{
+		std::lock_guard<std::mutex> lk(m_mutex);
+		m_queue.push_back(std::move(request));
+	}
+	m_wakeup.notify_one();
+}
+
+void AsyncTextureScaler::Clear()
+{
+	std::lock_guard<std::mutex> lk(m_mutex);
+	m_queue.clear();
+	m_results.clear();
+	m_has_results.store(false);
+}
+
+bool AsyncTextureScaler::GetResults(std::vector<Request>* results)
+{
+	if (!m_has_results.load())
+		return false;
+	std::lock_guard<std::mutex> lk(m_mutex);
+	*results = std::move(m_results);
+	m_results.clear();
+	m_has_results.store(false);
+	return !results->empty();
+}
+
+void AsyncTextureScaler::WorkerThread()
+{
+	Common::SetCurrentThreadName("Texture Scaler");
+	std::unique_lock<std::mutex> lk(m_mutex);
+	while (true)
+	{
+		m_wakeup.wait(lk, [this] { return !m_running || !m_queue.empty(); });
+		if (!m_running)
+			break;
+		Request request = std::move(m_queue.front());
+		m_queue.pop_front();
+		lk.unlock();
+		Process(&request);
+		lk.lock();
+		m_results.push_back(std::move(request));
+		m_has_results.store(true);
+	}
+}
+
+void AsyncTextureScaler::Process(Request* request)
+{
+	if (!request->cache_filename.empty() && LoadFromDisk(request))
+		return;
+
+	const u32 factor = request->factor;
+	for (Level& level : request->levels)
+	{
+		u32* scaled = m_scaler.Scale(level.data.data(), level.expanded_width, level.height,
+			request->type, request->factor, request->deposterize);
+		level.width *= factor;
+		level.height *= factor;
+		level.expanded_width *= factor;
+		level.data.assign(scaled, scaled + level.expanded_width * level.height);
+	}
+
+	if (!request->cache_filename.empty())
+		SaveToDisk(*request);
+}
+
+bool AsyncTextureScaler::LoadFromDisk(Request* request)
+{
+	File::IOFile file(request->cache_filename, "rb");
+	if (!file)
+		return false;
+
+	CacheFileHeader header;
+	if (!file.ReadArray(&header, 1) || header.magic != CACHE_FILE_MAGIC ||
+		header.version != CACHE_FILE_VERSION || header.key != request->key ||
+		header.factor != static_cast<u32>(request->factor) || header.level_count != request->levels.size())
+	{
+		return false;
+	}
+
+	const u32 factor = request->factor;
+	std::vector<Level> levels(request->levels.size());
+	for (size_t i = 0; i < levels.size(); i++)
+	{
+		const Level& native = request->levels[i];
+		CacheFileLevel level_header;
+		if (!file.ReadArray(&level_header, 1) || level_header.width != native.width * factor ||
+			level_header.height != native.height * factor ||
+			level_header.expanded_width != native.expanded_width * factor)
+		{
+			return false;
+		}
+		levels[i].width = level_header.width;
+		levels[i].height = level_header.height;
+		levels[i].expanded_width = level_header.expanded_width;
+		levels[i].data.resize(level_header.expanded_width * level_header.height);
+		if (!file.ReadArray(levels[i].data.data(), levels[i].data.size()))
+			return false;
+	}
+	request->levels = std::move(levels);
+	return true;
+}
+
+void AsyncTextureScaler::SaveToDisk(const Request& request)
+{
+	// Write to a temporary file first, so a crash never leaves a truncated texture behind
+	const std::string temp_filename = request.cache_filename + ".tmp";
+	File::CreateFullPath(temp_filename);
+	{
+		File::IOFile file(temp_filename, "wb");
+		if (!file)
+			return;
+
+		CacheFileHeader header = { CACHE_FILE_MAGIC, CACHE_FILE_VERSION, request.key,
+			static_cast<u32>(request.factor), static_cast<u32>(request.levels.size()) };
+		bool ok = file.WriteArray(&header, 1);
+		for (const Level& level : request.levels)
+		{
+			CacheFileLevel level_header = { level.width, level.height, level.expanded_width };
+			ok = ok && file.WriteArray(&level_header, 1) && file.WriteArray(level.data.data(), level.data.size());
+		}
+		if (!ok)
+		{
+			file.Close();
+			File::Delete(temp_filename);
+			return;
+		}
+	}
+	File::Rename(temp_filename, request.cache_filename);
+}
@@ -0,0 +1,72 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "VideoCommon/TextureScalerCommon.h"
+
+// Runs TextureScaler on a background thread, so new textures can be shown at native resolution
+// until their scaled version is ready. Scaled textures can also be kept on disk, keyed by the
+// texture hash, so they don't have to be scaled again on the next run.
+class AsyncTextureScaler
+{
+public:
+	struct Level
+	{
+		u32 width;
+		u32 height;
+		u32 expanded_width;
+		// RGBA32 texels, expanded_width * height of them
+		std::vector<u32> data;
+	};
+
+	struct Request
+	{
+		// Identifies the texture contents and scaling settings
+		u64 key;
+		u32 address;
+		s32 type;
+		s32 factor;
+		bool deposterize;
+		// Empty if the result shouldn't be looked up or stored on disk
+		std::string cache_filename;
+		// Native levels when queued, scaled levels once finished
+		std::vector<Level> levels;
+	};
+
+	AsyncTextureScaler();
+	~AsyncTextureScaler();
+
+	void Queue(Request&& request);
+	// Drops requests that haven't been started yet, and all unclaimed results.
+	void Clear();
+	// Moves the finished requests to results, returns false if there weren't any.
+	bool GetResults(std::vector<Request>* results);
+
+	static std::string GetCacheFilename(u64 key);
+
+private:
+	void WorkerThread();
+	void Process(Request* request);
+	static bool LoadFromDisk(Request* request);
+	static void SaveToDisk(const Request& request);
+
+	TextureScaler m_scaler;
+	std::thread m_thread;
+	std::mutex m_mutex;
+	std::condition_variable m_wakeup;
+	std::deque<Request> m_queue;
+	std::vector<Request> m_results;
+	std::atomic<bool> m_has_results;
+	bool m_running;
+};
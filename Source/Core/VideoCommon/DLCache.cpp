@@ -0,0 +1,413 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+// Display list cache.
+// A display list that is called twice with the same contents and the same vertex format state gets
+// recorded on its next call: the BP/CP/XF writes are stored as a flat command list, and the vertices
+// of draws that don't reference vertex arrays are stored already converted to the native format.
+// Later calls replay the commands and copy the converted vertices straight into the vertex manager
+// buffer, skipping the opcode decoder and the vertex loaders.
+// Entries are validated against the list contents on every call, so a list that gets rewritten in
+// emulated memory is simply recorded again.
+
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Hash.h"
+#include "VideoCommon/BPMemory.h"
+#include "VideoCommon/CPMemory.h"
+#include "VideoCommon/DataReader.h"
+#include "VideoCommon/DLCache.h"
+#include "VideoCommon/NativeVertexFormat.h"
+#include "VideoCommon/OpcodeDecoding.h"
+#include "VideoCommon/Statistics.h"
+#include "VideoCommon/VertexLoaderManager.h"
+#include "VideoCommon/VertexManagerBase.h"
+#include "VideoCommon/VideoCommon.h"
+#include "VideoCommon/VideoConfig.h"
+#include "VideoCommon/XFMemory.h"
+
+namespace DLCache
+{
+
+// Lists that weren't called for this many frames are dropped.
+static constexpr u32 MAX_UNUSED_FRAMES = 300;
+// Number of frames between two cleanup passes.
+static constexpr u32 CLEANUP_INTERVAL = 60;
+// Upper bound for the converted vertex data kept by the cache.
+static constexpr size_t MAX_VERTEX_DATA_SIZE = 64 * 1024 * 1024;
+
+enum class CommandType : u8
+{
+	LoadBP,
+	LoadCP,
+	LoadXF,
+	LoadIndexedXF,
+	Draw,
+	DrawCached,
+};
+
+struct Command
+{
+	CommandType type;
+	u8 sub_cmd;  // CP register, indexed XF array or draw opcode
+	u16 count;   // XF transfer size or raw vertex count
+	u32 value;   // register value, XF address or index into the cached draws
+	u32 offset;  // offset of the XF data or of the raw vertices inside the list
+};
+
+struct CachedDraw
+{
+	NativeVertexFormat* native_format;
+	u32 components;
+	u32 data_offset;
+	u32 count;
+	int primitive;
+};
+
+// CP state that affects how the vertices inside a list are converted.
+struct CPSnapshot
+{
+	TVtxDesc vtx_desc;
+	VAT vtx_attr[8];
+	TMatrixIndexA matrix_index_a;
+	TMatrixIndexB matrix_index_b;
+
+	void Capture(const CPState& state)
+	{
+		memset(this, 0, sizeof(*this));
+		vtx_desc.Hex = state.vtx_desc.Hex;
+		memcpy(vtx_attr, state.vtx_attr, sizeof(vtx_attr));
+		matrix_index_a.Hex = state.matrix_index_a.Hex;
+		matrix_index_b.Hex = state.matrix_index_b.Hex;
+	}
+	bool operator==(const CPSnapshot& other) const
+	{
+		return memcmp(this, &other, sizeof(*this)) == 0;
+	}
+};
+
+enum class EntryStatus : u8
+{
+	Pending,      // seen once, recorded on the next call with the same contents
+	Recorded,
+	Uncacheable,  // contains something the cache can't replay, always interpreted
+};
+
+struct CachedDisplayList
+{
+	u64 hash = 0;
+	CPSnapshot state;
+	u32 cycles = 0;
+	u32 last_frame = 0;
+	EntryStatus status = EntryStatus::Pending;
+	std::vector<Command> commands;
+	std::vector<CachedDraw> draws;
+	std::vector<u8> vertex_data;
+};
+
+static std::unordered_map<u64, CachedDisplayList> s_cache;
+static size_t s_vertex_data_size;
+static u32 s_frame_count;
+
+static void ReleaseEntry(CachedDisplayList& entry)
+{
+	s_vertex_data_size -= entry.vertex_data.size();
+	entry.commands = std::vector<Command>();
+	entry.draws = std::vector<CachedDraw>();
+	entry.vertex_data = std::vector<u8>();
+}
+
+static inline bool IsDrawSkipped()
+{
+	return xfmem.viewport.wd == 0.0f
+		|| xfmem.viewport.ht == 0.0f
+		|| (bpmem.scissorBR.x + 1 - bpmem.scissorTL.x) == 0
+		|| (bpmem.scissorBR.y + 1 - bpmem.scissorTL.y) == 0;
+}
+
+static inline bool UsesVertexArrays(const TVtxDesc& vtx_desc)
+{
+	// Position, normal, the two colors and the eight texture coordinates.
+	for (int i = 0; i < 12; i++)
+	{
+		if (vtx_desc.GetVertexArrayStatus(i) >= 0x2)
+			return true;
+	}
+	return false;
+}
+
+static inline bool RunDraw(u8 cmd_byte, u32 count, u8* source, size_t buf_size, u32* readsize, u32* writesize, VertexLoaderParameters* out_parameters)
+{
+	VertexLoaderParameters& parameters = *out_parameters;
+	const u32 vtx_attr_group = cmd_byte & GX_VAT_MASK;
+	parameters.count = count;
+	parameters.buf_size = buf_size;
+	parameters.primitive = (cmd_byte & GX_PRIMITIVE_MASK) >> GX_PRIMITIVE_SHIFT;
+	parameters.vtx_attr_group = vtx_attr_group;
+	parameters.needloaderrefresh = (g_main_cp_state.attr_dirty & (1u << vtx_attr_group)) != 0;
+	parameters.skip_draw = IsDrawSkipped();
+	parameters.VtxDesc = &g_main_cp_state.vtx_desc;
+	parameters.VtxAttr = &g_main_cp_state.vtx_attr[vtx_attr_group];
+	parameters.source = source;
+	parameters.destination = nullptr;
+	g_main_cp_state.attr_dirty &= ~(1 << vtx_attr_group);
+	if (!VertexLoaderManager::ConvertVertices(parameters, *readsize, *writesize))
+		return false;
+	VertexManagerBase::s_pCurBufferPointer += *writesize;
+	return true;
+}
+
+// Interprets the list in g_VideoData while recording it into entry.
+static void Record(CachedDisplayList& entry, u8* start_address)
+{
+	DataReader& reader = g_VideoData;
+	u32 total_cycles = 0;
+	entry.status = EntryStatus::Recorded;
+	while (reader.size())
+	{
+		u8* opcode_start = reader.GetReadPosition();
+		const u8 cmd_byte = reader.Read<u8>();
+		Command command = {};
+		switch (cmd_byte)
+		{
+		case GX_NOP:
+			total_cycles += GX_NOP_CYCLES;
+			continue;
+		case GX_UNKNOWN_RESET:
+			total_cycles += GX_NOP_CYCLES;
+			continue;
+		case GX_CMD_UNKNOWN_METRICS:
+			total_cycles += GX_CMD_UNKNOWN_METRICS_CYCLES;
+			continue;
+		case GX_CMD_INVL_VC:
+			total_cycles += GX_CMD_INVL_VC_CYCLES;
+			continue;
+		case GX_LOAD_CP_REG:
+		{
+			total_cycles += GX_LOAD_CP_REG_CYCLES;
+			command.type = CommandType::LoadCP;
+			command.sub_cmd = reader.Read<u8>();
+			command.value = reader.Read<u32>();
+			LoadCPReg<false>(command.sub_cmd, command.value);
+			INCSTAT(stats.thisFrame.numCPLoads);
+		}
+		break;
+		case GX_LOAD_XF_REG:
+		{
+			const u32 cmd2 = reader.Read<u32>();
+			const u32 transfer_size = ((cmd2 >> 16) & 15) + 1;
+			total_cycles += GX_LOAD_XF_REG_BASE_CYCLES + GX_LOAD_XF_REG_TRANSFER_CYCLES * transfer_size;
+			command.type = CommandType::LoadXF;
+			command.count = static_cast<u16>(transfer_size);
+			command.value = cmd2 & 0xFFFF;
+			command.offset = static_cast<u32>(reader.GetReadPosition() - start_address);
+			LoadXFReg(transfer_size, command.value);
+			INCSTAT(stats.thisFrame.numXFLoads);
+		}
+		break;
+		case GX_LOAD_INDX_A:
+		case GX_LOAD_INDX_B:
+		case GX_LOAD_INDX_C:
+		case GX_LOAD_INDX_D:
+		{
+			total_cycles += GX_LOAD_INDX_CYCLES;
+			command.type = CommandType::LoadIndexedXF;
+			command.sub_cmd = (cmd_byte >> 3) + 8;
+			command.value = reader.Read<u32>();
+			LoadIndexedXF(command.value, command.sub_cmd);
+		}
+		break;
+		case GX_LOAD_BP_REG:
+		{
+			total_cycles += GX_LOAD_BP_REG_CYCLES;
+			command.type = CommandType::LoadBP;
+			command.value = reader.Read<u32>();
+			LoadBPReg(command.value);
+			INCSTAT(stats.thisFrame.numBPLoads);
+		}
+		break;
+		default:
+			if ((cmd_byte & GX_DRAW_PRIMITIVES) == 0x80)
+			{
+				const u32 count = reader.Read<u16>();
+				if (count == 0)
+				{
+					total_cycles += GX_NOP_CYCLES;
+					continue;
+				}
+				VertexLoaderParameters parameters;
+				u32 readsize = 0;
+				u32 writesize = 0;
+				u8* source = reader.GetReadPosition();
+				if (RunDraw(cmd_byte, count, source, reader.size(), &readsize, &writesize, &parameters))
+				{
+					total_cycles += GX_NOP_CYCLES + GX_DRAW_PRIMITIVES_CYCLES * count;
+					reader.ReadSkip(readsize);
+					NativeVertexFormat* native_format = VertexLoaderManager::GetCurrentVertexFormat();
+					if (!parameters.skip_draw && writesize != 0 && !UsesVertexArrays(g_main_cp_state.vtx_desc)
+						&& s_vertex_data_size + writesize <= MAX_VERTEX_DATA_SIZE)
+					{
+						CachedDraw draw;
+						draw.native_format = native_format;
+						draw.components = VertexLoaderManager::g_current_components;
+						draw.data_offset = static_cast<u32>(entry.vertex_data.size());
+						draw.count = writesize / native_format->GetVertexStride();
+						draw.primitive = parameters.primitive;
+						entry.vertex_data.insert(entry.vertex_data.end(), parameters.destination, parameters.destination + writesize);
+						s_vertex_data_size += writesize;
+						command.type = CommandType::DrawCached;
+						command.value = static_cast<u32>(entry.draws.size());
+						entry.draws.push_back(draw);
+					}
+					else
+					{
+						command.type = CommandType::Draw;
+						command.sub_cmd = cmd_byte;
+						command.count = static_cast<u16>(count);
+						command.offset = static_cast<u32>(source - start_address);
+					}
+					break;
+				}
+			}
+			// Unknown opcodes, nested display lists and truncated draws are left to the
+			// regular decoder so that they behave exactly as without the cache.
+			{
+				u32 remaining_cycles = 0;
+				reader.SetReadPosition(opcode_start);
+				OpcodeDecoder::Run<false, false>(reader, &remaining_cycles);
+				total_cycles += remaining_cycles;
+				ReleaseEntry(entry);
+				entry.status = EntryStatus::Uncacheable;
+				entry.cycles = total_cycles;
+				return;
+			}
+		}
+		entry.commands.push_back(command);
+	}
+	entry.cycles = total_cycles;
+}
+
+static void Replay(const CachedDisplayList& entry, u8* start_address, u32 size)
+{
+	for (const Command& command : entry.commands)
+	{
+		switch (command.type)
+		{
+		case CommandType::LoadBP:
+			LoadBPReg(command.value);
+			INCSTAT(stats.thisFrame.numBPLoads);
+			break;
+		case CommandType::LoadCP:
+			LoadCPReg<false>(command.sub_cmd, command.value);
+			INCSTAT(stats.thisFrame.numCPLoads);
+			break;
+		case CommandType::LoadXF:
+			g_VideoData.SetReadPosition(start_address + command.offset);
+			LoadXFReg(command.count, command.value);
+			INCSTAT(stats.thisFrame.numXFLoads);
+			break;
+		case CommandType::LoadIndexedXF:
+			LoadIndexedXF(command.value, command.sub_cmd);
+			break;
+		case CommandType::Draw:
+		{
+			VertexLoaderParameters parameters;
+			u32 readsize = 0;
+			u32 writesize = 0;
+			RunDraw(command.sub_cmd, command.count, start_address + command.offset, size - command.offset, &readsize, &writesize, &parameters);
+		}
+		break;
+		case CommandType::DrawCached:
+		{
+			if (IsDrawSkipped())
+				break;
+			const CachedDraw& draw = entry.draws[command.value];
+			VertexLoaderManager::AddConvertedVertices(draw.native_format, draw.components, draw.primitive, draw.count, &entry.vertex_data[draw.data_offset]);
+		}
+		break;
+		}
+	}
+	INCSTAT(stats.thisFrame.numDListsReplayed);
+}
+
+void Init()
+{
+	Clear();
+	s_frame_count = 0;
+}
+
+void Shutdown()
+{
+	Clear();
+}
+
+void Clear()
+{
+	s_cache.clear();
+	s_vertex_data_size = 0;
+}
+
+void ProgressiveCleanup()
+{
+	s_frame_count++;
+	if (s_frame_count % CLEANUP_INTERVAL != 0)
+		return;
+	for (auto it = s_cache.begin(); it != s_cache.end();)
+	{
+		if (s_frame_count - it->second.last_frame > MAX_UNUSED_FRAMES)
+		{
+			ReleaseEntry(it->second);
+			it = s_cache.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+bool HandleDisplayList(u8* start_address, u32 address, u32 size, u32* cycles)
+{
+	// Recording the FIFO needs the raw commands and CPU bounding box emulation needs the
+	// vertex loaders to run, so both bypass the cache.
+	if (!g_ActiveConfig.bDlistCachingEnable || g_bRecordFifoData || g_ActiveConfig.iBBoxMode == BBoxCPU)
+		return false;
+
+	const u64 key = (static_cast<u64>(address) << 32) | size;
+	const u64 hash = GetHash64(start_address, size, 0);
+	CPSnapshot state;
+	state.Capture(g_main_cp_state);
+
+	CachedDisplayList& entry = s_cache[key];
+	entry.last_frame = s_frame_count;
+	if (entry.hash != hash || !(entry.state == state))
+	{
+		// New or modified list, only remember it for now so that lists which are
+		// rebuilt every frame don't pay for recording.
+		ReleaseEntry(entry);
+		entry.hash = hash;
+		entry.state = state;
+		entry.status = EntryStatus::Pending;
+		return false;
+	}
+
+	switch (entry.status)
+	{
+	case EntryStatus::Pending:
+		Record(entry, start_address);
+		break;
+	case EntryStatus::Recorded:
+		Replay(entry, start_address, size);
+		break;
+	case EntryStatus::Uncacheable:
+		return false;
+	}
+	*cycles = entry.cycles;
+	return true;
+}
+
+}  // namespace DLCache
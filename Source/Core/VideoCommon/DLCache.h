@@ -0,0 +1,24 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "Common/CommonTypes.h"
+
+namespace DLCache
+{
+
+void Init();
+void Shutdown();
+void Clear();
+
+// Called once per frame from the GPU thread, drops lists that haven't been used for a while.
+void ProgressiveCleanup();
+
+// Runs the display list at start_address (size bytes, located at address in emulated memory).
+// g_VideoData must already point at the list.
+// Returns false if the list isn't handled by the cache and has to be interpreted by the caller.
+bool HandleDisplayList(u8* start_address, u32 address, u32 size, u32* cycles);
+
+}  // namespace DLCache
@@ -2,6 +2,7 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <atomic>
 #include <cstring>
 
@@ -26,6 +27,7 @@
 #include "VideoCommon/CommandProcessor.h"
 #include "VideoCommon/DataReader.h"
 #include "VideoCommon/Fifo.h"
+#include "VideoCommon/FrameProfiler.h"
 #include "VideoCommon/OpcodeDecoding.h"
 #include "VideoCommon/VertexLoaderManager.h"
 #include "VideoCommon/VertexManagerBase.h"
@@ -37,6 +39,9 @@ namespace Fifo
 {
 static constexpr u32 FIFO_SIZE = 2 * 1024 * 1024;
 static constexpr int GPU_TIME_SLOT_SIZE = 1000;
+// Upper bound for the data the GPU thread takes from the FIFO in one go, so that
+// EFB access and swap requests are still answered in time.
+static constexpr u32 FIFO_MAX_BATCH_SIZE = 64 * 1024;
 
 static Common::BlockingLoop s_gpu_mainloop;
 
@@ -224,9 +229,8 @@ void* PopFifoAuxBuffer(size_t size)
 }
 
 // Description: RunGpuLoop() sends data through this function.
-static void ReadDataFromFifo(u32 readPtr)
+static void ReadDataFromFifo(u32 readPtr, size_t len)
 {
-	size_t len = 32;
 	if (len > (size_t)(s_video_buffer + FIFO_SIZE - s_video_buffer_write_ptr))
 	{
 		size_t existing_len = s_video_buffer_write_ptr - s_video_buffer_read_ptr;
@@ -245,6 +249,31 @@ static void ReadDataFromFifo(u32 readPtr)
 	s_video_buffer_write_ptr += len;
 }
 
+// Number of bytes RunGpuLoop() can take from the FIFO at readPtr in one go: everything the
+// CPU has written, stopping at the end of the ring buffer, at an enabled breakpoint and at the
+// enabled underflow interrupt.
+static u32 GetFifoBatchSize(u32 readPtr)
+{
+	const SCPFifoStruct& fifo = CommandProcessor::fifo;
+	const u32 end = fifo.CPEnd;
+	if (readPtr > end)
+		return 32;
+
+	const u32 distance = fifo.CPReadWriteDistance;
+	u32 size = std::min({distance, FIFO_MAX_BATCH_SIZE, end + 32 - readPtr});
+	const u32 breakpoint = fifo.CPBreakpoint;
+	if (fifo.bFF_BPEnable && breakpoint > readPtr && breakpoint - readPtr < size)
+		size = breakpoint - readPtr;
+	// Like the 32 byte loop, stop at the first granule that takes the distance below the low
+	// watermark, so SetCPStatusFromGPU raises the interrupt before the rest is consumed
+	if (fifo.bFF_LoWatermarkInt)
+	{
+		const u32 watermark = fifo.CPLoWatermark;
+		size = std::min(size, distance < watermark ? 32 : ((distance - watermark) & ~31u) + 32);
+	}
+	return std::max<u32>(size & ~31u, 32);
+}
+
 // The deterministic_gpu_thread version.
 static void ReadDataFromFifoOnCPU(u32 readPtr)
 {
@@ -309,6 +338,8 @@ void RunGpuLoop()
 		if (!s_emu_running_state.IsSet())
 			return;
 
+		FrameProfiler::ScopedSection gpu_thread_section(FrameProfiler::SECTION_GPU_THREAD);
+
 		if (s_use_deterministic_gpu_thread)
 		{
 			AsyncRequests::GetInstance()->PullEvents();
@@ -320,6 +351,7 @@ void RunGpuLoop()
 			if (write_ptr > seen_ptr)
 			{
 				g_VideoData.SetReadPosition(s_video_buffer_read_ptr, write_ptr);
+				FrameProfiler::ScopedSection decode_section(FrameProfiler::SECTION_OPCODE_DECODE);
 				s_video_buffer_read_ptr = OpcodeDecoder::Run<false>(g_VideoData, nullptr);
 				s_video_buffer_seen_ptr = write_ptr;
 			}
@@ -339,26 +371,32 @@ void RunGpuLoop()
 				if (param.bSyncGPU && s_sync_ticks.load() < param.iSyncGpuMinDistance)
 					break;
 
+				// SyncGPU paces the GPU thread by the cycles of every 32 byte granule, otherwise
+				// consume everything that is available and publish the new pointers once.
 				u32 cyclesExecuted = 0;
 				u32 readPtr = fifo.CPReadPointer;
-				ReadDataFromFifo(readPtr);
+				const u32 len = param.bSyncGPU ? 32 : GetFifoBatchSize(readPtr);
+				ReadDataFromFifo(readPtr, len);
 
-				if (readPtr == fifo.CPEnd)
+				if (readPtr <= fifo.CPEnd && len == fifo.CPEnd + 32 - readPtr)
 					readPtr = fifo.CPBase;
 				else
-					readPtr += 32;
+					readPtr += len;
 
-				_assert_msg_(COMMANDPROCESSOR, (s32)fifo.CPReadWriteDistance - 32 >= 0,
+				_assert_msg_(COMMANDPROCESSOR, (s32)fifo.CPReadWriteDistance - (s32)len >= 0,
 					"Negative fifo.CPReadWriteDistance = %i in FIFO Loop !\nThat can produce "
 					"instability in the game. Please report it.",
-					fifo.CPReadWriteDistance - 32);
+					fifo.CPReadWriteDistance - len);
 
 				u8* write_ptr = s_video_buffer_write_ptr;
 				g_VideoData.SetReadPosition(s_video_buffer_read_ptr, write_ptr);
-				s_video_buffer_read_ptr = OpcodeDecoder::Run(g_VideoData, &cyclesExecuted);
+				{
+					FrameProfiler::ScopedSection decode_section(FrameProfiler::SECTION_OPCODE_DECODE);
+					s_video_buffer_read_ptr = OpcodeDecoder::Run(g_VideoData, &cyclesExecuted);
+				}
 
 				Common::AtomicStore(fifo.CPReadPointer, readPtr);
-				Common::AtomicAdd(fifo.CPReadWriteDistance, -32);
+				Common::AtomicAdd(fifo.CPReadWriteDistance, -(s32)len);
 				if ((write_ptr - s_video_buffer_read_ptr) == 0)
 					Common::AtomicStore(fifo.SafeCPReadPointer, fifo.CPReadPointer);
 
@@ -463,10 +501,13 @@ static int RunGpuOnCpu(int ticks)
 				FPURoundMode::LoadDefaultSIMDState();
 				reset_simd_state = true;
 			}
-			ReadDataFromFifo(fifo.CPReadPointer);
+			ReadDataFromFifo(fifo.CPReadPointer, 32);
 			u32 cycles = 0;
 			g_VideoData.SetReadPosition(s_video_buffer_read_ptr, s_video_buffer_write_ptr);
+			{
+				FrameProfiler::ScopedSection decode_section(FrameProfiler::SECTION_OPCODE_DECODE);
 				s_video_buffer_read_ptr = OpcodeDecoder::Run(g_VideoData, &cycles);
+			}
 			available_ticks -= cycles;
 		}
 
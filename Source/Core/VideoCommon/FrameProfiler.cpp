@@ -0,0 +1,86 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <mutex>
+#include <utility>
+
+#include "VideoCommon/FrameProfiler.h"
+
+namespace FrameProfiler
+{
+static bool s_enabled = false;
+
+// Only touched by the video thread
+static int s_depth[NUM_SECTIONS];
+static std::chrono::steady_clock::time_point s_start[NUM_SECTIONS];
+static FrameTimes s_current_frame;
+
+static std::mutex s_frames_mutex;
+static std::vector<FrameTimes> s_frames;
+
+const char* GetSectionName(Section section)
+{
+	static const char* names[NUM_SECTIONS] = {"gpu_thread", "opcode_decode", "vertex_loader",
+		"texture_decode"};
+	return names[section];
+}
+
+void SetEnabled(bool enabled)
+{
+	s_enabled = enabled;
+	for (int& depth : s_depth)
+		depth = 0;
+	s_current_frame = {};
+	TakeFrames();
+}
+
+bool IsEnabled()
+{
+	return s_enabled;
+}
+
+void BeginSection(Section section)
+{
+	if (s_depth[section]++ == 0)
+		s_start[section] = std::chrono::steady_clock::now();
+}
+
+void EndSection(Section section)
+{
+	if (--s_depth[section] == 0)
+	{
+		s_current_frame.nanoseconds[section] += std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - s_start[section]).count();
+	}
+}
+
+void EndFrame()
+{
+	if (!s_enabled)
+		return;
+
+	const auto now = std::chrono::steady_clock::now();
+	for (int section = 0; section < NUM_SECTIONS; section++)
+	{
+		if (s_depth[section] == 0)
+			continue;
+		s_current_frame.nanoseconds[section] +=
+			std::chrono::duration_cast<std::chrono::nanoseconds>(now - s_start[section]).count();
+		s_start[section] = now;
+	}
+
+	std::lock_guard<std::mutex> lock(s_frames_mutex);
+	s_frames.push_back(s_current_frame);
+	s_current_frame = {};
+}
+
+std::vector<FrameTimes> TakeFrames()
+{
+	std::vector<FrameTimes> frames;
+	std::lock_guard<std::mutex> lock(s_frames_mutex);
+	frames.swap(s_frames);
+	return frames;
+}
+}
@@ -0,0 +1,62 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <vector>
+
+#include "Common/CommonTypes.h"
+
+// Per frame timings of the video emulation, for benchmarking. Sections nest: opcode decoding
+// includes the vertex loading and texture decoding it triggers, and all of them are part of the
+// GPU thread time. Timing is only done on the thread running the video emulation.
+namespace FrameProfiler
+{
+enum Section
+{
+	SECTION_GPU_THREAD,
+	SECTION_OPCODE_DECODE,
+	SECTION_VERTEX_LOADER,
+	SECTION_TEXTURE_DECODE,
+	NUM_SECTIONS
+};
+
+struct FrameTimes
+{
+	u64 nanoseconds[NUM_SECTIONS];
+};
+
+const char* GetSectionName(Section section);
+
+void SetEnabled(bool enabled);
+bool IsEnabled();
+
+void BeginSection(Section section);
+void EndSection(Section section);
+
+// Closes the current frame, the time of sections that are still running goes to the next one
+void EndFrame();
+
+// Returns the frames completed since the last call and forgets them, can be called from any thread
+std::vector<FrameTimes> TakeFrames();
+
+class ScopedSection
+{
+public:
+	explicit ScopedSection(Section section) : m_section(section), m_active(IsEnabled())
+	{
+		if (m_active)
+			BeginSection(m_section);
+	}
+	~ScopedSection()
+	{
+		if (m_active)
+			EndSection(m_section);
+	}
+
+private:
+	Section m_section;
+	bool m_active;
+};
+}
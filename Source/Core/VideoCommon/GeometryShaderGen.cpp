@@ -101,7 +101,7 @@ inline void GenerateGeometryShader(ShaderCode& out, const geometry_shader_uid_da
 	if (codebuffer == nullptr)
 	{
 		codebuffer = text;
-		out.SetBuffer(codebuffer);
+		out.SetBuffer(codebuffer, sizeof(text));
 	}
 	codebuffer[sizeof(text) - 1] = 0x7C;  // canary
 
@@ -62,7 +62,6 @@ HLSLAsyncCompiler::HLSLAsyncCompiler() :
 	m_output(256)
 {
 	WorkUnitRepository = new ShaderCompilerWorkUnit[256];
-	Common::ThreadPool::RegisterWorker(this);
 }
 
 void HLSLAsyncCompiler::SetCompilerFunction(pD3DCompile compilerfunc)
@@ -73,7 +72,6 @@ void HLSLAsyncCompiler::SetCompilerFunction(pD3DCompile compilerfunc)
 HLSLAsyncCompiler::~HLSLAsyncCompiler()
 {
 	delete[] WorkUnitRepository;
-	Common::ThreadPool::UnregisterWorker(this);
 }
 
 bool HLSLAsyncCompiler::NextTask()
@@ -102,7 +100,6 @@ bool HLSLAsyncCompiler::NextTask()
 }
 ShaderCompilerWorkUnit* HLSLAsyncCompiler::NewUnit(u32 codesize)
 {
-	Common::ThreadPool::NotifyWorkPending();
 	u32 index = m_repositoryIndex.fetch_add(1);
 	ShaderCompilerWorkUnit* result = &WorkUnitRepository[index & 255];
 	result->Clear();
@@ -116,6 +113,7 @@ ShaderCompilerWorkUnit* HLSLAsyncCompiler::NewUnit(u32 codesize)
 void HLSLAsyncCompiler::CompileShaderAsync(ShaderCompilerWorkUnit* unit)
 {
 	m_input.push(unit);
+	Common::ThreadPool::ExecuteAsync([this] { NextTask(); });
 }
 void HLSLAsyncCompiler::ProcCompilationResults()
 {
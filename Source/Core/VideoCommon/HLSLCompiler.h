@@ -33,7 +33,7 @@ public:
 	void Release();
 };
 
-class HLSLAsyncCompiler final : Common::IWorker
+class HLSLAsyncCompiler final
 {
 	friend class HLSLCompiler;
 	pD3DCompile PD3DCompile;
@@ -48,7 +48,7 @@ public:
 	static HLSLAsyncCompiler& getInstance();
 	void SetCompilerFunction(pD3DCompile compilerfunc);
 	virtual ~HLSLAsyncCompiler();
-	bool NextTask() override;
+	bool NextTask();
 	ShaderCompilerWorkUnit* NewUnit(u32 codesize);
 	void CompileShaderAsync(ShaderCompilerWorkUnit* unit);
 	void ProcCompilationResults();
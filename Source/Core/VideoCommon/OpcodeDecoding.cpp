@@ -21,6 +21,7 @@
 #include "VideoCommon/CommandProcessor.h"
 #include "VideoCommon/CPMemory.h"
 #include "VideoCommon/DataReader.h"
+#include "VideoCommon/DLCache.h"
 #include "VideoCommon/Fifo.h"
 #include "VideoCommon/OpcodeDecoding.h"
 #include "VideoCommon/Statistics.h"
@@ -62,7 +63,8 @@ __forceinline u32 InterpretDisplayList(u32 address, u32 size)
 
 		// temporarily swap dl and non-dl (small "hack" for the stats)
 		Statistics::SwapDL();
-		OpcodeDecoder::Run<false, false>(g_VideoData, &cycles);
+		if (!DLCache::HandleDisplayList(startAddress, address, size, &cycles))
+			OpcodeDecoder::Run<false, false>(g_VideoData, &cycles);
 		INCSTAT(stats.thisFrame.numDListsCalled);
 		// un-swap
 		Statistics::SwapDL();
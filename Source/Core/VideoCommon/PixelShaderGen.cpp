@@ -1518,7 +1518,7 @@ inline void GeneratePixelShader(ShaderCode& out, const pixel_shader_uid_data& ui
 	if (codebuffer == nullptr)
 	{
 		codebuffer = text;
-		out.SetBuffer(codebuffer);
+		out.SetBuffer(codebuffer, sizeof(text));
 	}
 	codebuffer[PIXELSHADERGEN_BUFFERSIZE - 1] = 0x7C;  // canary
 	PIXEL_SHADER_RENDER_MODE render_mode = (PIXEL_SHADER_RENDER_MODE)uid_data.render_mode;
@@ -43,8 +43,10 @@
 #include "VideoCommon/CommandProcessor.h"
 #include "VideoCommon/CPMemory.h"
 #include "VideoCommon/Debugger.h"
+#include "VideoCommon/DLCache.h"
 #include "VideoCommon/FPSCounter.h"
 #include "VideoCommon/FramebufferManagerBase.h"
+#include "VideoCommon/FrameProfiler.h"
 #include "VideoCommon/GeometryShaderManager.h"
 #include "VideoCommon/ImageWrite.h"
 #include "VideoCommon/OnScreenDisplay.h"
@@ -714,12 +716,14 @@ void Renderer::Swap(u32 xfbAddr, u32 fbWidth, u32 fbStride, u32 fbHeight, const
 		g_renderer->m_fps_counter.Update();
 
 	frameCount++;
+	DLCache::ProgressiveCleanup();
 	GFX_DEBUGGER_PAUSE_AT(NEXT_FRAME, true);
 
 	// Begin new frame
 	// Set default viewport and scissor, for the clear to work correctly
 	// New frame
 	stats.ResetFrame();
+	FrameProfiler::EndFrame();
 
 	Core::Callback_VideoCopiedToXFB(XFBWrited || (g_ActiveConfig.bUseXFB && g_ActiveConfig.bUseRealXFB));
 	XFBWrited = false;
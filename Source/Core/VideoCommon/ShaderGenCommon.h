@@ -4,7 +4,9 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstdarg>
+#include <cstdio>
 #include <cstring>
 #include <fstream>
 #include <iomanip>
@@ -99,29 +101,53 @@ private:
 	std::size_t HASH;
 };
 
+// Appends generated shader source to a caller provided buffer.
+// Writes never go past the end of the buffer: output that does not fit is truncated and
+// the buffer stays null-terminated, which eats the generators' canary and gets reported.
 class ShaderCode
 {
 public:
-	ShaderCode() : buf(NULL), write_ptr(NULL)
+	ShaderCode() : buf(nullptr), write_ptr(nullptr), buf_end(nullptr)
 	{
 
 	}
 
 	void Write(const char* fmt, ...)
 	{
+		// Most fragments are plain text, copy up to the first conversion without
+		// going through the printf machinery.
+		const char* conversion = fmt + strcspn(fmt, "%");
+		Append(fmt, conversion - fmt);
+		if (*conversion == '\0')
+			return;
+
+		const size_t space = buf_end - write_ptr;
 		va_list arglist;
 		va_start(arglist, fmt);
-		write_ptr += vsprintf(write_ptr, fmt, arglist);
+		const int written = vsnprintf(write_ptr, space, conversion, arglist);
 		va_end(arglist);
+		if (written > 0)
+			write_ptr += std::min(static_cast<size_t>(written), space - 1);
+	}
+
+	// Appends length characters of str, which may contain '%'.
+	void Append(const char* str, size_t length)
+	{
+		const size_t space = buf_end - write_ptr - 1;
+		length = std::min(length, space);
+		memcpy(write_ptr, str, length);
+		write_ptr += length;
+		*write_ptr = '\0';
 	}
 
 	char* GetBuffer()
 	{
 		return buf;
 	}
-	void SetBuffer(char* buffer)
+	void SetBuffer(char* buffer, size_t size)
 	{
-		buf = buffer; write_ptr = buffer;
+		buf = buffer; write_ptr = buffer; buf_end = buffer + size;
+		*buffer = '\0';
 	}
 	ptrdiff_t BufferSize()
 	{
@@ -130,6 +156,7 @@ public:
 private:
 	char* buf;
 	char* write_ptr;
+	char* buf_end;
 };
 
 template<API_TYPE api_type>
@@ -0,0 +1,79 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "VideoCommon/ShaderGenCommon.h"
+
+// Memoizes the source text the shader generators produce for a UID, so a UID that is needed
+// again (e.g. one vertex shader linked into many OpenGL programs) is only generated once.
+// Generation uses a buffer owned by the cache instead of the generators' static one.
+// Not thread safe; references returned by GetOrGenerate stay valid until the cache is cleared.
+template <typename Uid>
+class ShaderSourceCache
+{
+public:
+	// buffer_size must be at least the generator's *_BUFFERSIZE, which is where it puts
+	// its canary. Once max_entries sources are stored the cache starts over.
+	ShaderSourceCache(size_t buffer_size, size_t max_entries)
+		: m_buffer(buffer_size), m_max_entries(max_entries)
+	{
+	}
+
+	// generate is called as generate(ShaderCode&, const Uid&) when uid is not cached yet.
+	template <typename Generator>
+	const std::string& GetOrGenerate(const Uid& uid, Generator generate)
+	{
+		// Hashes loaded from disk may come from another hash function, recompute them
+		Uid key = uid;
+		key.ClearHASH();
+		key.CalculateUIDHash();
+		auto it = m_sources.find(key);
+		if (it != m_sources.end())
+		{
+			m_hits++;
+			return it->second;
+		}
+
+		if (m_sources.size() >= m_max_entries)
+			m_sources.clear();
+
+		ShaderCode code;
+		code.SetBuffer(m_buffer.data(), m_buffer.size());
+		generate(code, key);
+		m_misses++;
+		return m_sources.emplace(key, std::string(code.GetBuffer(), code.BufferSize())).first->second;
+	}
+
+	void Clear()
+	{
+		m_sources.clear();
+		m_hits = 0;
+		m_misses = 0;
+	}
+
+	size_t size() const
+	{
+		return m_sources.size();
+	}
+	u64 GetHits() const
+	{
+		return m_hits;
+	}
+	u64 GetMisses() const
+	{
+		return m_misses;
+	}
+
+private:
+	std::unordered_map<Uid, std::string, typename Uid::ShaderUidHasher> m_sources;
+	std::vector<char> m_buffer;
+	size_t m_max_entries;
+	u64 m_hits = 0;
+	u64 m_misses = 0;
+};
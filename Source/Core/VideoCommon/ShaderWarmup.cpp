@@ -0,0 +1,55 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "VideoCommon/ShaderWarmup.h"
+
+#include <algorithm>
+#include <atomic>
+
+#include "Common/StringUtil.h"
+#include "Common/ThreadPool.h"
+#include "Core/Host.h"
+
+namespace ShaderWarmup
+{
+void Run(const char* what, size_t count, const std::function<void(size_t)>& func)
+{
+	if (count == 0)
+		return;
+
+	std::atomic<size_t> next_item{0};
+	std::atomic<size_t> finished{0};
+	auto work = [&]
+	{
+		for (size_t i = next_item++; i < count; i = next_item++)
+		{
+			func(i);
+			finished++;
+		}
+	};
+
+	Common::TaskGroup group;
+	const size_t helpers = std::min<size_t>(Common::ThreadPool::GetThreadCount() - 1, count - 1);
+	for (size_t i = 0; i < helpers; i++)
+		group.Run(std::function<void()>(work));
+
+	// Host_UpdateTitle is only called from here, so the host sees the updates in order
+	size_t shown_percent = 0;
+	Host_UpdateTitle(StringFromFormat("%s 0 %% (0/%zu)", what, count));
+	for (size_t i = next_item++; i < count; i = next_item++)
+	{
+		func(i);
+		const size_t done = ++finished;
+		const size_t percent = done * 100 / count;
+		if (percent != shown_percent)
+		{
+			shown_percent = percent;
+			Host_UpdateTitle(StringFromFormat("%s %zu %% (%zu/%zu)", what, percent, done, count));
+		}
+	}
+	group.Wait();
+	if (shown_percent != 100)
+		Host_UpdateTitle(StringFromFormat("%s 100 %% (%zu/%zu)", what, count, count));
+}
+}
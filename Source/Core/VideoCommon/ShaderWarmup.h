@@ -0,0 +1,17 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace ShaderWarmup
+{
+// Runs func(i) for every i in [0, count) on the thread pool, for compiling or loading the shaders
+// of a cache at boot. The calling thread takes part and shows the progress in the title bar as
+// "<what> 42 % (420/1000)". Returns once every call finished.
+// func is called from several threads at once, so it must only touch per-item state.
+void Run(const char* what, size_t count, const std::function<void(size_t)>& func);
+}
@@ -56,7 +56,14 @@ std::string Statistics::ToString()
 	str += StringFromFormat("dshaders alive: %i\n", stats.numDomainShadersAlive);
 	str += StringFromFormat("shaders changes: %i\n", stats.thisFrame.numShaderChanges);
 	str += StringFromFormat("dlists called: %i\n", stats.thisFrame.numDListsCalled);
+	str += StringFromFormat("dlists replayed: %i\n", stats.thisFrame.numDListsReplayed);
 	str += StringFromFormat("Primitive joins: %i\n", stats.thisFrame.numPrimitiveJoins);
+	if (stats.numRewindStates)
+	{
+		str += StringFromFormat("Rewind states: %i\n", stats.numRewindStates);
+		str += StringFromFormat("Rewind memory: %i KB\n", stats.rewindMemoryKB);
+		str += StringFromFormat("Rewind capture: %.2f ms\n", stats.rewindCaptureMs);
+	}
 	str += StringFromFormat("Draw calls: %i\n", stats.thisFrame.numDrawCalls);
 	str += StringFromFormat("Primitives: %i\n", stats.thisFrame.numPrims);
 	str += StringFromFormat("Primitives (DL): %i\n", stats.thisFrame.numDLPrims);
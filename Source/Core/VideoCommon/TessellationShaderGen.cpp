@@ -393,7 +393,7 @@ inline void GenerateTessellationShader(ShaderCode& out, const Tessellation_shade
 	if (codebuffer == nullptr)
 	{
 		codebuffer = text;
-		out.SetBuffer(codebuffer);
+		out.SetBuffer(codebuffer, sizeof(text));
 	}
 	codebuffer[sizeof(text) - 1] = 0x7C;  // canary
 	if (enablenormalmaps)
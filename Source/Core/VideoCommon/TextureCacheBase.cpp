@@ -17,6 +17,7 @@
 #include "Core/FifoPlayer/FifoRecorder.h"
 #include "Core/HW/Memmap.h"
 
+#include "VideoCommon/AsyncTextureScaler.h"
 #include "VideoCommon/Debugger.h"
 #include "VideoCommon/FramebufferManagerBase.h"
 #include "VideoCommon/HiresTextures.h"
@@ -36,6 +37,28 @@ std::unique_ptr<TextureCacheBase> g_texture_cache;
 TextureCacheBase::TCacheEntryBase::~TCacheEntryBase()
 {}
 
+// Identifies a texture and the scaling settings applied to it
+static u64 GetAsyncScalingKey(u64 hash, u32 format, u32 width, u32 height, u32 levels)
+{
+	const u64 params[] = {
+		hash, format, width, height, levels,
+		static_cast<u64>(g_ActiveConfig.iTexScalingType),
+		static_cast<u64>(g_ActiveConfig.iTexScalingFactor),
+		g_ActiveConfig.bTexDeposterize };
+	return GetHash64(reinterpret_cast<const u8*>(params), sizeof(params), 0);
+}
+
+// Uploads a level decoded to RGBA32 as the native resolution placeholder and keeps a copy for the scaler
+static void LoadAsyncScalingLevel(TextureCacheBase::TCacheEntryBase* entry, AsyncTextureScaler::Request* request,
+	const u8* decoded, u32 width, u32 height, u32 expanded_width, u32 level)
+{
+	entry->Load(decoded, width, height, expanded_width, level);
+	const u32* texels = reinterpret_cast<const u32*>(decoded);
+	AsyncTextureScaler::Level scaling_level = { width, height, expanded_width,
+		std::vector<u32>(texels, texels + expanded_width * height) };
+	request->levels.push_back(std::move(scaling_level));
+}
+
 void TextureCacheBase::CheckTempSize(size_t required_size)
 {
 	if (required_size <= temp_size)
@@ -53,10 +76,11 @@ TextureCacheBase::TextureCacheBase()
 	temp = static_cast<u8*>(Common::AllocateAlignedMemory(temp_size, 16));
 
 	TexDecoder_SetTexFmtOverlayOptions(backup_config.texfmt_overlay, backup_config.texfmt_overlay_center);
+	TexDecoder_SetParallelDecoding(g_ActiveConfig.bParallelTextureDecoding);
 
 	HiresTexture::Init();
 
-	SetHash64Function();
+	SetHash64Function(backup_config.xxhash3_hashing);
 	texture_pool_memory_usage = 0;
 	UnbindTextures();
 }
@@ -64,6 +88,8 @@ TextureCacheBase::TextureCacheBase()
 void TextureCacheBase::Invalidate()
 {
 	UnbindTextures();
+	if (async_scaler)
+		async_scaler->Clear();
 	auto iter = textures_by_address.begin();
 	auto end = textures_by_address.end();
 	while (iter != end)
@@ -100,8 +126,15 @@ void TextureCacheBase::OnConfigChanged(VideoConfig& config)
 		HiresTexture::Update();
 	}
 
+	if (config.bXXHash3TextureHashing != backup_config.xxhash3_hashing)
+		SetHash64Function(config.bXXHash3TextureHashing);
+
+	// Doesn't change the decoded data, so no need to invalidate
+	TexDecoder_SetParallelDecoding(config.bParallelTextureDecoding);
+
 	// TODO: Invalidating texcache is really stupid in some of these cases
 	if (config.iSafeTextureCache_ColorSamples != backup_config.colorsamples ||
+		config.bXXHash3TextureHashing != backup_config.xxhash3_hashing ||
 		config.bTexFmtOverlayEnable != backup_config.texfmt_overlay ||
 		config.bTexFmtOverlayCenter != backup_config.texfmt_overlay_center ||
 		config.bHiresTextures != backup_config.hires_textures ||
@@ -129,6 +162,7 @@ void TextureCacheBase::OnConfigChanged(VideoConfig& config)
 void TextureCacheBase::SetBackupConfig(const VideoConfig& config)
 {
 	backup_config.colorsamples = config.iSafeTextureCache_ColorSamples;
+	backup_config.xxhash3_hashing = config.bXXHash3TextureHashing;
 	backup_config.texfmt_overlay = config.bTexFmtOverlayEnable;
 	backup_config.texfmt_overlay_center = config.bTexFmtOverlayCenter;
 	backup_config.hires_textures = config.bHiresTextures;
@@ -142,6 +176,9 @@ void TextureCacheBase::SetBackupConfig(const VideoConfig& config)
 
 void TextureCacheBase::Cleanup(s32 _frameCount)
 {
+	if (async_scaler)
+		ApplyAsyncScaledTextures();
+
 	s32 texture_kill_threshold = TEXTURE_KILL_THRESHOLD;
 	if (texture_pool_memory_usage < (TEXTURE_POOL_MEMORY_LIMIT / 2))
 	{
@@ -452,6 +489,54 @@ void TextureCacheBase::DumpTexture(TCacheEntryBase* entry, std::string basename,
 		entry->Save(filename, level);
 }
 
+void TextureCacheBase::ApplyAsyncScaledTextures()
+{
+	std::vector<AsyncTextureScaler::Request> results;
+	if (!async_scaler->GetResults(&results))
+		return;
+
+	for (const AsyncTextureScaler::Request& result : results)
+	{
+		auto iter_range = textures_by_address.equal_range(result.address);
+		for (TexAddrCache::iterator iter = iter_range.first; iter != iter_range.second; ++iter)
+		{
+			// The entry may have been overwritten or reused for another texture in the meantime
+			TCacheEntryBase* entry = iter->second;
+			if (entry->async_scale_key != result.key)
+				continue;
+
+			TCacheEntryConfig config = entry->config;
+			config.width = result.levels[0].width;
+			config.height = result.levels[0].height;
+			TCacheEntryBase* scaled_entry = AllocateTexture(config);
+			for (u32 level = 0; level < result.levels.size(); ++level)
+			{
+				const AsyncTextureScaler::Level& scaled_level = result.levels[level];
+				scaled_entry->Load(reinterpret_cast<const u8*>(scaled_level.data.data()), scaled_level.width,
+					scaled_level.height, scaled_level.expanded_width, level);
+			}
+			scaled_entry->SetGeneralParameters(entry->addr, entry->size_in_bytes, entry->format);
+			scaled_entry->SetDimensions(entry->native_width, entry->native_height, entry->native_levels);
+			scaled_entry->SetHiresParams(false, entry->basename, true, false);
+			scaled_entry->SetHashes(entry->hash, entry->base_hash);
+			scaled_entry->frameCount = entry->frameCount;
+			scaled_entry->is_efb_copy = false;
+			if (entry->textures_by_hash_iter != textures_by_hash.end())
+			{
+				scaled_entry->textures_by_hash_iter = textures_by_hash.emplace(entry->hash, scaled_entry);
+			}
+			for (TCacheEntryBase*& bound : bound_textures)
+			{
+				if (bound == entry)
+					bound = scaled_entry;
+			}
+			iter->second = scaled_entry;
+			// Partial updates applied to the placeholder are redone on the next lookup, as the references are dropped here
+			DisposeTexture(entry);
+		}
+	}
+}
+
 // Used by TextureCacheBase::Load
 TextureCacheBase::TCacheEntryBase* TextureCacheBase::ReturnEntry(u32 stage, TCacheEntryBase* entry)
 {
@@ -746,25 +831,31 @@ TextureCacheBase::TCacheEntryBase* TextureCacheBase::Load(const u32 stage)
 	config.pcformat = pcfmt;
 	config.materialmap = hires_tex && hires_tex->m_nrm_levels && g_ActiveConfig.HiresMaterialMapsEnabled();
 	const bool use_scaling = (g_ActiveConfig.iTexScalingType > 0) && !hires_tex && (width < 384) && (height < 384);
+	// In async mode the texture is uploaded at native resolution and swapped once the scaled version is ready
+	const bool async_scaling = use_scaling && g_ActiveConfig.bTexScalingAsync;
 	if (use_scaling)
 	{
-		config.width *= g_ActiveConfig.iTexScalingFactor;
-		config.height *= g_ActiveConfig.iTexScalingFactor;
+		if (!async_scaling)
+		{
+			config.width *= g_ActiveConfig.iTexScalingFactor;
+			config.height *= g_ActiveConfig.iTexScalingFactor;
+		}
 		config.pcformat = PC_TEX_FMT_RGBA32;
 	}
 	TCacheEntryBase* entry = AllocateTexture(config);
 	GFX_DEBUGGER_PAUSE_AT(NEXT_NEW_TEXTURE, true);
 
 	iter = textures_by_address.emplace(address, entry);
-	if (g_ActiveConfig.iSafeTextureCache_ColorSamples == 0 ||
-		std::max(texture_size, palette_size) <= (u32)g_ActiveConfig.iSafeTextureCache_ColorSamples * 8)
+	const bool fully_hashed = g_ActiveConfig.iSafeTextureCache_ColorSamples == 0 ||
+		std::max(texture_size, palette_size) <= (u32)g_ActiveConfig.iSafeTextureCache_ColorSamples * 8;
+	if (fully_hashed)
 	{
 		entry->textures_by_hash_iter = textures_by_hash.emplace(full_hash, entry);
 	}
 
 	entry->SetGeneralParameters(address, texture_size, full_format);
 	entry->SetDimensions(nativeW, nativeH, tex_levels);
-	entry->SetHiresParams(!!hires_tex, basename, use_scaling, !!hires_tex && hires_tex->emissive_in_color);
+	entry->SetHiresParams(!!hires_tex, basename, use_scaling && !async_scaling, !!hires_tex && hires_tex->emissive_in_color);
 	entry->SetHashes(full_hash, tex_hash);
 	entry->is_efb_copy = false;
 
@@ -796,16 +887,45 @@ TextureCacheBase::TCacheEntryBase* TextureCacheBase::Load(const u32 stage)
 	}
 	else
 	{
+		AsyncTextureScaler::Request scaling_request;
+		if (async_scaling)
+		{
+			scaling_request.key = GetAsyncScalingKey(full_hash, full_format, nativeW, nativeH, texLevels);
+			scaling_request.address = address;
+			scaling_request.type = g_ActiveConfig.iTexScalingType;
+			scaling_request.factor = g_ActiveConfig.iTexScalingFactor;
+			scaling_request.deposterize = g_ActiveConfig.bTexDeposterize;
+			// Sampled hashes are too weak to identify a texture across runs
+			if (g_ActiveConfig.bTexScalingCache && fully_hashed)
+				scaling_request.cache_filename = AsyncTextureScaler::GetCacheFilename(scaling_request.key);
+		}
+
 		if (!(texformat == GX_TF_RGBA8 && from_tmem))
 		{
-			entry->Load(src_data, width, height, expandedWidth,
-				expandedHeight, texformat, tlutaddr, (TlutFormat)tlutfmt, 0);
+			if (async_scaling)
+			{
+				TexDecoder_Decode(temp, src_data, expandedWidth, expandedHeight, texformat, tlutaddr, (TlutFormat)tlutfmt, true);
+				LoadAsyncScalingLevel(entry, &scaling_request, temp, width, height, expandedWidth, 0);
+			}
+			else
+			{
+				entry->Load(src_data, width, height, expandedWidth,
+					expandedHeight, texformat, tlutaddr, (TlutFormat)tlutfmt, 0);
+			}
 		}
 		else
 		{
 			u8* src_data_gb = &texMem[bpmem.tex[stage / 4].texImage2[stage % 4].tmem_odd * TMEM_LINE_SIZE];
-			entry->LoadFromTmem(src_data, src_data_gb, width, height, expandedWidth,
-				expandedHeight, 0);
+			if (async_scaling)
+			{
+				TexDecoder_DecodeRGBA8FromTmem(reinterpret_cast<u32*>(temp), src_data, src_data_gb, expandedWidth, expandedHeight);
+				LoadAsyncScalingLevel(entry, &scaling_request, temp, width, height, expandedWidth, 0);
+			}
+			else
+			{
+				entry->LoadFromTmem(src_data, src_data_gb, width, height, expandedWidth,
+					expandedHeight, 0);
+			}
 		}
 		if (g_ActiveConfig.bDumpTextures)
 		{
@@ -831,13 +951,29 @@ TextureCacheBase::TCacheEntryBase* TextureCacheBase::Load(const u32 stage)
 			const u8*& mip_src_data = from_tmem
 				? ((level % 2) ? ptr_odd : ptr_even)
 				: src_data;
-			entry->Load(mip_src_data, mip_width, mip_height, expanded_mip_width,
-				expanded_mip_height, texformat, tlutaddr, (TlutFormat)tlutfmt, level);
+			if (async_scaling)
+			{
+				TexDecoder_Decode(temp, mip_src_data, expanded_mip_width, expanded_mip_height, texformat, tlutaddr, (TlutFormat)tlutfmt, true);
+				LoadAsyncScalingLevel(entry, &scaling_request, temp, mip_width, mip_height, expanded_mip_width, level);
+			}
+			else
+			{
+				entry->Load(mip_src_data, mip_width, mip_height, expanded_mip_width,
+					expanded_mip_height, texformat, tlutaddr, (TlutFormat)tlutfmt, level);
+			}
 			mip_src_data += TexDecoder_GetTextureSizeInBytes(expanded_mip_width, expanded_mip_height, texformat);
 
 			if (g_ActiveConfig.bDumpTextures)
 				DumpTexture(entry, basename, level);
 		}
+
+		if (async_scaling)
+		{
+			if (!async_scaler)
+				async_scaler = std::make_unique<AsyncTextureScaler>();
+			entry->async_scale_key = scaling_request.key;
+			async_scaler->Queue(std::move(scaling_request));
+		}
 	}
 
 	INCSTAT(stats.numTexturesCreated);
@@ -1355,6 +1491,7 @@ TextureCacheBase::TCacheEntryBase* TextureCacheBase::AllocateTexture(const TCach
 	}
 	entry->textures_by_hash_iter = textures_by_hash.end();
 	entry->may_have_overlapping_textures = true;
+	entry->async_scale_key = 0;
 	return entry;
 }
 
@@ -17,6 +17,7 @@
 #include "VideoCommon/VideoCommon.h"
 
 struct VideoConfig;
+class AsyncTextureScaler;
 
 enum TextureCacheParams
 {
@@ -119,6 +120,8 @@ public:
 		s32 frameCount = {};
 		u64 hash = {};
 		u64 base_hash = {};
+		// Set while a scaled version of this texture is being prepared by the AsyncTextureScaler
+		u64 async_scale_key = {};
 
 		// Keep an iterator to the entry in textures_by_hash, so it does not need to be searched when removing the cache entry
 		std::multimap<u64, TCacheEntryBase*>::iterator textures_by_hash_iter;
@@ -268,6 +271,8 @@ private:
 	TCacheEntryBase* DoPartialTextureUpdates(TCacheEntryBase* entry_to_update, u32 tlutaddr, u32 tlutfmt, u32 palette_size);
 	TextureCacheBase::TCacheEntryBase* ApplyPaletteToEntry(TCacheEntryBase* entry, u32 tlutaddr, u32 tlutfmt, u32 palette_size);
 	void DumpTexture(TCacheEntryBase* entry, std::string basename, u32 level);
+	// Swaps the textures that have been scaled in the background in place of their native resolution versions
+	void ApplyAsyncScaledTextures();
 
 	TexPool::iterator FindMatchingTextureFromPool(const TCacheEntryConfig& config);
 	TexAddrCache::iterator GetTexCacheIter(TCacheEntryBase* entry);
@@ -290,6 +295,7 @@ private:
 	struct BackupConfig
 	{
 		s32 colorsamples;
+		bool xxhash3_hashing;
 		bool texfmt_overlay;
 		bool texfmt_overlay_center;
 		bool hires_textures;
@@ -301,6 +307,9 @@ private:
 		bool scaling_deposterize;
 	};
 	BackupConfig backup_config = {};
+
+	// Created the first time a texture is scaled asynchronously
+	std::unique_ptr<AsyncTextureScaler> async_scaler;
 };
 
 extern std::unique_ptr<TextureCacheBase> g_texture_cache;
\ No newline at end of file
@@ -88,10 +88,14 @@ enum PC_TexFormat
 	PC_TEX_FMT_R32,
 };
 PC_TexFormat TexDecoder_Decode(u8 *dst, const u8 *src, u32 width, u32 height, u32 texformat, u32 tlutaddr, TlutFormat tlutfmt, bool rgbaOnly = false, bool compressed_supported = false);
+// Returns PC_TEX_FMT_NONE when the texture has to be decoded by the SSE2 code instead
+PC_TexFormat TexDecoder_Decode_RGBA_AVX2(u32* dst, const u8* src, u32 width, u32 height, u32 texformat, u32 tlutaddr, TlutFormat tlutfmt);
 PC_TexFormat GetPC_TexFormat(u32 texformat, TlutFormat tlutfmt, bool compressed_supported = false);
 PC_TexFormat TexDecoder_DecodeRGBA8FromTmem(u32* dst, const u8 *src_ar, const u8 *src_gb, u32 width, u32 height);
 PC_TexFormat TexDecoder_DecodeBGRA8FromTmem(u32* dst, const u8 *src_ar, const u8 *src_gb, u32 width, u32 height);
 void TexDecoder_DecodeTexel(u8 *dst, const u8 *src, u32 s, u32 t, u32 imageWidth, u32 texformat, const u16 *tlut, TlutFormat tlutfmt);
 void TexDecoder_DecodeTexelRGBA8FromTmem(u8 *dst, const u8 *src_ar, const u8* src_gb, u32 s, u32 t, u32 imageWidth);
 void TexDecoder_DecodeTexelBGRA8FromTmem(u8 *dst, const u8 *src_ar, const u8* src_gb, u32 s, u32 t, u32 imageWidth);
-void TexDecoder_SetTexFmtOverlayOptions(bool enable, bool center);
\ No newline at end of file
+void TexDecoder_SetTexFmtOverlayOptions(bool enable, bool center);
+// Decodes large textures in bands on the thread pool, with the same result as a serial decode
+void TexDecoder_SetParallelDecoding(bool enable);
@@ -20,6 +20,7 @@
 #include "Common/CommonTypes.h"
 #include "Common/MemoryUtil.h"
 
+#include <functional>
 #include <vector>
 
 class TextureScaler
@@ -29,6 +30,11 @@ public:
 	~TextureScaler();
 
 	u32* Scale(u32* data, int width, int height);
+	// Same as above, without looking at g_ActiveConfig, so it can be used off the GPU thread.
+	u32* Scale(u32* data, int width, int height, int type, int factor, bool deposterize);
+
+	// Limits the number of threads used for scaling, 0 uses the whole thread pool.
+	void SetMaxThreads(u32 max_threads) { m_max_threads = max_threads; }
 
 	enum
 	{
@@ -36,6 +42,10 @@ public:
 	};
 
 private:
+	// Smaller bands aren't worth waking up another thread for.
+	static const int MIN_ROWS_PER_BAND = 4;
+
+	void ParallelLoop(const std::function<void(int, int)>& func, int lower, int upper);
 
 	void ScaleXBRZ(int factor, u32* source, u32* dest, int width, int height);
 	void ScaleBilinear(int factor, u32* source, u32* dest, int width, int height);
@@ -57,4 +67,5 @@ private:
 	// maximum is (100 MB total for a 512 by 512 texture with scaling factor 5 and hybrid scaling)
 	// of course, scaling factor 5 is totally silly anyway
 	Common::SimpleBuf<u32> bufInput, bufDeposter, bufOutput, bufTmp1, bufTmp2, bufTmp3;
+	u32 m_max_threads = 0;
 };
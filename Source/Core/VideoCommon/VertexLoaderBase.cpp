@@ -111,6 +111,14 @@ u32 VertexLoaderUID::GetElement(u32 idx) const
 	return vid[idx];
 }
 
+void VertexLoaderUID::GetVertexFormat(const u32* elements, TVtxDesc* vtx_desc, VAT* vat)
+{
+	vtx_desc->Hex = (static_cast<u64>(elements[0]) << 1) | (elements[2] >> 31);
+	vat->g0.Hex = elements[1];
+	vat->g1.Hex = elements[2] & 0x7FFFFFFFu;
+	vat->g2.Hex = elements[3];
+}
+
 u64 VertexLoaderUID::CalculateHash()
 {
 	u64 h = -1;
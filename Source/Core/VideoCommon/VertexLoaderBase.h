@@ -35,6 +35,9 @@ public:
 	u64 GetHash() const;
 	size_t GetplatformHash() const;
 	u32 GetElement(u32 idx) const;
+	// Rebuilds a vertex description and attribute table with the given uid elements,
+	// the fractional bits, which aren't part of the uid, are left at zero.
+	static void GetVertexFormat(const u32* elements, TVtxDesc* vtx_desc, VAT* vat);
 private:
 	u64 CalculateHash();
 };
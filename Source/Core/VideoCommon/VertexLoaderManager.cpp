@@ -3,18 +3,29 @@
 // Refer to the license.txt file included.
 // Modified for Ishiiruka by Tino
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
 #include <unordered_map>
 
 
 #include "Core/ConfigManager.h"
 #include "Core/HW/Memmap.h"
 
+#include "Common/FileUtil.h"
+#include "Common/Logging/Log.h"
+#include "Common/Thread.h"
 #include "Common/ThreadPool.h"
 
+#include "VideoCommon/FrameProfiler.h"
 #include "VideoCommon/IndexGenerator.h"
 #include "VideoCommon/Statistics.h"
+#include "VideoCommon/VertexLoaderCompiled.h"
 #include "VideoCommon/VertexLoaderManager.h"
 #include "VideoCommon/VertexManagerBase.h"
 #include "VideoCommon/VideoConfig.h"
@@ -26,12 +37,40 @@ static std::string last_game_code;
 
 typedef std::unordered_map<VertexLoaderUID, std::unique_ptr<VertexLoaderBase>> VertexLoaderMap;
 
+static const u32 PROFILE_FILE_MAGIC = 0x504C5456; // "VTLP"
+static const u32 PROFILE_FILE_VERSION = 1;
+
+struct ProfileFileHeader
+{
+	u32 magic;
+	u32 version;
+	u32 entry_count;
+	u32 entry_size;
+};
+
+// A vertex format used by the game, and how many vertices were loaded with it
+struct ProfileEntry
+{
+	u32 uid[4];
+	u64 num_verts;
+};
+
 namespace VertexLoaderManager
 {
 static VertexLoaderMap s_vertex_loader_map;
 static NativeVertexFormatMap s_native_vertex_map;
 static NativeVertexFormat* s_current_vtx_fmt;
 u32 g_current_components;
+
+// The vertex formats of the game are kept on disk, so their loaders can be generated on a
+// background thread at boot instead of in the middle of the first frames using them.
+static std::string s_profile_filename;
+static std::vector<ProfileEntry> s_profile;
+static std::thread s_precompile_thread;
+static std::atomic<bool> s_precompile_abort;
+static std::mutex s_precompiled_mutex;
+static VertexLoaderMap s_precompiled_loaders;
+
 // TODO - change into array of pointers. Keep a map of all seen so far.
 // Used in D3D12 backend, to populate input layouts used by cached-to-disk PSOs.
 NativeVertexFormatMap* GetNativeVertexFormatMap()
@@ -183,20 +222,128 @@ void AppendListToString(std::string *dest)
 	}
 }
 
+static void PrecompileThread()
+{
+	Common::SetCurrentThreadName("Vertex Loader Precompiler");
+
+	File::IOFile file(s_profile_filename, "rb");
+	ProfileFileHeader header;
+	if (!file || !file.ReadArray(&header, 1) || header.magic != PROFILE_FILE_MAGIC ||
+		header.version != PROFILE_FILE_VERSION || header.entry_size != sizeof(ProfileEntry))
+	{
+		return;
+	}
+	std::vector<ProfileEntry> profile(header.entry_count);
+	if (!file.ReadArray(profile.data(), profile.size()))
+		return;
+	file.Close();
+
+	// Most used formats first, they are the likeliest to be needed right away
+	std::sort(profile.begin(), profile.end(), [](const ProfileEntry& a, const ProfileEntry& b) {
+		return a.num_verts > b.num_verts;
+	});
+	size_t count = 0;
+	for (const ProfileEntry& entry : profile)
+	{
+		if (s_precompile_abort.load())
+			break;
+		TVtxDesc vtx_desc;
+		VAT vtx_attr;
+		VertexLoaderUID::GetVertexFormat(entry.uid, &vtx_desc, &vtx_attr);
+		VertexLoaderUID uid(vtx_desc, vtx_attr);
+		// Skip anything that isn't a valid uid, the file might be damaged
+		bool valid = true;
+		for (u32 i = 0; i < 4; i++)
+			valid = valid && uid.GetElement(i) == entry.uid[i];
+		if (!valid)
+			continue;
+		std::unique_ptr<VertexLoaderBase> loader = VertexLoaderBase::CreateVertexLoader(vtx_desc, vtx_attr);
+		std::lock_guard<std::mutex> lk(s_precompiled_mutex);
+		s_precompiled_loaders.emplace(uid, std::move(loader));
+		count++;
+	}
+	INFO_LOG(VIDEO, "Precompiled %zu vertex loaders from %s", count, s_profile_filename.c_str());
+	s_profile = std::move(profile);
+}
+
+static std::unique_ptr<VertexLoaderBase> TakePrecompiledLoader(const VertexLoaderUID& uid)
+{
+	std::lock_guard<std::mutex> lk(s_precompiled_mutex);
+	auto iter = s_precompiled_loaders.find(uid);
+	if (iter == s_precompiled_loaders.end())
+		return nullptr;
+	std::unique_ptr<VertexLoaderBase> loader = std::move(iter->second);
+	s_precompiled_loaders.erase(iter);
+	return loader;
+}
+
+static void SaveProfile()
+{
+	// Formats that weren't used this time are kept for the next run
+	std::map<std::tuple<u32, u32, u32, u32>, u64> formats;
+	for (const ProfileEntry& entry : s_profile)
+		formats[std::make_tuple(entry.uid[0], entry.uid[1], entry.uid[2], entry.uid[3])] = entry.num_verts;
+	for (const auto& iter : s_vertex_loader_map)
+	{
+		const VertexLoaderUID& uid = iter.first;
+		u64 num_verts = iter.second->m_numLoadedVertices;
+		if (iter.second->GetFallback())
+			num_verts += iter.second->GetFallback()->m_numLoadedVertices;
+		formats[std::make_tuple(uid.GetElement(0), uid.GetElement(1), uid.GetElement(2),
+			uid.GetElement(3))] += num_verts;
+	}
+
+	std::vector<ProfileEntry> profile;
+	profile.reserve(formats.size());
+	for (const auto& format : formats)
+	{
+		ProfileEntry entry = { { std::get<0>(format.first), std::get<1>(format.first),
+			std::get<2>(format.first), std::get<3>(format.first) }, format.second };
+		profile.push_back(entry);
+	}
+
+	File::CreateFullPath(s_profile_filename);
+	File::IOFile file(s_profile_filename, "wb");
+	ProfileFileHeader header = { PROFILE_FILE_MAGIC, PROFILE_FILE_VERSION,
+		static_cast<u32>(profile.size()), sizeof(ProfileEntry) };
+	if (!file || !file.WriteArray(&header, 1) || !file.WriteArray(profile.data(), profile.size()))
+		ERROR_LOG(VIDEO, "Failed to write the vertex loader profile %s", s_profile_filename.c_str());
+}
+
 void Init()
 {
 	MarkAllDirty();
 	for (VertexLoaderBase*& vertexLoader : g_main_cp_state.vertex_loaders)
 		vertexLoader = nullptr;
 	last_game_code = SConfig::GetInstance().m_strGameID;
+
+	s_profile_filename.clear();
+	if (g_ActiveConfig.bCompileVertexLoadersOnStartup && !last_game_code.empty())
+	{
+		s_profile_filename = StringFromFormat("%sVertexLoaders/%s.vlp",
+			File::GetUserPath(D_CACHE_IDX).c_str(), last_game_code.c_str());
+		// The lookup tables of the loaders are set up here, not by the background thread
+		VertexLoaderCompiled::Initialize();
+		s_precompile_abort.store(false);
+		s_precompile_thread = std::thread(PrecompileThread);
+	}
 }
 
 void Shutdown()
 {
+	if (s_precompile_thread.joinable())
+	{
+		s_precompile_abort.store(true);
+		s_precompile_thread.join();
+	}
+	if (!s_profile_filename.empty())
+		SaveProfile();
 	if (s_vertex_loader_map.size() > 0 && g_ActiveConfig.bDumpVertexLoaders)
 		DumpLoadersCode();
 	s_vertex_loader_map.clear();
 	s_native_vertex_map.clear();
+	s_precompiled_loaders.clear();
+	s_profile.clear();
 }
 
 void UpdateVertexArrayPointers()
@@ -245,8 +392,11 @@ inline VertexLoaderBase *GetOrAddLoader(const TVtxDesc &VtxDesc, const VAT &VtxA
 	VertexLoaderMap::iterator iter = s_vertex_loader_map.find(uid);
 	if (iter == s_vertex_loader_map.end())
 	{
-		s_vertex_loader_map[uid] = VertexLoaderBase::CreateVertexLoader(VtxDesc, VtxAttr);
-		VertexLoaderBase* loader = s_vertex_loader_map[uid].get();
+		std::unique_ptr<VertexLoaderBase> new_loader = TakePrecompiledLoader(uid);
+		if (!new_loader)
+			new_loader = VertexLoaderBase::CreateVertexLoader(VtxDesc, VtxAttr);
+		VertexLoaderBase* loader = new_loader.get();
+		s_vertex_loader_map[uid] = std::move(new_loader);
 		loader->m_native_vertex_format = GetNativeVertexFormat(loader->m_native_vtx_decl);
 		VertexLoaderBase * fallback = loader->GetFallback();
 		if (fallback)
@@ -305,7 +455,11 @@ bool ConvertVertices(VertexLoaderParameters &parameters, u32 &readsize, u32 &wri
 	g_current_components = loader->m_native_components;
 	VertexManagerBase::PrepareForAdditionalData(parameters.primitive, parameters.count, loader->m_native_stride);
 	parameters.destination = VertexManagerBase::s_pCurBufferPointer;
-	s32 finalcount = loader->RunVertices(parameters);
+	s32 finalcount;
+	{
+		FrameProfiler::ScopedSection section(FrameProfiler::SECTION_VERTEX_LOADER);
+		finalcount = loader->RunVertices(parameters);
+	}
 	writesize = loader->m_native_stride * finalcount;
 	IndexGenerator::AddIndices(parameters.primitive, finalcount);
 	ADDSTAT(stats.thisFrame.numPrims, finalcount);
@@ -313,6 +467,24 @@ bool ConvertVertices(VertexLoaderParameters &parameters, u32 &readsize, u32 &wri
 	return true;
 }
 
+void AddConvertedVertices(NativeVertexFormat* nativefmt, u32 components, int primitive, u32 count, const u8* data)
+{
+	if (s_current_vtx_fmt != nullptr && s_current_vtx_fmt != nativefmt)
+	{
+		VertexManagerBase::Flush();
+	}
+	s_current_vtx_fmt = nativefmt;
+	g_current_components = components;
+	const u32 stride = nativefmt->GetVertexStride();
+	VertexManagerBase::PrepareForAdditionalData(primitive, count, stride);
+	const u32 size = count * stride;
+	memcpy(VertexManagerBase::s_pCurBufferPointer, data, size);
+	VertexManagerBase::s_pCurBufferPointer += size;
+	IndexGenerator::AddIndices(primitive, count);
+	ADDSTAT(stats.thisFrame.numPrims, count);
+	INCSTAT(stats.thisFrame.numPrimitiveJoins);
+}
+
 int GetVertexSize(const VertexLoaderParameters &parameters)
 {
 	if (parameters.needloaderrefresh)
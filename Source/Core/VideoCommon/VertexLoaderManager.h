@@ -3,6 +3,8 @@
 // Refer to the license.txt file included.
 // Modified for Ishiiruka by Tino
 #pragma once
+#include <map>
+#include <memory>
 #include <string>
 #include "Common/Common.h"
 #include "VideoCommon/NativeVertexFormat.h"
@@ -23,6 +25,9 @@ int GetVertexSize(const VertexLoaderParameters &parameters);
 
 bool ConvertVertices(VertexLoaderParameters &parameters, u32 &readsize, u32 &writesize);
 
+// Appends vertices that were already converted to nativefmt, used by the display list cache.
+void AddConvertedVertices(NativeVertexFormat* nativefmt, u32 components, int primitive, u32 count, const u8* data);
+
 void GetVertexSizeAndComponents(const VertexLoaderParameters &parameters, u32 &vertexsize, u32 &components);
 
 // For debugging
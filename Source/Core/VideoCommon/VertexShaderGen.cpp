@@ -94,7 +94,7 @@ inline void GenerateVertexShader(ShaderCode& out, const vertex_shader_uid_data&
 	if (buffer == nullptr)
 	{
 		buffer = text;
-		out.SetBuffer(text);
+		out.SetBuffer(text, sizeof(text));
 	}
 	const u32 components = uid_data.components;
 	bool lightingEnabled = uid_data.numColorChans > 0;
@@ -51,6 +51,8 @@ VideoConfig::VideoConfig()
 	bTexDeposterize = false;
 	iTexScalingType = 0;
 	iTexScalingFactor = 2;
+	bTexScalingAsync = false;
+	bTexScalingCache = false;
 	backend_info.bSupportsMultithreading = false;
 	backend_info.bSupportsInternalResolutionFrameDumps = false;
 	bEnableValidationLayer = false;
@@ -73,6 +75,8 @@ void VideoConfig::Load(const std::string& ini_file)
 	settings->Get("UseXFB", &bUseXFB, 0);
 	settings->Get("UseRealXFB", &bUseRealXFB, 0);
 	settings->Get("SafeTextureCacheColorSamples", &iSafeTextureCache_ColorSamples, 128);
+	settings->Get("XXHash3TextureHashing", &bXXHash3TextureHashing, false);
+	settings->Get("ParallelTextureDecoding", &bParallelTextureDecoding, true);
 	settings->Get("ShowFPS", &bShowFPS, false);
 	settings->Get("ShowNetPlayPing", &bShowNetPlayPing, false);
 	settings->Get("ShowNetPlayMessages", &bShowNetPlayMessages, false);
@@ -91,6 +95,7 @@ void VideoConfig::Load(const std::string& ini_file)
 	settings->Get("DumpFramesAsImages", &bDumpFramesAsImages, 0);
 	settings->Get("FreeLook", &bFreeLook, 0);
 	settings->Get("CompileShaderOnStartup", &bCompileShaderOnStartup, 1);
+	settings->Get("CompileVertexLoadersOnStartup", &bCompileVertexLoadersOnStartup, 1);
 	settings->Get("UseFFV1", &bUseFFV1, 0);
 	settings->Get("InternalResolutionFrameDumps", &bInternalResolutionFrameDumps, 0);
 	settings->Get("EnablePixelLighting", &bEnablePixelLighting, 0);
@@ -142,6 +147,8 @@ void VideoConfig::Load(const std::string& ini_file)
 	enhancements->Get("TextureScalingType", &iTexScalingType, 0);
 	enhancements->Get("TextureScalingFactor", &iTexScalingFactor, 2);
 	enhancements->Get("UseDePosterize", &bTexDeposterize, true);
+	enhancements->Get("TextureScalingAsync", &bTexScalingAsync, false);
+	enhancements->Get("TextureScalingCache", &bTexScalingCache, false);
 	enhancements->Get("Tessellation", &bTessellation, 0);
 	enhancements->Get("TessellationEarlyCulling", &bTessellationEarlyCulling, 0);
 	enhancements->Get("TessellationDistance", &iTessellationDistance, 0);
@@ -170,6 +177,7 @@ void VideoConfig::Load(const std::string& ini_file)
 	hacks->Get("EnableComputeTextureDecoding", &bEnableComputeTextureDecoding, false);
 	hacks->Get("EnableComputeTextureEncoding", &bEnableComputeTextureEncoding, false);
 	hacks->Get("PredictiveFifo", &bPredictiveFifo, false);
+	hacks->Get("DlistCachingEnable", &bDlistCachingEnable, false);
 	hacks->Get("BoundingBoxMode", &iBBoxMode, (int)BBoxMode::BBoxNone);
 	hacks->Get("LastStoryEFBToRam", &bLastStoryEFBToRam, false);
 	hacks->Get("ForceLogicOpBlend", &bForceLogicOpBlend, false);
@@ -223,6 +231,8 @@ void VideoConfig::GameIniLoad()
 	CHECK_SETTING("Video_Settings", "UseXFB", bUseXFB);
 	CHECK_SETTING("Video_Settings", "UseRealXFB", bUseRealXFB);
 	CHECK_SETTING("Video_Settings", "SafeTextureCacheColorSamples", iSafeTextureCache_ColorSamples);
+	CHECK_SETTING("Video_Settings", "XXHash3TextureHashing", bXXHash3TextureHashing);
+	CHECK_SETTING("Video_Settings", "ParallelTextureDecoding", bParallelTextureDecoding);
 	CHECK_SETTING("Video_Settings", "HiresTextures", bHiresTextures);
 	CHECK_SETTING("Video_Settings", "HiresMaterialMaps", bHiresMaterialMaps);
 
@@ -288,6 +298,8 @@ void VideoConfig::GameIniLoad()
 	CHECK_SETTING("Video_Enhancements", "TextureScalingType", iTexScalingType);
 	CHECK_SETTING("Video_Enhancements", "TextureScalingFactor", iTexScalingFactor);
 	CHECK_SETTING("Video_Enhancements", "UseDePosterize", bTexDeposterize);
+	CHECK_SETTING("Video_Enhancements", "TextureScalingAsync", bTexScalingAsync);
+	CHECK_SETTING("Video_Enhancements", "TextureScalingCache", bTexScalingCache);
 	CHECK_SETTING("Video_Enhancements", "Tessellation", bTessellation);
 	CHECK_SETTING("Video_Enhancements", "TessellationEarlyCulling", bTessellationEarlyCulling);
 	CHECK_SETTING("Video_Enhancements", "TessellationDistance", iTessellationDistance);
@@ -313,6 +325,7 @@ void VideoConfig::GameIniLoad()
 	CHECK_SETTING("Video_Hacks", "EFBEmulateFormatChanges", bEFBEmulateFormatChanges);
 	CHECK_SETTING("Video_Hacks", "BoundingBoxMode", iBBoxMode);
 	CHECK_SETTING("Video_Hacks", "LastStoryEFBToRam", bLastStoryEFBToRam);
+	CHECK_SETTING("Video_Hacks", "DlistCachingEnable", bDlistCachingEnable);
 
 
 	CHECK_SETTING("Video", "ProjectionHack", iPhackvalue[0]);
@@ -414,6 +427,8 @@ void VideoConfig::Save(const std::string& ini_file)
 	settings->Set("UseXFB", bUseXFB);
 	settings->Set("UseRealXFB", bUseRealXFB);
 	settings->Set("SafeTextureCacheColorSamples", iSafeTextureCache_ColorSamples);
+	settings->Set("XXHash3TextureHashing", bXXHash3TextureHashing);
+	settings->Set("ParallelTextureDecoding", bParallelTextureDecoding);
 	settings->Set("ShowFPS", bShowFPS);
 	settings->Set("ShowNetPlayPing", bShowNetPlayPing);
 	settings->Set("ShowNetPlayMessages", bShowNetPlayMessages);
@@ -433,6 +448,7 @@ void VideoConfig::Save(const std::string& ini_file)
 	settings->Set("FreeLook", bFreeLook);
 	settings->Set("InternalResolutionFrameDumps", bInternalResolutionFrameDumps);
 	settings->Set("CompileShaderOnStartup", bCompileShaderOnStartup);
+	settings->Set("CompileVertexLoadersOnStartup", bCompileVertexLoadersOnStartup);
 	settings->Set("UseFFV1", bUseFFV1);
 	settings->Set("EnablePixelLighting", bEnablePixelLighting);
 	settings->Set("ForcedLighting", bForcedLighting);
@@ -484,6 +500,8 @@ void VideoConfig::Save(const std::string& ini_file)
 	enhancements->Set("TextureScalingType", iTexScalingType);
 	enhancements->Set("TextureScalingFactor", iTexScalingFactor);
 	enhancements->Set("UseDePosterize", bTexDeposterize);
+	enhancements->Set("TextureScalingAsync", bTexScalingAsync);
+	enhancements->Set("TextureScalingCache", bTexScalingCache);
 	enhancements->Set("Tessellation", bTessellation);
 	enhancements->Set("TessellationEarlyCulling", bTessellationEarlyCulling);
 	enhancements->Set("TessellationDistance", iTessellationDistance);
@@ -512,6 +530,7 @@ void VideoConfig::Save(const std::string& ini_file)
 	hacks->Set("EnableComputeTextureDecoding", bEnableComputeTextureDecoding);
 	hacks->Set("EnableComputeTextureEncoding", bEnableComputeTextureEncoding);
 	hacks->Set("PredictiveFifo", bPredictiveFifo);
+	hacks->Set("DlistCachingEnable", bDlistCachingEnable);
 	hacks->Set("BoundingBoxMode", iBBoxMode);
 	hacks->Set("LastStoryEFBToRam", bLastStoryEFBToRam);
 	hacks->Set("ForceLogicOpBlend", bForceLogicOpBlend);
@@ -113,6 +113,8 @@ struct VideoConfig final
 	bool bTexDeposterize;
 	int iTexScalingType;
 	int iTexScalingFactor;
+	bool bTexScalingAsync;
+	bool bTexScalingCache;
 	bool bTessellation;
 	bool bTessellationEarlyCulling;
 	int iTessellationDistance;
@@ -152,6 +154,7 @@ struct VideoConfig final
 	bool bFreeLook;
 	bool bBorderlessFullscreen;
 	bool bCompileShaderOnStartup;
+	bool bCompileVertexLoadersOnStartup;
 
 	// Hacks
 	bool bEFBAccessEnable;
@@ -160,6 +163,7 @@ struct VideoConfig final
 	bool bPerfQueriesEnable;
 	bool bFullAsyncShaderCompilation;
 	bool bPredictiveFifo;
+	bool bDlistCachingEnable;
 	bool bWaitForShaderCompilation;
 	bool bEnableComputeTextureDecoding;
 	bool bEnableComputeTextureEncoding;
@@ -167,6 +171,8 @@ struct VideoConfig final
 	bool bSkipEFBCopyToRam;
 	bool bCopyEFBScaled;
 	int iSafeTextureCache_ColorSamples;
+	bool bXXHash3TextureHashing;
+	bool bParallelTextureDecoding;
 	int iPhackvalue[4];
 	std::string sPhackvalue[2];
 	float fAspectRatioHackW, fAspectRatioHackH;
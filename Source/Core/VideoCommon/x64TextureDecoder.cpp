@@ -2,6 +2,7 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cmath>
 
 #include "Common/Common.h"
@@ -9,7 +10,9 @@
 
 #include "Common/CPUDetect.h"
 #include "Common/Intrinsics.h"
+#include "Common/ThreadPool.h"
 
+#include "VideoCommon/FrameProfiler.h"
 #include "VideoCommon/TextureDecoder.h"
 #ifdef _WIN32
 #include "OpenCL.h"
@@ -18,6 +21,7 @@
 #include "VideoCommon/VideoConfig.h"
 
 #include "VideoCommon/LookUpTables.h"
+#include "VideoCommon/TextureUtil.h"
 
 
 
@@ -29,6 +33,7 @@
 
 bool TexFmt_Overlay_Enable = false;
 bool TexFmt_Overlay_Center = false;
+static bool s_parallel_decoding = false;
 
 extern const char* texfmt[];
 extern const unsigned char sfont_map[];
@@ -1067,6 +1072,13 @@ static PC_TexFormat TexDecoder_Decode_real(u8 *dst, const u8 *src, u32 width, u3
 
 static PC_TexFormat TexDecoder_Decode_RGBA(u32 * dst, const u8 * src, u32 width, u32 height, u32 texformat, u32 tlutaddr, TlutFormat tlutfmt)
 {
+	if (cpu_info.bAVX2)
+	{
+		PC_TexFormat retval = TexDecoder_Decode_RGBA_AVX2(dst, src, width, height, texformat, tlutaddr, tlutfmt);
+		if (retval != PC_TEX_FMT_NONE)
+			return retval;
+	}
+
 	const u32 Wsteps4 = (width + 3) / 4;
 	const u32 Wsteps8 = (width + 7) / 8;
 
@@ -2119,8 +2131,48 @@ void TexDecoder_SetTexFmtOverlayOptions(bool enable, bool center)
 	TexFmt_Overlay_Center = center;
 }
 
+void TexDecoder_SetParallelDecoding(bool enable)
+{
+	s_parallel_decoding = enable;
+}
+
+// Textures with at least this many texels are split into bands of block rows,
+// each band being big enough to be worth a pool task
+static const u32 PARALLEL_DECODE_MIN_TEXELS = 256 * 256;
+static const u32 PARALLEL_DECODE_BAND_TEXELS = 32 * 1024;
+
+static PC_TexFormat TexDecoder_Decode_CPU(u8 *dst, const u8 *src, u32 width, u32 height, u32 texformat, u32 tlutaddr, TlutFormat tlutfmt, bool rgbaOnly, bool compressed_supported)
+{
+	if (rgbaOnly)
+		return TexDecoder_Decode_RGBA((u32*)dst, src, width, height, texformat, tlutaddr, tlutfmt);
+	return TexDecoder_Decode_real(dst, src, width, height, texformat, tlutaddr, tlutfmt, compressed_supported);
+}
+
+static PC_TexFormat TexDecoder_Decode_Parallel(u8 *dst, const u8 *src, u32 width, u32 height, u32 texformat, u32 tlutaddr, TlutFormat tlutfmt, bool rgbaOnly, bool compressed_supported)
+{
+	const u32 block_height = TexDecoder_GetBlockHeightInTexels(texformat);
+	const PC_TexFormat native_format = GetPC_TexFormat(texformat, tlutfmt, compressed_supported);
+	if (width * height < PARALLEL_DECODE_MIN_TEXELS || native_format == PC_TEX_FMT_NONE ||
+		width % TexDecoder_GetBlockWidthInTexels(texformat) != 0 || height % block_height != 0)
+		return TexDecoder_Decode_CPU(dst, src, width, height, texformat, tlutaddr, tlutfmt, rgbaOnly, compressed_supported);
+
+	// Every block row starts at a fixed offset in both the source and the decoded texture,
+	// so the bands can be decoded independently straight into dst
+	const s32 block_rows = height / block_height;
+	const s32 rows_per_band = std::max<s32>(1, PARALLEL_DECODE_BAND_TEXELS / (width * block_height));
+	const PC_TexFormat pcfmt = rgbaOnly ? PC_TEX_FMT_RGBA32 : native_format;
+	Common::ThreadPool::ParallelFor(0, block_rows, rows_per_band, [&](s32 begin, s32 end) {
+		const u32 y = begin * block_height;
+		TexDecoder_Decode_CPU(dst + TextureUtil::GetTextureSizeInBytes(width, y, pcfmt),
+			src + TexDecoder_GetTextureSizeInBytes(width, y, texformat), width, (end - begin) * block_height,
+			texformat, tlutaddr, tlutfmt, rgbaOnly, compressed_supported);
+	});
+	return pcfmt;
+}
+
 PC_TexFormat TexDecoder_Decode(u8 *dst, const u8 *src, u32 width, u32 height, u32 texformat, u32 tlutaddr, TlutFormat tlutfmt, bool rgbaOnly, bool compressed_supported)
 {
+	FrameProfiler::ScopedSection section(FrameProfiler::SECTION_TEXTURE_DECODE);
 	PC_TexFormat retval = PC_TEX_FMT_NONE;
 #ifdef _WIN32
 	retval = TexDecoder_Decode_OpenCL(dst, src,
@@ -2129,13 +2181,13 @@ PC_TexFormat TexDecoder_Decode(u8 *dst, const u8 *src, u32 width, u32 height, u3
 	if (retval == PC_TEX_FMT_NONE)
 	{
 #endif
-		if (rgbaOnly)
+		if (s_parallel_decoding)
 		{
-			retval = TexDecoder_Decode_RGBA((u32*)dst, src, width, height, texformat, tlutaddr, tlutfmt);
+			retval = TexDecoder_Decode_Parallel(dst, src, width, height, texformat, tlutaddr, tlutfmt, rgbaOnly, compressed_supported);
 		}
 		else
 		{
-			retval = TexDecoder_Decode_real(dst, src, width, height, texformat, tlutaddr, tlutfmt, compressed_supported);
+			retval = TexDecoder_Decode_CPU(dst, src, width, height, texformat, tlutaddr, tlutfmt, rgbaOnly, compressed_supported);
 		}
 #ifdef _WIN32
 	}
@@ -0,0 +1,359 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Intrinsics.h"
+
+#include "VideoCommon/LookUpTables.h"
+#include "VideoCommon/TextureDecoder.h"
+
+// AVX2 versions of the RGBA32 decoders in x64TextureDecoder.cpp. They must produce exactly the
+// same output as the SSE2/SSSE3 code there, including its quirks.
+// All of them expect the width to be a multiple of the block width, like the texture cache's
+// expanded sizes are.
+
+namespace
+{
+// Loads 8 big endian 16 bit values into 32 bit lanes, the first four in the low 128 bits
+FUNCTION_TARGET_AVX2 inline __m256i LoadBE16x8(const u8* src)
+{
+	const __m128i swap16 = _mm_set_epi8(14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1);
+	return _mm256_cvtepu16_epi32(_mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)src), swap16));
+}
+
+// 4 texel wide formats decode two rows per vector, one in each 128 bit half
+FUNCTION_TARGET_AVX2 inline void StoreRows(u32* dst, u32 width, __m256i rows)
+{
+	_mm_storeu_si128((__m128i*)dst, _mm256_castsi256_si128(rows));
+	_mm_storeu_si128((__m128i*)(dst + width), _mm256_extracti128_si256(rows, 1));
+}
+
+FUNCTION_TARGET_AVX2 inline __m256i DecodeIA8(__m256i val)
+{
+	const __m256i i = _mm256_and_si256(val, _mm256_set1_epi32(0xFF));
+	const __m256i a = _mm256_slli_epi32(_mm256_srli_epi32(val, 8), 24);
+	return _mm256_or_si256(_mm256_mullo_epi32(i, _mm256_set1_epi32(0x010101)), a);
+}
+
+FUNCTION_TARGET_AVX2 inline __m256i DecodeRGB565(__m256i val)
+{
+	const __m256i r = _mm256_srli_epi32(val, 11);
+	const __m256i g = _mm256_and_si256(_mm256_srli_epi32(val, 5), _mm256_set1_epi32(0x3F));
+	const __m256i b = _mm256_and_si256(val, _mm256_set1_epi32(0x1F));
+
+	const __m256i r8 = _mm256_or_si256(_mm256_slli_epi32(r, 3), _mm256_srli_epi32(r, 2));
+	const __m256i g8 = _mm256_or_si256(_mm256_slli_epi32(g, 2), _mm256_srli_epi32(g, 4));
+	const __m256i b8 = _mm256_or_si256(_mm256_slli_epi32(b, 3), _mm256_srli_epi32(b, 2));
+	return _mm256_or_si256(_mm256_or_si256(r8, _mm256_slli_epi32(g8, 8)),
+		_mm256_or_si256(_mm256_slli_epi32(b8, 16), _mm256_set1_epi32(0xFF000000)));
+}
+
+FUNCTION_TARGET_AVX2 inline __m256i DecodeRGB5A3(__m256i val)
+{
+	const __m256i mask5 = _mm256_set1_epi32(0x1F);
+	const __m256i mask4 = _mm256_set1_epi32(0x0F);
+
+	// RGB555 with full alpha
+	const __m256i r5 = _mm256_and_si256(_mm256_srli_epi32(val, 10), mask5);
+	const __m256i g5 = _mm256_and_si256(_mm256_srli_epi32(val, 5), mask5);
+	const __m256i b5 = _mm256_and_si256(val, mask5);
+	const __m256i opaque = _mm256_or_si256(
+		_mm256_or_si256(_mm256_or_si256(_mm256_slli_epi32(r5, 3), _mm256_srli_epi32(r5, 2)),
+			_mm256_slli_epi32(_mm256_or_si256(_mm256_slli_epi32(g5, 3), _mm256_srli_epi32(g5, 2)), 8)),
+		_mm256_or_si256(_mm256_slli_epi32(_mm256_or_si256(_mm256_slli_epi32(b5, 3), _mm256_srli_epi32(b5, 2)), 16),
+			_mm256_set1_epi32(0xFF000000)));
+
+	// RGB4A3
+	const __m256i a3 = _mm256_and_si256(_mm256_srli_epi32(val, 12), _mm256_set1_epi32(0x07));
+	const __m256i a8 = _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi32(a3, 5), _mm256_slli_epi32(a3, 2)),
+		_mm256_srli_epi32(a3, 1));
+	const __m256i rgb4 = _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(val, 8), mask4),
+		_mm256_slli_epi32(_mm256_and_si256(_mm256_srli_epi32(val, 4), mask4), 8)),
+		_mm256_slli_epi32(_mm256_and_si256(val, mask4), 16));
+	const __m256i translucent = _mm256_or_si256(_mm256_mullo_epi32(rgb4, _mm256_set1_epi32(0x11)),
+		_mm256_slli_epi32(a8, 24));
+
+	const __m256i is_opaque = _mm256_cmpgt_epi32(val, _mm256_set1_epi32(0x7FFF));
+	return _mm256_blendv_epi8(translucent, opaque, is_opaque);
+}
+
+// Converts the TLUT at tlutaddr to RGBA32, like the C4/C8/C14X2 decoders of the RGBA path do
+FUNCTION_TARGET_AVX2 void DecodePalette(u32* palette, u32 tlutaddr, u32 entries, TlutFormat tlutfmt)
+{
+	const u8* tlut = texMem + tlutaddr;
+	for (u32 i = 0; i < entries; i += 8)
+	{
+		const __m256i val = LoadBE16x8(tlut + 2 * i);
+		__m256i colors;
+		if (tlutfmt == GX_TL_IA8)
+			colors = DecodeIA8(val);
+		else if (tlutfmt == GX_TL_RGB565)
+			colors = DecodeRGB565(val);
+		else
+			colors = DecodeRGB5A3(val);
+		_mm256_storeu_si256((__m256i*)(palette + i), colors);
+	}
+}
+
+// Nibble positions of the 8 texels in a little endian load of 4 bytes, high nibble first
+FUNCTION_TARGET_AVX2 inline __m256i NibbleShifts()
+{
+	return _mm256_setr_epi32(4, 0, 12, 8, 20, 16, 28, 24);
+}
+
+FUNCTION_TARGET_AVX2 inline __m256i LoadNibbles(const u8* src)
+{
+	u32 val;
+	std::memcpy(&val, src, sizeof(u32));
+	return _mm256_and_si256(_mm256_srlv_epi32(_mm256_set1_epi32(val), NibbleShifts()), _mm256_set1_epi32(0xF));
+}
+
+FUNCTION_TARGET_AVX2 void DecodeI4(u32* dst, const u8* src, u32 width, u32 height)
+{
+	const __m256i replicate = _mm256_set1_epi32(0x11111111);
+	for (u32 y = 0; y < height; y += 8)
+		for (u32 x = 0; x < width; x += 8, src += 32)
+			for (u32 iy = 0; iy < 8; iy++)
+				_mm256_storeu_si256((__m256i*)(dst + (y + iy) * width + x),
+					_mm256_mullo_epi32(LoadNibbles(src + 4 * iy), replicate));
+}
+
+FUNCTION_TARGET_AVX2 void DecodeI8(u32* dst, const u8* src, u32 width, u32 height)
+{
+	const __m256i mask = _mm256_setr_epi8(0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+		4, 4, 4, 4, 5, 5, 5, 5, 6, 6, 6, 6, 7, 7, 7, 7);
+	for (u32 y = 0; y < height; y += 4)
+		for (u32 x = 0; x < width; x += 8, src += 32)
+			for (u32 iy = 0; iy < 4; iy++)
+			{
+				s64 row;
+				std::memcpy(&row, src + 8 * iy, sizeof(s64));
+				_mm256_storeu_si256((__m256i*)(dst + (y + iy) * width + x),
+					_mm256_shuffle_epi8(_mm256_set1_epi64x(row), mask));
+			}
+}
+
+FUNCTION_TARGET_AVX2 void DecodeIA4(u32* dst, const u8* src, u32 width, u32 height)
+{
+	const __m256i mask4 = _mm256_set1_epi32(0xF);
+	const __m256i replicate_i = _mm256_set1_epi32(0x00111111);
+	const __m256i replicate_a = _mm256_set1_epi32(0x11000000);
+	for (u32 y = 0; y < height; y += 4)
+		for (u32 x = 0; x < width; x += 8, src += 32)
+			for (u32 iy = 0; iy < 4; iy++)
+			{
+				const __m256i val = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(src + 8 * iy)));
+				const __m256i i = _mm256_mullo_epi32(_mm256_and_si256(val, mask4), replicate_i);
+				const __m256i a = _mm256_mullo_epi32(_mm256_srli_epi32(val, 4), replicate_a);
+				_mm256_storeu_si256((__m256i*)(dst + (y + iy) * width + x), _mm256_or_si256(i, a));
+			}
+}
+
+// Decodes the 4x4 blocks of a 16 bit format, two rows at a time
+template <__m256i (*Decode)(__m256i)>
+FUNCTION_TARGET_AVX2 void Decode16BitBlocks(u32* dst, const u8* src, u32 width, u32 height)
+{
+	for (u32 y = 0; y < height; y += 4)
+		for (u32 x = 0; x < width; x += 4, src += 32)
+		{
+			StoreRows(dst + y * width + x, width, Decode(LoadBE16x8(src)));
+			StoreRows(dst + (y + 2) * width + x, width, Decode(LoadBE16x8(src + 16)));
+		}
+}
+
+FUNCTION_TARGET_AVX2 void DecodeRGBA8(u32* dst, const u8* src, u32 width, u32 height)
+{
+	// AGRB -> RGBA
+	const __m256i mask = _mm256_setr_epi8(2, 1, 3, 0, 6, 5, 7, 4, 10, 9, 11, 8, 14, 13, 15, 12,
+		2, 1, 3, 0, 6, 5, 7, 4, 10, 9, 11, 8, 14, 13, 15, 12);
+	for (u32 y = 0; y < height; y += 4)
+		for (u32 x = 0; x < width; x += 4, src += 64)
+		{
+			for (u32 iy = 0; iy < 4; iy += 2)
+			{
+				const __m256i ar = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(src + 8 * iy)));
+				const __m256i gb = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(src + 32 + 8 * iy)));
+				const __m256i agrb = _mm256_or_si256(ar, _mm256_slli_epi16(gb, 8));
+				StoreRows(dst + (y + iy) * width + x, width, _mm256_shuffle_epi8(agrb, mask));
+			}
+		}
+}
+
+FUNCTION_TARGET_AVX2 void DecodeC4(u32* dst, const u8* src, u32 width, u32 height, const u32* palette)
+{
+	const __m256i low = _mm256_loadu_si256((const __m256i*)palette);
+	const __m256i high = _mm256_loadu_si256((const __m256i*)(palette + 8));
+	const __m256i seven = _mm256_set1_epi32(7);
+	for (u32 y = 0; y < height; y += 8)
+		for (u32 x = 0; x < width; x += 8, src += 32)
+			for (u32 iy = 0; iy < 8; iy++)
+			{
+				const __m256i index = LoadNibbles(src + 4 * iy);
+				const __m256i colors = _mm256_blendv_epi8(_mm256_permutevar8x32_epi32(low, index),
+					_mm256_permutevar8x32_epi32(high, index), _mm256_cmpgt_epi32(index, seven));
+				_mm256_storeu_si256((__m256i*)(dst + (y + iy) * width + x), colors);
+			}
+}
+
+FUNCTION_TARGET_AVX2 void DecodeC8(u32* dst, const u8* src, u32 width, u32 height, const u32* palette)
+{
+	for (u32 y = 0; y < height; y += 4)
+		for (u32 x = 0; x < width; x += 8, src += 32)
+			for (u32 iy = 0; iy < 4; iy++)
+			{
+				const __m256i index = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(src + 8 * iy)));
+				_mm256_storeu_si256((__m256i*)(dst + (y + iy) * width + x),
+					_mm256_i32gather_epi32((const int*)palette, index, 4));
+			}
+}
+
+FUNCTION_TARGET_AVX2 void DecodeC14X2(u32* dst, const u8* src, u32 width, u32 height, const u32* palette)
+{
+	const __m256i mask = _mm256_set1_epi32(0x3FFF);
+	for (u32 y = 0; y < height; y += 4)
+		for (u32 x = 0; x < width; x += 4, src += 32)
+		{
+			for (u32 iy = 0; iy < 4; iy += 2)
+			{
+				const __m256i index = _mm256_and_si256(LoadBE16x8(src + 8 * iy), mask);
+				StoreRows(dst + (y + iy) * width + x, width, _mm256_i32gather_epi32((const int*)palette, index, 4));
+			}
+		}
+}
+
+// Same color math as the SSE2 CMPR decoder: signed deltas, wrapping per component
+inline void DecodeDXTColors(u32* colors, const u8* block)
+{
+	const u16 c1 = (block[0] << 8) | block[1];
+	const u16 c2 = (block[2] << 8) | block[3];
+	const s32 r1 = Convert5To8(c1 >> 11), g1 = Convert6To8((c1 >> 5) & 0x3F), b1 = Convert5To8(c1 & 0x1F);
+	const s32 r2 = Convert5To8(c2 >> 11), g2 = Convert6To8((c2 >> 5) & 0x3F), b2 = Convert5To8(c2 & 0x1F);
+
+	colors[0] = r1 | (g1 << 8) | (b1 << 16) | 0xFF000000;
+	colors[1] = r2 | (g2 << 8) | (b2 << 16) | 0xFF000000;
+	if (c1 > c2)
+	{
+		const s32 dr = ((r2 - r1) >> 1) - ((r2 - r1) >> 3);
+		const s32 dg = ((g2 - g1) >> 1) - ((g2 - g1) >> 3);
+		const s32 db = ((b2 - b1) >> 1) - ((b2 - b1) >> 3);
+		colors[2] = ((r1 + dr) & 0xFF) | (((g1 + dg) & 0xFF) << 8) | (((b1 + db) & 0xFF) << 16) | 0xFF000000;
+		colors[3] = ((r2 - dr) & 0xFF) | (((g2 - dg) & 0xFF) << 8) | (((b2 - db) & 0xFF) << 16) | 0xFF000000;
+	}
+	else
+	{
+		colors[2] = ((r1 + r2 + 1) >> 1) | (((g1 + g2 + 1) >> 1) << 8) | (((b1 + b2 + 1) >> 1) << 16) | 0xFF000000;
+		colors[3] = colors[1] & 0x00FFFFFF;
+	}
+}
+
+FUNCTION_TARGET_AVX2 void DecodeCMPR(u32* dst, const u8* src, u32 width, u32 height)
+{
+	// Two DXT1 blocks side by side make up 8 texels of a row: the left block's colors go in
+	// palette entries 0-3 and the right block's in 4-7.
+	const __m256i shifts = _mm256_setr_epi32(6, 4, 2, 0, 14, 12, 10, 8);
+	const __m256i right = _mm256_setr_epi32(0, 0, 0, 0, 4, 4, 4, 4);
+	const __m256i mask2 = _mm256_set1_epi32(3);
+	for (u32 y = 0; y < height; y += 8)
+	{
+		for (u32 x = 0; x < width; x += 8, src += 32)
+		{
+			for (u32 half = 0; half < 2; half++)
+			{
+				const u8* left_block = src + 16 * half;
+				const u8* right_block = left_block + 8;
+				alignas(32) u32 colors[8];
+				DecodeDXTColors(colors, left_block);
+				DecodeDXTColors(colors + 4, right_block);
+				const __m256i palette = _mm256_load_si256((const __m256i*)colors);
+
+				u32* row = dst + (y + 4 * half) * width + x;
+				for (u32 iy = 0; iy < 4; iy++, row += width)
+				{
+					const __m256i lines = _mm256_set1_epi32(left_block[4 + iy] | (right_block[4 + iy] << 8));
+					const __m256i index = _mm256_or_si256(_mm256_and_si256(_mm256_srlv_epi32(lines, shifts), mask2), right);
+					_mm256_storeu_si256((__m256i*)row, _mm256_permutevar8x32_epi32(palette, index));
+				}
+			}
+		}
+	}
+}
+}
+
+PC_TexFormat TexDecoder_Decode_RGBA_AVX2(u32* dst, const u8* src, u32 width, u32 height, u32 texformat, u32 tlutaddr, TlutFormat tlutfmt)
+{
+	if (width % TexDecoder_GetBlockWidthInTexels(texformat) != 0 ||
+		height % TexDecoder_GetBlockHeightInTexels(texformat) != 0)
+	{
+		return PC_TEX_FMT_NONE;
+	}
+
+	const u32 palette_entries = TexDecoder_GetPaletteSize(texformat) / 2;
+	if (palette_entries != 0 && tlutaddr + palette_entries * 2 > TMEM_SIZE)
+		return PC_TEX_FMT_NONE;
+
+	switch (texformat)
+	{
+	case GX_TF_I4:
+		DecodeI4(dst, src, width, height);
+		break;
+	case GX_TF_I8:
+		DecodeI8(dst, src, width, height);
+		break;
+	case GX_TF_IA4:
+		DecodeIA4(dst, src, width, height);
+		break;
+	case GX_TF_IA8:
+		Decode16BitBlocks<DecodeIA8>(dst, src, width, height);
+		break;
+	case GX_TF_RGB565:
+		Decode16BitBlocks<DecodeRGB565>(dst, src, width, height);
+		break;
+	case GX_TF_RGB5A3:
+		Decode16BitBlocks<DecodeRGB5A3>(dst, src, width, height);
+		break;
+	case GX_TF_RGBA8:
+		DecodeRGBA8(dst, src, width, height);
+		break;
+	case GX_TF_C4:
+	{
+		alignas(32) u32 palette[16];
+		DecodePalette(palette, tlutaddr, 16, tlutfmt);
+		DecodeC4(dst, src, width, height, palette);
+		break;
+	}
+	case GX_TF_C8:
+	{
+		alignas(32) u32 palette[256];
+		DecodePalette(palette, tlutaddr, 256, tlutfmt);
+		DecodeC8(dst, src, width, height, palette);
+		break;
+	}
+	case GX_TF_C14X2:
+	{
+		// Converting the whole TLUT only pays off for textures with more texels than entries
+		if (width * height < palette_entries)
+			return PC_TEX_FMT_NONE;
+
+		std::vector<u32> palette(palette_entries);
+		DecodePalette(palette.data(), tlutaddr, palette_entries, tlutfmt);
+		if (tlutfmt == GX_TL_RGB5A3)
+		{
+			// The SSE2 path decodes this combination to BGRA
+			for (u32& color : palette)
+				color = (color & 0xFF00FF00) | ((color >> 16) & 0xFF) | ((color & 0xFF) << 16);
+		}
+		DecodeC14X2(dst, src, width, height, palette.data());
+		break;
+	}
+	case GX_TF_CMPR:
+		DecodeCMPR(dst, src, width, height);
+		break;
+	default:
+		return PC_TEX_FMT_NONE;
+	}
+	return PC_TEX_FMT_RGBA32;
+}
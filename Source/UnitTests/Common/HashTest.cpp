@@ -0,0 +1,104 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Common/CPUDetect.h"
+#include "Common/CommonTypes.h"
+#include "Common/Hash.h"
+
+namespace
+{
+std::vector<u8> MakeData(size_t size)
+{
+  std::vector<u8> data(size);
+  for (size_t i = 0; i < size; i++)
+    data[i] = static_cast<u8>((static_cast<u32>(i) * 0x9E3779B1U) >> 24);
+  return data;
+}
+
+const u32 s_lengths[] = {0,   1,    3,    4,    8,    9,    16,   17,     100,    128,
+                         129, 200,  240,  241,  1000, 1024, 1025, 4096, 100000, 1 << 20};
+}
+
+TEST(Hash, XXHash3MatchesReference)
+{
+  // Computed with the reference XXH3_64bits
+  const u64 expected[] = {
+      0x2d06800538d394c2ULL, 0xc44bdff4074eecdbULL, 0xe14090f554a5ea90ULL, 0x2e8d078a566e9749ULL,
+      0xcd1c7f88482fcaefULL, 0xbfe43def699fa9e3ULL, 0x81e9eb8634460bb9ULL, 0x9998430fd0a655beULL,
+      0x4ff5f6c0d102cd55ULL, 0x75eca5c5d5594884ULL, 0xa05da42e7a4e4667ULL, 0xe07bfbc15015bf69ULL,
+      0x5eb2467c8c9e3969ULL, 0x2d431e984c441f15ULL, 0x8d3e88d833cd4a80ULL, 0xe99def1145f12936ULL,
+      0x83cba9b371e4e7f4ULL, 0x9bf67f8deff876aeULL, 0x920056915640359fULL, 0xa60868b9a5018405ULL,
+  };
+  std::vector<u8> data = MakeData(1 << 20);
+
+  // Once with the default stripe loop, once with the best one for this CPU
+  for (int pass = 0; pass < 2; pass++)
+  {
+    for (size_t i = 0; i < sizeof(s_lengths) / sizeof(s_lengths[0]); i++)
+      EXPECT_EQ(expected[i], GetXXHash3(data.data(), s_lengths[i], 0)) << "length " << s_lengths[i];
+    SetHash64Function(true);
+  }
+}
+
+TEST(Hash, XXHash3Sampling)
+{
+  SetHash64Function(true);
+  std::vector<u8> data = MakeData(1 << 16);
+
+  // Enough samples to cover every stripe is the same as hashing everything
+  EXPECT_EQ(GetXXHash3(data.data(), 4096, 0), GetXXHash3(data.data(), 4096, 4096 / 8));
+  EXPECT_EQ(GetXXHash3(data.data(), 4096, 0), GetHash64(data.data(), 4096, 0));
+
+  const u64 sampled = GetXXHash3(data.data(), static_cast<u32>(data.size()), 128);
+  EXPECT_NE(GetXXHash3(data.data(), static_cast<u32>(data.size()), 0), sampled);
+
+  // The last stripe is always hashed
+  data.back() ^= 1;
+  EXPECT_NE(sampled, GetXXHash3(data.data(), static_cast<u32>(data.size()), 128));
+}
+
+// Throughput of the texture hash functions. Disabled by default, pass
+// --gtest_also_run_disabled_tests to run it.
+TEST(Hash, DISABLED_TextureHashBenchmark)
+{
+  // RGBA8 and CMPR textures of common sizes
+  const u32 sizes[] = {64 * 64 * 4, 256 * 256 * 4, 512 * 512 / 2, 640 * 528 * 4, 1024 * 1024 * 4};
+  std::vector<u8> data = MakeData(1024 * 1024 * 4);
+
+  struct
+  {
+    const char* name;
+    u64 (*function)(const u8*, u32, u32);
+  } functions[] = {{"MurmurHash3", &GetMurmurHash3}, {"CRC32", &GetCRC32}, {"xxHash3", &GetXXHash3}};
+  SetHash64Function(true);
+
+  for (u32 size : sizes)
+  {
+    for (const auto& function : functions)
+    {
+      if (function.function == &GetCRC32 && (!cpu_info.bSSE4_2 || GetCRC32(data.data(), size, 0) == 0))
+        continue;  // not supported by this build or CPU
+
+      for (u32 samples : {0u, 128u})
+      {
+        const int rounds = std::max(1, static_cast<int>((64 << 20) / size));
+        u64 sum = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int round = 0; round < rounds; round++)
+          sum += function.function(data.data(), size, samples);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printf("%8u bytes, %3u samples, %-12s %8.0f MB/s (%016llx)\n", size, samples, function.name,
+               static_cast<double>(size) * rounds / seconds / (1 << 20),
+               static_cast<unsigned long long>(sum));
+      }
+    }
+  }
+}
@@ -0,0 +1,281 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+#include "Common/CommonPaths.h"
+#include "Common/FileUtil.h"
+#include "Common/LinearDiskCache.h"
+
+namespace
+{
+// Three bytes, so the u32 values that follow it need padding
+struct OddKey
+{
+  u8 bytes[3];
+};
+
+template <typename K, typename V>
+class CollectingReader : public LinearDiskCacheReader<K, V>
+{
+public:
+  void Read(const K& key, const V* value, u32 value_size) override
+  {
+    keys.push_back(key);
+    values.emplace_back(value, value + value_size);
+  }
+
+  std::vector<K> keys;
+  std::vector<std::vector<V>> values;
+};
+
+class LinearDiskCacheTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    m_dir = File::CreateTempDir();
+    m_filename = m_dir + DIR_SEP "test.cache";
+  }
+  void TearDown() override { File::DeleteDirRecursively(m_dir); }
+  std::string m_dir;
+  std::string m_filename;
+};
+}
+
+TEST_F(LinearDiskCacheTest, ReadsAppendedEntries)
+{
+  LinearDiskCache<u32, u8> cache;
+  CollectingReader<u32, u8> empty;
+  EXPECT_EQ(0u, cache.OpenAndRead(m_filename, empty));
+  const u8 first[] = {1, 2, 3};
+  cache.Append(7, first, 3);
+  cache.Append(8, nullptr, 0);
+  cache.Close();
+
+  CollectingReader<u32, u8> reader;
+  EXPECT_EQ(2u, cache.OpenAndRead(m_filename, reader));
+  ASSERT_EQ(2u, reader.keys.size());
+  EXPECT_EQ(7u, reader.keys[0]);
+  EXPECT_EQ(std::vector<u8>({1, 2, 3}), reader.values[0]);
+  EXPECT_EQ(8u, reader.keys[1]);
+  EXPECT_TRUE(reader.values[1].empty());
+
+  // Appending after reading continues the file
+  const u8 third[] = {4};
+  cache.Append(9, third, 1);
+  cache.Close();
+
+  LinearDiskCache<u32, u8>::MappedEntries entries;
+  EXPECT_EQ(3u, cache.OpenAndReadMapped(m_filename, &entries));
+  ASSERT_EQ(3u, entries.GetEntries().size());
+  EXPECT_EQ(9u, entries.GetEntries()[2].key);
+  EXPECT_EQ(4, entries.GetEntries()[2].value[0]);
+  cache.Close();
+}
+
+TEST_F(LinearDiskCacheTest, RebuildsIndexAfterCrash)
+{
+  const u8 value[] = {1, 2, 3, 4};
+  {
+    LinearDiskCache<u32, u8> cache;
+    cache.Open(m_filename);
+    cache.Append(1, value, 4);
+    cache.Close();
+    cache.Open(m_filename);
+    cache.Append(2, value, 4);
+    cache.Append(3, value, 4);
+    cache.Sync();
+    // Not closed, so the index in the file is stale
+  }
+
+  LinearDiskCache<u32, u8> cache;
+  CollectingReader<u32, u8> reader;
+  EXPECT_EQ(3u, cache.OpenAndRead(m_filename, reader));
+  EXPECT_EQ(std::vector<u32>({1, 2, 3}), reader.keys);
+  cache.Close();
+}
+
+TEST_F(LinearDiskCacheTest, DropsIncompleteTail)
+{
+  const u8 value[] = {1, 2, 3, 4};
+  {
+    LinearDiskCache<u32, u8> cache;
+    cache.Open(m_filename);
+    cache.Append(1, value, 4);
+    cache.Append(2, value, 4);
+    cache.Sync();
+  }
+
+  // Cut the last entry short, as if the emulator crashed while writing it
+  {
+    File::IOFile file(m_filename, "r+b");
+    file.Resize(file.GetSize() - 2);
+  }
+
+  LinearDiskCache<u32, u8> cache;
+  LinearDiskCache<u32, u8>::MappedEntries entries;
+  EXPECT_EQ(1u, cache.OpenAndReadMapped(m_filename, &entries));
+  cache.Append(3, value, 4);
+  cache.Close();
+
+  CollectingReader<u32, u8> after;
+  EXPECT_EQ(2u, cache.OpenAndRead(m_filename, after));
+  EXPECT_EQ(std::vector<u32>({1, 3}), after.keys);
+  cache.Close();
+}
+
+TEST_F(LinearDiskCacheTest, KeepsEntriesWhenAppendingOverOldIndex)
+{
+  // Big enough values that the appended entries leave the stream buffer before Close
+  const std::vector<u32> value(1024, 0x5a5a5a5a);
+  LinearDiskCache<u32, u32> cache;
+  cache.Open(m_filename);
+  for (u32 i = 0; i < 1000; i++)
+    cache.Append(i, value.data(), static_cast<u32>(value.size()));
+  cache.Close();
+
+  CollectingReader<u32, u32> reader;
+  EXPECT_EQ(1000u, cache.OpenAndRead(m_filename, reader));
+  for (u32 i = 1000; i < 1010; i++)
+    cache.Append(i, value.data(), static_cast<u32>(value.size()));
+  u32 size = 0;
+  EXPECT_NE(nullptr, cache.Find(999, &size));
+  cache.Close();
+
+  CollectingReader<u32, u32> after;
+  EXPECT_EQ(1010u, cache.OpenAndRead(m_filename, after));
+  ASSERT_EQ(1010u, after.keys.size());
+  for (u32 i = 0; i < 1010; i++)
+  {
+    EXPECT_EQ(i, after.keys[i]);
+    EXPECT_EQ(value, after.values[i]);
+  }
+  cache.Close();
+}
+
+TEST_F(LinearDiskCacheTest, FindsKeysThroughIndex)
+{
+  LinearDiskCache<u32, u32> cache;
+  cache.Open(m_filename);
+  for (u32 i = 0; i < 1000; i++)
+    cache.Append(i * 7, &i, 1);
+  cache.Close();
+
+  EXPECT_EQ(1000u, cache.Open(m_filename));
+  u32 size = 0;
+  for (u32 i = 0; i < 1000; i++)
+  {
+    const u32* value = cache.Find(i * 7, &size);
+    ASSERT_NE(nullptr, value);
+    EXPECT_EQ(1u, size);
+    EXPECT_EQ(i, *value);
+  }
+  EXPECT_EQ(nullptr, cache.Find(1, &size));
+  cache.Close();
+}
+
+TEST_F(LinearDiskCacheTest, NewestEntryWinsAndDuplicatesAreCompacted)
+{
+  LinearDiskCache<u32, u32> cache;
+  cache.Open(m_filename);
+  for (u32 i = 0; i < 100; i++)
+    cache.Append(i, &i, 1);
+  cache.Close();
+  const u64 size_before = File::GetSize(m_filename);
+
+  // Replace every key twice, the second time with a bigger value
+  for (u32 round = 1; round <= 2; round++)
+  {
+    cache.Open(m_filename);
+    for (u32 i = 0; i < 100; i++)
+    {
+      const u32 value[] = {i + round * 1000, round};
+      cache.Append(i, value, round);
+    }
+    cache.Close();
+  }
+
+  // The dead entries were dropped once they outnumbered the live ones
+  EXPECT_LT(File::GetSize(m_filename), size_before * 2);
+
+  CollectingReader<u32, u32> reader;
+  EXPECT_EQ(100u, cache.OpenAndRead(m_filename, reader));
+  ASSERT_EQ(100u, reader.keys.size());
+  for (u32 i = 0; i < 100; i++)
+  {
+    EXPECT_EQ(i, reader.keys[i]);
+    EXPECT_EQ(std::vector<u32>({i + 2000, 2}), reader.values[i]);
+  }
+  cache.Close();
+}
+
+TEST_F(LinearDiskCacheTest, MigratesLegacyFormat)
+{
+  // Header and two entries of the unindexed format, the second one a replacement of the first
+  std::string legacy("DCAC");
+  const u16 sizes[] = {sizeof(u32), sizeof(u32)};
+  legacy.append(reinterpret_cast<const char*>(sizes), sizeof(sizes));
+  std::string ver = scm_rev_cache_str.substr(0, 40);
+  ver.resize(40);
+  legacy += ver;
+  const u32 entries[][4] = {{1, 5, 50, 1}, {1, 5, 51, 2}};
+  for (const auto& entry : entries)
+    legacy.append(reinterpret_cast<const char*>(entry), sizeof(entry));
+  File::WriteStringToFile(legacy, m_filename);
+
+  LinearDiskCache<u32, u32> cache;
+  EXPECT_EQ(1u, cache.Open(m_filename));
+  u32 size = 0;
+  const u32* value = cache.Find(5, &size);
+  ASSERT_NE(nullptr, value);
+  EXPECT_EQ(51u, *value);
+  cache.Close();
+
+  std::string migrated;
+  File::ReadFileToString(m_filename, migrated);
+  EXPECT_EQ("DCAI", migrated.substr(0, 4));
+}
+
+TEST_F(LinearDiskCacheTest, AlignsValues)
+{
+  LinearDiskCache<OddKey, u32> cache;
+  CollectingReader<OddKey, u32> reader;
+  cache.OpenAndRead(m_filename, reader);
+  const u32 value[] = {0x12345678, 0x9abcdef0};
+  for (u8 i = 0; i < 4; i++)
+    cache.Append({{i, i, i}}, value, 2);
+  cache.Close();
+
+  LinearDiskCache<OddKey, u32>::MappedEntries entries;
+  EXPECT_EQ(4u, cache.OpenAndReadMapped(m_filename, &entries));
+  for (u8 i = 0; i < 4; i++)
+  {
+    const auto& entry = entries.GetEntries()[i];
+    EXPECT_EQ(i, entry.key.bytes[2]);
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(entry.value) % alignof(u32));
+    ASSERT_EQ(2u, entry.value_size);
+    EXPECT_EQ(0x12345678u, entry.value[0]);
+    EXPECT_EQ(0x9abcdef0u, entry.value[1]);
+  }
+  cache.Close();
+}
+
+TEST_F(LinearDiskCacheTest, RecreatesFileWithBadHeader)
+{
+  File::WriteStringToFile("not a cache", m_filename);
+
+  LinearDiskCache<u32, u8> cache;
+  CollectingReader<u32, u8> reader;
+  EXPECT_EQ(0u, cache.OpenAndRead(m_filename, reader));
+  const u8 value[] = {5};
+  cache.Append(1, value, 1);
+  cache.Close();
+
+  CollectingReader<u32, u8> after;
+  EXPECT_EQ(1u, cache.OpenAndRead(m_filename, after));
+  cache.Close();
+}
@@ -0,0 +1,82 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Common/Common.h"
+#include "Common/ThreadPool.h"
+
+TEST(ThreadPool, TaskGroupWaitsForAllTasks)
+{
+  std::atomic<int> done(0);
+  Common::TaskGroup group;
+  for (int i = 0; i < 1000; i++)
+    group.Run([&done] { done.fetch_add(1); });
+  group.Wait();
+  EXPECT_EQ(1000, done.load());
+}
+
+TEST(ThreadPool, NestedTaskGroups)
+{
+  std::atomic<int> done(0);
+  Common::TaskGroup outer;
+  for (int i = 0; i < 16; i++)
+  {
+    outer.Run([&done] {
+      Common::TaskGroup inner;
+      for (int j = 0; j < 16; j++)
+        inner.Run([&done] { done.fetch_add(1); });
+      inner.Wait();
+    });
+  }
+  outer.Wait();
+  EXPECT_EQ(256, done.load());
+}
+
+TEST(ThreadPool, ParallelForCoversRangeOnce)
+{
+  std::vector<std::atomic<int>> hits(10007);
+  for (auto& hit : hits)
+    hit.store(0);
+  Common::ThreadPool::ParallelFor(0, static_cast<s32>(hits.size()), 16, [&hits](s32 begin, s32 end) {
+    for (s32 i = begin; i < end; i++)
+      hits[i].fetch_add(1);
+  });
+  for (size_t i = 0; i < hits.size(); i++)
+    EXPECT_EQ(1, hits[i].load()) << "index " << i;
+}
+
+TEST(ThreadPool, ParallelForFromManyThreads)
+{
+  std::atomic<int> total(0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++)
+  {
+    threads.emplace_back([&total] {
+      for (int i = 0; i < 50; i++)
+      {
+        Common::ThreadPool::ParallelFor(0, 256, 1, [&total](s32 begin, s32 end) {
+          total.fetch_add(end - begin);
+        });
+      }
+    });
+  }
+  for (std::thread& thread : threads)
+    thread.join();
+  EXPECT_EQ(4 * 50 * 256, total.load());
+}
+
+TEST(ThreadPool, ExecuteAsyncRunsTask)
+{
+  std::atomic<int> done(0);
+  for (int i = 0; i < 100; i++)
+    Common::ThreadPool::ExecuteAsync([&done] { done.fetch_add(1); });
+  while (done.load() < 100)
+    std::this_thread::yield();
+  EXPECT_EQ(100, done.load());
+}
@@ -0,0 +1,253 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>  // NOLINT
+
+#include "Common/CommonTypes.h"
+#include "Common/MathUtil.h"
+#include "Core/HW/DSPHLE/UCodes/AXKernels.h"
+
+using namespace DSP::HLE;
+
+namespace
+{
+// The per sample voice processing that AXVoice.h used before the kernels, kept as the
+// reference for the frame based versions.
+u32 ResampleReference(const s16* input, s16* output, u32 count, s16* last_samples, u32 curr_pos, u32 ratio)
+{
+  int read_samples_count = 0;
+  s16 temp[4];
+  u32 idx = 0;
+
+  temp[idx++ & 3] = last_samples[0];
+  temp[idx++ & 3] = last_samples[1];
+  temp[idx++ & 3] = last_samples[2];
+  temp[idx++ & 3] = last_samples[3];
+
+  for (u32 i = 0; i < count; ++i)
+  {
+    curr_pos += ratio;
+    while (curr_pos >= 0x10000)
+    {
+      temp[idx++ & 3] = input[read_samples_count++];
+      curr_pos -= 0x10000;
+    }
+
+    u16 curr_frac = curr_pos & 0xFFFF;
+    u16 inv_curr_frac = -curr_frac;
+    s16 sample;
+    if (curr_frac)
+    {
+      s32 s0 = temp[idx++ & 3];
+      s32 s1 = temp[idx++ & 3];
+      sample = ((s0 * inv_curr_frac) + (s1 * curr_frac)) >> 16;
+      idx += 2;
+    }
+    else
+    {
+      sample = temp[idx++ & 3];
+      idx += 3;
+    }
+    output[i] = sample;
+  }
+
+  last_samples[3] = temp[--idx & 3];
+  last_samples[2] = temp[--idx & 3];
+  last_samples[1] = temp[--idx & 3];
+  last_samples[0] = temp[--idx & 3];
+  return curr_pos;
+}
+
+void MixAddReference(int* out, const s16* input, u32 count, u16* pvol, s16* dpop, bool ramp)
+{
+  u16& volume = pvol[0];
+  u16 volume_delta = ramp ? pvol[1] : 0;
+  for (u32 i = 0; i < count; ++i)
+  {
+    s64 sample = input[i];
+    sample *= volume;
+    sample >>= 15;
+    sample = MathUtil::Clamp((s32)sample, -32767, 32767);
+    out[i] += (s16)sample;
+    volume += volume_delta;
+    *dpop = (s16)sample;
+  }
+}
+
+// The state a voice keeps in its parameter block from one frame to the next
+struct VoiceState
+{
+  u32 ratio;
+  u16 cur_addr_frac;
+  s16 last_samples[4];
+  u16 envelope_volume;
+  u16 envelope_delta;
+  u16 mixer[2];
+  s16 dpop;
+};
+
+VoiceState RandomVoice(std::mt19937& rng)
+{
+  // Pitches seen in games: 1:1, the 32 kHz <-> 48 kHz conversions, and arbitrary notes
+  const u32 ratios[] = {0x10000, 0xAAAA, 0x18000, 0x8000, 0x40000, 0x1, 0x3FFFF};
+  VoiceState voice;
+  voice.ratio = rng() % 2 ? ratios[rng() % 7] : rng() % 0x40001;
+  voice.cur_addr_frac = rng();
+  for (s16& sample : voice.last_samples)
+    sample = rng();
+  voice.envelope_volume = rng();
+  voice.envelope_delta = rng() % 2 ? 0 : rng() % 64 - 32;
+  voice.mixer[0] = rng();
+  voice.mixer[1] = rng() % 256 - 128;
+  voice.dpop = 0;
+  return voice;
+}
+
+u32 InputSamplesForFrame(const VoiceState& voice, u32 count)
+{
+  return static_cast<u32>((voice.cur_addr_frac + static_cast<u64>(voice.ratio) * count) >> 16);
+}
+
+// Runs one frame the way GetInputSamples and ProcessVoice did before
+void ProcessFrameReference(VoiceState* voice, const s16* input, u32 count, bool ramp, int* out)
+{
+  s16 samples[96];
+  voice->cur_addr_frac =
+      ResampleReference(input, samples, count, voice->last_samples, voice->cur_addr_frac, voice->ratio);
+  for (u32 i = 0; i < count; ++i)
+  {
+    samples[i] = MathUtil::Clamp(((s32)samples[i] * voice->envelope_volume) >> 15, -32767, 32767);
+    voice->envelope_volume += voice->envelope_delta;
+  }
+  MixAddReference(out, samples, count, voice->mixer, &voice->dpop, ramp);
+}
+
+// Runs one frame the way the batched pipeline does
+void ProcessFrameBatched(VoiceState* voice, const s16* input, u32 count, bool ramp, int* out, bool simd)
+{
+  s16 buffer[4 + 4 * 96 + 1];
+  s16 samples[96];
+  const u32 input_count = InputSamplesForFrame(*voice, count);
+  memcpy(buffer, voice->last_samples, sizeof(voice->last_samples));
+  memcpy(buffer + 4, input, input_count * sizeof(s16));
+
+#ifdef _M_X86
+  if (simd)
+  {
+    voice->cur_addr_frac = AXKernels::ResampleLinearSSE2(buffer, samples, count, voice->cur_addr_frac, voice->ratio);
+    AXKernels::ApplyVolumeRampSSE2(samples, count, &voice->envelope_volume, voice->envelope_delta);
+    AXKernels::MixAddSSE2(out, samples, count, voice->mixer, &voice->dpop, ramp);
+  }
+  else
+#endif
+  {
+    voice->cur_addr_frac = AXKernels::ResampleLinearScalar(buffer, samples, count, voice->cur_addr_frac, voice->ratio);
+    AXKernels::ApplyVolumeRampScalar(samples, count, &voice->envelope_volume, voice->envelope_delta);
+    AXKernels::MixAddScalar(out, samples, count, voice->mixer, &voice->dpop, ramp);
+  }
+  memcpy(voice->last_samples, buffer + input_count, sizeof(voice->last_samples));
+}
+
+void ExpectSameState(const VoiceState& expected, const VoiceState& actual)
+{
+  EXPECT_EQ(expected.cur_addr_frac, actual.cur_addr_frac);
+  EXPECT_EQ(0, memcmp(expected.last_samples, actual.last_samples, sizeof(expected.last_samples)));
+  EXPECT_EQ(expected.envelope_volume, actual.envelope_volume);
+  EXPECT_EQ(expected.mixer[0], actual.mixer[0]);
+  EXPECT_EQ(expected.dpop, actual.dpop);
+}
+}
+
+TEST(AXKernels, FramesMatchReference)
+{
+  std::mt19937 rng(17);
+  std::vector<s16> stream(1 << 16);
+  for (s16& sample : stream)
+    sample = rng() % 4 ? static_cast<s16>(rng()) : (rng() % 2 ? 32767 : -32768);
+
+  // GC frames, Wii frames and the Wii remote frames
+  const u32 counts[] = {32, 96, 18, 6, 5};
+  for (int voice_index = 0; voice_index < 200; voice_index++)
+  {
+    const VoiceState initial = RandomVoice(rng);
+    const u32 count = counts[voice_index % 5];
+    const bool ramp = voice_index % 3 != 0;
+
+    VoiceState reference = initial, scalar = initial, simd = initial;
+    std::vector<int> out_reference(count), out_scalar(count), out_simd(count);
+    u32 stream_pos = 0;
+    for (int frame = 0; frame < 50; frame++)
+    {
+      const u32 input_count = InputSamplesForFrame(reference, count);
+      if (stream_pos + input_count > stream.size())
+        stream_pos = 0;
+      const s16* input = stream.data() + stream_pos;
+      stream_pos += input_count;
+
+      ProcessFrameReference(&reference, input, count, ramp, out_reference.data());
+      ProcessFrameBatched(&scalar, input, count, ramp, out_scalar.data(), false);
+      ProcessFrameBatched(&simd, input, count, ramp, out_simd.data(), true);
+
+      ExpectSameState(reference, scalar);
+      ExpectSameState(reference, simd);
+      ASSERT_EQ(out_reference, out_scalar) << "voice " << voice_index << " frame " << frame;
+      ASSERT_EQ(out_reference, out_simd) << "voice " << voice_index << " frame " << frame;
+    }
+  }
+}
+
+// Times a second of mixing with the scalar and SIMD kernels. Not run by default, use
+// --gtest_also_run_disabled_tests.
+TEST(AXKernels, DISABLED_MixingBenchmark)
+{
+  // 64 Wii voices mixed to the 9 main and aux buffers, for one second of audio
+  std::mt19937 rng(23);
+  std::vector<s16> stream(1 << 16);
+  for (s16& sample : stream)
+    sample = static_cast<s16>(rng());
+  std::vector<VoiceState> voices(64);
+  for (VoiceState& voice : voices)
+    voice = RandomVoice(rng);
+  const int frames = 333;
+
+  for (int mode = 0; mode < 2; mode++)
+  {
+    std::vector<int> buffers(9 * 96);
+    std::vector<VoiceState> state = voices;
+    auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frames; frame++)
+    {
+      for (VoiceState& voice : state)
+      {
+        s16 samples[96];
+        s16 buffer[4 + 4 * 96 + 1];
+        memcpy(buffer, voice.last_samples, sizeof(voice.last_samples));
+        memcpy(buffer + 4, stream.data() + (frame * 96) % 32768, InputSamplesForFrame(voice, 96) * sizeof(s16));
+        if (mode == 0)
+        {
+          voice.cur_addr_frac = AXKernels::ResampleLinearScalar(buffer, samples, 96, voice.cur_addr_frac, voice.ratio);
+          AXKernels::ApplyVolumeRampScalar(samples, 96, &voice.envelope_volume, voice.envelope_delta);
+          for (int i = 0; i < 9; i++)
+            AXKernels::MixAddScalar(&buffers[i * 96], samples, 96, voice.mixer, &voice.dpop, true);
+        }
+        else
+        {
+          voice.cur_addr_frac = AXKernels::ResampleLinear(buffer, samples, 96, voice.cur_addr_frac, voice.ratio);
+          AXKernels::ApplyVolumeRamp(samples, 96, &voice.envelope_volume, voice.envelope_delta);
+          for (int i = 0; i < 9; i++)
+            AXKernels::MixAdd(&buffers[i * 96], samples, 96, voice.mixer, &voice.dpop, true);
+        }
+      }
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    printf("%-6s %.2f ms for %d frames of %d voices\n", mode == 0 ? "scalar" : "SIMD", ms, frames,
+           static_cast<int>(voices.size()));
+  }
+}
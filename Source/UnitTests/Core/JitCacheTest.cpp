@@ -0,0 +1,213 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Core/CoreTiming.h"
+#include "Core/PowerPC/JitCommon/JitBase.h"
+#include "Core/PowerPC/JitCommon/JitCache.h"
+#include "Core/PowerPC/PowerPC.h"
+
+// include order is important
+#include <gtest/gtest.h>  // NOLINT
+
+namespace
+{
+class TestBlockCache final : public JitBaseBlockCache
+{
+public:
+  explicit TestBlockCache(JitBase& jit) : JitBaseBlockCache(jit) {}
+
+private:
+  void WriteLinkBlock(const JitBlock::LinkData& source, const JitBlock* dest) override {}
+};
+
+class BlockCacheFakeJit : public JitBase
+{
+public:
+  // CPUCoreBase methods
+  void Init() override {}
+  void Shutdown() override {}
+  void ClearCache() override {}
+  void Run() override {}
+  void SingleStep() override {}
+  const char* GetName() override { return nullptr; }
+  // JitBase methods
+  JitBaseBlockCache* GetBlockCache() override { return nullptr; }
+  void Jit(u32 em_address) override {}
+  const CommonAsmRoutinesBase* GetAsmRoutines() override { return nullptr; }
+  bool HandleFault(uintptr_t access_address, SContext* ctx) override { return false; }
+};
+
+constexpr u32 BASE_ADDRESS = 0x00100000;
+constexpr u32 BLOCK_INSTRUCTIONS = 8;
+constexpr u32 BLOCK_BYTES = BLOCK_INSTRUCTIONS * 4;
+
+u32 BlockAddress(int i)
+{
+  return BASE_ADDRESS + i * BLOCK_BYTES;
+}
+
+// Back to back blocks, each one linking to the next.
+void AddBlocks(JitBaseBlockCache& cache, int count)
+{
+  for (int i = 0; i < count; i++)
+  {
+    int block_num = cache.AllocateBlock(BlockAddress(i));
+    JitBlock* b = cache.GetBlock(block_num);
+    b->checkedEntry = nullptr;
+    b->normalEntry = nullptr;
+    b->codeSize = 0;
+    b->originalSize = BLOCK_INSTRUCTIONS;
+    b->linkData.push_back({nullptr, BlockAddress(i + 1), false});
+    cache.FinalizeBlock(block_num, true, nullptr);
+  }
+}
+
+// The block lookup structures JitBaseBlockCache used before they were bucketed by page,
+// kept to compare the invalidation throughput against.
+class MapBlockIndex
+{
+public:
+  void Add(u32 address, int block_num)
+  {
+    start_block_map[address] = block_num;
+    block_map[std::make_pair(address + BLOCK_BYTES - 1, address)] = block_num;
+    links_to.emplace(address + BLOCK_BYTES, block_num);
+  }
+
+  void Invalidate(u32 address, u32 length)
+  {
+    auto it = block_map.lower_bound(std::make_pair(address, 0));
+    while (it != block_map.end() && it->first.second < address + length)
+    {
+      start_block_map.erase(it->first.second);
+      auto links = links_to.equal_range(it->first.second);
+      while (links.first != links.second)
+      {
+        if (links.first->second == static_cast<int>(it->second))
+          links.first = links_to.erase(links.first);
+        else
+          links.first++;
+      }
+      it = block_map.erase(it);
+    }
+  }
+
+  bool Empty() const { return block_map.empty() && start_block_map.empty(); }
+
+private:
+  std::multimap<u32, int> links_to;
+  std::map<std::pair<u32, u32>, u32> block_map;
+  std::map<u32, u32> start_block_map;
+};
+
+class JitCacheTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    MSR = 0;
+    m_cache = std::make_unique<TestBlockCache>(m_jit);
+    m_cache->Init();
+  }
+
+  void TearDown() override
+  {
+    m_cache->Shutdown();
+    m_cache.reset();
+    CoreTiming::UnregisterAllEvents();
+  }
+
+  bool IsCompiled(u32 address) { return m_cache->GetBlockNumberFromStartAddress(address, 0) >= 0; }
+
+  BlockCacheFakeJit m_jit;
+  std::unique_ptr<TestBlockCache> m_cache;
+};
+}
+
+TEST_F(JitCacheTest, InvalidateDestroysOverlappingBlocks)
+{
+  const int count = 1024;
+  AddBlocks(*m_cache, count);
+  std::vector<bool> alive(count, true);
+
+  std::mt19937 rng(42);
+  for (int i = 0; i < 200; i++)
+  {
+    const u32 address = BASE_ADDRESS + rng() % (count * BLOCK_BYTES);
+    const u32 length = 4 + (rng() % 64) * 4;
+    m_cache->InvalidateICache(address, length, true);
+    for (int b = 0; b < count; b++)
+    {
+      if (BlockAddress(b) < address + length && BlockAddress(b) + BLOCK_BYTES > address)
+        alive[b] = false;
+    }
+  }
+
+  for (int b = 0; b < count; b++)
+    EXPECT_EQ(alive[b], IsCompiled(BlockAddress(b))) << "block " << b;
+}
+
+TEST_F(JitCacheTest, InvalidateBlockSpanningPages)
+{
+  const u32 address = 0x00200FF0;
+  int block_num = m_cache->AllocateBlock(address);
+  m_cache->GetBlock(block_num)->originalSize = 16;
+  m_cache->FinalizeBlock(block_num, false, nullptr);
+  ASSERT_TRUE(IsCompiled(address));
+
+  // Only touches the second page of the block
+  m_cache->InvalidateICache(0x00201020, 32, true);
+  EXPECT_FALSE(IsCompiled(address));
+}
+
+TEST_F(JitCacheTest, InvalidateWholeAddressSpace)
+{
+  const int count = 256;
+  AddBlocks(*m_cache, count);
+  m_cache->InvalidateICache(0, 0xffffffff, true);
+  for (int b = 0; b < count; b++)
+    EXPECT_FALSE(IsCompiled(BlockAddress(b))) << "block " << b;
+}
+
+// Compares icbi invalidation against a std::map index. Only prints timings, so it is
+// disabled; run it with --gtest_also_run_disabled_tests.
+TEST_F(JitCacheTest, DISABLED_InvalidateBenchmark)
+{
+  const int count = 32768, rounds = 4;
+  double cache_ms = 0, map_ms = 0;
+  for (int round = 0; round < rounds; round++)
+  {
+    m_cache->Clear();
+    AddBlocks(*m_cache, count);
+    MapBlockIndex map_index;
+    for (int i = 0; i < count; i++)
+      map_index.Add(BlockAddress(i), i + 1);
+
+    // icbi on every cache line, as games that copy code around do
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; i++)
+      m_cache->InvalidateICache(BlockAddress(i), 32, true);
+    auto middle = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; i++)
+      map_index.Invalidate(BlockAddress(i), 32);
+    auto end = std::chrono::steady_clock::now();
+
+    cache_ms += std::chrono::duration<double, std::milli>(middle - start).count();
+    map_ms += std::chrono::duration<double, std::milli>(end - middle).count();
+    EXPECT_FALSE(IsCompiled(BlockAddress(0)));
+    EXPECT_FALSE(IsCompiled(BlockAddress(count - 1)));
+    EXPECT_TRUE(map_index.Empty());
+  }
+  printf("Invalidating %d blocks: JitBaseBlockCache %.2f ms, std::map index (lookups only) %.2f ms\n",
+         count, cache_ms / rounds, map_ms / rounds);
+}
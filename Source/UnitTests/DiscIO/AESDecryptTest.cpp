@@ -0,0 +1,73 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <mbedtls/aes.h>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>  // NOLINT
+
+#include "Common/CPUDetect.h"
+#include "Common/CommonTypes.h"
+#include "DiscIO/VolumeWiiCrypted.h"
+
+#ifdef _M_X86
+namespace
+{
+std::vector<u8> RandomBytes(std::mt19937& rng, size_t size)
+{
+  std::uniform_int_distribution<int> dist(0, 255);
+  std::vector<u8> bytes(size);
+  for (u8& byte : bytes)
+    byte = static_cast<u8>(dist(rng));
+  return bytes;
+}
+
+std::vector<u8> DecryptReference(const std::vector<u8>& key, std::vector<u8> iv,
+                                 const std::vector<u8>& src)
+{
+  mbedtls_aes_context ctx;
+  mbedtls_aes_init(&ctx);
+  mbedtls_aes_setkey_dec(&ctx, key.data(), 128);
+  std::vector<u8> dst(src.size());
+  mbedtls_aes_crypt_cbc(&ctx, MBEDTLS_AES_DECRYPT, src.size(), iv.data(), src.data(), dst.data());
+  mbedtls_aes_free(&ctx);
+  return dst;
+}
+
+void ExpectSameAsReference(std::mt19937& rng, size_t size)
+{
+  const std::vector<u8> key = RandomBytes(rng, 16);
+  const std::vector<u8> iv = RandomBytes(rng, 16);
+  const std::vector<u8> src = RandomBytes(rng, size);
+
+  std::vector<u8> dst(size);
+  DiscIO::DecryptCBC_AESNI(key.data(), iv.data(), src.data(), dst.data(), size);
+  EXPECT_EQ(DecryptReference(key, iv, src), dst) << "size " << size;
+}
+}
+
+TEST(AESDecrypt, MatchesMbedtlsForClusters)
+{
+  if (!cpu_info.bAES)
+    return;
+
+  // A Wii disc cluster holds 0x7C00 bytes of data
+  std::mt19937 rng(0x5769);
+  for (int i = 0; i < 16; i++)
+    ExpectSameAsReference(rng, 0x7C00);
+}
+
+TEST(AESDecrypt, MatchesMbedtlsForTailSizes)
+{
+  if (!cpu_info.bAES)
+    return;
+
+  // Every block count up to three full batches of eight, so the one block at a
+  // time tail runs for each remainder
+  std::mt19937 rng(0x4145);
+  for (size_t blocks = 1; blocks <= 3 * 8; blocks++)
+    ExpectSameAsReference(rng, blocks * 16);
+}
+#endif
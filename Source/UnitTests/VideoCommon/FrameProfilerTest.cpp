@@ -0,0 +1,69 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>  // NOLINT
+
+#include "VideoCommon/FrameProfiler.h"
+
+namespace
+{
+void Sleep(int ms)
+{
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+u64 Milliseconds(const FrameProfiler::FrameTimes& frame, FrameProfiler::Section section)
+{
+  return frame.nanoseconds[section] / 1000000;
+}
+}
+
+TEST(FrameProfiler, DisabledRecordsNothing)
+{
+  FrameProfiler::SetEnabled(false);
+  {
+    FrameProfiler::ScopedSection section(FrameProfiler::SECTION_GPU_THREAD);
+  }
+  FrameProfiler::EndFrame();
+  EXPECT_TRUE(FrameProfiler::TakeFrames().empty());
+}
+
+TEST(FrameProfiler, NestedSectionsAndFrames)
+{
+  FrameProfiler::SetEnabled(true);
+  {
+    FrameProfiler::ScopedSection gpu(FrameProfiler::SECTION_GPU_THREAD);
+    {
+      FrameProfiler::ScopedSection decode(FrameProfiler::SECTION_OPCODE_DECODE);
+      {
+        // Nested use of the same section only counts once
+        FrameProfiler::ScopedSection decode_again(FrameProfiler::SECTION_OPCODE_DECODE);
+        Sleep(10);
+      }
+    }
+    // A frame ending inside a section splits its time between the two frames
+    FrameProfiler::EndFrame();
+    Sleep(100);
+  }
+  FrameProfiler::EndFrame();
+
+  std::vector<FrameProfiler::FrameTimes> frames = FrameProfiler::TakeFrames();
+  FrameProfiler::SetEnabled(false);
+  ASSERT_EQ(2u, frames.size());
+  EXPECT_TRUE(FrameProfiler::TakeFrames().empty());
+
+  EXPECT_GE(Milliseconds(frames[0], FrameProfiler::SECTION_GPU_THREAD), 10u);
+  EXPECT_LT(Milliseconds(frames[0], FrameProfiler::SECTION_GPU_THREAD), 100u);
+  EXPECT_GE(Milliseconds(frames[0], FrameProfiler::SECTION_OPCODE_DECODE), 10u);
+  EXPECT_LE(Milliseconds(frames[0], FrameProfiler::SECTION_OPCODE_DECODE),
+            Milliseconds(frames[0], FrameProfiler::SECTION_GPU_THREAD));
+  EXPECT_EQ(0u, frames[0].nanoseconds[FrameProfiler::SECTION_TEXTURE_DECODE]);
+
+  EXPECT_GE(Milliseconds(frames[1], FrameProfiler::SECTION_GPU_THREAD), 100u);
+  EXPECT_EQ(0u, frames[1].nanoseconds[FrameProfiler::SECTION_OPCODE_DECODE]);
+}
@@ -0,0 +1,139 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>  // NOLINT
+
+#include "Common/Common.h"
+#include "VideoBackends/Software/PixelKernels.h"
+
+#ifdef _M_X86
+
+namespace
+{
+PixelKernels::CombinerInputs RandomInputs(std::mt19937& rng)
+{
+  PixelKernels::CombinerInputs inputs;
+  for (int i = 0; i < 4; i++)
+  {
+    inputs.a[i] = static_cast<s16>(rng());
+    inputs.b[i] = static_cast<s16>(rng());
+    inputs.c[i] = static_cast<s16>(rng());
+    inputs.d[i] = static_cast<s16>(rng());
+  }
+  return inputs;
+}
+}
+
+TEST(SWPixelKernels, CombineRegularMatchesScalar)
+{
+  std::mt19937 rng(7);
+  // Every bias/op/clamp/shift combination, for color and alpha independently
+  for (u32 color_mode = 0; color_mode < 64; color_mode++)
+  {
+    if ((color_mode & 3) == 3)
+      continue;  // compare mode
+    for (u32 alpha_mode = 0; alpha_mode < 64; alpha_mode++)
+    {
+      if ((alpha_mode & 3) == 3)
+        continue;
+
+      TevStageCombiner::ColorCombiner cc;
+      TevStageCombiner::AlphaCombiner ac;
+      cc.hex = color_mode << 16;
+      ac.hex = alpha_mode << 16;
+      for (int i = 0; i < 200; i++)
+      {
+        PixelKernels::CombinerInputs inputs = RandomInputs(rng);
+        s16 scalar[4], simd[4];
+        PixelKernels::CombineRegularScalar(inputs, cc, ac, scalar);
+        PixelKernels::CombineRegularSSE2(inputs, cc, ac, simd);
+        for (int comp = 0; comp < 4; comp++)
+          ASSERT_EQ(scalar[comp], simd[comp]) << "color " << color_mode << " alpha " << alpha_mode
+                                              << " component " << comp;
+      }
+    }
+  }
+}
+
+TEST(SWPixelKernels, BlendMatchesScalar)
+{
+  std::mt19937 rng(11);
+  const u32 edges[] = {0x00000000, 0xffffffff, 0x7f7f7f7f, 0x80808080, 0x01fe7f80};
+  for (u32 src : edges)
+  {
+    for (u32 dst : edges)
+    {
+      for (u32 sf : edges)
+      {
+        for (u32 df : edges)
+        {
+          u8 scalar[4], simd[4];
+          PixelKernels::BlendScalar((const u8*)&src, (const u8*)&dst, sf, df, scalar);
+          PixelKernels::BlendSSE2((const u8*)&src, (const u8*)&dst, sf, df, simd);
+          for (int comp = 0; comp < 4; comp++)
+            ASSERT_EQ(scalar[comp], simd[comp]);
+        }
+      }
+    }
+  }
+
+  for (int i = 0; i < 1000000; i++)
+  {
+    u32 src = rng(), dst = rng();
+    u32 sf = rng(), df = rng();
+    u8 scalar[4], simd[4];
+    PixelKernels::BlendScalar((const u8*)&src, (const u8*)&dst, sf, df, scalar);
+    PixelKernels::BlendSSE2((const u8*)&src, (const u8*)&dst, sf, df, simd);
+    for (int comp = 0; comp < 4; comp++)
+      ASSERT_EQ(scalar[comp], simd[comp]);
+  }
+}
+
+// Scalar vs. SSE2 combiner throughput, run with --gtest_also_run_disabled_tests.
+TEST(SWPixelKernels, DISABLED_CombineRegularBenchmark)
+{
+  std::mt19937 rng(3);
+  std::vector<PixelKernels::CombinerInputs> inputs(4096);
+  for (auto& input : inputs)
+    input = RandomInputs(rng);
+  TevStageCombiner::ColorCombiner cc;
+  TevStageCombiner::AlphaCombiner ac;
+  cc.hex = 0x190000;  // scale by 2, clamp, +0.5 bias
+  ac.hex = 0x0a0000;  // clamp, -0.5 bias
+  const int rounds = 500;
+
+  s16 out[4];
+  s32 scalar_sum = 0, simd_sum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int round = 0; round < rounds; round++)
+  {
+    for (const auto& input : inputs)
+    {
+      PixelKernels::CombineRegularScalar(input, cc, ac, out);
+      scalar_sum += out[0] + out[1] + out[2] + out[3];
+    }
+  }
+  auto middle = std::chrono::steady_clock::now();
+  for (int round = 0; round < rounds; round++)
+  {
+    for (const auto& input : inputs)
+    {
+      PixelKernels::CombineRegularSSE2(input, cc, ac, out);
+      simd_sum += out[0] + out[1] + out[2] + out[3];
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  EXPECT_EQ(scalar_sum, simd_sum);
+  printf("Combining %d pixels: scalar %.2f ms, SSE2 %.2f ms\n", rounds * static_cast<int>(inputs.size()),
+         std::chrono::duration<double, std::milli>(middle - start).count(),
+         std::chrono::duration<double, std::milli>(end - middle).count());
+}
+
+#endif
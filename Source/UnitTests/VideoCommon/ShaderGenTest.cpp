@@ -0,0 +1,147 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>  // NOLINT
+
+#include "VideoCommon/GeometryShaderGen.h"
+#include "VideoCommon/ObjectUsageProfiler.h"
+#include "VideoCommon/PixelShaderGen.h"
+#include "VideoCommon/ShaderGenCommon.h"
+#include "VideoCommon/ShaderSourceCache.h"
+#include "VideoCommon/VertexShaderGen.h"
+
+TEST(ShaderCode, WritesPlainAndFormattedText)
+{
+  std::vector<char> buffer(64);
+  ShaderCode code;
+  code.SetBuffer(buffer.data(), buffer.size());
+  code.Write("float4 ");
+  code.Write("c%d = %s;\n", 3, "x");
+  code.Write("100%% ");
+  code.Append("a%d", 3);
+
+  EXPECT_STREQ("float4 c3 = x;\n100% a%d", code.GetBuffer());
+  EXPECT_EQ(23, code.BufferSize());
+}
+
+TEST(ShaderCode, TruncatesAtEndOfBuffer)
+{
+  std::vector<char> buffer(9, 0x7C);
+  ShaderCode code;
+  code.SetBuffer(buffer.data(), buffer.size() - 1);
+  code.Write("0123");
+  code.Write("%d", 4567);
+  code.Write("89");
+
+  EXPECT_STREQ("0123456", code.GetBuffer());
+  EXPECT_EQ(7, code.BufferSize());
+  // Nothing was written past the given size
+  EXPECT_EQ(0x7C, buffer[8]);
+}
+
+TEST(ShaderSourceCache, GeneratesOncePerUid)
+{
+  ShaderSourceCache<VertexShaderUid> cache(64, 16);
+  int generated = 0;
+  auto generate = [&](ShaderCode& code, const VertexShaderUid& uid) {
+    generated++;
+    code.Write("components %u", uid.GetUidData().components);
+  };
+
+  VertexShaderUid first;
+  first.ClearUID();
+  first.GetUidData<vertex_shader_uid_data>().components = 1;
+  VertexShaderUid second;
+  second.ClearUID();
+  second.GetUidData<vertex_shader_uid_data>().components = 2;
+
+  EXPECT_EQ("components 1", cache.GetOrGenerate(first, generate));
+  EXPECT_EQ("components 2", cache.GetOrGenerate(second, generate));
+  EXPECT_EQ("components 1", cache.GetOrGenerate(first, generate));
+  EXPECT_EQ(2, generated);
+  EXPECT_EQ(1u, cache.GetHits());
+  EXPECT_EQ(2u, cache.size());
+}
+
+namespace
+{
+template <typename Uid, typename Generator>
+void BenchmarkUidCache(const std::string& path, pKey_t version, Generator generate, size_t buffer_size)
+{
+  ObjectUsageProfiler<Uid, pKey_t, int, typename Uid::ShaderUidHasher> profile(version);
+  const std::string::size_type name_start = path.find_last_of("/\\");
+  const bool global = path.compare(name_start + 1, 9, "Ishiiruka") == 0;
+  profile.ReadFromFile(path, global);
+
+  std::vector<Uid> uids;
+  profile.ForEachMostUsed([&](const Uid& uid) { uids.push_back(uid); });
+  ASSERT_FALSE(uids.empty()) << "No UIDs in " << path;
+
+  std::vector<char> buffer(buffer_size);
+  size_t total_size = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (const Uid& uid : uids)
+  {
+    ShaderCode code;
+    code.SetBuffer(buffer.data(), buffer.size());
+    generate(code, uid);
+    total_size += code.BufferSize();
+  }
+  const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start);
+
+  printf("Generated %zu shaders (%zu KiB) in %lld us, %.1f us per shader\n", uids.size(),
+         total_size / 1024, static_cast<long long>(elapsed.count()),
+         static_cast<double>(elapsed.count()) / uids.size());
+}
+}
+
+// Generates every UID of a shader UID cache (User/Cache/ShaderUidCache/*.vs.usage, *.ps.usage
+// or *.gs.usage) as GLSL and reports the time taken. Only runs if SHADERGEN_BENCHMARK_FILE
+// points to such a file.
+TEST(ShaderGen, BenchmarkUidCache)
+{
+  const char* file = getenv("SHADERGEN_BENCHMARK_FILE");
+  if (!file)
+    return;
+
+  const std::string path = file;
+  if (path.find(".vs") != std::string::npos)
+  {
+    BenchmarkUidCache<VertexShaderUid>(
+        path, VERTEXSHADERGEN_UID_VERSION,
+        [](ShaderCode& code, const VertexShaderUid& uid) {
+          GenerateVertexShaderCodeGL(code, uid.GetUidData());
+        },
+        VERTEXSHADERGEN_BUFFERSIZE);
+  }
+  else if (path.find(".ps") != std::string::npos)
+  {
+    BenchmarkUidCache<PixelShaderUid>(
+        path, PIXELSHADERGEN_UID_VERSION,
+        [](ShaderCode& code, const PixelShaderUid& uid) {
+          GeneratePixelShaderCodeGL(code, uid.GetUidData());
+        },
+        PIXELSHADERGEN_BUFFERSIZE);
+  }
+  else if (path.find(".gs") != std::string::npos)
+  {
+    BenchmarkUidCache<GeometryShaderUid>(
+        path, GEOMETRYSHADERGEN_UID_VERSION,
+        [](ShaderCode& code, const GeometryShaderUid& uid) {
+          GenerateGeometryShaderCode(code, uid.GetUidData(), API_OPENGL);
+        },
+        GEOMETRYSHADERGEN_BUFFERSIZE);
+  }
+  else
+  {
+    FAIL() << "Unknown UID cache type: " << path;
+  }
+}
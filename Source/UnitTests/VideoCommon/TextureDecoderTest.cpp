@@ -0,0 +1,152 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>  // NOLINT
+
+#include "Common/CPUDetect.h"
+#include "Common/CommonTypes.h"
+#include "VideoCommon/TextureDecoder.h"
+
+#ifdef _M_X86
+
+namespace
+{
+const u32 s_formats[] = {GX_TF_I4,     GX_TF_I8,     GX_TF_IA4,   GX_TF_IA8, GX_TF_RGB565, GX_TF_RGB5A3,
+                         GX_TF_RGBA8,  GX_TF_C4,     GX_TF_C8,    GX_TF_C14X2, GX_TF_CMPR};
+const TlutFormat s_tlut_formats[] = {GX_TL_IA8, GX_TL_RGB565, GX_TL_RGB5A3};
+const u32 s_tlut_address = 0x8000;
+
+std::vector<u8> RandomData(std::mt19937& rng, size_t size)
+{
+  std::vector<u8> data(size);
+  for (u8& byte : data)
+    byte = static_cast<u8>(rng());
+  return data;
+}
+
+void FillTlut(std::mt19937& rng)
+{
+  for (u32 i = 0; i < 0x8000; i++)
+    texMem[s_tlut_address + i] = static_cast<u8>(rng());
+}
+
+std::vector<u32> Decode(const std::vector<u8>& src, u32 width, u32 height, u32 format, TlutFormat tlutfmt,
+                        bool avx2)
+{
+  const bool had_avx2 = cpu_info.bAVX2;
+  cpu_info.bAVX2 = avx2;
+  std::vector<u32> dst(width * height);
+  EXPECT_EQ(PC_TEX_FMT_RGBA32, TexDecoder_Decode(reinterpret_cast<u8*>(dst.data()), src.data(), width, height,
+                                                 format, s_tlut_address, tlutfmt, true));
+  cpu_info.bAVX2 = had_avx2;
+  return dst;
+}
+}
+
+TEST(TextureDecoder, AVX2MatchesSSE)
+{
+  if (!cpu_info.bAVX2)
+    return;
+
+  std::mt19937 rng(5);
+  FillTlut(rng);
+  const u32 sizes[][2] = {{8, 8}, {64, 32}, {136, 128}};
+  for (u32 format : s_formats)
+  {
+    for (TlutFormat tlutfmt : s_tlut_formats)
+    {
+      if (TexDecoder_GetPaletteSize(format) == 0 && tlutfmt != GX_TL_IA8)
+        continue;  // not paletted
+
+      for (const auto& size : sizes)
+      {
+        const u32 width = size[0], height = size[1];
+        std::vector<u8> src = RandomData(rng, TexDecoder_GetTextureSizeInBytes(width, height, format));
+        std::vector<u32> expected = Decode(src, width, height, format, tlutfmt, false);
+        std::vector<u32> result = Decode(src, width, height, format, tlutfmt, true);
+        for (u32 i = 0; i < width * height; i++)
+        {
+          ASSERT_EQ(expected[i], result[i]) << "format " << format << " tlut " << tlutfmt << " size "
+                                            << width << "x" << height << " texel " << i;
+        }
+      }
+    }
+  }
+}
+
+TEST(TextureDecoder, ParallelMatchesSerial)
+{
+  std::mt19937 rng(13);
+  FillTlut(rng);
+  const u32 sizes[][2] = {{1024, 1024}, {640, 528}, {256, 256}};
+  for (u32 format : s_formats)
+  {
+    for (const auto& size : sizes)
+    {
+      const u32 width = size[0], height = size[1];
+      std::vector<u8> src = RandomData(rng, TexDecoder_GetTextureSizeInBytes(width, height, format));
+      for (int mode = 0; mode < 3; mode++)
+      {
+        // RGBA, native and native with compressed CMPR output
+        const bool rgba = mode == 0, compressed = mode == 2;
+        std::vector<u32> serial(width * height), parallel(width * height);
+        TexDecoder_SetParallelDecoding(false);
+        const PC_TexFormat serial_format =
+            TexDecoder_Decode(reinterpret_cast<u8*>(serial.data()), src.data(), width, height, format,
+                              s_tlut_address, GX_TL_RGB5A3, rgba, compressed);
+        TexDecoder_SetParallelDecoding(true);
+        const PC_TexFormat parallel_format =
+            TexDecoder_Decode(reinterpret_cast<u8*>(parallel.data()), src.data(), width, height, format,
+                              s_tlut_address, GX_TL_RGB5A3, rgba, compressed);
+        TexDecoder_SetParallelDecoding(false);
+
+        EXPECT_EQ(serial_format, parallel_format);
+        EXPECT_TRUE(serial == parallel) << "format " << format << " mode " << mode << " size " << width
+                                        << "x" << height;
+      }
+    }
+  }
+}
+
+// Decoding speed per format and path, run with --gtest_also_run_disabled_tests.
+TEST(TextureDecoder, DISABLED_DecodeBenchmark)
+{
+  std::mt19937 rng(9);
+  FillTlut(rng);
+  const u32 width = 512, height = 512;
+  const int rounds = 20;
+  std::vector<u32> dst(width * height);
+  for (u32 format : s_formats)
+  {
+    std::vector<u8> src = RandomData(rng, TexDecoder_GetTextureSizeInBytes(width, height, format));
+    for (int mode = 0; mode < 3; mode++)
+    {
+      const bool avx2 = mode != 0, parallel = mode == 2;
+      if (avx2 && !cpu_info.bAVX2)
+        continue;
+
+      const bool had_avx2 = cpu_info.bAVX2;
+      cpu_info.bAVX2 = avx2;
+      TexDecoder_SetParallelDecoding(parallel);
+      auto start = std::chrono::steady_clock::now();
+      for (int round = 0; round < rounds; round++)
+      {
+        TexDecoder_Decode(reinterpret_cast<u8*>(dst.data()), src.data(), width, height, format, s_tlut_address,
+                          GX_TL_RGB565, true);
+      }
+      double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      cpu_info.bAVX2 = had_avx2;
+      TexDecoder_SetParallelDecoding(false);
+      printf("format %2u %-13s %8.1f Mtexels/s\n", format, parallel ? "AVX2 parallel" : avx2 ? "AVX2" : "SSE",
+             static_cast<double>(width) * height * rounds / seconds / 1e6);
+    }
+  }
+}
+
+#endif
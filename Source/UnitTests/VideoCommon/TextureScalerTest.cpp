@@ -0,0 +1,86 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>  // NOLINT
+
+#include "Common/Common.h"
+#include "Common/ThreadPool.h"
+#include "VideoCommon/TextureScalerCommon.h"
+#include "VideoCommon/VideoConfig.h"
+
+namespace
+{
+// Blocky noise, so the edge detecting scalers have some work to do.
+std::vector<u32> MakeTexture(int width, int height)
+{
+  std::vector<u32> texture(width * height);
+  std::mt19937 rng(1234);
+  for (int y = 0; y < height; y += 4)
+  {
+    for (int x = 0; x < width; x += 4)
+    {
+      u32 color = rng();
+      for (int by = y; by < y + 4 && by < height; by++)
+        for (int bx = x; bx < x + 4 && bx < width; bx++)
+          texture[by * width + bx] = color;
+    }
+  }
+  return texture;
+}
+
+std::vector<u32> Scale(TextureScaler& scaler, u32 max_threads, std::vector<u32> input, int width,
+                       int height)
+{
+  scaler.SetMaxThreads(max_threads);
+  u32* output = scaler.Scale(input.data(), width, height);
+  int factor = g_ActiveConfig.iTexScalingFactor;
+  return std::vector<u32>(output, output + width * height * factor * factor);
+}
+}
+
+TEST(TextureScaler, ThreadCountDoesNotChangeOutput)
+{
+  const int width = 61, height = 37;
+  std::vector<u32> input = MakeTexture(width, height);
+  TextureScaler scaler;
+  g_ActiveConfig.bTexDeposterize = true;
+  for (int factor = 2; factor <= 4; factor++)
+  {
+    g_ActiveConfig.iTexScalingFactor = factor;
+    for (int type = TextureScaler::XBRZ; type <= TextureScaler::DDT_SHARP; type++)
+    {
+      g_ActiveConfig.iTexScalingType = type;
+      std::vector<u32> single = Scale(scaler, 1, input, width, height);
+      std::vector<u32> threaded = Scale(scaler, 0, input, width, height);
+      EXPECT_TRUE(single == threaded) << "type " << type << " factor " << factor;
+    }
+  }
+  g_ActiveConfig.bTexDeposterize = false;
+}
+
+// Times xBRZ 4x at every thread count. Opt in with --gtest_also_run_disabled_tests.
+TEST(TextureScaler, DISABLED_Benchmark)
+{
+  const int width = 256, height = 256, runs = 4;
+  std::vector<u32> input = MakeTexture(width, height);
+  TextureScaler scaler;
+  g_ActiveConfig.iTexScalingType = TextureScaler::XBRZ;
+  g_ActiveConfig.iTexScalingFactor = 4;
+  // Warm up, xBRZ builds its lookup tables on first use.
+  Scale(scaler, 0, input, width, height);
+  for (u32 threads = 1; threads <= Common::ThreadPool::GetThreadCount(); threads++)
+  {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < runs; i++)
+      Scale(scaler, threads, input, width, height);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    double ms = std::chrono::duration<double, std::milli>(elapsed).count() / runs;
+    printf("xBRZ 4x %dx%d, %u thread(s): %.2f ms\n", width, height, threads, ms);
+  }
+}
@@ -0,0 +1,286 @@
+// Copyright 2017 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+// Compiles the shaders recorded in a game's shader UID cache to SPIR-V and appends them to the
+// disk caches the Vulkan backend loads at startup. No GPU is needed, so the caches can be warmed
+// on any machine, as long as the device they are used on has the features assumed here.
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/FileUtil.h"
+#include "Common/Hash.h"
+#include "Common/LinearDiskCache.h"
+#include "Common/StringUtil.h"
+#include "Core/ConfigManager.h"
+#include "Core/Host.h"
+#include "UICommon/UICommon.h"
+#include "VideoBackends/Vulkan/ObjectCache.h"
+#include "VideoBackends/Vulkan/ShaderCompiler.h"
+#include "VideoBackends/Vulkan/VulkanContext.h"
+#include "VideoCommon/GeometryShaderGen.h"
+#include "VideoCommon/ObjectUsageProfiler.h"
+#include "VideoCommon/PixelShaderGen.h"
+#include "VideoCommon/VertexShaderGen.h"
+#include "VideoCommon/VideoConfig.h"
+
+// Stub out the host stuff, since this is just a simple cmdline tool.
+void Host_NotifyMapLoaded()
+{
+}
+void Host_RefreshDSPDebuggerWindow()
+{
+}
+void Host_Message(int)
+{
+}
+void* Host_GetRenderHandle()
+{
+	return nullptr;
+}
+void Host_UpdateTitle(const std::string&)
+{
+}
+void Host_UpdateDisasmDialog()
+{
+}
+void Host_UpdateMainFrame()
+{
+}
+void Host_RequestRenderWindowSize(int, int)
+{
+}
+void Host_SetStartupDebuggingParameters()
+{
+}
+bool Host_UIHasFocus()
+{
+	return false;
+}
+bool Host_RendererHasFocus()
+{
+	return false;
+}
+bool Host_RendererIsFullscreen()
+{
+	return false;
+}
+void Host_ConnectWiimote(int, bool)
+{
+}
+void Host_SetWiiMoteConnectionState(int)
+{
+}
+void Host_ShowVideoConfig(void*, const std::string&)
+{
+}
+void Host_YieldToUI()
+{
+}
+
+// Collects the UIDs that already have SPIR-V in the disk cache
+template <typename Uid>
+class CachedUidReader : public LinearDiskCacheReader<Uid, u32>
+{
+public:
+	void Read(const Uid& key, const u32* value, u32 value_size) override
+	{
+		Uid item = key;
+		item.ClearHASH();
+		item.CalculateUIDHash();
+		uids.insert(item);
+	}
+
+	std::unordered_set<Uid, typename Uid::ShaderUidHasher> uids;
+};
+
+template <typename Uid, typename Generator, typename Compiler>
+static void CompileShaders(const std::string& game_id, const char* type, pKey_t version,
+	size_t buffer_size, unsigned int thread_count, Generator generate, Compiler compile)
+{
+	// Same UID lists and cache files as ObjectCache::LoadShaderCaches
+	using UidProfile = ObjectUsageProfiler<Uid, pKey_t, bool, typename Uid::ShaderUidHasher>;
+	const pKey_t game_hash = (pKey_t)GetMurmurHash3(reinterpret_cast<const u8*>(game_id.data()), (u32)game_id.size(), 0);
+	std::unique_ptr<UidProfile> profile(UidProfile::Create(game_hash, version,
+		StringFromFormat("Ishiiruka.%s", type), StringFromFormat("%s.%s", game_id.c_str(), type)));
+
+	LinearDiskCache<Uid, u32> disk_cache;
+	CachedUidReader<Uid> cached;
+	disk_cache.OpenAndRead(Vulkan::ObjectCache::GetDiskCacheFileName(game_id, type), cached);
+
+	std::vector<Uid> uids;
+	profile->ForEachMostUsedByCategory(game_hash,
+		[&](const Uid& uid, size_t total)
+	{
+		Uid item = uid;
+		item.ClearHASH();
+		item.CalculateUIDHash();
+		if (!cached.uids.count(item))
+			uids.push_back(item);
+	}, {}, true);
+
+	std::atomic<size_t> next_uid{0};
+	std::mutex results_lock;
+	size_t finished = 0;
+	size_t failed = 0;
+	auto worker = [&]
+	{
+		// The generators' static buffers are shared, give each thread its own
+		std::vector<char> buffer(buffer_size);
+		Vulkan::ShaderCompiler::SPIRVCodeVector spv;
+		for (size_t i = next_uid++; i < uids.size(); i = next_uid++)
+		{
+			ShaderCode code;
+			code.SetBuffer(buffer.data(), buffer.size());
+			generate(code, uids[i]);
+			spv.clear();
+			const bool compiled = compile(&spv, code.GetBuffer(), code.BufferSize());
+
+			std::lock_guard<std::mutex> guard(results_lock);
+			if (compiled)
+				disk_cache.Append(uids[i], spv.data(), static_cast<u32>(spv.size()));
+			else
+				failed++;
+			finished++;
+			printf("\r%s: %zu/%zu", type, finished, uids.size());
+			fflush(stdout);
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (unsigned int i = 0; i < thread_count; i++)
+		threads.emplace_back(worker);
+	for (std::thread& thread : threads)
+		thread.join();
+
+	disk_cache.Sync();
+	disk_cache.Close();
+	printf("%s%s: %zu compiled, %zu failed, %zu already cached\n", uids.empty() ? "" : "\n", type,
+		uids.size() - failed, failed, cached.uids.size());
+}
+
+static void PrintUsage()
+{
+	printf("Usage: vulkanshadertool [options] <game id>\n"
+		"Compiles the shaders in the game's shader UID cache to SPIR-V.\n"
+		"  -u <path>                Use <path> as the user directory\n"
+		"  -j <count>               Number of compiler threads (default: all cores)\n"
+		"  --no-geometry-shaders    Target a device without geometry shaders\n"
+		"  --no-dual-source-blend   Target a device without dual source blending\n"
+		"  --no-bbox                Target a device without fragment stores and atomics\n"
+		"  --no-ssaa                Target a device without sample rate shading\n"
+		"  --no-depth-clamp         Target a device without depth clamping\n");
+}
+
+int main(int argc, const char* argv[])
+{
+	std::string user_dir;
+	std::string game_id;
+	unsigned int thread_count = std::thread::hardware_concurrency();
+	bool geometry_shaders = true;
+	bool dual_source_blend = true;
+	bool bbox = true;
+	bool ssaa = true;
+	bool depth_clamp = true;
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "-u") && i + 1 < argc)
+			user_dir = argv[++i];
+		else if (!strcmp(argv[i], "-j") && i + 1 < argc)
+			thread_count = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--no-geometry-shaders"))
+			geometry_shaders = false;
+		else if (!strcmp(argv[i], "--no-dual-source-blend"))
+			dual_source_blend = false;
+		else if (!strcmp(argv[i], "--no-bbox"))
+			bbox = false;
+		else if (!strcmp(argv[i], "--no-ssaa"))
+			ssaa = false;
+		else if (!strcmp(argv[i], "--no-depth-clamp"))
+			depth_clamp = false;
+		else if (argv[i][0] != '-' && game_id.empty())
+			game_id = argv[i];
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+	if (game_id.empty())
+	{
+		PrintUsage();
+		return 1;
+	}
+	if (thread_count == 0)
+		thread_count = 1;
+
+	UICommon::SetUserDirectory(user_dir);
+	UICommon::CreateDirectories();
+	SConfig::Init();
+	SConfig::GetInstance().m_strGameID = game_id;
+
+	// Mirror VideoBackend::Initialize, with the device features the user asked for
+	Vulkan::VulkanContext::PopulateBackendInfo(&g_Config);
+	g_Config.backend_info.bSupportsDualSourceBlend = dual_source_blend;
+	g_Config.backend_info.bSupportsGeometryShaders = geometry_shaders;
+	g_Config.backend_info.bSupportsGSInstancing = geometry_shaders;
+	g_Config.backend_info.bSupportsBBox = bbox;
+	g_Config.backend_info.bSupportsSSAA = ssaa;
+	g_Config.backend_info.bSupportsDepthClamp = depth_clamp;
+	g_Config.Load(File::GetUserPath(D_CONFIG_IDX) + "GFX.ini");
+	g_Config.GameIniLoad();
+	g_Config.VerifyValidity();
+	UpdateActiveConfig();
+
+	if (!Vulkan::ShaderCompiler::InitializeGlslang())
+		return 1;
+
+	CompileShaders<VertexShaderUid>(game_id, "vs", VERTEXSHADERGEN_UID_VERSION,
+		VERTEXSHADERGEN_BUFFERSIZE, thread_count,
+		[](ShaderCode& code, const VertexShaderUid& uid)
+	{
+		GenerateVertexShaderCodeVulkan(code, uid.GetUidData());
+	},
+		[](Vulkan::ShaderCompiler::SPIRVCodeVector* spv, const char* source, size_t length)
+	{
+		return Vulkan::ShaderCompiler::CompileVertexShader(spv, source, length);
+	});
+
+	CompileShaders<PixelShaderUid>(game_id, "ps", PIXELSHADERGEN_UID_VERSION,
+		PIXELSHADERGEN_BUFFERSIZE, thread_count,
+		[](ShaderCode& code, const PixelShaderUid& uid)
+	{
+		GeneratePixelShaderCodeVulkan(code, uid.GetUidData());
+	},
+		[](Vulkan::ShaderCompiler::SPIRVCodeVector* spv, const char* source, size_t length)
+	{
+		return Vulkan::ShaderCompiler::CompileFragmentShader(spv, source, length);
+	});
+
+	if (g_ActiveConfig.backend_info.bSupportsGeometryShaders)
+	{
+		CompileShaders<GeometryShaderUid>(game_id, "gs", GEOMETRYSHADERGEN_UID_VERSION,
+			GEOMETRYSHADERGEN_BUFFERSIZE, thread_count,
+			[](ShaderCode& code, const GeometryShaderUid& uid)
+		{
+			GenerateGeometryShaderCode(code, uid.GetUidData(), API_VULKAN);
+		},
+			[](Vulkan::ShaderCompiler::SPIRVCodeVector* spv, const char* source, size_t length)
+		{
+			return Vulkan::ShaderCompiler::CompileGeometryShader(spv, source, length);
+		});
+	}
+
+	SConfig::Shutdown();
+	return 0;
+}